@@ -48,7 +48,7 @@ extern "C" {
 typedef struct {
 	int freq;		/* DSP frequency -- samples per second */
 	Uint16 format;		/* Audio data format */
-	Uint8  channels;	/* Number of channels: 1 mono, 2 stereo */
+	Uint8  channels;	/* Number of channels: 1, 2, 4, 6 or 8 */
 	Uint8  silence;		/* Audio buffer silence value (calculated) */
 	Uint16 samples;		/* Audio buffer size in samples (power of 2) */
 	Uint16 padding;		/* Necessary for some compile environments */
@@ -58,29 +58,43 @@ typedef struct {
 	   'stream' is a pointer to the audio data buffer
 	   'len' is the length of that buffer in bytes.
 	   Once the callback returns, the buffer will no longer be valid.
-	   Stereo samples are stored in a LRLRLR ordering.
+	   Stereo samples are stored in a LRLRLR ordering, and the other
+	   layouts are listed with SDL_SetChannelMatrix() below.
 	*/
 	void (*callback)(void *userdata, Uint8 *stream, int len);
 	void  *userdata;
 } SDL_AudioSpec;
 
-/* Audio format flags (defaults to LSB byte order) */
+/* Audio format flags (defaults to LSB byte order)
+   Floating point samples range from -1.0 to 1.0, and are clipped to that
+   range when they are converted to integer samples.
+ */
 #define AUDIO_U8	0x0008	/* Unsigned 8-bit samples */
 #define AUDIO_S8	0x8008	/* Signed 8-bit samples */
 #define AUDIO_U16LSB	0x0010	/* Unsigned 16-bit samples */
 #define AUDIO_S16LSB	0x8010	/* Signed 16-bit samples */
 #define AUDIO_U16MSB	0x1010	/* As above, but big-endian byte order */
 #define AUDIO_S16MSB	0x9010	/* As above, but big-endian byte order */
+#define AUDIO_S32LSB	0x8020	/* 32-bit integer samples */
+#define AUDIO_S32MSB	0x9020	/* As above, but big-endian byte order */
+#define AUDIO_F32LSB	0x8120	/* 32-bit floating point samples */
+#define AUDIO_F32MSB	0x9120	/* As above, but big-endian byte order */
 #define AUDIO_U16	AUDIO_U16LSB
 #define AUDIO_S16	AUDIO_S16LSB
+#define AUDIO_S32	AUDIO_S32LSB
+#define AUDIO_F32	AUDIO_F32LSB
 
 /* Native audio byte ordering */
 #if SDL_BYTEORDER == SDL_LIL_ENDIAN
 #define AUDIO_U16SYS	AUDIO_U16LSB
 #define AUDIO_S16SYS	AUDIO_S16LSB
+#define AUDIO_S32SYS	AUDIO_S32LSB
+#define AUDIO_F32SYS	AUDIO_F32LSB
 #else
 #define AUDIO_U16SYS	AUDIO_U16MSB
 #define AUDIO_S16SYS	AUDIO_S16MSB
+#define AUDIO_S32SYS	AUDIO_S32MSB
+#define AUDIO_F32SYS	AUDIO_F32MSB
 #endif
 
 
@@ -146,7 +160,8 @@ extern DECLSPEC char * SDLCALL SDL_AudioDriverName(char *namebuf, int maxlen);
  *     to the audio buffer, and the length in bytes of the audio buffer.
  *     This function usually runs in a separate thread, and so you should
  *     protect data structures that it accesses by calling SDL_LockAudio()
- *     and SDL_UnlockAudio() in your code.
+ *     and SDL_UnlockAudio() in your code.  If it is NULL, the audio is
+ *     fed with SDL_QueueAudio() instead.
  *  'desired->userdata' is passed as the first parameter to your callback
  *     function.
  *
@@ -226,16 +241,184 @@ extern DECLSPEC int SDLCALL SDL_BuildAudioCVT(SDL_AudioCVT *cvt,
  */
 extern DECLSPEC int SDLCALL SDL_ConvertAudio(SDL_AudioCVT *cvt);
 
+/*
+ * The channels of each frame are stored in this order:
+ *	1 (mono):	C
+ *	2 (stereo):	FL FR
+ *	4 (quad):	FL FR BL BR
+ *	6 (5.1):	FL FR FC LFE BL BR
+ *	8 (7.1):	FL FR FC LFE BL BR SL SR
+ * for the front, center, low frequency, back and side speakers.
+ * Converting between these is done by mixing with a matrix, which holds
+ * a row of 'src_channels' coefficients for each of the 'dst_channels'
+ * output channels.  The default matrices keep each speaker where it is,
+ * or move it to the nearest speakers the output has, and scale down-mixes
+ * from more than two channels so they don't clip.  Mono to stereo and
+ * stereo to mono work as they always have, with coefficients of 1.0.
+ *
+ * SDL_SetChannelMatrix() replaces the matrix for a pair of layouts, or
+ * restores the default if 'matrix' is NULL.  It may be called while audio
+ * is playing; conversions pick up the new matrix from their next buffer.
+ * SDL_GetChannelMatrix() copies the matrix in use.
+ * These functions return 0, or -1 if there is no layout for one of the
+ * counts or they are the same.
+ */
+extern DECLSPEC int SDLCALL SDL_SetChannelMatrix(int src_channels, int dst_channels, const float *matrix);
+extern DECLSPEC int SDLCALL SDL_GetChannelMatrix(int src_channels, int dst_channels, float *matrix);
+
+/*
+ * Sample rates are converted with a windowed sinc filter, or by linear
+ * interpolation at SDL_RESAMPLE_LINEAR.  Higher qualities keep more of
+ * the high frequencies and filter aliasing better, but cost more time.
+ * The default is SDL_RESAMPLE_MEDIUM, or the SDL_AUDIO_RESAMPLER
+ * environment variable set to "linear", "fast", "medium" or "best".
+ * The quality is picked up by later calls to SDL_ConvertAudio() and
+ * SDL_OpenAudio().
+ */
+typedef enum {
+	SDL_RESAMPLE_LINEAR = 0,
+	SDL_RESAMPLE_FAST,
+	SDL_RESAMPLE_MEDIUM,
+	SDL_RESAMPLE_BEST
+} SDL_ResampleQuality;
+extern DECLSPEC void SDLCALL SDL_SetResampleQuality(SDL_ResampleQuality quality);
+extern DECLSPEC SDL_ResampleQuality SDLCALL SDL_GetResampleQuality(void);
+
+/*
+ * An audio stream converts audio data like SDL_ConvertAudio(), but takes
+ * it in pieces of any size and keeps the converted data until it is
+ * read, so a stream of audio can be fed in as it is decoded and read out
+ * as it is needed.  SDL_CreateAudioStream() takes the same parameters as
+ * SDL_BuildAudioCVT(), and returns NULL if the conversion isn't supported.
+ * A stream may only be used by one thread at a time.
+ */
+typedef struct SDL_AudioStream SDL_AudioStream;
+extern DECLSPEC SDL_AudioStream * SDLCALL SDL_CreateAudioStream(
+		Uint16 src_format, Uint8 src_channels, int src_rate,
+		Uint16 dst_format, Uint8 dst_channels, int dst_rate);
+
+/* Add 'len' bytes of audio in the source format to the stream.
+ * This function returns 0, or -1 if it ran out of memory.
+ */
+extern DECLSPEC int SDLCALL SDL_AudioStreamPut(SDL_AudioStream *stream, const void *buf, int len);
+
+/* Read up to 'len' bytes of converted audio, in whole frames.
+ * This function returns the number of bytes read, which is 'len' as long
+ * as SDL_AudioStreamAvailable() returns at least that much.
+ */
+extern DECLSPEC int SDLCALL SDL_AudioStreamGet(SDL_AudioStream *stream, void *buf, int len);
+
+/* Returns the number of converted bytes that can be read right now.
+ * When the rate is converted, the last few frames put are held back
+ * until more audio follows them or the stream is flushed.
+ */
+extern DECLSPEC int SDLCALL SDL_AudioStreamAvailable(SDL_AudioStream *stream);
+
+/* Mark the end of the audio put so far, so all of it can be read, and
+ * start over as if the stream were new.  Unread audio is kept.
+ * This function returns 0, or -1 if it ran out of memory.
+ */
+extern DECLSPEC int SDLCALL SDL_AudioStreamFlush(SDL_AudioStream *stream);
+
+/* Throw away all audio in the stream that hasn't been read */
+extern DECLSPEC void SDLCALL SDL_AudioStreamClear(SDL_AudioStream *stream);
+
+extern DECLSPEC void SDLCALL SDL_FreeAudioStream(SDL_AudioStream *stream);
+
 /*
  * This takes two audio buffers of the playing audio format and mixes
  * them, performing addition, volume adjustment, and overflow clipping.
  * The volume ranges from 0 - 128, and should be set to SDL_MIX_MAXVOLUME
  * for full audio volume.  Note this does not change hardware volume.
+ * Floating point samples are added without clipping, so they can go
+ * past -1.0 and 1.0 and be scaled back down before they are played.
  * This is provided for convenience -- you can mix your own audio data.
  */
 #define SDL_MIX_MAXVOLUME 128
 extern DECLSPEC void SDLCALL SDL_MixAudio(Uint8 *dst, const Uint8 *src, Uint32 len, int volume);
 
+/*
+ * An audio mixer plays up to a fixed number of sounds at once, each on
+ * its own voice with its own volume, pan and pitch.  All the voices are
+ * added up in floating point and clipped once, when the result is
+ * converted to the format the mixer was created for.
+ * SDL_MixVoices() can be used as the audio callback, with the mixer as
+ * the userdata, and the voices can be controlled from any thread while
+ * it runs, without locking the audio.  Changes are picked up at the
+ * start of the next buffer mixed.
+ */
+typedef struct SDL_AudioMixer SDL_AudioMixer;
+typedef struct SDL_MixerSound SDL_MixerSound;
+
+/* Create a mixer with 'voices' voices producing audio in the format,
+ * channels and rate of 'spec', usually the spec the audio device was
+ * opened with.  This function returns NULL if it ran out of memory or
+ * the format isn't supported.
+ */
+extern DECLSPEC SDL_AudioMixer * SDLCALL SDL_CreateAudioMixer(const SDL_AudioSpec *spec, int voices);
+
+/* Fill 'stream' with 'len' bytes of the voices mixed together.
+ * 'mixer' is the SDL_AudioMixer, so this can be the audio callback.
+ * Only one thread may mix at a time.
+ */
+extern DECLSPEC void SDLCALL SDL_MixVoices(void *mixer, Uint8 *stream, int len);
+
+/* Returns the number of frames mixed so far.  Voices are started and
+ * stopped at positions on this count.
+ */
+extern DECLSPEC Uint32 SDLCALL SDL_GetMixerFrame(SDL_AudioMixer *mixer);
+
+/* Free the mixer, after its last buffer has been mixed and after all
+ * the sounds made for it have been freed.
+ */
+extern DECLSPEC void SDLCALL SDL_FreeAudioMixer(SDL_AudioMixer *mixer);
+
+/*
+ * Make a sound that can be played by the mixer from 'len' bytes of
+ * audio in 'buf' described by 'spec'.  The audio is converted to the
+ * mixer's rate and to floating point once, and is kept mono if it is
+ * mono, or converted to the mixer's channels.  The sound can be freed
+ * while it is playing, and goes away when it has finished.
+ * This function returns NULL if it ran out of memory or the audio
+ * can't be converted.
+ */
+extern DECLSPEC SDL_MixerSound * SDLCALL SDL_CreateMixerSound(SDL_AudioMixer *mixer, const SDL_AudioSpec *spec, const Uint8 *buf, Uint32 len);
+extern DECLSPEC void SDLCALL SDL_FreeMixerSound(SDL_MixerSound *sound);
+
+/*
+ * Play 'sound' on a voice, starting at mixer frame 'frame', stopping
+ * whatever the voice was playing.  The sound is played 'loops' more
+ * times after the first, or forever if 'loops' is -1.  A frame that has
+ * already been mixed, such as the one SDL_GetMixerFrame() returns,
+ * starts it at the beginning of the next buffer.
+ * This function returns 0, or -1 if the voice doesn't exist or too many
+ * changes are waiting for the mixer.
+ */
+extern DECLSPEC int SDLCALL SDL_PlayVoice(SDL_AudioMixer *mixer, int voice, SDL_MixerSound *sound, int loops, Uint32 frame);
+
+/* Stop a voice at mixer frame 'frame', so the frame before it is the
+ * last one played.  This function returns 0 or -1 like SDL_PlayVoice().
+ */
+extern DECLSPEC int SDLCALL SDL_StopVoice(SDL_AudioMixer *mixer, int voice, Uint32 frame);
+
+/* Returns 1 if the voice was playing at the end of the last buffer mixed */
+extern DECLSPEC int SDLCALL SDL_VoicePlaying(SDL_AudioMixer *mixer, int voice);
+
+/*
+ * Set the volume of a voice, 1.0 for the volume of the sound itself,
+ * and its pan, from -1.0 for the left speaker to 1.0 for the right.
+ * Mono sounds are panned with constant power between the front left and
+ * right speakers, and other sounds have their front channels balanced.
+ * Volume and pan move smoothly to the new values over a few frames.
+ * The pitch plays the sound faster or slower with the resampler, 2.0
+ * being an octave up.  The voices start at volume 1.0, pan 0.0 and
+ * pitch 1.0, and keep their settings from one sound to the next.
+ * These functions return 0 or -1 like SDL_PlayVoice().
+ */
+extern DECLSPEC int SDLCALL SDL_SetVoiceVolume(SDL_AudioMixer *mixer, int voice, float volume);
+extern DECLSPEC int SDLCALL SDL_SetVoicePan(SDL_AudioMixer *mixer, int voice, float pan);
+extern DECLSPEC int SDLCALL SDL_SetVoicePitch(SDL_AudioMixer *mixer, int voice, float pitch);
+
 /*
  * The lock manipulated by these functions protects the callback function.
  * During a LockAudio/UnlockAudio pair, you can be guaranteed that the
@@ -245,6 +428,95 @@ extern DECLSPEC void SDLCALL SDL_MixAudio(Uint8 *dst, const Uint8 *src, Uint32 l
 extern DECLSPEC void SDLCALL SDL_LockAudio(void);
 extern DECLSPEC void SDLCALL SDL_UnlockAudio(void);
 
+/*
+ * When the audio device is opened without a callback, the application
+ * queues audio in the format it asked for with SDL_QueueAudio(), and the
+ * audio thread plays it as soon as it's unpaused, or silence when the
+ * queue runs dry.  The queue holds at least a second of audio.
+ * Only one thread may queue audio at a time, but neither it nor the
+ * audio thread ever waits for the other, and it doesn't need to lock
+ * the audio.
+ * SDL_QueueAudio() queues all of 'len' bytes, or returns -1 if they
+ * don't fit or the device isn't open for queuing.  It returns 0 if they
+ * were queued.
+ */
+extern DECLSPEC int SDLCALL SDL_QueueAudio(const void *data, Uint32 len);
+
+/* Returns the number of bytes queued and not yet played */
+extern DECLSPEC Uint32 SDLCALL SDL_GetQueuedAudioSize(void);
+
+/* Throw away all the queued audio */
+extern DECLSPEC void SDLCALL SDL_ClearQueuedAudio(void);
+
+/*
+ * Have 'callback' called from the audio thread each time it takes audio
+ * from the queue and leaves less than 'low_water' bytes, so the queue can
+ * be refilled without polling.  It is passed 'userdata' and the number of
+ * bytes left.  It runs with the audio locked like the audio callback, and
+ * may queue audio itself, as long as no other thread is doing so.
+ * A NULL callback turns it off.  This function returns 0, or -1 if the
+ * device isn't open for queuing.
+ */
+extern DECLSPEC int SDLCALL SDL_SetAudioQueueLowWater(Uint32 low_water, void (*callback)(void *userdata, Uint32 queued), void *userdata);
+
+/* How long one part of the audio thread's work took, in microseconds.
+ * histogram[0] counts the times under 16 microseconds, and histogram[i]
+ * those from 16<<(i-1) up to 16<<i, with the last one counting all the
+ * longer times too.
+ */
+#define SDL_AUDIO_HISTOGRAM_SIZE	16
+typedef struct SDL_AudioTiming {
+	Uint32 count;		/* Times measured */
+	Uint32 last_us;		/* The latest time */
+	Uint32 min_us;		/* The shortest time */
+	Uint32 max_us;		/* The longest time */
+	Uint32 mean_us;		/* The average time */
+	Uint32 histogram[SDL_AUDIO_HISTOGRAM_SIZE];
+} SDL_AudioTiming;
+
+/* Counters for the audio thread, since the device was opened */
+typedef struct SDL_AudioStats {
+	Uint32 buffers;		/* Buffers played by the device */
+	Uint32 dropped;		/* Buffers thrown away because the device
+				   didn't have one ready */
+	Uint32 silent;		/* Buffers of silence played while paused */
+	Uint32 starved;		/* Buffers the audio queue couldn't fill */
+	Uint32 xruns;		/* Underruns reported by the audio driver */
+	SDL_AudioTiming wait;	/* Waiting for the device to want audio */
+	SDL_AudioTiming callback; /* Getting audio from the application */
+	SDL_AudioTiming convert; /* Converting it to the device format */
+} SDL_AudioStats;
+
+/*
+ * This function fills in 'stats' with the counters for the audio device,
+ * and clears them if 'reset' is non-zero, so reading them regularly with
+ * 'reset' set gives the figures for each period.  The callback is only
+ * timed when it is called, and the conversion when there is one.
+ * 'stats' may be NULL, to just reset the counters.  The counters and
+ * the trace hook below belong to the open audio device, and go away
+ * when it is closed.
+ */
+extern DECLSPEC void SDLCALL SDL_GetAudioStats(SDL_AudioStats *stats, int reset);
+
+/* What happened to one buffer, for the trace hook */
+typedef struct SDL_AudioTrace {
+	Uint32 sequence;	/* Buffers worked on before this one */
+	Uint32 wait_us;
+	Uint32 callback_us;
+	Uint32 convert_us;
+	Uint8 dropped;
+	Uint8 silent;
+	Uint8 starved;
+	Uint8 xruns;
+} SDL_AudioTrace;
+
+/*
+ * Have 'hook' called by the audio thread after each buffer, with
+ * 'userdata' and the trace of the buffer.  It is called without the
+ * audio locked, and should return quickly.  A NULL hook turns it off.
+ */
+extern DECLSPEC void SDLCALL SDL_SetAudioTraceHook(void (*hook)(void *userdata, const SDL_AudioTrace *trace), void *userdata);
+
 /*
  * This function shuts down audio processing and closes the audio device.
  */
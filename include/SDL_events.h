@@ -273,12 +273,37 @@ extern DECLSPEC int SDLCALL SDL_PollEvent(SDL_Event *event);
  */
 extern DECLSPEC int SDLCALL SDL_WaitEvent(SDL_Event *event);
 
+/* Waits up to 'timeout' milliseconds for the next available event,
+   returning 1, or 0 if there was an error or no event arrived in time.
+   A negative 'timeout' waits indefinitely, like SDL_WaitEvent().
+   If 'event' is not NULL, the next event is removed from the queue and
+   stored in that area.
+ */
+extern DECLSPEC int SDLCALL SDL_WaitEventTimeout(SDL_Event *event, int timeout);
+
 /* Add an event to the event queue.
    This function returns 0 if the event queue was full, or -1
    if there was some other error.  Returns 1 on success.
  */
 extern DECLSPEC int SDLCALL SDL_PushEvent(SDL_Event *event);
 
+/* Counters describing the use of the event queue.
+   The queue grows as needed, so events are only dropped when a very
+   large number of them are waiting, or memory runs out.
+ */
+typedef struct SDL_EventQueueStats {
+	Uint32 queued;		/* Events waiting in the queue */
+	Uint32 peak;		/* Most events waiting at once */
+	Uint32 added;		/* Events added to the queue */
+	Uint32 dropped;		/* Events lost because they didn't fit */
+} SDL_EventQueueStats;
+
+/* Get the event queue counters, if 'stats' is not NULL.
+   If 'reset' is non-zero, the peak and the added and dropped counters
+   start again from the current state of the queue.
+ */
+extern DECLSPEC void SDLCALL SDL_GetEventQueueStats(SDL_EventQueueStats *stats, int reset);
+
 /*
   This function sets up a filter to process all events before they
   change internal state and are posted to the internal event queue.
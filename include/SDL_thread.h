@@ -70,6 +70,81 @@ extern DECLSPEC void SDLCALL SDL_WaitThread(SDL_Thread *thread, int *status);
 extern DECLSPEC void SDLCALL SDL_KillThread(SDL_Thread *thread);
 
 
+/* Thread local storage: each thread sees its own value for a TLS ID */
+typedef unsigned int SDL_TLSID;
+
+/* Create an identifier that is globally visible to all threads but refers
+   to data that is thread-specific.  This returns 0 if there is an error.
+ */
+extern DECLSPEC SDL_TLSID SDLCALL SDL_TLSCreate(void);
+
+/* Get the current thread's value associated with a TLS ID, or NULL if no
+   value has been set.
+ */
+extern DECLSPEC void * SDLCALL SDL_TLSGet(SDL_TLSID id);
+
+/* Set the current thread's value associated with a TLS ID.
+   If 'destructor' isn't NULL, it is called with the value when the thread
+   exits.  This returns 0 on success or -1 on error.
+
+   The storage of threads not created by SDL_CreateThread() is cleaned up
+   when they exit where the platform allows it, and may leak otherwise.
+ */
+extern DECLSPEC int SDLCALL SDL_TLSSet(SDL_TLSID id, const void *value, void (SDLCALL *destructor)(void*));
+
+
+/* The job system: a pool of worker threads, one for each CPU besides the
+   calling thread, which SDL uses for its own parallel work and which the
+   application can share instead of creating threads of its own.
+   The pool is started when it is first used and stopped by SDL_Quit().
+   If it has no threads, as on a single CPU, jobs run in the thread that
+   makes them ready.
+ */
+typedef void (SDLCALL *SDL_JobFunction)(void *data);
+typedef void (SDLCALL *SDL_ParallelFunction)(void *data, int first, int last);
+
+/* A job counter counts the jobs that have been run with it and haven't
+   finished yet.  Jobs can wait for a counter to reach zero before they
+   start, and threads can wait for it with SDL_WaitJobCounter().
+ */
+struct SDL_JobCounter;
+typedef struct SDL_JobCounter SDL_JobCounter;
+
+/* Create a job counter, or return NULL if there's not enough memory */
+extern DECLSPEC SDL_JobCounter * SDLCALL SDL_CreateJobCounter(void);
+
+/* Wait for the jobs of a counter to finish, then free it */
+extern DECLSPEC void SDLCALL SDL_FreeJobCounter(SDL_JobCounter *counter);
+
+/* Run 'func' with 'data' on the job pool.
+   If 'done' isn't NULL, it counts the job until it has finished.
+   If 'after' isn't NULL and counts any jobs, the job doesn't start until
+   the count reaches zero, so jobs counted by 'after' later on, before it
+   gets there, hold it up too.
+   This returns 0, or -1 if there's not enough memory for the job.
+ */
+extern DECLSPEC int SDLCALL SDL_RunJob(SDL_JobFunction func, void *data, SDL_JobCounter *done, SDL_JobCounter *after);
+
+/* Wait for the jobs counted by 'counter' to finish, running waiting jobs
+   on the calling thread in the meantime.  Jobs may call this function.
+ */
+extern DECLSPEC void SDLCALL SDL_WaitJobCounter(SDL_JobCounter *counter);
+
+/* Call 'func' for all of the items from 0 to 'count'-1, split into ranges
+   from 'first' to 'last'-1 of at most 'grain' items, on the job pool and
+   the calling thread, and return when all of them are done.  The calling
+   thread doesn't run any other jobs in the meantime.
+   A 'grain' of 0 or less picks a few ranges for each thread.
+ */
+extern DECLSPEC void SDLCALL SDL_ParallelFor(int count, int grain, SDL_ParallelFunction func, void *data);
+
+/* Return the number of threads in the job pool, starting it if needed.
+   The SDL_JOB_THREADS environment variable sets this number when the pool
+   starts, which is otherwise one less than the number of CPUs.
+ */
+extern DECLSPEC int SDLCALL SDL_GetJobThreads(void);
+
+
 /* Ends C function definitions when using C++ */
 #ifdef __cplusplus
 }
@@ -53,6 +53,41 @@ extern DECLSPEC Uint32 SDLCALL SDL_GetTicks(void);
 /* Wait a specified number of milliseconds before returning */
 extern DECLSPEC void SDLCALL SDL_Delay(Uint32 ms);
 
+#ifdef SDL_HAS_64BIT_TYPE
+/* Get the current value of a high resolution counter, which counts up
+ * SDL_GetPerformanceFrequency() times a second and doesn't change when
+ * the time of day is set.  Only the difference between two values means
+ * anything, for example:
+ *   Uint64 start = SDL_GetPerformanceCounter();
+ *   ...
+ *   double seconds = (double)(Sint64)(SDL_GetPerformanceCounter() - start)
+ *                    / (Sint64)SDL_GetPerformanceFrequency();
+ */
+extern DECLSPEC Uint64 SDLCALL SDL_GetPerformanceCounter(void);
+
+/* Get the number of counts per second of the high resolution counter */
+extern DECLSPEC Uint64 SDLCALL SDL_GetPerformanceFrequency(void);
+
+/* Get the number of nanoseconds since the SDL library initialization,
+ * counted on the high resolution counter.
+ */
+extern DECLSPEC Uint64 SDLCALL SDL_GetTicksNS(void);
+
+/* Wait until SDL_GetTicksNS() reaches 'deadline', and return how many
+ * nanoseconds after it the wait ended, to keep track of the jitter.
+ * Deadlines that have passed return at once.  A frame limiter can wait
+ * for each frame's deadline in turn without the error adding up:
+ *   next += 16666667;
+ *   SDL_DelayUntilNS(next, 1);
+ *
+ * If 'spin' is non-zero, the wait stops sleeping a little early and uses
+ * the CPU for the rest of the time.  How early is learned from how late
+ * the OS has woken up from previous sleeps, usually some tens of
+ * microseconds and never more than 2 ms.
+ */
+extern DECLSPEC Sint64 SDLCALL SDL_DelayUntilNS(Uint64 deadline, int spin);
+#endif /* SDL_HAS_64BIT_TYPE */
+
 /* Function prototype for the timer callback function */
 typedef Uint32 (SDLCALL *SDL_TimerCallback)(Uint32 interval);
 
@@ -68,11 +103,13 @@ typedef Uint32 (SDLCALL *SDL_TimerCallback)(Uint32 interval);
  * The timer callback function may run in a different thread than your
  * main code, and so shouldn't call any functions from within itself.
  *
- * The maximum resolution of this timer is 10 ms, which means that if
- * you request a 16 ms timer, your callback will run approximately 20 ms
- * later on an unloaded system.  If you wanted to set a flag signaling
- * a frame update at 30 frames per second (every 33 ms), you might set a 
- * timer for 30 ms:
+ * Where threads are available the timers are run by a thread that sleeps
+ * until the next one is due, and the resolution is that of the OS sleep,
+ * usually a millisecond.  Otherwise the maximum resolution of this timer
+ * is 10 ms, which means that if you request a 16 ms timer, your callback
+ * will run approximately 20 ms later on an unloaded system.  If you wanted
+ * to set a flag signaling a frame update at 30 frames per second (every
+ * 33 ms), you might set a timer for 30 ms:
  *   SDL_SetTimer((33/10)*10, flag_update);
  *
  * If you use this function, you need to pass SDL_INIT_TIMER to SDL_Init().
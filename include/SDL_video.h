@@ -365,6 +365,39 @@ extern DECLSPEC void SDLCALL SDL_UpdateRects
 extern DECLSPEC void SDLCALL SDL_UpdateRect
 		(SDL_Surface *screen, Sint32 x, Sint32 y, Uint32 w, Uint32 h);
 
+/*
+ * This function turns merging of the rectangles passed to SDL_UpdateRects()
+ * on or off.  When it is on, overlapping and touching rectangles are merged
+ * so that no pixel is updated twice.  If the rectangles left cover at least
+ * 'bounding_percent' percent of their bounding box, the bounding box is
+ * updated instead, and if the bounding box covers at least 'full_percent'
+ * percent of the screen, the whole screen is updated.  Passing 0 for either
+ * percentage selects a default value.
+ * Merging is off unless the SDL_UPDATE_COALESCE environment variable is set
+ * to 1 when the video subsystem is initialized.
+ */
+extern DECLSPEC void SDLCALL SDL_SetUpdateCoalescing
+		(int enable, int bounding_percent, int full_percent);
+
+/* Counters describing the work done by SDL_UpdateRects() */
+typedef struct SDL_UpdateStats {
+	Uint32 updates;		/* Calls to SDL_UpdateRects() */
+	Uint32 rects_in;	/* Rectangles passed to SDL_UpdateRects() */
+	Uint32 rects_out;	/* Rectangles actually updated */
+	Uint32 pixels_in;	/* Total area of the rectangles passed in */
+	Uint32 pixels_out;	/* Total area actually updated */
+	Uint32 bounding_box;	/* Updates done as one bounding box */
+	Uint32 full_screen;	/* Updates done as a full screen update */
+} SDL_UpdateStats;
+
+/*
+ * This function fills in 'stats' with the counters for the screen updates
+ * done so far, and clears the counters if 'reset' is non-zero.  The ratio
+ * of 'pixels_in' to 'pixels_out' shows how much overdraw was avoided.
+ * 'stats' may be NULL, to just reset the counters.
+ */
+extern DECLSPEC void SDLCALL SDL_GetUpdateStats(SDL_UpdateStats *stats, int reset);
+
 /*
  * On hardware that supports double-buffering, this function sets up a flip
  * and returns.  The hardware will wait for vertical retrace, and then swap
@@ -377,6 +410,25 @@ extern DECLSPEC void SDLCALL SDL_UpdateRect
  */
 extern DECLSPEC int SDLCALL SDL_Flip(SDL_Surface *screen);
 
+/*
+ * When the video surface has a different format than the one requested,
+ * SDL_Flip() converts the whole screen before it returns.  This function
+ * moves that work to a separate present thread: SDL_Flip() copies the
+ * screen into one of 'frames' buffers and returns at once, blocking only
+ * if all of them are still waiting to be presented.  Passing 0 turns
+ * asynchronous flips off again.  It has no effect on screens that are
+ * displayed directly, and can also be enabled by setting the environment
+ * variable SDL_ASYNC_PRESENT to the number of frames before video init.
+ * Other functions that change the screen wait for pending flips first.
+ * This function returns 0 if successful, or -1 if there was an error.
+ */
+extern DECLSPEC int SDLCALL SDL_SetAsyncPresent(int frames);
+
+/*
+ * Wait until every asynchronous SDL_Flip() has reached the display.
+ */
+extern DECLSPEC void SDLCALL SDL_WaitPresent(void);
+
 /*
  * Set the gamma correction for each of the color channels.
  * The gamma values range (approximately) between 0.1 and 10.0
@@ -710,6 +762,20 @@ extern DECLSPEC int SDLCALL SDL_LowerBlit
 			(SDL_Surface *src, SDL_Rect *srcrect,
 			 SDL_Surface *dst, SDL_Rect *dstrect);
 
+/*
+ * This function lets large software blits run on several threads.
+ * Blits covering at least 'min_pixels' destination pixels are split into
+ * bands of rows which are converted in parallel by 'threads' threads,
+ * including the calling thread, from the job pool in SDL_thread.h.
+ * The number of threads is limited to the size of the pool plus one.
+ * A 'min_pixels' of 0 selects the default threshold, and 'threads' <= 1
+ * turns parallel blitting off again.
+ * The SDL_BLIT_THREADS and SDL_BLIT_THREAD_PIXELS environment variables
+ * set the same values when the video subsystem is initialized.
+ * This function returns the number of threads that will be used.
+ */
+extern DECLSPEC int SDLCALL SDL_SetBlitThreads(int threads, Uint32 min_pixels);
+
 /*
  * This function performs a fast fill of the given rectangle with 'color'
  * The given rectangle is clipped to the destination surface clip area
@@ -890,6 +956,29 @@ extern DECLSPEC SDL_GrabMode SDLCALL SDL_WM_GrabInput(SDL_GrabMode mode);
 /* Not in public API at the moment - do not use! */
 extern DECLSPEC int SDLCALL SDL_SoftStretch(SDL_Surface *src, SDL_Rect *srcrect,
                                     SDL_Surface *dst, SDL_Rect *dstrect);
+
+/* Filters for SDL_SoftStretchFilter() */
+#define SDL_STRETCH_NEAREST	0	/* Repeat or skip source pixels */
+#define SDL_STRETCH_BILINEAR	1	/* Interpolate between source pixels */
+#define SDL_STRETCH_BOX		2	/* Average the source area covered */
+
+/*
+ * This function scales the source rectangle of 'src' into the destination
+ * rectangle of 'dst' in software, using one of the filters above.
+ * SDL_STRETCH_BOX gives the best quality when shrinking an image.
+ * The surfaces may have different pixel formats; the pixels are then
+ * converted as they are written, as with SDL_BlitSurface().  Color keys
+ * and per-surface alpha are ignored, but an alpha channel is scaled along
+ * with the color channels.  Surfaces of less than 8 bits per pixel are
+ * only supported with SDL_STRETCH_NEAREST and matching depths.
+ * The rectangles must lie inside the surfaces; they are not clipped.
+ * This function may be called from several threads at once, as long as
+ * they write to different surfaces and any source they share doesn't need
+ * locking (see SDL_MUSTLOCK()).
+ * It returns 0 on success, or -1 if there was an error.
+ */
+extern DECLSPEC int SDLCALL SDL_SoftStretchFilter(SDL_Surface *src, SDL_Rect *srcrect,
+                                    SDL_Surface *dst, SDL_Rect *dstrect, int filter);
                     
 /* Ends C function definitions when using C++ */
 #ifdef __cplusplus
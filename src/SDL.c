@@ -50,9 +50,13 @@ extern void SDL_CDROMQuit(void);
 #endif
 #ifndef DISABLE_TIMERS
 extern void SDL_StartTicks(void);
+#ifdef SDL_HAS_64BIT_TYPE
+extern void SDL_StartTicksNS(void);
+#endif
 extern int  SDL_TimerInit(void);
 extern void SDL_TimerQuit(void);
 #endif
+extern void SDL_QuitJobs(void);
 
 /* The current SDL version */
 static SDL_version version = 
@@ -103,6 +107,9 @@ int SDL_InitSubSystem(Uint32 flags)
 	/* Initialize the timer subsystem */
 	if ( ! ticks_started ) {
 		SDL_StartTicks();
+#ifdef SDL_HAS_64BIT_TYPE
+		SDL_StartTicksNS();
+#endif
 		ticks_started = 1;
 	}
 	if ( (flags & SDL_INIT_TIMER) && !(SDL_initialized & SDL_INIT_TIMER) ) {
@@ -222,6 +229,9 @@ void SDL_Quit(void)
 	/* Quit all subsystems */
 	SDL_QuitSubSystem(SDL_INIT_EVERYTHING);
 
+	/* Stop the job pool, once the subsystems don't need it */
+	SDL_QuitJobs();
+
 #ifdef CHECK_LEAKS
 	/* Print the number of surfaces not freed */
 	if ( surfaces_allocated != 0 ) {
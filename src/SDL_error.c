@@ -51,8 +51,6 @@ static SDL_error SDL_global_error;
 #define DISABLE_STDIO
 #endif
 
-#define SDL_ERRBUFIZE	1024
-
 /* Private functions */
 
 static void SDL_LookupString(const Uint8 *key, Uint16 *buf, int buflen)
@@ -294,9 +292,11 @@ Uint8 *SDL_GetErrorMsg(Uint8 *errstr, unsigned int maxlen)
 /* Available for backwards compatibility */
 char *SDL_GetError (void)
 {
-	static char errmsg[SDL_ERRBUFIZE];
+	SDL_error *error;
 
-	return((char *)SDL_GetErrorMsg((unsigned char *)errmsg, SDL_ERRBUFIZE));
+	/* Format the message in the thread's own buffer */
+	error = SDL_GetErrBuf();
+	return((char *)SDL_GetErrorMsg(error->msg, SDL_ERRBUFIZE));
 }
 
 void SDL_ClearError(void)
@@ -34,6 +34,7 @@ static char rcsid =
 
 #define ERR_MAX_STRLEN	128
 #define ERR_MAX_ARGS	5
+#define SDL_ERRBUFIZE	1024
 
 typedef struct {
 	/* This is a numeric value corresponding to the current error */
@@ -57,6 +58,9 @@ typedef struct {
 		double value_f;
 		unsigned char buf[ERR_MAX_STRLEN];
 	} args[ERR_MAX_ARGS];
+
+	/* This is where SDL_GetError() prints the message */
+	unsigned char msg[SDL_ERRBUFIZE];
 } SDL_error;
 
 #endif /* _SDL_error_c_h */
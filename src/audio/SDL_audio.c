@@ -37,6 +37,8 @@ static char rcsid =
 #include "SDL_audio_c.h"
 #include "SDL_audiomem.h"
 #include "SDL_sysaudio.h"
+#include "SDL_resample_c.h"
+#include "SDL_audioqueue_c.h"
 
 /* Available audio drivers */
 static AudioBootStrap *bootstrap[] = {
@@ -117,6 +119,168 @@ void SDL_AudioQuit(void);
 static int audio_configured = 0;
 #endif
 
+/* A microsecond clock for timing the audio thread, it only counts up */
+static Uint32 SDL_AudioMicroseconds(void)
+{
+#ifdef SDL_HAS_64BIT_TYPE
+	Uint64 now = SDL_GetPerformanceCounter();
+	Uint64 frequency = SDL_GetPerformanceFrequency();
+
+	/* Split the conversion so the multiplication can't overflow */
+	return((Uint32)((now / frequency) * 1000000 +
+	                (now % frequency) * 1000000 / frequency));
+#else
+	return(SDL_GetTicks()*1000);
+#endif
+}
+
+static void SDL_AddAudioTiming(SDL_AudioTiming *timing, double *total,
+                               Uint32 us)
+{
+	int i;
+
+	if ( (timing->count == 0) || (us < timing->min_us) ) {
+		timing->min_us = us;
+	}
+	if ( us > timing->max_us ) {
+		timing->max_us = us;
+	}
+	timing->last_us = us;
+	++timing->count;
+	*total += us;
+	timing->mean_us = (Uint32)(*total / timing->count);
+	for ( i=0; (i < SDL_AUDIO_HISTOGRAM_SIZE-1) && (us >= (16u<<i)); ++i ) {
+		/* Find the bucket */;
+	}
+	++timing->histogram[i];
+}
+
+/* Add the trace of the buffer just done to the statistics, and start
+   the next one */
+static void SDL_AudioCommitStats(SDL_AudioDevice *audio, int converted)
+{
+	SDL_AudioStats *stats = &audio->stats;
+	SDL_AudioTrace *trace = &audio->trace;
+	void (*hook)(void *userdata, const SDL_AudioTrace *trace);
+	void *userdata;
+	Uint32 sequence;
+
+	SDL_mutexP(audio->stats_lock);
+	if ( trace->dropped ) {
+		++stats->dropped;
+	} else {
+		++stats->buffers;
+	}
+	if ( trace->silent ) {
+		++stats->silent;
+	} else {
+		SDL_AddAudioTiming(&stats->callback, &audio->stats_total[1],
+		                   trace->callback_us);
+	}
+	if ( trace->starved ) {
+		++stats->starved;
+	}
+	stats->xruns += trace->xruns;
+	SDL_AddAudioTiming(&stats->wait, &audio->stats_total[0],
+	                   trace->wait_us);
+	if ( converted ) {
+		SDL_AddAudioTiming(&stats->convert, &audio->stats_total[2],
+		                   trace->convert_us);
+	}
+	hook = audio->trace_hook;
+	userdata = audio->trace_userdata;
+	SDL_mutexV(audio->stats_lock);
+
+	if ( hook ) {
+		hook(userdata, trace);
+	}
+	sequence = trace->sequence + 1;
+	memset(trace, 0, sizeof(*trace));
+	trace->sequence = sequence;
+}
+
+/* Call the application for a buffer of audio */
+static void SDL_CallAudio(SDL_AudioDevice *audio,
+                          void (*fill)(void *userdata, Uint8 *stream, int len),
+                          void *udata, Uint8 *stream, int len)
+{
+	Uint32 start;
+
+	if ( audio->paused ) {
+		/* Leave the silence */
+		audio->trace.silent = 1;
+		return;
+	}
+	start = SDL_AudioMicroseconds();
+	if ( audio->queue ) {
+		(*fill)(udata, stream, len);
+	} else {
+		SDL_mutexP(audio->mixer_lock);
+		(*fill)(udata, stream, len);
+		SDL_mutexV(audio->mixer_lock);
+	}
+	audio->trace.callback_us += SDL_AudioMicroseconds() - start;
+}
+
+/* Fill a device buffer through the resampler, calling back as many times
+   as it takes to get a full buffer at the hardware rate */
+static void SDL_FillResampled(SDL_AudioDevice *audio, Uint8 *stream,
+                              void (*fill)(void *userdata,Uint8 *stream,
+                                           int len),
+                              void *udata, int silence)
+{
+	SDL_Resampler *resampler = audio->resampler;
+	int framesize = (audio->spec.format & 0xFF) / 8 * audio->spec.channels;
+	int len, got;
+	Uint32 start;
+
+	while ( SDL_ResamplerAvailable(resampler) < audio->spec.samples ) {
+		memset(audio->convert.buf, silence, audio->convert.len);
+		SDL_CallAudio(audio, fill, udata,
+		              audio->convert.buf, audio->convert.len);
+		start = SDL_AudioMicroseconds();
+		len = audio->convert.len;
+		if ( audio->convert.needed ) {
+			SDL_ConvertAudio(&audio->convert);
+			len = audio->convert.len_cvt;
+		}
+		got = SDL_ResamplerPut(resampler, audio->convert.buf,
+		                       len / framesize);
+		audio->trace.convert_us += SDL_AudioMicroseconds() - start;
+		if ( got < 0 ) {
+			break;
+		}
+	}
+	start = SDL_AudioMicroseconds();
+	got = SDL_ResamplerGet(resampler, stream, audio->spec.samples);
+	if ( got < audio->spec.samples ) {
+		memset(stream + got*framesize, audio->spec.silence,
+		       (audio->spec.samples - got)*framesize);
+	}
+	audio->trace.convert_us += SDL_AudioMicroseconds() - start;
+}
+
+/* The callback taking audio from SDL_QueueAudio().  The queue doesn't
+   need the mixer lock, only the low water callback runs with it held.
+ */
+static void SDL_DequeueAudio(void *udata, Uint8 *stream, int len)
+{
+	SDL_AudioDevice *audio = (SDL_AudioDevice *)udata;
+	Uint32 queued;
+
+	if ( SDL_AudioQueueGet(audio->queue, stream, len) < (Uint32)len ) {
+		audio->trace.starved = 1;
+	}
+	queued = SDL_AudioQueueSize(audio->queue);
+	if ( queued < audio->queue_lowwater ) {
+		SDL_mutexP(audio->mixer_lock);
+		if ( audio->queue_callback ) {
+			audio->queue_callback(audio->queue_userdata, queued);
+		}
+		SDL_mutexV(audio->mixer_lock);
+	}
+}
+
 /* The general mixing thread function */
 int SDL_RunAudio(void *audiop)
 {
@@ -126,6 +290,7 @@ int SDL_RunAudio(void *audiop)
 	void  *udata;
 	void (*fill)(void *userdata,Uint8 *stream, int len);
 	int    silence;
+	Uint32 start;
 #ifdef ENABLE_AHI
 	int started = 0;
 
@@ -183,6 +348,7 @@ int SDL_RunAudio(void *audiop)
 	while ( audio->enabled ) {
 
 		/* Wait for new current buffer to finish playing */
+		start = SDL_AudioMicroseconds();
 		if ( stream == audio->fake_stream ) {
 			SDL_Delay((audio->spec.samples*1000)/audio->spec.freq);
 		} else {
@@ -191,37 +357,44 @@ int SDL_RunAudio(void *audiop)
 #endif
 			audio->WaitAudio(audio);
 		}
+		audio->trace.wait_us = SDL_AudioMicroseconds() - start;
 
 		/* Fill the current buffer with sound */
-		if ( audio->convert.needed ) {
-			if ( audio->convert.buf ) {
-				stream = audio->convert.buf;
-			} else {
-				continue;
-			}
-		} else {
+		if ( audio->resampler ) {
 			stream = audio->GetAudioBuf(audio);
 			if ( stream == NULL ) {
 				stream = audio->fake_stream;
 			}
-		}
-		memset(stream, silence, stream_len);
-
-		if ( ! audio->paused ) {
-			SDL_mutexP(audio->mixer_lock);
-			(*fill)(udata, stream, stream_len);
-			SDL_mutexV(audio->mixer_lock);
-		}
+			SDL_FillResampled(audio, stream, fill, udata, silence);
+		} else {
+			if ( audio->convert.needed ) {
+				if ( audio->convert.buf ) {
+					stream = audio->convert.buf;
+				} else {
+					continue;
+				}
+			} else {
+				stream = audio->GetAudioBuf(audio);
+				if ( stream == NULL ) {
+					stream = audio->fake_stream;
+				}
+			}
+			memset(stream, silence, stream_len);
+			SDL_CallAudio(audio, fill, udata, stream, stream_len);
 
-		/* Convert the audio if necessary */
-		if ( audio->convert.needed ) {
-			SDL_ConvertAudio(&audio->convert);
-			stream = audio->GetAudioBuf(audio);
-			if ( stream == NULL ) {
-				stream = audio->fake_stream;
+			/* Convert the audio if necessary */
+			if ( audio->convert.needed ) {
+				start = SDL_AudioMicroseconds();
+				SDL_ConvertAudio(&audio->convert);
+				audio->trace.convert_us =
+					SDL_AudioMicroseconds() - start;
+				stream = audio->GetAudioBuf(audio);
+				if ( stream == NULL ) {
+					stream = audio->fake_stream;
+				}
+				memcpy(stream, audio->convert.buf,
+				               audio->convert.len_cvt);
 			}
-			memcpy(stream, audio->convert.buf,
-			               audio->convert.len_cvt);
 		}
 
 		/* Ready current buffer for play and change current buffer */
@@ -231,7 +404,11 @@ int SDL_RunAudio(void *audiop)
 /* AmigaOS don't have to wait the first time audio is played! */
 			started++;
 #endif
+		} else {
+			audio->trace.dropped = 1;
 		}
+		SDL_AudioCommitStats(audio,
+		           (audio->convert.needed || audio->resampler));
 	}
 	/* Wait for the audio to drain.. */
 	if ( audio->WaitDone ) {
@@ -381,16 +558,15 @@ int SDL_OpenAudio(SDL_AudioSpec *desired, SDL_AudioSpec *obtained)
 	}
 
 	/* Verify some parameters */
-	if ( desired->callback == NULL ) {
-		SDL_SetError("SDL_OpenAudio() passed a NULL callback");
-		return(-1);
-	}
 	switch ( desired->channels ) {
 	    case 1:	/* Mono */
 	    case 2:	/* Stereo */
+	    case 4:	/* Quad */
+	    case 6:	/* 5.1 */
+	    case 8:	/* 7.1 */
 		break;
 	    default:
-		SDL_SetError("1 (mono) and 2 (stereo) channels supported");
+		SDL_SetError("1, 2, 4, 6 and 8 channels supported");
 		return(-1);
 	}
 
@@ -407,6 +583,12 @@ int SDL_OpenAudio(SDL_AudioSpec *desired, SDL_AudioSpec *obtained)
 		SDL_CloseAudio();
 		return(-1);
 	}
+	audio->stats_lock = SDL_CreateMutex();
+	if ( audio->stats_lock == NULL ) {
+		SDL_SetError("Couldn't create statistics lock");
+		SDL_CloseAudio();
+		return(-1);
+	}
 #endif /* __MINT__ */
 #endif /* macintosh */
 
@@ -471,16 +653,36 @@ int SDL_OpenAudio(SDL_AudioSpec *desired, SDL_AudioSpec *obtained)
 		if ( obtained != NULL ) {
 			memcpy(obtained, &audio->spec, sizeof(audio->spec));
 		} else {
-			/* Build an audio conversion block */
+#ifndef ENABLE_AHI
+			/* The audio thread converts the rate as a stream, so
+			   it can call back as often as it needs to.  Drivers
+			   that call back by themselves get one fixed size
+			   buffer per callback, which can't carry the rate.
+			 */
+			if ( (audio->opened == 1) &&
+			     (desired->freq != audio->spec.freq) ) {
+				audio->resampler = SDL_CreateResampler(
+					audio->spec.format, audio->spec.channels,
+					desired->freq, audio->spec.freq);
+				if ( audio->resampler == NULL ) {
+					SDL_CloseAudio();
+					return(-1);
+				}
+			}
+#endif
+			/* Build an audio conversion block, which converts the
+			   rate too unless the resampler does it
+			 */
 			if ( SDL_BuildAudioCVT(&audio->convert,
 				desired->format, desired->channels,
+				audio->resampler ? audio->spec.freq :
 						desired->freq,
 				audio->spec.format, audio->spec.channels,
 						audio->spec.freq) < 0 ) {
 				SDL_CloseAudio();
 				return(-1);
 			}
-			if ( audio->convert.needed ) {
+			if ( audio->convert.needed || audio->resampler ) {
 				audio->convert.len = desired->size;
 				audio->convert.buf =(Uint8 *)SDL_AllocAudioMem(
 				   audio->convert.len*audio->convert.len_mult);
@@ -493,6 +695,27 @@ int SDL_OpenAudio(SDL_AudioSpec *desired, SDL_AudioSpec *obtained)
 		}
 	}
 
+	/* Without a callback, the application queues the audio instead */
+	if ( desired->callback == NULL ) {
+		Uint32 size;
+
+		size = desired->freq * ((desired->format & 0xFF) / 8) *
+		       desired->channels;
+		if ( size < 4*desired->size ) {
+			size = 4*desired->size;
+		}
+		audio->queue = SDL_CreateAudioQueue(size,
+		       ((desired->format & 0xFF) / 8) * desired->channels,
+		       desired->silence);
+		if ( audio->queue == NULL ) {
+			SDL_CloseAudio();
+			SDL_OutOfMemory();
+			return(-1);
+		}
+		audio->spec.callback = SDL_DequeueAudio;
+		audio->spec.userdata = audio;
+	}
+
 #ifndef ENABLE_AHI
 	/* Start the audio thread if necessary */
 	switch (audio->opened) {
@@ -564,6 +787,103 @@ void SDL_UnlockAudio (void)
 	}
 }
 
+int SDL_QueueAudio(const void *data, Uint32 len)
+{
+	SDL_AudioDevice *audio = current_audio;
+
+	if ( !audio || !audio->queue ) {
+		SDL_SetError("Audio device not opened for queuing");
+		return(-1);
+	}
+	if ( SDL_AudioQueuePut(audio->queue, data, len) < 0 ) {
+		SDL_SetError("Audio queue is full");
+		return(-1);
+	}
+	return(0);
+}
+
+Uint32 SDL_GetQueuedAudioSize(void)
+{
+	SDL_AudioDevice *audio = current_audio;
+
+	if ( !audio || !audio->queue ) {
+		return(0);
+	}
+	return(SDL_AudioQueueSize(audio->queue));
+}
+
+void SDL_ClearQueuedAudio(void)
+{
+	SDL_AudioDevice *audio = current_audio;
+
+	if ( audio && audio->queue ) {
+		SDL_AudioQueueClear(audio->queue);
+	}
+}
+
+int SDL_SetAudioQueueLowWater(Uint32 low_water,
+                              void (*callback)(void *userdata, Uint32 queued),
+                              void *userdata)
+{
+	SDL_AudioDevice *audio = current_audio;
+
+	if ( !audio || !audio->queue ) {
+		SDL_SetError("Audio device not opened for queuing");
+		return(-1);
+	}
+	SDL_LockAudio();
+	audio->queue_callback = callback;
+	audio->queue_userdata = userdata;
+	audio->queue_lowwater = callback ? low_water : 0;
+	SDL_UnlockAudio();
+	return(0);
+}
+
+void SDL_GetAudioStats(SDL_AudioStats *stats, int reset)
+{
+	SDL_AudioDevice *audio = current_audio;
+
+	if ( ! audio ) {
+		if ( stats ) {
+			memset(stats, 0, sizeof(*stats));
+		}
+		return;
+	}
+	SDL_mutexP(audio->stats_lock);
+	if ( stats ) {
+		*stats = audio->stats;
+	}
+	if ( reset ) {
+		memset(&audio->stats, 0, sizeof(audio->stats));
+		memset(audio->stats_total, 0, sizeof(audio->stats_total));
+	}
+	SDL_mutexV(audio->stats_lock);
+}
+
+void SDL_SetAudioTraceHook(void (*hook)(void *userdata,
+                                        const SDL_AudioTrace *trace),
+                           void *userdata)
+{
+	SDL_AudioDevice *audio = current_audio;
+
+	if ( audio ) {
+		SDL_mutexP(audio->stats_lock);
+		audio->trace_hook = hook;
+		audio->trace_userdata = userdata;
+		SDL_mutexV(audio->stats_lock);
+	}
+}
+
+/* This is called by the driver in the audio thread, while it plays */
+void SDL_AudioXrun(void)
+{
+	SDL_AudioDevice *audio = current_audio;
+
+	if ( audio ) {
+		++audio->trace.xruns;
+	}
+}
+
 void SDL_CloseAudio (void)
 {
 	SDL_QuitSubSystem(SDL_INIT_AUDIO);
@@ -581,12 +901,23 @@ void SDL_AudioQuit(void)
 		if ( audio->mixer_lock != NULL ) {
 			SDL_DestroyMutex(audio->mixer_lock);
 		}
+		if ( audio->stats_lock != NULL ) {
+			SDL_DestroyMutex(audio->stats_lock);
+		}
 		if ( audio->fake_stream != NULL ) {
 			SDL_FreeAudioMem(audio->fake_stream);
 		}
-		if ( audio->convert.needed ) {
+		if ( audio->convert.buf != NULL ) {
 			SDL_FreeAudioMem(audio->convert.buf);
-
+			audio->convert.buf = NULL;
+		}
+		if ( audio->resampler != NULL ) {
+			SDL_FreeResampler(audio->resampler);
+			audio->resampler = NULL;
+		}
+		if ( audio->queue != NULL ) {
+			SDL_FreeAudioQueue(audio->queue);
+			audio->queue = NULL;
 		}
 #ifndef ENABLE_AHI
 		if ( audio->opened ) {
@@ -600,16 +931,30 @@ void SDL_AudioQuit(void)
 	}
 }
 
-#define NUM_FORMATS	6
+#define NUM_FORMATS	10
 static int format_idx;
 static int format_idx_sub;
 static Uint16 format_list[NUM_FORMATS][NUM_FORMATS] = {
- { AUDIO_U8, AUDIO_S8, AUDIO_S16LSB, AUDIO_S16MSB, AUDIO_U16LSB, AUDIO_U16MSB },
- { AUDIO_S8, AUDIO_U8, AUDIO_S16LSB, AUDIO_S16MSB, AUDIO_U16LSB, AUDIO_U16MSB },
- { AUDIO_S16LSB, AUDIO_S16MSB, AUDIO_U16LSB, AUDIO_U16MSB, AUDIO_U8, AUDIO_S8 },
- { AUDIO_S16MSB, AUDIO_S16LSB, AUDIO_U16MSB, AUDIO_U16LSB, AUDIO_U8, AUDIO_S8 },
- { AUDIO_U16LSB, AUDIO_U16MSB, AUDIO_S16LSB, AUDIO_S16MSB, AUDIO_U8, AUDIO_S8 },
- { AUDIO_U16MSB, AUDIO_U16LSB, AUDIO_S16MSB, AUDIO_S16LSB, AUDIO_U8, AUDIO_S8 },
+ { AUDIO_U8, AUDIO_S8, AUDIO_S16LSB, AUDIO_S16MSB, AUDIO_U16LSB, AUDIO_U16MSB,
+   AUDIO_S32LSB, AUDIO_S32MSB, AUDIO_F32LSB, AUDIO_F32MSB },
+ { AUDIO_S8, AUDIO_U8, AUDIO_S16LSB, AUDIO_S16MSB, AUDIO_U16LSB, AUDIO_U16MSB,
+   AUDIO_S32LSB, AUDIO_S32MSB, AUDIO_F32LSB, AUDIO_F32MSB },
+ { AUDIO_S16LSB, AUDIO_S16MSB, AUDIO_U16LSB, AUDIO_U16MSB, AUDIO_S32LSB,
+   AUDIO_S32MSB, AUDIO_F32LSB, AUDIO_F32MSB, AUDIO_U8, AUDIO_S8 },
+ { AUDIO_S16MSB, AUDIO_S16LSB, AUDIO_U16MSB, AUDIO_U16LSB, AUDIO_S32MSB,
+   AUDIO_S32LSB, AUDIO_F32MSB, AUDIO_F32LSB, AUDIO_U8, AUDIO_S8 },
+ { AUDIO_U16LSB, AUDIO_U16MSB, AUDIO_S16LSB, AUDIO_S16MSB, AUDIO_S32LSB,
+   AUDIO_S32MSB, AUDIO_F32LSB, AUDIO_F32MSB, AUDIO_U8, AUDIO_S8 },
+ { AUDIO_U16MSB, AUDIO_U16LSB, AUDIO_S16MSB, AUDIO_S16LSB, AUDIO_S32MSB,
+   AUDIO_S32LSB, AUDIO_F32MSB, AUDIO_F32LSB, AUDIO_U8, AUDIO_S8 },
+ { AUDIO_S32LSB, AUDIO_S32MSB, AUDIO_F32LSB, AUDIO_F32MSB, AUDIO_S16LSB,
+   AUDIO_S16MSB, AUDIO_U16LSB, AUDIO_U16MSB, AUDIO_U8, AUDIO_S8 },
+ { AUDIO_S32MSB, AUDIO_S32LSB, AUDIO_F32MSB, AUDIO_F32LSB, AUDIO_S16MSB,
+   AUDIO_S16LSB, AUDIO_U16MSB, AUDIO_U16LSB, AUDIO_U8, AUDIO_S8 },
+ { AUDIO_F32LSB, AUDIO_F32MSB, AUDIO_S32LSB, AUDIO_S32MSB, AUDIO_S16LSB,
+   AUDIO_S16MSB, AUDIO_U16LSB, AUDIO_U16MSB, AUDIO_U8, AUDIO_S8 },
+ { AUDIO_F32MSB, AUDIO_F32LSB, AUDIO_S32MSB, AUDIO_S32LSB, AUDIO_S16MSB,
+   AUDIO_S16LSB, AUDIO_U16MSB, AUDIO_U16LSB, AUDIO_U8, AUDIO_S8 },
 };
 
 Uint16 SDL_FirstAudioFormat(Uint16 format)
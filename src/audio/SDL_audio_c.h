@@ -36,3 +36,6 @@ extern void SDL_CalculateAudioSpec(SDL_AudioSpec *spec);
 
 /* The actual mixing thread function */
 extern int SDL_RunAudio(void *audiop);
+
+/* Drivers call this when the hardware ran out of audio */
+extern void SDL_AudioXrun(void);
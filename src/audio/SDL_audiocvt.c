@@ -31,6 +31,11 @@ static char rcsid =
 
 #include "SDL_error.h"
 #include "SDL_audio.h"
+#include "SDL_endian.h"
+#include "SDL_audiotypecvt_c.h"
+#include "SDL_audiomatrix_c.h"
+#include "SDL_resample_c.h"
+#include "SDL_simd.h"
 
 
 /* Effectively mix right and left channels into a single channel */
@@ -50,9 +55,13 @@ void SDL_ConvertMono(SDL_AudioCVT *cvt, Uint16 format)
 			src = cvt->buf;
 			dst = cvt->buf;
 			for ( i=cvt->len_cvt/2; i; --i ) {
-				sample = src[0] + src[1];
+				/* Silence is 128, so take it out once */
+				sample = src[0] + src[1] - 128;
 				if ( sample > 255 ) {
 					*dst = 255;
+				} else
+				if ( sample < 0 ) {
+					*dst = 0;
 				} else {
 					*dst = sample;
 				}
@@ -91,10 +100,15 @@ void SDL_ConvertMono(SDL_AudioCVT *cvt, Uint16 format)
 			if ( (format & 0x1000) == 0x1000 ) {
 				for ( i=cvt->len_cvt/4; i; --i ) {
 					sample = (Uint16)((src[0]<<8)|src[1])+
-					         (Uint16)((src[2]<<8)|src[3]);
+					         (Uint16)((src[2]<<8)|src[3])-
+					         32768;
 					if ( sample > 65535 ) {
 						dst[0] = 0xFF;
 						dst[1] = 0xFF;
+					} else
+					if ( sample < 0 ) {
+						dst[0] = 0x00;
+						dst[1] = 0x00;
 					} else {
 						dst[1] = (sample&0xFF);
 						sample >>= 8;
@@ -106,10 +120,15 @@ void SDL_ConvertMono(SDL_AudioCVT *cvt, Uint16 format)
 			} else {
 				for ( i=cvt->len_cvt/4; i; --i ) {
 					sample = (Uint16)((src[1]<<8)|src[0])+
-					         (Uint16)((src[3]<<8)|src[2]);
+					         (Uint16)((src[3]<<8)|src[2])-
+					         32768;
 					if ( sample > 65535 ) {
 						dst[0] = 0xFF;
 						dst[1] = 0xFF;
+					} else
+					if ( sample < 0 ) {
+						dst[0] = 0x00;
+						dst[1] = 0x00;
 					} else {
 						dst[0] = (sample&0xFF);
 						sample >>= 8;
@@ -337,147 +356,298 @@ void SDL_ConvertEndian(SDL_AudioCVT *cvt, Uint16 format)
 	}
 }
 
-/* Convert rate up by multiple of 2 */
-void SDL_RateMUL2(SDL_AudioCVT *cvt, Uint16 format)
+/* Floating point samples are read and written through this, so swapping
+   their bytes never goes through a float register */
+typedef union {
+	Uint32 u;
+	float f;
+} SDL_FloatBits;
+
+#ifdef SDL_SSE2_INTRINSICS
+/* These work from the end of the buffer back, since the samples grow */
+SDL_TARGETING("sse2")
+static void S16ToFloatSSE2(const Sint16 *src, float *dst, int samples)
 {
+	const __m128i *in;
+	__m128 *out;
+	__m128i x;
 	int i;
-	Uint8 *src, *dst;
 
-#ifdef DEBUG_CONVERT
-	fprintf(stderr, "Converting audio rate * 2\n");
-#endif
-	src = cvt->buf+cvt->len_cvt;
-	dst = cvt->buf+cvt->len_cvt*2;
-	switch (format & 0xFF) {
-		case 8:
-			for ( i=cvt->len_cvt; i; --i ) {
-				src -= 1;
-				dst -= 2;
-				dst[0] = src[0];
-				dst[1] = src[0];
-			}
-			break;
-		case 16:
-			for ( i=cvt->len_cvt/2; i; --i ) {
-				src -= 2;
-				dst -= 4;
-				dst[0] = src[0];
-				dst[1] = src[1];
-				dst[2] = src[0];
-				dst[3] = src[1];
-			}
-			break;
+	for ( i=samples-8; i>=0; i-=8 ) {
+		in = (const __m128i *)(src+i);
+		out = (__m128 *)(dst+i);
+		x = _mm_loadu_si128(in);
+		_mm_storeu_ps((float *)(out+1), _mm_mul_ps(_mm_cvtepi32_ps(
+			_mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16)),
+			_mm_set1_ps(1.0f/32768)));
+		_mm_storeu_ps((float *)out, _mm_mul_ps(_mm_cvtepi32_ps(
+			_mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16)),
+			_mm_set1_ps(1.0f/32768)));
 	}
-	cvt->len_cvt *= 2;
-	if ( cvt->filters[++cvt->filter_index] ) {
-		cvt->filters[cvt->filter_index](cvt, format);
+}
+
+SDL_TARGETING("sse2")
+static void S32ToFloatSSE2(const Sint32 *src, float *dst, int samples)
+{
+	__m128i x;
+	int i;
+
+	for ( i=samples-4; i>=0; i-=4 ) {
+		x = _mm_loadu_si128((const __m128i *)(src+i));
+		_mm_storeu_ps(dst+i, _mm_mul_ps(_mm_cvtepi32_ps(x),
+		                     _mm_set1_ps(1.0f/2147483648.0f)));
 	}
 }
 
-/* Convert rate down by multiple of 2 */
-void SDL_RateDIV2(SDL_AudioCVT *cvt, Uint16 format)
+/* These work from the front, the same way as the C code below */
+SDL_TARGETING("sse2")
+static void FloatToS16SSE2(const float *src, Sint16 *dst, int samples)
 {
+	const __m128 scale = _mm_set1_ps(32768.0f);
+	const __m128 bias = _mm_set1_ps(32768.5f);
+	const __m128 top = _mm_set1_ps(65535.0f);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128i half = _mm_set1_epi32(32768);
+	__m128i a, b;
 	int i;
-	Uint8 *src, *dst;
+
+	for ( i=0; i+8<=samples; i+=8 ) {
+		a = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(_mm_add_ps(
+			_mm_mul_ps(_mm_loadu_ps(src+i), scale), bias), zero), top));
+		b = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(_mm_add_ps(
+			_mm_mul_ps(_mm_loadu_ps(src+i+4), scale), bias), zero), top));
+		a = _mm_sub_epi32(a, half);
+		b = _mm_sub_epi32(b, half);
+		_mm_storeu_si128((__m128i *)(dst+i), _mm_packs_epi32(a, b));
+	}
+}
+
+/* Conversion overflows to 0x80000000, which the mask flips to 0x7FFFFFFF */
+SDL_TARGETING("sse2")
+static void FloatToS32SSE2(const float *src, Sint32 *dst, int samples)
+{
+	const __m128 scale = _mm_set1_ps(2147483648.0f);
+	const __m128 one = _mm_set1_ps(1.0f);
+	__m128 x;
+	__m128i v;
+	int i;
+
+	for ( i=0; i+4<=samples; i+=4 ) {
+		x = _mm_loadu_ps(src+i);
+		v = _mm_cvttps_epi32(_mm_mul_ps(x, scale));
+		v = _mm_xor_si128(v, _mm_castps_si128(_mm_cmpge_ps(x, one)));
+		_mm_storeu_si128((__m128i *)(dst+i), v);
+	}
+}
+#endif /* SDL_SSE2_INTRINSICS */
+
+/* Convert any format to native floating point samples */
+void SDL_ConvertToFloat(SDL_AudioCVT *cvt, Uint16 format)
+{
+	float *dst;
+	SDL_FloatBits bits;
+	Uint16 u16;
+	Uint32 u32;
+	int i, samples, vec;
 
 #ifdef DEBUG_CONVERT
-	fprintf(stderr, "Converting audio rate / 2\n");
+	fprintf(stderr, "Converting to float\n");
 #endif
-	src = cvt->buf;
-	dst = cvt->buf;
-	switch (format & 0xFF) {
-		case 8:
-			for ( i=cvt->len_cvt/2; i; --i ) {
-				dst[0] = src[0];
-				src += 2;
-				dst += 1;
+	samples = cvt->len_cvt / ((format & 0xFF) / 8);
+	dst = (float *)cvt->buf;
+
+	/* The samples grow, so the C code converts the end of the buffer
+	   first and then the vector code does the rest */
+	vec = 0;
+#ifdef SDL_SSE2_INTRINSICS
+	if ( SDL_HasSSE2() &&
+	     ((format == AUDIO_S16SYS) || (format == AUDIO_S32SYS)) ) {
+		vec = samples & ~7;
+	}
+#endif
+	switch (format) {
+		case AUDIO_U8: {
+			Uint8 *src = cvt->buf;
+
+			for ( i=samples-1; i>=vec; --i ) {
+				dst[i] = (src[i] - 128) * (1.0f/128);
+			}
+		}
+		break;
+
+		case AUDIO_S8: {
+			Sint8 *src = (Sint8 *)cvt->buf;
+
+			for ( i=samples-1; i>=vec; --i ) {
+				dst[i] = src[i] * (1.0f/128);
 			}
-			break;
-		case 16:
-			for ( i=cvt->len_cvt/4; i; --i ) {
-				dst[0] = src[0];
-				dst[1] = src[1];
-				src += 4;
-				dst += 2;
+		}
+		break;
+
+		case AUDIO_U16LSB:
+		case AUDIO_U16MSB:
+		case AUDIO_S16LSB:
+		case AUDIO_S16MSB: {
+			Uint16 *src = (Uint16 *)cvt->buf;
+
+			for ( i=samples-1; i>=vec; --i ) {
+				u16 = src[i];
+				if ( format & 0x1000 ) {
+					u16 = SDL_SwapBE16(u16);
+				} else {
+					u16 = SDL_SwapLE16(u16);
+				}
+				if ( format & 0x8000 ) {
+					dst[i] = (Sint16)u16 * (1.0f/32768);
+				} else {
+					dst[i] = (u16 - 32768) * (1.0f/32768);
+				}
+			}
+		}
+		break;
+
+		case AUDIO_S32LSB:
+		case AUDIO_S32MSB:
+		case AUDIO_F32LSB:
+		case AUDIO_F32MSB: {
+			Uint32 *src = (Uint32 *)cvt->buf;
+
+			for ( i=samples-1; i>=vec; --i ) {
+				u32 = src[i];
+				if ( format & 0x1000 ) {
+					u32 = SDL_SwapBE32(u32);
+				} else {
+					u32 = SDL_SwapLE32(u32);
+				}
+				if ( format & 0x0100 ) {
+					bits.u = u32;
+					dst[i] = bits.f;
+				} else {
+					dst[i] = (Sint32)u32 *
+					         (1.0f/2147483648.0f);
+				}
 			}
-			break;
+		}
+		break;
 	}
-	cvt->len_cvt /= 2;
+#ifdef SDL_SSE2_INTRINSICS
+	if ( vec ) {
+		if ( format == AUDIO_S16SYS ) {
+			S16ToFloatSSE2((Sint16 *)cvt->buf, dst, vec);
+		} else {
+			S32ToFloatSSE2((Sint32 *)cvt->buf, dst, vec);
+		}
+	}
+#endif
+	cvt->len_cvt = samples * sizeof(float);
+	format = AUDIO_F32SYS;
 	if ( cvt->filters[++cvt->filter_index] ) {
 		cvt->filters[cvt->filter_index](cvt, format);
 	}
 }
 
-/* Very slow rate conversion routine */
-void SDL_RateSLOW(SDL_AudioCVT *cvt, Uint16 format)
+/* Convert native floating point samples to the destination format, with
+   rounding and clipping.  Biasing the value keeps it positive, so the
+   cast rounds the same way in both directions.
+ */
+void SDL_ConvertFromFloat(SDL_AudioCVT *cvt, Uint16 format)
 {
-	double ipos;
-	int i, clen;
+	float *src;
+	SDL_FloatBits bits;
+	float s;
+	Uint32 u32;
+	int i, v, samples, vec;
 
 #ifdef DEBUG_CONVERT
-	fprintf(stderr, "Converting audio rate * %4.4f\n", 1.0/cvt->rate_incr);
+	fprintf(stderr, "Converting from float\n");
+#endif
+	format = cvt->dst_format;
+	samples = cvt->len_cvt / sizeof(float);
+	src = (float *)cvt->buf;
+
+	/* The samples shrink, so the vector code goes first from the front
+	   of the buffer and the C code finishes up */
+	vec = 0;
+#ifdef SDL_SSE2_INTRINSICS
+	if ( SDL_HasSSE2() ) {
+		if ( format == AUDIO_S16SYS ) {
+			vec = samples & ~7;
+			FloatToS16SSE2(src, (Sint16 *)cvt->buf, vec);
+		} else if ( format == AUDIO_S32SYS ) {
+			vec = samples & ~7;
+			FloatToS32SSE2(src, (Sint32 *)cvt->buf, vec);
+		}
+	}
 #endif
-	clen = (int)((double)cvt->len_cvt / cvt->rate_incr);
-	if ( cvt->rate_incr > 1.0 ) {
-		switch (format & 0xFF) {
-			case 8: {
-				Uint8 *output;
-
-				output = cvt->buf;
-				ipos = 0.0;
-				for ( i=clen; i; --i ) {
-					*output = cvt->buf[(int)ipos];
-					ipos += cvt->rate_incr;
-					output += 1;
+	switch (format & 0xFF) {
+		case 8: {
+			Uint8 *dst = cvt->buf;
+
+			for ( i=vec; i<samples; ++i ) {
+				s = src[i] * 128.0f + 128.5f;
+				if ( s < 0.0f ) {
+					v = 0;
+				} else if ( s >= 256.0f ) {
+					v = 255;
+				} else {
+					v = (int)s;
 				}
-			}
-			break;
-
-			case 16: {
-				Uint16 *output;
-
-				clen &= ~1;
-				output = (Uint16 *)cvt->buf;
-				ipos = 0.0;
-				for ( i=clen/2; i; --i ) {
-					*output=((Uint16 *)cvt->buf)[(int)ipos];
-					ipos += cvt->rate_incr;
-					output += 1;
+				if ( format & 0x8000 ) {
+					v ^= 0x80;
 				}
+				dst[i] = (Uint8)v;
 			}
-			break;
 		}
-	} else {
-		switch (format & 0xFF) {
-			case 8: {
-				Uint8 *output;
-
-				output = cvt->buf+clen;
-				ipos = (double)cvt->len_cvt;
-				for ( i=clen; i; --i ) {
-					ipos -= cvt->rate_incr;
-					output -= 1;
-					*output = cvt->buf[(int)ipos];
+		break;
+
+		case 16: {
+			Uint16 *dst = (Uint16 *)cvt->buf;
+
+			for ( i=vec; i<samples; ++i ) {
+				s = src[i] * 32768.0f + 32768.5f;
+				if ( s < 0.0f ) {
+					v = 0;
+				} else if ( s >= 65536.0f ) {
+					v = 65535;
+				} else {
+					v = (int)s;
+				}
+				if ( format & 0x8000 ) {
+					v ^= 0x8000;
+				}
+				if ( format & 0x1000 ) {
+					dst[i] = SDL_SwapBE16((Uint16)v);
+				} else {
+					dst[i] = SDL_SwapLE16((Uint16)v);
 				}
 			}
-			break;
-
-			case 16: {
-				Uint16 *output;
-
-				clen &= ~1;
-				output = (Uint16 *)(cvt->buf+clen);
-				ipos = (double)cvt->len_cvt/2;
-				for ( i=clen/2; i; --i ) {
-					ipos -= cvt->rate_incr;
-					output -= 1;
-					*output=((Uint16 *)cvt->buf)[(int)ipos];
+		}
+		break;
+
+		case 32: {
+			Uint32 *dst = (Uint32 *)cvt->buf;
+
+			for ( i=vec; i<samples; ++i ) {
+				if ( format & 0x0100 ) {
+					bits.f = src[i];
+					u32 = bits.u;
+				} else if ( src[i] >= 1.0f ) {
+					u32 = 0x7FFFFFFF;
+				} else if ( src[i] <= -1.0f ) {
+					u32 = 0x80000000;
+				} else {
+					u32 = (Sint32)(src[i] * 2147483648.0f);
+				}
+				if ( format & 0x1000 ) {
+					dst[i] = SDL_SwapBE32(u32);
+				} else {
+					dst[i] = SDL_SwapLE32(u32);
 				}
 			}
-			break;
 		}
+		break;
 	}
-	cvt->len_cvt = clen;
+	cvt->len_cvt = samples * ((format & 0xFF) / 8);
 	if ( cvt->filters[++cvt->filter_index] ) {
 		cvt->filters[cvt->filter_index](cvt, format);
 	}
@@ -511,124 +681,165 @@ int SDL_BuildAudioCVT(SDL_AudioCVT *cvt,
 	Uint16 src_format, Uint8 src_channels, int src_rate,
 	Uint16 dst_format, Uint8 dst_channels, int dst_rate)
 {
+	SDL_AudioFilter typecvt, matrix;
+	int from_float;
+
 	/* Start off with no conversion necessary */
 	cvt->needed = 0;
 	cvt->filter_index = 0;
 	cvt->filters[0] = NULL;
 	cvt->len_mult = 1;
 	cvt->len_ratio = 1.0;
+	from_float = 0;
 
-	/* First filter:  Endian conversion from src to dst */
-	if ( (src_format & 0x1000) != (dst_format & 0x1000)
-	     && ((src_format & 0xff) != 8) ) {
-		cvt->filters[cvt->filter_index++] = SDL_ConvertEndian;
-	}
-	
-	/* Second filter: Sign conversion -- signed/unsigned */
-	if ( (src_format & 0x8000) != (dst_format & 0x8000) ) {
-		cvt->filters[cvt->filter_index++] = SDL_ConvertSign;
+	/* Anything but mono to stereo and back is mixed with a matrix,
+	   and so are those when the application has set its own matrix */
+	matrix = NULL;
+	if ( src_channels != dst_channels ) {
+		if ( (src_channels > 2) || (dst_channels > 2) ||
+		     SDL_ChannelMatrixChanged(src_channels, dst_channels) ) {
+			matrix = SDL_ChooseChannelMatrix(src_channels,
+			                                 dst_channels);
+			if ( matrix == NULL ) {
+				SDL_SetError("Can't convert %d channels to %d",
+				             (int)src_channels,
+				             (int)dst_channels);
+				return(-1);
+			}
+		}
 	}
 
-	/* Next filter:  Convert 16 bit <--> 8 bit PCM */
-	if ( (src_format & 0xFF) != (dst_format & 0xFF) ) {
-		switch (dst_format&0x10FF) {
-			case AUDIO_U8:
-				cvt->filters[cvt->filter_index++] =
-							 SDL_Convert8;
-				cvt->len_ratio /= 2;
-				break;
-			case AUDIO_U16LSB:
-				cvt->filters[cvt->filter_index++] =
-							SDL_Convert16LSB;
-				cvt->len_mult *= 2;
-				cvt->len_ratio *= 2;
-				break;
-			case AUDIO_U16MSB:
-				cvt->filters[cvt->filter_index++] =
-							SDL_Convert16MSB;
-				cvt->len_mult *= 2;
-				cvt->len_ratio *= 2;
-				break;
-		}
+	/* Convert the samples and channels in one pass if possible */
+	typecvt = NULL;
+	if ( matrix == NULL ) {
+		typecvt = SDL_ChooseTypeCVT(src_format, src_channels,
+		                            dst_format, dst_channels);
 	}
+	if ( typecvt ) {
+		int src_frame = ((src_format & 0xFF) / 8) * src_channels;
+		int dst_frame = ((dst_format & 0xFF) / 8) * dst_channels;
 
-	/* Last filter:  Mono/Stereo conversion */
-	if ( src_channels != dst_channels ) {
-		while ( (src_channels*2) <= dst_channels ) {
-			cvt->filters[cvt->filter_index++] = 
-						SDL_ConvertStereo;
-			cvt->len_mult *= 2;
-			src_channels *= 2;
-			cvt->len_ratio *= 2;
+		cvt->filters[cvt->filter_index++] = typecvt;
+		if ( dst_frame > src_frame ) {
+			cvt->len_mult *= dst_frame / src_frame;
 		}
-		/* This assumes that 4 channel audio is in the format:
-		     Left {front/back} + Right {front/back}
-		   so converting to L/R stereo works properly.
-		 */
-		while ( ((src_channels%2) == 0) &&
-				((src_channels/2) >= dst_channels) ) {
-			cvt->filters[cvt->filter_index++] =
-						 SDL_ConvertMono;
-			src_channels /= 2;
-			cvt->len_ratio /= 2;
+		cvt->len_ratio *= (double)dst_frame / src_frame;
+		src_channels = dst_channels;
+	} else
+	if ( matrix ||
+	     ((((src_format & 0xFF) == 32) || ((dst_format & 0xFF) == 32)) &&
+	      ((src_format != dst_format) || (src_channels != dst_channels) ||
+	       (src_rate != dst_rate))) ) {
+		/* 32-bit samples and channel matrices go through native floats */
+		if ( src_format != AUDIO_F32SYS ) {
+			int size = (src_format & 0xFF) / 8;
+
+			cvt->filters[cvt->filter_index++] = SDL_ConvertToFloat;
+			cvt->len_mult *= sizeof(float) / size;
+			cvt->len_ratio *= (double)sizeof(float) / size;
 		}
 		if ( src_channels != dst_channels ) {
-			/* Uh oh.. */;
+			if ( matrix == NULL ) {
+				matrix = SDL_ChooseChannelMatrix(src_channels,
+				                                 dst_channels);
+			}
+			if ( matrix == NULL ) {
+				SDL_SetError("Can't convert %d channels to %d",
+				             (int)src_channels, (int)dst_channels);
+				return(-1);
+			}
+			cvt->filters[cvt->filter_index++] = matrix;
+			cvt->len_mult *= (dst_channels + src_channels - 1) /
+			                 src_channels;
+			cvt->len_ratio *= (double)dst_channels / src_channels;
+			src_channels = dst_channels;
 		}
-	}
-
-	/* Do rate conversion */
-	cvt->rate_incr = 0.0;
-	if ( (src_rate/100) != (dst_rate/100) ) {
-		Uint32 hi_rate, lo_rate;
-		int len_mult;
-		double len_ratio;
-		void (*rate_cvt)(SDL_AudioCVT *cvt, Uint16 format);
-
-		if ( src_rate > dst_rate ) {
-			hi_rate = src_rate;
-			lo_rate = dst_rate;
-			rate_cvt = SDL_RateDIV2;
-			len_mult = 1;
-			len_ratio = 0.5;
-		} else {
-			hi_rate = dst_rate;
-			lo_rate = src_rate;
-			rate_cvt = SDL_RateMUL2;
-			len_mult = 2;
-			len_ratio = 2.0;
+		from_float = (dst_format != AUDIO_F32SYS);
+	} else {
+		/* First filter:  Endian conversion from src to dst */
+		if ( (src_format & 0x1000) != (dst_format & 0x1000)
+		     && ((src_format & 0xff) != 8) ) {
+			cvt->filters[cvt->filter_index++] = SDL_ConvertEndian;
 		}
-		/* If hi_rate = lo_rate*2^x then conversion is easy */
-		while ( ((lo_rate*2)/100) <= (hi_rate/100) ) {
-			cvt->filters[cvt->filter_index++] = rate_cvt;
-			cvt->len_mult *= len_mult;
-			lo_rate *= 2;
-			cvt->len_ratio *= len_ratio;
+	
+		/* Second filter: Sign conversion -- signed/unsigned */
+		if ( (src_format & 0x8000) != (dst_format & 0x8000) ) {
+			cvt->filters[cvt->filter_index++] = SDL_ConvertSign;
 		}
-		/* We may need a slow conversion here to finish up */
-		if ( (lo_rate/100) != (hi_rate/100) ) {
-#if 1
-			/* The problem with this is that if the input buffer is
-			   say 1K, and the conversion rate is say 1.1, then the
-			   output buffer is 1.1K, which may not be an acceptable
-			   buffer size for the audio driver (not a power of 2)
-			*/
-			/* For now, punt and hope the rate distortion isn't great.
-			*/
-#else
-			if ( src_rate < dst_rate ) {
-				cvt->rate_incr = (double)lo_rate/hi_rate;
+
+		/* Next filter:  Convert 16 bit <--> 8 bit PCM */
+		if ( (src_format & 0xFF) != (dst_format & 0xFF) ) {
+			switch (dst_format&0x10FF) {
+				case AUDIO_U8:
+					cvt->filters[cvt->filter_index++] =
+								 SDL_Convert8;
+					cvt->len_ratio /= 2;
+					break;
+				case AUDIO_U16LSB:
+					cvt->filters[cvt->filter_index++] =
+								SDL_Convert16LSB;
+					cvt->len_mult *= 2;
+					cvt->len_ratio *= 2;
+					break;
+				case AUDIO_U16MSB:
+					cvt->filters[cvt->filter_index++] =
+								SDL_Convert16MSB;
+					cvt->len_mult *= 2;
+					cvt->len_ratio *= 2;
+					break;
+			}
+		}
+
+		/* Last filter:  Mono/Stereo conversion */
+		if ( src_channels != dst_channels ) {
+			if ( (src_channels == 1) && (dst_channels == 2) ) {
+				cvt->filters[cvt->filter_index++] = 
+							SDL_ConvertStereo;
 				cvt->len_mult *= 2;
-				cvt->len_ratio /= cvt->rate_incr;
+				cvt->len_ratio *= 2;
+			} else
+			if ( (src_channels == 2) && (dst_channels == 1) ) {
+				cvt->filters[cvt->filter_index++] =
+							 SDL_ConvertMono;
+				cvt->len_ratio /= 2;
 			} else {
-				cvt->rate_incr = (double)hi_rate/lo_rate;
-				cvt->len_ratio *= cvt->rate_incr;
+				SDL_SetError("Can't convert %d channels to %d",
+				             (int)src_channels, (int)dst_channels);
+				return(-1);
 			}
-			cvt->filters[cvt->filter_index++] = SDL_RateSLOW;
-#endif
+			src_channels = dst_channels;
 		}
 	}
 
+	/* Do rate conversion */
+	cvt->rate_incr = 0.0;
+	if ( src_rate != dst_rate ) {
+		if ( (src_rate <= 0) || (dst_rate <= 0) ) {
+			SDL_SetError("Invalid sample rate");
+			return(-1);
+		}
+		if ( (src_channels > SDL_RESAMPLE_MAXCHANNELS) ||
+		     (SDL_RateConvertFilters[src_channels] == NULL) ) {
+			SDL_SetError("Can't resample %d channels",
+			             (int)src_channels);
+			return(-1);
+		}
+		/* The resampler rounds the number of frames up, so a buffer
+		   rounded up to a whole multiple of the ratio always fits */
+		cvt->filters[cvt->filter_index++] =
+					SDL_RateConvertFilters[src_channels];
+		cvt->rate_incr = (double)src_rate / dst_rate;
+		cvt->len_mult *= (dst_rate + src_rate - 1) / src_rate;
+		cvt->len_ratio *= (double)dst_rate / src_rate;
+	}
+
+	/* Convert the floats to the destination format after everything */
+	if ( from_float ) {
+		cvt->filters[cvt->filter_index++] = SDL_ConvertFromFloat;
+		cvt->len_ratio *= (double)((dst_format & 0xFF) / 8) /
+		                  sizeof(float);
+	}
+
 	/* Set up the filter information */
 	if ( cvt->filter_index != 0 ) {
 		cvt->needed = 1;
@@ -0,0 +1,469 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997, 1998, 1999, 2000, 2001, 2002  Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the Free
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+
+#ifdef SAVE_RCSID
+static char rcsid =
+ "@(#) $Id$";
+#endif
+
+/* Channel layouts and mixing matrices
+
+   Conversions between 1, 2, 4, 6 and 8 channels, other than plain mono
+   to stereo and back, are done on native floats by a matrix: each output
+   channel is the sum of the input channels, each weighted by its own
+   coefficient.  The channels are laid out as
+	1: FC
+	2: FL FR
+	4: FL FR BL BR
+	6: FL FR FC LFE BL BR
+	8: FL FR FC LFE BL BR SL SR
+   and the default matrices put each input speaker on the same output
+   speaker, or on the nearest ones the output has.  Down-mixes from more
+   than two channels are scaled so they can't get louder than the input.
+   The matrices are only touched with their lock held, and conversions
+   mix with a copy, so they can be changed while audio is playing.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "SDL_error.h"
+#include "SDL_audio.h"
+#include "SDL_mutex.h"
+#include "SDL_audiotypecvt_c.h"
+#include "SDL_audiomatrix_c.h"
+#include "SDL_simd.h"
+#include "SDL_atomic_c.h"
+
+#define MAX_CHANNELS	8
+#define NUM_LAYOUTS	5
+
+enum {
+	SPEAKER_FL,
+	SPEAKER_FR,
+	SPEAKER_FC,
+	SPEAKER_LFE,
+	SPEAKER_BL,
+	SPEAKER_BR,
+	SPEAKER_SL,
+	SPEAKER_SR
+};
+
+static const int layout_channels[NUM_LAYOUTS] = { 1, 2, 4, 6, 8 };
+static const int layouts[NUM_LAYOUTS][MAX_CHANNELS] = {
+	{ SPEAKER_FC },
+	{ SPEAKER_FL, SPEAKER_FR },
+	{ SPEAKER_FL, SPEAKER_FR, SPEAKER_BL, SPEAKER_BR },
+	{ SPEAKER_FL, SPEAKER_FR, SPEAKER_FC, SPEAKER_LFE,
+	  SPEAKER_BL, SPEAKER_BR },
+	{ SPEAKER_FL, SPEAKER_FR, SPEAKER_FC, SPEAKER_LFE,
+	  SPEAKER_BL, SPEAKER_BR, SPEAKER_SL, SPEAKER_SR }
+};
+
+/* Where a speaker the output layout doesn't have is mixed instead.
+   Every layout has either the front pair or the center, so this always
+   ends up somewhere, except for the LFE which is left out.
+ */
+static const struct {
+	int to[2];
+	float gain;
+} fallback[MAX_CHANNELS] = {
+	{ { SPEAKER_FC, -1 }, 1.0f },
+	{ { SPEAKER_FC, -1 }, 1.0f },
+	{ { SPEAKER_FL, SPEAKER_FR }, 0.70710678f },
+	{ { -1, -1 }, 0.0f },
+	{ { SPEAKER_FL, -1 }, 0.70710678f },
+	{ { SPEAKER_FR, -1 }, 0.70710678f },
+	{ { SPEAKER_BL, -1 }, 1.0f },
+	{ { SPEAKER_BR, -1 }, 1.0f }
+};
+
+/* The matrices, with a row of 'src' coefficients for each output channel */
+static float matrices[NUM_LAYOUTS][NUM_LAYOUTS][MAX_CHANNELS*MAX_CHANNELS];
+static Uint8 matrix_state[NUM_LAYOUTS][NUM_LAYOUTS];
+#define MATRIX_UNSET	0
+#define MATRIX_DEFAULT	1
+#define MATRIX_CUSTOM	2
+static SDL_mutex * volatile matrix_lock = NULL;
+
+static int LayoutIndex(int channels)
+{
+	int i;
+
+	for ( i=0; i<NUM_LAYOUTS; ++i ) {
+		if ( layout_channels[i] == channels ) {
+			return(i);
+		}
+	}
+	return(-1);
+}
+
+static int SpeakerChannel(int layout, int speaker)
+{
+	int i;
+
+	for ( i=0; i<layout_channels[layout]; ++i ) {
+		if ( layouts[layout][i] == speaker ) {
+			return(i);
+		}
+	}
+	return(-1);
+}
+
+static void RouteSpeaker(float *matrix, int src_channels, int dst,
+                         int speaker, int in, float gain)
+{
+	int out, i;
+
+	out = SpeakerChannel(dst, speaker);
+	if ( out >= 0 ) {
+		matrix[out*src_channels+in] += gain;
+		return;
+	}
+	for ( i=0; i<2; ++i ) {
+		if ( fallback[speaker].to[i] >= 0 ) {
+			RouteSpeaker(matrix, src_channels, dst,
+			             fallback[speaker].to[i], in,
+			             gain*fallback[speaker].gain);
+		}
+	}
+}
+
+static void DefaultMatrix(int src, int dst, float *matrix)
+{
+	int src_channels, dst_channels;
+	int in, out;
+	float sum;
+
+	src_channels = layout_channels[src];
+	dst_channels = layout_channels[dst];
+	memset(matrix, 0, MAX_CHANNELS*MAX_CHANNELS*sizeof(float));
+	for ( in=0; in<src_channels; ++in ) {
+		if ( (src_channels == 1) &&
+		     (SpeakerChannel(dst, SPEAKER_FC) < 0) ) {
+			/* Mono goes on both sides at full level, as always */
+			RouteSpeaker(matrix, 1, dst, SPEAKER_FL, in, 1.0f);
+			RouteSpeaker(matrix, 1, dst, SPEAKER_FR, in, 1.0f);
+		} else {
+			RouteSpeaker(matrix, src_channels, dst,
+			             layouts[src][in], in, 1.0f);
+		}
+	}
+
+	/* Stereo to mono adds the sides like SDL_ConvertMono(), and
+	   bigger down-mixes are scaled down so they don't clip. */
+	if ( src_channels > 2 ) {
+		for ( out=0; out<dst_channels; ++out ) {
+			sum = 0.0f;
+			for ( in=0; in<src_channels; ++in ) {
+				sum += matrix[out*src_channels+in];
+			}
+			if ( sum > 1.0f ) {
+				for ( in=0; in<src_channels; ++in ) {
+					matrix[out*src_channels+in] /= sum;
+				}
+			}
+		}
+	}
+}
+
+static void LockMatrices(void)
+{
+	SDL_mutex *lock;
+
+	/* The lock is made by the first one to need it, and kept */
+	lock = matrix_lock;
+	if ( lock == NULL ) {
+		lock = SDL_CreateMutex();
+		if ( lock && !SDL_AtomicCASPtr(&matrix_lock, NULL, lock) ) {
+			SDL_DestroyMutex(lock);
+			lock = matrix_lock;
+		}
+	}
+	if ( lock ) {
+		SDL_mutexP(lock);
+	}
+}
+
+static void UnlockMatrices(void)
+{
+	if ( matrix_lock ) {
+		SDL_mutexV(matrix_lock);
+	}
+}
+
+/* Copy out the matrix in use, since it may be replaced at any time */
+static void GetMatrix(int src, int dst, float *matrix)
+{
+	LockMatrices();
+	if ( matrix_state[src][dst] == MATRIX_UNSET ) {
+		DefaultMatrix(src, dst, matrices[src][dst]);
+		matrix_state[src][dst] = MATRIX_DEFAULT;
+	}
+	memcpy(matrix, matrices[src][dst],
+	       layout_channels[src]*layout_channels[dst]*sizeof(float));
+	UnlockMatrices();
+}
+
+int SDL_SetChannelMatrix(int src_channels, int dst_channels,
+                         const float *matrix)
+{
+	float defaults[MAX_CHANNELS*MAX_CHANNELS];
+	int src, dst, state;
+
+	src = LayoutIndex(src_channels);
+	dst = LayoutIndex(dst_channels);
+	if ( (src < 0) || (dst < 0) || (src == dst) ) {
+		SDL_SetError("Can't mix %d channels to %d",
+		             src_channels, dst_channels);
+		return(-1);
+	}
+	if ( matrix ) {
+		state = MATRIX_CUSTOM;
+	} else {
+		DefaultMatrix(src, dst, defaults);
+		matrix = defaults;
+		state = MATRIX_DEFAULT;
+	}
+	LockMatrices();
+	memcpy(matrices[src][dst], matrix,
+	       src_channels*dst_channels*sizeof(float));
+	matrix_state[src][dst] = state;
+	UnlockMatrices();
+	return(0);
+}
+
+int SDL_GetChannelMatrix(int src_channels, int dst_channels, float *matrix)
+{
+	int src, dst;
+
+	src = LayoutIndex(src_channels);
+	dst = LayoutIndex(dst_channels);
+	if ( (src < 0) || (dst < 0) || (src == dst) ) {
+		SDL_SetError("Can't mix %d channels to %d",
+		             src_channels, dst_channels);
+		return(-1);
+	}
+	GetMatrix(src, dst, matrix);
+	return(0);
+}
+
+int SDL_ChannelMatrixChanged(int src_channels, int dst_channels)
+{
+	int src, dst, changed;
+
+	src = LayoutIndex(src_channels);
+	dst = LayoutIndex(dst_channels);
+	if ( (src < 0) || (dst < 0) ) {
+		return(0);
+	}
+	LockMatrices();
+	changed = (matrix_state[src][dst] == MATRIX_CUSTOM);
+	UnlockMatrices();
+	return(changed);
+}
+
+/* Mix one frame, which is copied first because it may overlap the output.
+   The SSE2 version adds up in the same order, so they match exactly.
+ */
+static void MixFrame(const float *matrix, const float *src, float *dst,
+                     int src_channels, int dst_channels)
+{
+	float in[MAX_CHANNELS];
+	float sample;
+	int i, j;
+
+	memcpy(in, src, src_channels*sizeof(float));
+	for ( j=0; j<dst_channels; ++j ) {
+		sample = in[0] * matrix[0];
+		for ( i=1; i<src_channels; ++i ) {
+			sample += in[i] * matrix[i];
+		}
+		dst[j] = sample;
+		matrix += src_channels;
+	}
+}
+
+#ifdef SDL_SSE2_INTRINSICS
+/* Each input sample is multiplied by its column of the matrix, so a whole
+   frame of up to eight outputs takes one or two vectors per input.  All
+   of a frame is read before any of it is written.
+ */
+SDL_TARGETING("sse2")
+static void MixChannelsSSE2(const float *matrix, float *buf, int frames,
+                            int src_channels, int dst_channels)
+{
+	float cols[MAX_CHANNELS*MAX_CHANNELS] SDL_SIMD_ALIGNED;
+	const __m128 *col;
+	const float *in;
+	float *out;
+	__m128 x, lo, hi;
+	int i, j, step;
+
+	memset(cols, 0, sizeof(cols));
+	for ( i=0; i<src_channels; ++i ) {
+		for ( j=0; j<dst_channels; ++j ) {
+			cols[i*MAX_CHANNELS+j] = matrix[j*src_channels+i];
+		}
+	}
+	col = (const __m128 *)cols;
+
+	if ( dst_channels > src_channels ) {
+		i = frames-1;
+		step = -1;
+	} else {
+		i = 0;
+		step = 1;
+	}
+	for ( ; frames; --frames, i+=step ) {
+		in = buf+i*src_channels;
+		out = buf+i*dst_channels;
+		x = _mm_set1_ps(in[0]);
+		lo = _mm_mul_ps(x, col[0]);
+		hi = _mm_mul_ps(x, col[1]);
+		for ( j=1; j<src_channels; ++j ) {
+			x = _mm_set1_ps(in[j]);
+			lo = _mm_add_ps(lo, _mm_mul_ps(x, col[j*2]));
+			hi = _mm_add_ps(hi, _mm_mul_ps(x, col[j*2+1]));
+		}
+		switch (dst_channels) {
+		    case 1:
+			_mm_store_ss(out, lo);
+			break;
+		    case 2:
+			_mm_storel_pi((__m64 *)out, lo);
+			break;
+		    case 4:
+			_mm_storeu_ps(out, lo);
+			break;
+		    case 6:
+			_mm_storeu_ps(out, lo);
+			_mm_storel_pi((__m64 *)(out+4), hi);
+			break;
+		    case 8:
+			_mm_storeu_ps(out, lo);
+			_mm_storeu_ps(out+4, hi);
+			break;
+		}
+	}
+}
+#endif /* SDL_SSE2_INTRINSICS */
+
+/* Mix the channels in place, going backwards when the frames grow so the
+   output never runs over input that hasn't been read yet.
+ */
+static void SDL_MixChannels(SDL_AudioCVT *cvt, Uint16 format,
+                            int src_channels, int dst_channels)
+{
+	float matrix[MAX_CHANNELS*MAX_CHANNELS];
+	float *buf;
+	int i, frames;
+
+#ifdef DEBUG_CONVERT
+	fprintf(stderr, "Mixing %d channels to %d\n",
+	        src_channels, dst_channels);
+#endif
+	GetMatrix(LayoutIndex(src_channels), LayoutIndex(dst_channels),
+	          matrix);
+	buf = (float *)cvt->buf;
+	frames = cvt->len_cvt / (src_channels*sizeof(float));
+#ifdef SDL_SSE2_INTRINSICS
+	if ( SDL_HasSSE2() ) {
+		MixChannelsSSE2(matrix, buf, frames,
+		                src_channels, dst_channels);
+	} else
+#endif
+	if ( dst_channels > src_channels ) {
+		for ( i=frames-1; i>=0; --i ) {
+			MixFrame(matrix, buf+i*src_channels,
+			         buf+i*dst_channels,
+			         src_channels, dst_channels);
+		}
+	} else {
+		for ( i=0; i<frames; ++i ) {
+			MixFrame(matrix, buf+i*src_channels,
+			         buf+i*dst_channels,
+			         src_channels, dst_channels);
+		}
+	}
+	cvt->len_cvt = frames * dst_channels * sizeof(float);
+	if ( cvt->filters[++cvt->filter_index] ) {
+		cvt->filters[cvt->filter_index](cvt, format);
+	}
+}
+
+/* SDL_AudioCVT filters only get the format, so there is one for each pair
+   of layouts, indexed like the matrices.
+ */
+#define MIX_CHANNELS(src, dst) \
+static void SDL_MixChannels_##src##_##dst(SDL_AudioCVT *cvt, Uint16 format) \
+{ \
+	SDL_MixChannels(cvt, format, src, dst); \
+}
+MIX_CHANNELS(1, 2)
+MIX_CHANNELS(1, 4)
+MIX_CHANNELS(1, 6)
+MIX_CHANNELS(1, 8)
+MIX_CHANNELS(2, 1)
+MIX_CHANNELS(2, 4)
+MIX_CHANNELS(2, 6)
+MIX_CHANNELS(2, 8)
+MIX_CHANNELS(4, 1)
+MIX_CHANNELS(4, 2)
+MIX_CHANNELS(4, 6)
+MIX_CHANNELS(4, 8)
+MIX_CHANNELS(6, 1)
+MIX_CHANNELS(6, 2)
+MIX_CHANNELS(6, 4)
+MIX_CHANNELS(6, 8)
+MIX_CHANNELS(8, 1)
+MIX_CHANNELS(8, 2)
+MIX_CHANNELS(8, 4)
+MIX_CHANNELS(8, 6)
+
+static const SDL_AudioFilter mix_filters[NUM_LAYOUTS][NUM_LAYOUTS] = {
+	{ NULL, SDL_MixChannels_1_2, SDL_MixChannels_1_4,
+	  SDL_MixChannels_1_6, SDL_MixChannels_1_8 },
+	{ SDL_MixChannels_2_1, NULL, SDL_MixChannels_2_4,
+	  SDL_MixChannels_2_6, SDL_MixChannels_2_8 },
+	{ SDL_MixChannels_4_1, SDL_MixChannels_4_2, NULL,
+	  SDL_MixChannels_4_6, SDL_MixChannels_4_8 },
+	{ SDL_MixChannels_6_1, SDL_MixChannels_6_2, SDL_MixChannels_6_4,
+	  NULL, SDL_MixChannels_6_8 },
+	{ SDL_MixChannels_8_1, SDL_MixChannels_8_2, SDL_MixChannels_8_4,
+	  SDL_MixChannels_8_6, NULL }
+};
+
+SDL_AudioFilter SDL_ChooseChannelMatrix(int src_channels, int dst_channels)
+{
+	float matrix[MAX_CHANNELS*MAX_CHANNELS];
+	int src, dst;
+
+	src = LayoutIndex(src_channels);
+	dst = LayoutIndex(dst_channels);
+	if ( (src < 0) || (dst < 0) ) {
+		return(NULL);
+	}
+	/* Fill in the default now, rather than in the audio thread */
+	GetMatrix(src, dst, matrix);
+	return(mix_filters[src][dst]);
+}
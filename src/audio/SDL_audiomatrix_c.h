@@ -0,0 +1,38 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997, 1998, 1999, 2000, 2001, 2002  Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the Free
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+
+#ifdef SAVE_RCSID
+static char rcsid =
+ "@(#) $Id$";
+#endif
+
+/* Channel mixing matrices for SDL_AudioCVT, this needs SDL_audiotypecvt_c.h */
+
+/* Returns the filter mixing 'src_channels' native float channels into
+   'dst_channels' with the matrix set for them, or NULL if there isn't a
+   layout for one of the counts.
+ */
+extern SDL_AudioFilter SDL_ChooseChannelMatrix(int src_channels,
+                                               int dst_channels);
+
+/* Returns 1 if the application has set its own matrix for these counts */
+extern int SDL_ChannelMatrixChanged(int src_channels, int dst_channels);
@@ -0,0 +1,989 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997, 1998, 1999, 2000, 2001, 2002  Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the Free
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+
+#ifdef SAVE_RCSID
+static char rcsid =
+ "@(#) $Id$";
+#endif
+
+/* A mixer for many voices at once
+
+   Sounds are converted to floats at the mixer rate when they are made,
+   so a voice at its normal pitch just adds its frames to the sum, and
+   only a voice at another pitch goes through a resampler.  A block of
+   frames is summed for every voice before the sum is clipped and
+   converted to the output format, once.
+
+   The application doesn't touch the voices.  It queues changes stamped
+   with the mixer frame they are due at, under a lock that the mixing
+   thread only holds to take them all at the start of a buffer.  The
+   buffer is then mixed in pieces split at the frames changes are due.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "SDL_error.h"
+#include "SDL_mutex.h"
+#include "SDL_audio.h"
+#include "SDL_resample_c.h"
+#include "SDL_simd.h"
+
+#ifndef M_PI
+#define M_PI	3.14159265358979323846
+#endif
+
+/* Frames summed before converting them to the output format */
+#define MIXER_BLOCK		256
+
+/* Frames taken to move to a new volume or pan */
+#define MIXER_RAMP		64
+
+#define MIXER_MAXCHANNELS	SDL_RESAMPLE_MAXCHANNELS
+
+/* Range of the pitch, limited by the length of the resampler filter */
+#define MIXER_MINPITCH		(1.0f/16)
+#define MIXER_MAXPITCH		16.0f
+
+enum {
+	MIXER_PLAY,
+	MIXER_STOP,
+	MIXER_VOLUME,
+	MIXER_PAN,
+	MIXER_PITCH
+};
+
+typedef struct SDL_MixerCommand {
+	int type;
+	int voice;
+	Uint32 frame;		/* The mixer frame it is due at */
+	SDL_MixerSound *sound;	/* Holds a reference while queued */
+	int loops;
+	float value;
+	SDL_Resampler *resamplers[2];
+} SDL_MixerCommand;
+
+typedef struct SDL_MixerVoice {
+	SDL_MixerSound *sound;	/* NULL when the voice is idle */
+	int position;		/* The next frame of the sound to use */
+	int loops;
+	int flushed;		/* The end of the sound is in the resampler */
+	volatile int playing;
+	float volume;
+	float pan;
+
+	/* For mono and for other sounds, when the pitch isn't 1.0 */
+	SDL_Resampler *resamplers[2];
+
+	/* Gain for each output channel, and where it is moving to */
+	float gain[MIXER_MAXCHANNELS];
+	float target[MIXER_MAXCHANNELS];
+	int ramp;
+} SDL_MixerVoice;
+
+struct SDL_MixerSound {
+	SDL_AudioMixer *mixer;
+	float *data;
+	int channels;		/* 1 or the mixer channels */
+	int frames;
+	int refcount;		/* Under the mixer lock */
+};
+
+struct SDL_AudioMixer {
+	int channels;
+	int freq;
+	int framesize;
+	SDL_AudioCVT cvt;	/* From the sums to the output format */
+	float *sum;
+	float *scratch;		/* A block of resampled voice */
+	volatile Uint32 frame;
+
+	/* Changes from the application, under the lock */
+	SDL_mutex *lock;
+	SDL_MixerCommand *queued;
+	int num_queued;
+
+	/* Changes waiting for their frame, only used by the mixing thread */
+	SDL_MixerCommand *events;
+	int num_events;
+	int max_commands;
+
+	SDL_MixerVoice *voices;
+	int num_voices;
+
+	/* Vector code for adding a voice at a steady gain, or NULL */
+	int (*add)(const float *src, int stride, float *sum,
+	           int channels, const float *gain, int frames);
+};
+
+#ifdef SDL_SSE2_INTRINSICS
+/* Add as many whole frames at a steady gain as fill whole vectors, for
+   the common layouts, and return the number of frames added */
+SDL_TARGETING("sse2")
+static int AddFramesSSE2(const float *src, int stride, float *sum,
+                         int channels, const float *gain, int frames)
+{
+	__m128 g, g2, x;
+	int i, n;
+
+	if ( (stride == channels) && (channels <= 4) && (channels != 3) ) {
+		switch (channels) {
+		    case 1:
+			g = _mm_set1_ps(gain[0]);
+			break;
+		    case 2:
+			g = _mm_set_ps(gain[1], gain[0], gain[1], gain[0]);
+			break;
+		    default:
+			g = _mm_loadu_ps(gain);
+			break;
+		}
+		n = (frames*channels) & ~3;
+		for ( i=0; i<n; i+=4 ) {
+			x = _mm_mul_ps(_mm_loadu_ps(src+i), g);
+			_mm_storeu_ps(sum+i, _mm_add_ps(_mm_loadu_ps(sum+i), x));
+		}
+		return(n / channels);
+	}
+	if ( (stride == channels) && (channels == 8) ) {
+		g = _mm_loadu_ps(gain);
+		g2 = _mm_loadu_ps(gain+4);
+		for ( i=0; i<frames*8; i+=8 ) {
+			x = _mm_mul_ps(_mm_loadu_ps(src+i), g);
+			_mm_storeu_ps(sum+i, _mm_add_ps(_mm_loadu_ps(sum+i), x));
+			x = _mm_mul_ps(_mm_loadu_ps(src+i+4), g2);
+			_mm_storeu_ps(sum+i+4,
+			              _mm_add_ps(_mm_loadu_ps(sum+i+4), x));
+		}
+		return(frames);
+	}
+	if ( (stride == 1) && (channels == 2) ) {
+		/* Each mono frame goes to both sides */
+		g = _mm_set_ps(gain[1], gain[0], gain[1], gain[0]);
+		n = frames & ~3;
+		for ( i=0; i<n; i+=4, sum+=8 ) {
+			x = _mm_loadu_ps(src+i);
+			_mm_storeu_ps(sum, _mm_add_ps(_mm_loadu_ps(sum),
+			              _mm_mul_ps(_mm_unpacklo_ps(x, x), g)));
+			_mm_storeu_ps(sum+4, _mm_add_ps(_mm_loadu_ps(sum+4),
+			              _mm_mul_ps(_mm_unpackhi_ps(x, x), g)));
+		}
+		return(n);
+	}
+	return(0);
+}
+#endif /* SDL_SSE2_INTRINSICS */
+
+#ifdef SDL_AVX2_INTRINSICS
+SDL_TARGETING("avx2")
+static int AddFramesAVX2(const float *src, int stride, float *sum,
+                         int channels, const float *gain, int frames)
+{
+	__m256 g, x, lo, hi;
+	int i, n;
+
+	if ( (stride == channels) && (channels != 3) &&
+	     (channels != 5) && (channels != 6) && (channels != 7) ) {
+		switch (channels) {
+		    case 1:
+			g = _mm256_set1_ps(gain[0]);
+			break;
+		    case 2:
+			g = _mm256_set_ps(gain[1], gain[0], gain[1], gain[0],
+			                  gain[1], gain[0], gain[1], gain[0]);
+			break;
+		    case 4:
+			g = _mm256_set_ps(gain[3], gain[2], gain[1], gain[0],
+			                  gain[3], gain[2], gain[1], gain[0]);
+			break;
+		    default:
+			g = _mm256_loadu_ps(gain);
+			break;
+		}
+		n = (frames*channels) & ~7;
+		for ( i=0; i<n; i+=8 ) {
+			x = _mm256_mul_ps(_mm256_loadu_ps(src+i), g);
+			_mm256_storeu_ps(sum+i,
+			                 _mm256_add_ps(_mm256_loadu_ps(sum+i), x));
+		}
+		return(n / channels);
+	}
+	if ( (stride == 1) && (channels == 2) ) {
+		g = _mm256_set_ps(gain[1], gain[0], gain[1], gain[0],
+		                  gain[1], gain[0], gain[1], gain[0]);
+		n = frames & ~7;
+		for ( i=0; i<n; i+=8, sum+=16 ) {
+			/* The unpacks work within each half of the vector */
+			x = _mm256_loadu_ps(src+i);
+			lo = _mm256_unpacklo_ps(x, x);
+			hi = _mm256_unpackhi_ps(x, x);
+			x = _mm256_permute2f128_ps(lo, hi, 0x20);
+			_mm256_storeu_ps(sum, _mm256_add_ps(_mm256_loadu_ps(sum),
+			                 _mm256_mul_ps(x, g)));
+			x = _mm256_permute2f128_ps(lo, hi, 0x31);
+			_mm256_storeu_ps(sum+8, _mm256_add_ps(
+			                 _mm256_loadu_ps(sum+8), _mm256_mul_ps(x, g)));
+		}
+		return(n);
+	}
+	return(0);
+}
+#endif /* SDL_AVX2_INTRINSICS */
+
+SDL_AudioMixer *SDL_CreateAudioMixer(const SDL_AudioSpec *spec, int voices)
+{
+	SDL_AudioMixer *mixer;
+	int i;
+
+	switch (spec->format) {
+		case AUDIO_U8:
+		case AUDIO_S8:
+		case AUDIO_U16LSB:
+		case AUDIO_S16LSB:
+		case AUDIO_U16MSB:
+		case AUDIO_S16MSB:
+		case AUDIO_S32LSB:
+		case AUDIO_S32MSB:
+		case AUDIO_F32LSB:
+		case AUDIO_F32MSB:
+			break;
+		default:
+			SDL_SetError("Unsupported audio format");
+			return(NULL);
+	}
+	if ( (spec->channels < 1) || (spec->channels > MIXER_MAXCHANNELS) ) {
+		SDL_SetError("Can't mix %d channels", (int)spec->channels);
+		return(NULL);
+	}
+	if ( spec->freq <= 0 ) {
+		SDL_SetError("Invalid sample rate");
+		return(NULL);
+	}
+	if ( voices <= 0 ) {
+		SDL_SetError("Invalid number of voices");
+		return(NULL);
+	}
+
+	mixer = (SDL_AudioMixer *)malloc(sizeof(*mixer));
+	if ( mixer == NULL ) {
+		SDL_OutOfMemory();
+		return(NULL);
+	}
+	memset(mixer, 0, sizeof(*mixer));
+	mixer->channels = spec->channels;
+	mixer->freq = spec->freq;
+	mixer->framesize = ((spec->format & 0xFF) / 8) * spec->channels;
+	if ( SDL_BuildAudioCVT(&mixer->cvt, AUDIO_F32SYS, spec->channels,
+	                       spec->freq, spec->format, spec->channels,
+	                       spec->freq) < 0 ) {
+		free(mixer);
+		return(NULL);
+	}
+
+	/* Every voice can have a change queued and one waiting, with room
+	   to spare for the ones setting the volume and pan as they go */
+	mixer->max_commands = 4*voices + 64;
+	mixer->num_voices = voices;
+	mixer->sum = (float *)
+		malloc(MIXER_BLOCK*mixer->channels*sizeof(float));
+	mixer->scratch = (float *)
+		malloc(MIXER_BLOCK*mixer->channels*sizeof(float));
+	mixer->queued = (SDL_MixerCommand *)
+		malloc(mixer->max_commands*sizeof(SDL_MixerCommand));
+	mixer->events = (SDL_MixerCommand *)
+		malloc(mixer->max_commands*sizeof(SDL_MixerCommand));
+	mixer->voices = (SDL_MixerVoice *)
+		malloc(voices*sizeof(SDL_MixerVoice));
+	mixer->lock = SDL_CreateMutex();
+	if ( (mixer->sum == NULL) || (mixer->scratch == NULL) ||
+	     (mixer->queued == NULL) || (mixer->events == NULL) ||
+	     (mixer->voices == NULL) || (mixer->lock == NULL) ) {
+		SDL_FreeAudioMixer(mixer);
+		SDL_OutOfMemory();
+		return(NULL);
+	}
+	memset(mixer->voices, 0, voices*sizeof(SDL_MixerVoice));
+	for ( i=0; i<voices; ++i ) {
+		mixer->voices[i].volume = 1.0f;
+	}
+#ifdef SDL_SSE2_INTRINSICS
+	if ( SDL_HasSSE2() ) {
+		mixer->add = AddFramesSSE2;
+	}
+#endif
+#ifdef SDL_AVX2_INTRINSICS
+	if ( SDL_HasAVX2() ) {
+		mixer->add = AddFramesAVX2;
+	}
+#endif
+	return(mixer);
+}
+
+static void ReleaseSound(SDL_MixerSound *sound)
+{
+	SDL_AudioMixer *mixer = sound->mixer;
+	int last;
+
+	SDL_mutexP(mixer->lock);
+	last = (--sound->refcount == 0);
+	SDL_mutexV(mixer->lock);
+	if ( last ) {
+		free(sound->data);
+		free(sound);
+	}
+}
+
+static void DiscardCommand(SDL_MixerCommand *command)
+{
+	if ( command->sound ) {
+		ReleaseSound(command->sound);
+	}
+	if ( command->resamplers[0] ) {
+		SDL_FreeResampler(command->resamplers[0]);
+	}
+	if ( command->resamplers[1] ) {
+		SDL_FreeResampler(command->resamplers[1]);
+	}
+}
+
+static void SetResamplers(SDL_MixerVoice *voice, SDL_Resampler **resamplers)
+{
+	int i;
+
+	for ( i=0; i<2; ++i ) {
+		if ( voice->resamplers[i] ) {
+			SDL_FreeResampler(voice->resamplers[i]);
+		}
+		voice->resamplers[i] = resamplers[i];
+	}
+}
+
+static SDL_Resampler *VoiceResampler(SDL_MixerVoice *voice)
+{
+	return(voice->resamplers[voice->sound->channels > 1]);
+}
+
+/* Work out the gains for the volume and pan */
+static void AimVoice(SDL_AudioMixer *mixer, SDL_MixerVoice *voice)
+{
+	float left, right;
+	double angle;
+	int c;
+
+	for ( c=0; c<mixer->channels; ++c ) {
+		voice->target[c] = voice->volume;
+	}
+	if ( mixer->channels == 1 ) {
+		return;
+	}
+	if ( voice->sound->channels == 1 ) {
+		/* Constant power, so a centered sound is 3 dB down on each
+		   side and as loud overall as it is on one side */
+		angle = (voice->pan + 1.0) * (M_PI / 4);
+		left = (float)cos(angle);
+		right = (float)sin(angle);
+		for ( c=2; c<mixer->channels; ++c ) {
+			voice->target[c] = 0.0f;
+		}
+	} else {
+		left = (voice->pan > 0.0f) ? (1.0f - voice->pan) : 1.0f;
+		right = (voice->pan < 0.0f) ? (1.0f + voice->pan) : 1.0f;
+	}
+	voice->target[0] *= left;
+	voice->target[1] *= right;
+}
+
+static void EndVoice(SDL_MixerVoice *voice)
+{
+	ReleaseSound(voice->sound);
+	voice->sound = NULL;
+}
+
+/* Go back to the start of the sound if there are loops left */
+static int NextLoop(SDL_MixerVoice *voice)
+{
+	if ( voice->loops == 0 ) {
+		return(0);
+	}
+	if ( voice->loops > 0 ) {
+		--voice->loops;
+	}
+	voice->position = 0;
+	return(1);
+}
+
+/* Pick the voice up at the same place in the sound at the new pitch */
+static void Repitch(SDL_MixerVoice *voice, SDL_Resampler **resamplers)
+{
+	SDL_MixerSound *sound = voice->sound;
+	SDL_Resampler *resampler;
+	int position;
+
+	if ( sound == NULL ) {
+		SetResamplers(voice, resamplers);
+		return;
+	}
+
+	/* The frames already put into the old resampler but not reached
+	   are played again.  The tail of a flushed sound isn't, since the
+	   padding put after it can't be told apart from the frames. */
+	position = voice->position;
+	resampler = VoiceResampler(voice);
+	if ( voice->flushed ) {
+		position = sound->frames;
+	} else if ( resampler ) {
+		position -= SDL_ResamplerPending(resampler);
+		if ( position < 0 ) {
+			position += sound->frames;
+			if ( voice->loops >= 0 ) {
+				++voice->loops;
+			}
+		}
+	}
+	voice->position = position;
+	voice->flushed = 0;
+
+	SetResamplers(voice, resamplers);
+	resampler = VoiceResampler(voice);
+	if ( resampler ) {
+		SDL_ResamplerPrime(resampler, (Uint8 *)sound->data, position);
+	}
+}
+
+static void RunCommand(SDL_AudioMixer *mixer, SDL_MixerCommand *command)
+{
+	SDL_MixerVoice *voice = &mixer->voices[command->voice];
+	SDL_Resampler *resampler;
+
+	switch (command->type) {
+	    case MIXER_PLAY:
+		if ( voice->sound ) {
+			EndVoice(voice);
+		}
+		voice->sound = command->sound;
+		command->sound = NULL;
+		voice->position = 0;
+		voice->loops = command->loops;
+		voice->flushed = 0;
+		resampler = VoiceResampler(voice);
+		if ( resampler ) {
+			SDL_ResetResampler(resampler);
+		}
+		AimVoice(mixer, voice);
+		memcpy(voice->gain, voice->target, sizeof(voice->gain));
+		voice->ramp = 0;
+		break;
+	    case MIXER_STOP:
+		if ( voice->sound ) {
+			EndVoice(voice);
+		}
+		break;
+	    case MIXER_VOLUME:
+	    case MIXER_PAN:
+		if ( command->type == MIXER_VOLUME ) {
+			voice->volume = command->value;
+		} else {
+			voice->pan = command->value;
+		}
+		if ( voice->sound ) {
+			AimVoice(mixer, voice);
+			voice->ramp = MIXER_RAMP;
+		}
+		break;
+	    case MIXER_PITCH:
+		Repitch(voice, command->resamplers);
+		command->resamplers[0] = NULL;
+		command->resamplers[1] = NULL;
+		break;
+	}
+}
+
+/* Add a voice to the sum, moving the gains towards their targets */
+static void AddVoice(SDL_AudioMixer *mixer, SDL_MixerVoice *voice,
+                     const float *src, float *sum, int frames)
+{
+	int channels = mixer->channels;
+	int stride = voice->sound->channels;
+	float step[MIXER_MAXCHANNELS];
+	float *gain = voice->gain;
+	int i, c, n;
+
+	n = voice->ramp;
+	if ( n > frames ) {
+		n = frames;
+	}
+	if ( n > 0 ) {
+		for ( c=0; c<channels; ++c ) {
+			step[c] = (voice->target[c] - gain[c]) / voice->ramp;
+		}
+		for ( i=0; i<n; ++i ) {
+			for ( c=0; c<channels; ++c ) {
+				gain[c] += step[c];
+				sum[c] += src[(stride == 1) ? 0 : c] * gain[c];
+			}
+			src += stride;
+			sum += channels;
+		}
+		voice->ramp -= n;
+		if ( voice->ramp == 0 ) {
+			memcpy(gain, voice->target, sizeof(voice->gain));
+		}
+		frames -= n;
+	}
+
+	if ( mixer->add ) {
+		n = mixer->add(src, stride, sum, channels, gain, frames);
+		src += n*stride;
+		sum += n*channels;
+		frames -= n;
+	}
+	if ( stride == 1 ) {
+		if ( channels == 1 ) {
+			for ( i=0; i<frames; ++i ) {
+				sum[i] += src[i] * gain[0];
+			}
+		} else if ( channels == 2 ) {
+			for ( i=0; i<frames; ++i, sum+=2 ) {
+				sum[0] += src[i] * gain[0];
+				sum[1] += src[i] * gain[1];
+			}
+		} else {
+			for ( i=0; i<frames; ++i, sum+=channels ) {
+				for ( c=0; c<channels; ++c ) {
+					sum[c] += src[i] * gain[c];
+				}
+			}
+		}
+	} else if ( channels == 2 ) {
+		for ( i=0; i<frames; ++i, src+=2, sum+=2 ) {
+			sum[0] += src[0] * gain[0];
+			sum[1] += src[1] * gain[1];
+		}
+	} else {
+		for ( i=0; i<frames; ++i ) {
+			for ( c=0; c<channels; ++c ) {
+				*sum++ += *src++ * gain[c];
+			}
+		}
+	}
+}
+
+/* Resample up to 'frames' frames of the voice into the scratch buffer,
+   returns fewer when the sound ends */
+static int ResampleVoice(SDL_AudioMixer *mixer, SDL_MixerVoice *voice,
+                         SDL_Resampler *resampler, int frames)
+{
+	SDL_MixerSound *sound = voice->sound;
+	int got, n;
+
+	got = 0;
+	for ( ;; ) {
+		got += SDL_ResamplerGet(resampler,
+		                        (Uint8 *)(mixer->scratch +
+		                                  got*sound->channels),
+		                        frames - got);
+		if ( (got == frames) || voice->flushed ) {
+			break;
+		}
+
+		/* Feed it the next block of the sound */
+		n = sound->frames - voice->position;
+		if ( n > MIXER_BLOCK ) {
+			n = MIXER_BLOCK;
+		}
+		if ( SDL_ResamplerPut(resampler, (Uint8 *)(sound->data +
+		                      voice->position*sound->channels), n) < 0 ) {
+			break;
+		}
+		voice->position += n;
+		if ( (voice->position == sound->frames) && ! NextLoop(voice) ) {
+			SDL_ResamplerFlush(resampler);
+			voice->flushed = 1;
+		}
+	}
+	return(got);
+}
+
+static void MixVoice(SDL_AudioMixer *mixer, SDL_MixerVoice *voice,
+                     float *sum, int frames)
+{
+	SDL_MixerSound *sound;
+	SDL_Resampler *resampler;
+	int n;
+
+	while ( (frames > 0) && voice->sound ) {
+		sound = voice->sound;
+		resampler = VoiceResampler(voice);
+		if ( resampler ) {
+			n = ResampleVoice(mixer, voice, resampler, frames);
+			AddVoice(mixer, voice, mixer->scratch, sum, n);
+			if ( n < frames ) {
+				EndVoice(voice);
+			}
+		} else {
+			n = sound->frames - voice->position;
+			if ( n > frames ) {
+				n = frames;
+			}
+			AddVoice(mixer, voice,
+			         sound->data + voice->position*sound->channels,
+			         sum, n);
+			voice->position += n;
+			if ( (voice->position == sound->frames) &&
+			     ! NextLoop(voice) ) {
+				EndVoice(voice);
+			}
+		}
+		sum += n*mixer->channels;
+		frames -= n;
+	}
+}
+
+/* Run the changes that are due, and return how many of the next
+   'frames' frames can be mixed before the next one is */
+static int RunCommands(SDL_AudioMixer *mixer, int frames)
+{
+	SDL_MixerCommand *event;
+	Sint32 ahead;
+	int i;
+
+	i = 0;
+	while ( i < mixer->num_events ) {
+		event = &mixer->events[i];
+		ahead = (Sint32)(event->frame - mixer->frame);
+		if ( ahead <= 0 ) {
+			RunCommand(mixer, event);
+			DiscardCommand(event);
+			--mixer->num_events;
+			memmove(event, event+1,
+			        (mixer->num_events-i)*sizeof(*event));
+		} else {
+			if ( ahead < frames ) {
+				frames = ahead;
+			}
+			++i;
+		}
+	}
+	return(frames);
+}
+
+void SDL_MixVoices(void *userdata, Uint8 *stream, int len)
+{
+	SDL_AudioMixer *mixer = (SDL_AudioMixer *)userdata;
+	int frames, n, i;
+
+	/* Take the changes the application has queued */
+	SDL_mutexP(mixer->lock);
+	n = mixer->max_commands - mixer->num_events;
+	if ( n > mixer->num_queued ) {
+		n = mixer->num_queued;
+	}
+	memcpy(mixer->events+mixer->num_events, mixer->queued,
+	       n*sizeof(SDL_MixerCommand));
+	mixer->num_events += n;
+	mixer->num_queued -= n;
+	memmove(mixer->queued, mixer->queued+n,
+	        mixer->num_queued*sizeof(SDL_MixerCommand));
+	SDL_mutexV(mixer->lock);
+
+	frames = len / mixer->framesize;
+	while ( frames > 0 ) {
+		n = RunCommands(mixer,
+		                (frames < MIXER_BLOCK) ? frames : MIXER_BLOCK);
+		memset(mixer->sum, 0, n*mixer->channels*sizeof(float));
+		for ( i=0; i<mixer->num_voices; ++i ) {
+			if ( mixer->voices[i].sound ) {
+				MixVoice(mixer, &mixer->voices[i],
+				         mixer->sum, n);
+			}
+		}
+
+		/* Clip the sum and convert it to the output format */
+		mixer->cvt.buf = (Uint8 *)mixer->sum;
+		mixer->cvt.len = n*mixer->channels*sizeof(float);
+		SDL_ConvertAudio(&mixer->cvt);
+		memcpy(stream, mixer->sum, mixer->cvt.len_cvt);
+		stream += mixer->cvt.len_cvt;
+		frames -= n;
+		mixer->frame += n;
+	}
+	for ( i=0; i<mixer->num_voices; ++i ) {
+		mixer->voices[i].playing = (mixer->voices[i].sound != NULL);
+	}
+}
+
+Uint32 SDL_GetMixerFrame(SDL_AudioMixer *mixer)
+{
+	return(mixer->frame);
+}
+
+void SDL_FreeAudioMixer(SDL_AudioMixer *mixer)
+{
+	SDL_Resampler *none[2];
+	int i;
+
+	if ( mixer == NULL ) {
+		return;
+	}
+	if ( mixer->voices ) {
+		none[0] = NULL;
+		none[1] = NULL;
+		for ( i=0; i<mixer->num_voices; ++i ) {
+			if ( mixer->voices[i].sound ) {
+				EndVoice(&mixer->voices[i]);
+			}
+			SetResamplers(&mixer->voices[i], none);
+		}
+		free(mixer->voices);
+	}
+	if ( mixer->queued ) {
+		for ( i=0; i<mixer->num_queued; ++i ) {
+			DiscardCommand(&mixer->queued[i]);
+		}
+		free(mixer->queued);
+	}
+	if ( mixer->events ) {
+		for ( i=0; i<mixer->num_events; ++i ) {
+			DiscardCommand(&mixer->events[i]);
+		}
+		free(mixer->events);
+	}
+	if ( mixer->lock ) {
+		SDL_DestroyMutex(mixer->lock);
+	}
+	if ( mixer->scratch ) {
+		free(mixer->scratch);
+	}
+	if ( mixer->sum ) {
+		free(mixer->sum);
+	}
+	free(mixer);
+}
+
+SDL_MixerSound *SDL_CreateMixerSound(SDL_AudioMixer *mixer,
+                   const SDL_AudioSpec *spec, const Uint8 *buf, Uint32 len)
+{
+	SDL_AudioStream *stream;
+	SDL_MixerSound *sound;
+	int channels, size;
+
+	channels = (spec->channels == 1) ? 1 : mixer->channels;
+	stream = SDL_CreateAudioStream(spec->format, spec->channels, spec->freq,
+	                           AUDIO_F32SYS, channels, mixer->freq);
+	if ( stream == NULL ) {
+		return(NULL);
+	}
+	if ( (SDL_AudioStreamPut(stream, buf, (int)len) < 0) ||
+	     (SDL_AudioStreamFlush(stream) < 0) ) {
+		SDL_FreeAudioStream(stream);
+		return(NULL);
+	}
+	size = SDL_AudioStreamAvailable(stream);
+	if ( size < (int)(channels*sizeof(float)) ) {
+		SDL_FreeAudioStream(stream);
+		SDL_SetError("Invalid audio length");
+		return(NULL);
+	}
+
+	sound = (SDL_MixerSound *)malloc(sizeof(*sound));
+	if ( sound == NULL ) {
+		SDL_FreeAudioStream(stream);
+		SDL_OutOfMemory();
+		return(NULL);
+	}
+	sound->data = (float *)malloc(size);
+	if ( sound->data == NULL ) {
+		free(sound);
+		SDL_FreeAudioStream(stream);
+		SDL_OutOfMemory();
+		return(NULL);
+	}
+	size = SDL_AudioStreamGet(stream, sound->data, size);
+	SDL_FreeAudioStream(stream);
+	sound->mixer = mixer;
+	sound->channels = channels;
+	sound->frames = size / (channels*sizeof(float));
+	sound->refcount = 1;
+	return(sound);
+}
+
+void SDL_FreeMixerSound(SDL_MixerSound *sound)
+{
+	if ( sound ) {
+		ReleaseSound(sound);
+	}
+}
+
+static int ValidVoice(SDL_AudioMixer *mixer, int voice)
+{
+	if ( (voice < 0) || (voice >= mixer->num_voices) ) {
+		SDL_SetError("Invalid voice %d", voice);
+		return(0);
+	}
+	return(1);
+}
+
+/* Queue a change, taking a reference to its sound */
+static int SendCommand(SDL_AudioMixer *mixer, SDL_MixerCommand *command)
+{
+	SDL_mutexP(mixer->lock);
+	if ( mixer->num_queued == mixer->max_commands ) {
+		SDL_mutexV(mixer->lock);
+		SDL_SetError("Too many mixer changes waiting");
+		return(-1);
+	}
+	if ( command->sound ) {
+		++command->sound->refcount;
+	}
+	mixer->queued[mixer->num_queued++] = *command;
+	SDL_mutexV(mixer->lock);
+	return(0);
+}
+
+static int SendVoiceCommand(SDL_AudioMixer *mixer, int type, int voice,
+                            float value)
+{
+	SDL_MixerCommand command;
+
+	if ( ! ValidVoice(mixer, voice) ) {
+		return(-1);
+	}
+	memset(&command, 0, sizeof(command));
+	command.type = type;
+	command.voice = voice;
+	command.frame = mixer->frame;
+	command.value = value;
+	return(SendCommand(mixer, &command));
+}
+
+int SDL_PlayVoice(SDL_AudioMixer *mixer, int voice, SDL_MixerSound *sound,
+                  int loops, Uint32 frame)
+{
+	SDL_MixerCommand command;
+
+	if ( ! ValidVoice(mixer, voice) ) {
+		return(-1);
+	}
+	if ( (sound == NULL) || (sound->mixer != mixer) ) {
+		SDL_SetError("The sound wasn't made for this mixer");
+		return(-1);
+	}
+	memset(&command, 0, sizeof(command));
+	command.type = MIXER_PLAY;
+	command.voice = voice;
+	command.frame = frame;
+	command.sound = sound;
+	command.loops = (loops < 0) ? -1 : loops;
+	return(SendCommand(mixer, &command));
+}
+
+int SDL_StopVoice(SDL_AudioMixer *mixer, int voice, Uint32 frame)
+{
+	SDL_MixerCommand command;
+
+	if ( ! ValidVoice(mixer, voice) ) {
+		return(-1);
+	}
+	memset(&command, 0, sizeof(command));
+	command.type = MIXER_STOP;
+	command.voice = voice;
+	command.frame = frame;
+	return(SendCommand(mixer, &command));
+}
+
+int SDL_VoicePlaying(SDL_AudioMixer *mixer, int voice)
+{
+	if ( ! ValidVoice(mixer, voice) ) {
+		return(0);
+	}
+	return(mixer->voices[voice].playing);
+}
+
+int SDL_SetVoiceVolume(SDL_AudioMixer *mixer, int voice, float volume)
+{
+	if ( volume < 0.0f ) {
+		volume = 0.0f;
+	}
+	return(SendVoiceCommand(mixer, MIXER_VOLUME, voice, volume));
+}
+
+int SDL_SetVoicePan(SDL_AudioMixer *mixer, int voice, float pan)
+{
+	if ( pan < -1.0f ) {
+		pan = -1.0f;
+	}
+	if ( pan > 1.0f ) {
+		pan = 1.0f;
+	}
+	return(SendVoiceCommand(mixer, MIXER_PAN, voice, pan));
+}
+
+int SDL_SetVoicePitch(SDL_AudioMixer *mixer, int voice, float pitch)
+{
+	SDL_MixerCommand command;
+	int rate;
+
+	if ( ! ValidVoice(mixer, voice) ) {
+		return(-1);
+	}
+	if ( ! (pitch > 0.0f) ) {
+		SDL_SetError("Invalid pitch");
+		return(-1);
+	}
+	if ( pitch < MIXER_MINPITCH ) {
+		pitch = MIXER_MINPITCH;
+	}
+	if ( pitch > MIXER_MAXPITCH ) {
+		pitch = MIXER_MAXPITCH;
+	}
+	memset(&command, 0, sizeof(command));
+	command.type = MIXER_PITCH;
+	command.voice = voice;
+	command.frame = mixer->frame;
+	command.value = pitch;
+
+	/* The filters are built here rather than in the mixing thread,
+	   one for mono sounds and one for the others */
+	rate = (int)(mixer->freq * pitch + 0.5f);
+	if ( rate != mixer->freq ) {
+		command.resamplers[0] = SDL_CreateResampler(AUDIO_F32SYS, 1,
+		                                          rate, mixer->freq);
+		if ( command.resamplers[0] == NULL ) {
+			return(-1);
+		}
+		if ( mixer->channels > 1 ) {
+			command.resamplers[1] = SDL_CreateResampler(
+			                        AUDIO_F32SYS, mixer->channels,
+			                        rate, mixer->freq);
+			if ( command.resamplers[1] == NULL ) {
+				DiscardCommand(&command);
+				return(-1);
+			}
+		}
+	}
+	if ( SendCommand(mixer, &command) < 0 ) {
+		DiscardCommand(&command);
+		return(-1);
+	}
+	return(0);
+}
@@ -0,0 +1,196 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997, 1998, 1999, 2000, 2001, 2002  Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the Free
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+
+#ifdef SAVE_RCSID
+static char rcsid =
+ "@(#) $Id$";
+#endif
+
+/* A single producer, single consumer ring buffer for SDL_QueueAudio()
+
+   'head' and 'tail' count the bytes ever put and taken, so the queued
+   size is their difference and wraps around without any special case.
+   Only the producer moves 'head'.  'tail' is moved with compare and swap,
+   since SDL_ClearQueuedAudio() moves it from the other side: if the queue
+   is cleared while the audio thread reads it, the producer may already be
+   writing over what was read, so the read is thrown away.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "SDL_audio.h"
+#include "SDL_mutex.h"
+#include "SDL_audioqueue_c.h"
+#include "SDL_atomic_c.h"
+
+struct SDL_AudioQueue {
+	Uint8 *buf;
+	Uint32 size;		/* A power of two */
+	int framesize;
+	Uint8 silence;
+	volatile Uint32 head;
+	volatile Uint32 tail;
+#ifndef SDL_HAVE_ATOMICS
+	SDL_mutex *lock;
+#endif
+};
+
+#ifdef SDL_HAVE_ATOMICS
+#define LOCK_QUEUE(queue)
+#define UNLOCK_QUEUE(queue)
+#else
+#define LOCK_QUEUE(queue)	SDL_mutexP(queue->lock)
+#define UNLOCK_QUEUE(queue)	SDL_mutexV(queue->lock)
+#endif
+
+SDL_AudioQueue *SDL_CreateAudioQueue(Uint32 size, int framesize,
+                                     Uint8 silence)
+{
+	SDL_AudioQueue *queue;
+	Uint32 ring_size;
+
+	queue = (SDL_AudioQueue *)malloc(sizeof(*queue));
+	if ( queue == NULL ) {
+		return(NULL);
+	}
+	memset(queue, 0, sizeof(*queue));
+	for ( ring_size=1024; ring_size < size; ring_size *= 2 ) {
+		/* Round up to a power of two */;
+	}
+	queue->buf = (Uint8 *)malloc(ring_size);
+#ifndef SDL_HAVE_ATOMICS
+	queue->lock = SDL_CreateMutex();
+	if ( queue->lock == NULL ) {
+		SDL_FreeAudioQueue(queue);
+		return(NULL);
+	}
+#endif
+	if ( queue->buf == NULL ) {
+		SDL_FreeAudioQueue(queue);
+		return(NULL);
+	}
+	queue->size = ring_size;
+	queue->framesize = framesize;
+	queue->silence = silence;
+	return(queue);
+}
+
+int SDL_AudioQueuePut(SDL_AudioQueue *queue, const void *data, Uint32 len)
+{
+	const Uint8 *src = (const Uint8 *)data;
+	Uint32 head, pos, part;
+	int retval;
+
+	retval = -1;
+	LOCK_QUEUE(queue);
+	head = queue->head;
+	if ( len <= (queue->size - (head - queue->tail)) ) {
+		pos = head & (queue->size - 1);
+		part = queue->size - pos;
+		if ( part > len ) {
+			part = len;
+		}
+		memcpy(queue->buf + pos, src, part);
+		memcpy(queue->buf, src + part, len - part);
+
+		/* The audio has to be there before the audio thread sees it */
+		SDL_MemoryBarrier();
+		queue->head = head + len;
+		retval = 0;
+	}
+	UNLOCK_QUEUE(queue);
+	return(retval);
+}
+
+Uint32 SDL_AudioQueueGet(SDL_AudioQueue *queue, Uint8 *buf, Uint32 len)
+{
+	Uint32 head, tail, pos, part, got;
+
+	LOCK_QUEUE(queue);
+	tail = queue->tail;
+	head = queue->head;
+	SDL_MemoryBarrier();
+
+	got = head - tail;
+	if ( got > len ) {
+		got = len;
+	}
+	got -= got % queue->framesize;
+	pos = tail & (queue->size - 1);
+	part = queue->size - pos;
+	if ( part > got ) {
+		part = got;
+	}
+	memcpy(buf, queue->buf + pos, part);
+	memcpy(buf + part, queue->buf, got - part);
+
+	/* Finish reading before the space is handed back */
+	SDL_MemoryBarrier();
+	if ( ! SDL_AtomicCAS(&queue->tail, tail, tail + got) ) {
+		got = 0;
+	}
+	UNLOCK_QUEUE(queue);
+
+	memset(buf + got, queue->silence, len - got);
+	return(got);
+}
+
+Uint32 SDL_AudioQueueSize(SDL_AudioQueue *queue)
+{
+	Uint32 tail, queued;
+
+	/* Reading the tail first keeps the difference from going negative */
+	tail = queue->tail;
+	SDL_MemoryBarrier();
+	queued = queue->head - tail;
+	if ( queued > queue->size ) {
+		queued = queue->size;
+	}
+	return(queued);
+}
+
+void SDL_AudioQueueClear(SDL_AudioQueue *queue)
+{
+	Uint32 tail;
+
+	LOCK_QUEUE(queue);
+	do {
+		tail = queue->tail;
+	} while ( ! SDL_AtomicCAS(&queue->tail, tail, queue->head) );
+	UNLOCK_QUEUE(queue);
+}
+
+void SDL_FreeAudioQueue(SDL_AudioQueue *queue)
+{
+	if ( queue ) {
+#ifndef SDL_HAVE_ATOMICS
+		if ( queue->lock ) {
+			SDL_DestroyMutex(queue->lock);
+		}
+#endif
+		if ( queue->buf ) {
+			free(queue->buf);
+		}
+		free(queue);
+	}
+}
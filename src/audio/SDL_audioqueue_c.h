@@ -0,0 +1,64 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997, 1998, 1999, 2000, 2001, 2002  Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the Free
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+
+#ifdef SAVE_RCSID
+static char rcsid =
+ "@(#) $Id$";
+#endif
+
+/* The queue behind SDL_QueueAudio()
+
+   One thread puts audio in and the audio thread takes it out, and
+   neither ever waits for the other.  The queue has a fixed size.
+*/
+
+#ifndef _SDL_audioqueue_c_h
+#define _SDL_audioqueue_c_h
+
+#include "SDL_audio.h"
+
+typedef struct SDL_AudioQueue SDL_AudioQueue;
+
+/* Create a queue holding at least 'size' bytes, which are read out in
+   whole frames of 'framesize' bytes.  Returns NULL if out of memory.
+*/
+extern SDL_AudioQueue *SDL_CreateAudioQueue(Uint32 size, int framesize,
+                                            Uint8 silence);
+
+/* Add all of 'len' bytes, or return -1 if they don't fit */
+extern int SDL_AudioQueuePut(SDL_AudioQueue *queue,
+                             const void *data, Uint32 len);
+
+/* Read as many whole frames as are queued, up to 'len' bytes, and fill
+   the rest of the buffer with silence.  Returns the number of bytes read.
+*/
+extern Uint32 SDL_AudioQueueGet(SDL_AudioQueue *queue, Uint8 *buf, Uint32 len);
+
+/* Returns the number of bytes queued */
+extern Uint32 SDL_AudioQueueSize(SDL_AudioQueue *queue);
+
+/* Throw away everything queued, from any thread */
+extern void SDL_AudioQueueClear(SDL_AudioQueue *queue);
+
+extern void SDL_FreeAudioQueue(SDL_AudioQueue *queue);
+
+#endif /* _SDL_audioqueue_c_h */
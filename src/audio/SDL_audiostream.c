@@ -0,0 +1,360 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997, 1998, 1999, 2000, 2001, 2002  Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the Free
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+
+#ifdef SAVE_RCSID
+static char rcsid =
+ "@(#) $Id$";
+#endif
+
+/* Streaming audio conversion
+
+   A stream runs its input through an SDL_AudioCVT at the source rate,
+   a fixed number of frames at a time, so the conversion buffer is
+   allocated once.  The result goes through a resampler if the rates
+   differ, and ends up in a ring buffer that is read from at any size.
+   The ring only grows when more is put than is read.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "SDL_error.h"
+#include "SDL_audio.h"
+#include "SDL_resample_c.h"
+
+/* Source frames converted per pass */
+#define STREAM_CHUNK	1024
+
+struct SDL_AudioStream {
+	SDL_AudioCVT cvt;
+	SDL_Resampler *resampler;
+	int src_framesize;
+	int dst_framesize;
+
+	/* Part of a source frame left over from the last put */
+	Uint8 *partial;
+	int partial_len;
+
+	/* Converted output, 'fill' bytes starting at 'head' */
+	Uint8 *ring;
+	int ring_size;
+	int head;
+	int fill;
+};
+
+SDL_AudioStream *SDL_CreateAudioStream(
+		Uint16 src_format, Uint8 src_channels, int src_rate,
+		Uint16 dst_format, Uint8 dst_channels, int dst_rate)
+{
+	SDL_AudioStream *stream;
+
+	if ( (src_channels == 0) || (dst_channels == 0) ) {
+		SDL_SetError("Invalid number of channels");
+		return(NULL);
+	}
+	stream = (SDL_AudioStream *)malloc(sizeof(*stream));
+	if ( stream == NULL ) {
+		SDL_OutOfMemory();
+		return(NULL);
+	}
+	memset(stream, 0, sizeof(*stream));
+	stream->src_framesize = ((src_format & 0xFF) / 8) * src_channels;
+	stream->dst_framesize = ((dst_format & 0xFF) / 8) * dst_channels;
+
+	/* Formats are converted at the source rate, then resampled */
+	if ( SDL_BuildAudioCVT(&stream->cvt,
+	                       src_format, src_channels, src_rate,
+	                       dst_format, dst_channels, src_rate) < 0 ) {
+		SDL_FreeAudioStream(stream);
+		return(NULL);
+	}
+	if ( src_rate != dst_rate ) {
+		stream->resampler = SDL_CreateResampler(dst_format,
+		                            dst_channels, src_rate, dst_rate);
+		if ( stream->resampler == NULL ) {
+			SDL_FreeAudioStream(stream);
+			return(NULL);
+		}
+	}
+	stream->cvt.len = STREAM_CHUNK * stream->src_framesize;
+	stream->cvt.buf = (Uint8 *)malloc(stream->cvt.len *
+	                                  stream->cvt.len_mult);
+	stream->partial = (Uint8 *)malloc(stream->src_framesize);
+	stream->ring_size = 2 * STREAM_CHUNK * stream->dst_framesize;
+	stream->ring = (Uint8 *)malloc(stream->ring_size);
+	if ( !stream->cvt.buf || !stream->partial || !stream->ring ) {
+		SDL_FreeAudioStream(stream);
+		SDL_OutOfMemory();
+		return(NULL);
+	}
+	return(stream);
+}
+
+/* Make sure there is room for 'len' more bytes in the ring */
+static int SDL_AudioStreamRoom(SDL_AudioStream *stream, int len)
+{
+	Uint8 *ring;
+	int size, first;
+
+	if ( (stream->fill + len) <= stream->ring_size ) {
+		return(0);
+	}
+	size = stream->ring_size * 2;
+	if ( size < (stream->fill + len) ) {
+		size = stream->fill + len;
+	}
+	ring = (Uint8 *)malloc(size);
+	if ( ring == NULL ) {
+		SDL_OutOfMemory();
+		return(-1);
+	}
+	first = stream->ring_size - stream->head;
+	if ( first > stream->fill ) {
+		first = stream->fill;
+	}
+	memcpy(ring, stream->ring + stream->head, first);
+	memcpy(ring + first, stream->ring, stream->fill - first);
+	free(stream->ring);
+	stream->ring = ring;
+	stream->ring_size = size;
+	stream->head = 0;
+	return(0);
+}
+
+/* Returns the contiguous free space at the end of the data in the ring */
+static Uint8 *SDL_AudioStreamTail(SDL_AudioStream *stream, int *len)
+{
+	int tail = stream->head + stream->fill;
+
+	if ( tail >= stream->ring_size ) {
+		tail -= stream->ring_size;
+		*len = stream->head - tail;
+	} else {
+		*len = stream->ring_size - tail;
+	}
+	return(stream->ring + tail);
+}
+
+static int SDL_AudioStreamWrite(SDL_AudioStream *stream,
+                                const Uint8 *buf, int len)
+{
+	Uint8 *tail;
+	int n;
+
+	if ( SDL_AudioStreamRoom(stream, len) < 0 ) {
+		return(-1);
+	}
+	while ( len > 0 ) {
+		tail = SDL_AudioStreamTail(stream, &n);
+		if ( n > len ) {
+			n = len;
+		}
+		memcpy(tail, buf, n);
+		stream->fill += n;
+		buf += n;
+		len -= n;
+	}
+	return(0);
+}
+
+/* Move whatever the resampler can produce into the ring */
+static int SDL_AudioStreamDrain(SDL_AudioStream *stream)
+{
+	int framesize = stream->dst_framesize;
+	int frames, got, n;
+	Uint8 *tail;
+
+	frames = SDL_ResamplerAvailable(stream->resampler);
+	if ( SDL_AudioStreamRoom(stream, frames*framesize) < 0 ) {
+		return(-1);
+	}
+	while ( frames > 0 ) {
+		/* The ring and everything in it is in whole frames */
+		tail = SDL_AudioStreamTail(stream, &n);
+		n /= framesize;
+		if ( n > frames ) {
+			n = frames;
+		}
+		got = SDL_ResamplerGet(stream->resampler, tail, n);
+		if ( got == 0 ) {
+			break;
+		}
+		stream->fill += got*framesize;
+		frames -= got;
+	}
+	return(0);
+}
+
+/* Convert whole source frames and queue the result */
+static int SDL_AudioStreamConvert(SDL_AudioStream *stream,
+                                  const Uint8 *buf, int frames)
+{
+	SDL_AudioCVT *cvt = &stream->cvt;
+	int len = frames * stream->src_framesize;
+	Uint8 *data = (Uint8 *)buf;
+
+	if ( cvt->needed ) {
+		memcpy(cvt->buf, buf, len);
+		cvt->len = len;
+		SDL_ConvertAudio(cvt);
+		data = cvt->buf;
+		len = cvt->len_cvt;
+	}
+	if ( stream->resampler ) {
+		if ( SDL_ResamplerPut(stream->resampler, data,
+		                      len / stream->dst_framesize) < 0 ) {
+			return(-1);
+		}
+		return(SDL_AudioStreamDrain(stream));
+	}
+	return(SDL_AudioStreamWrite(stream, data, len));
+}
+
+int SDL_AudioStreamPut(SDL_AudioStream *stream, const void *buf, int len)
+{
+	const Uint8 *data = (const Uint8 *)buf;
+	int framesize = stream->src_framesize;
+	int frames, n;
+
+	if ( len < 0 ) {
+		SDL_SetError("Invalid audio length");
+		return(-1);
+	}
+
+	/* Finish the frame split by the last call */
+	if ( stream->partial_len > 0 ) {
+		n = framesize - stream->partial_len;
+		if ( n > len ) {
+			n = len;
+		}
+		memcpy(stream->partial + stream->partial_len, data, n);
+		stream->partial_len += n;
+		data += n;
+		len -= n;
+		if ( stream->partial_len < framesize ) {
+			return(0);
+		}
+		stream->partial_len = 0;
+		if ( SDL_AudioStreamConvert(stream, stream->partial, 1) < 0 ) {
+			return(-1);
+		}
+	}
+
+	while ( len >= framesize ) {
+		frames = len / framesize;
+		if ( frames > STREAM_CHUNK ) {
+			frames = STREAM_CHUNK;
+		}
+		if ( SDL_AudioStreamConvert(stream, data, frames) < 0 ) {
+			return(-1);
+		}
+		data += frames * framesize;
+		len -= frames * framesize;
+	}
+
+	/* Keep the start of a frame for next time */
+	if ( len > 0 ) {
+		memcpy(stream->partial, data, len);
+		stream->partial_len = len;
+	}
+	return(0);
+}
+
+int SDL_AudioStreamGet(SDL_AudioStream *stream, void *buf, int len)
+{
+	Uint8 *data = (Uint8 *)buf;
+	int got, n;
+
+	if ( len > stream->fill ) {
+		len = stream->fill;
+	}
+	len -= len % stream->dst_framesize;
+	got = len;
+	while ( len > 0 ) {
+		n = stream->ring_size - stream->head;
+		if ( n > len ) {
+			n = len;
+		}
+		memcpy(data, stream->ring + stream->head, n);
+		stream->head += n;
+		if ( stream->head == stream->ring_size ) {
+			stream->head = 0;
+		}
+		stream->fill -= n;
+		data += n;
+		len -= n;
+	}
+	if ( stream->fill == 0 ) {
+		stream->head = 0;
+	}
+	return(got);
+}
+
+int SDL_AudioStreamAvailable(SDL_AudioStream *stream)
+{
+	return(stream->fill);
+}
+
+int SDL_AudioStreamFlush(SDL_AudioStream *stream)
+{
+	int retval = 0;
+
+	/* A partial frame can't be converted, so it is dropped */
+	stream->partial_len = 0;
+	if ( stream->resampler ) {
+		if ( (SDL_ResamplerFlush(stream->resampler) < 0) ||
+		     (SDL_AudioStreamDrain(stream) < 0) ) {
+			retval = -1;
+		}
+		SDL_ResetResampler(stream->resampler);
+	}
+	return(retval);
+}
+
+void SDL_AudioStreamClear(SDL_AudioStream *stream)
+{
+	stream->partial_len = 0;
+	stream->head = 0;
+	stream->fill = 0;
+	if ( stream->resampler ) {
+		SDL_ResetResampler(stream->resampler);
+	}
+}
+
+void SDL_FreeAudioStream(SDL_AudioStream *stream)
+{
+	if ( stream ) {
+		if ( stream->resampler ) {
+			SDL_FreeResampler(stream->resampler);
+		}
+		if ( stream->cvt.buf ) {
+			free(stream->cvt.buf);
+		}
+		if ( stream->partial ) {
+			free(stream->partial);
+		}
+		if ( stream->ring ) {
+			free(stream->ring);
+		}
+		free(stream);
+	}
+}
@@ -0,0 +1,513 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997, 1998, 1999, 2000, 2001, 2002  Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the Free
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+
+#ifdef SAVE_RCSID
+static char rcsid =
+ "@(#) $Id$";
+#endif
+
+/* Single pass sample format and channel conversion
+
+   The filters in SDL_audiocvt.c each make a pass over the whole buffer,
+   so a conversion like U8 mono to S16MSB stereo goes over it four times.
+   These filters work through the buffer a block at a time instead,
+   unpacking each block to native 16-bit samples, mixing or duplicating
+   channels, and packing it to the destination format while it is still
+   in the cache.
+
+   The blocks only pay off with vector code; unpacking, mixing and packing
+   one sample at a time costs more than the passes of the filter chain,
+   so without SSE2 the chain is used as before.  The plain C versions
+   below finish off the samples left over by the vector loops.
+*/
+
+#include <string.h>
+
+#include "SDL_audio.h"
+#include "SDL_audiotypecvt_c.h"
+#include "SDL_simd.h"
+
+#ifdef SDL_SSE2_INTRINSICS
+
+/* Frames converted per block */
+#define TYPECVT_BLOCK	256
+
+typedef void (*SDL_UnpackFunc)(const Uint8 *src, Sint16 *dst, int samples);
+typedef void (*SDL_PackFunc)(const Sint16 *src, Uint8 *dst, int samples);
+
+static void Unpack_U8(const Uint8 *src, Sint16 *dst, int samples)
+{
+	int i;
+
+	for ( i=0; i<samples; ++i ) {
+		dst[i] = (Sint16)((src[i] ^ 0x80) << 8);
+	}
+}
+
+static void Unpack_S8(const Uint8 *src, Sint16 *dst, int samples)
+{
+	int i;
+
+	for ( i=0; i<samples; ++i ) {
+		dst[i] = (Sint16)(src[i] << 8);
+	}
+}
+
+static void Unpack_S16Native(const Uint8 *src, Sint16 *dst, int samples)
+{
+	memcpy(dst, src, samples*2);
+}
+
+static void Unpack_S16Swapped(const Uint8 *src, Sint16 *dst, int samples)
+{
+	const Uint16 *in = (const Uint16 *)src;
+	int i;
+
+	for ( i=0; i<samples; ++i ) {
+		dst[i] = (Sint16)((in[i] << 8) | (in[i] >> 8));
+	}
+}
+
+static void Unpack_U16Native(const Uint8 *src, Sint16 *dst, int samples)
+{
+	const Uint16 *in = (const Uint16 *)src;
+	int i;
+
+	for ( i=0; i<samples; ++i ) {
+		dst[i] = (Sint16)(in[i] ^ 0x8000);
+	}
+}
+
+static void Unpack_U16Swapped(const Uint8 *src, Sint16 *dst, int samples)
+{
+	const Uint16 *in = (const Uint16 *)src;
+	int i;
+
+	for ( i=0; i<samples; ++i ) {
+		dst[i] = (Sint16)(((in[i] << 8) | (in[i] >> 8)) ^ 0x8000);
+	}
+}
+
+/* Packing to 8 bits keeps the high byte, like SDL_Convert8() */
+static void Pack_U8(const Sint16 *src, Uint8 *dst, int samples)
+{
+	int i;
+
+	for ( i=0; i<samples; ++i ) {
+		dst[i] = (Uint8)((src[i] >> 8) ^ 0x80);
+	}
+}
+
+static void Pack_S8(const Sint16 *src, Uint8 *dst, int samples)
+{
+	int i;
+
+	for ( i=0; i<samples; ++i ) {
+		dst[i] = (Uint8)(src[i] >> 8);
+	}
+}
+
+static void Pack_S16Native(const Sint16 *src, Uint8 *dst, int samples)
+{
+	memcpy(dst, src, samples*2);
+}
+
+static void Pack_S16Swapped(const Sint16 *src, Uint8 *dst, int samples)
+{
+	Uint16 *out = (Uint16 *)dst;
+	int i;
+
+	for ( i=0; i<samples; ++i ) {
+		Uint16 x = (Uint16)src[i];
+		out[i] = (x << 8) | (x >> 8);
+	}
+}
+
+static void Pack_U16Native(const Sint16 *src, Uint8 *dst, int samples)
+{
+	Uint16 *out = (Uint16 *)dst;
+	int i;
+
+	for ( i=0; i<samples; ++i ) {
+		out[i] = (Uint16)src[i] ^ 0x8000;
+	}
+}
+
+static void Pack_U16Swapped(const Sint16 *src, Uint8 *dst, int samples)
+{
+	Uint16 *out = (Uint16 *)dst;
+	int i;
+
+	for ( i=0; i<samples; ++i ) {
+		Uint16 x = (Uint16)src[i] ^ 0x8000;
+		out[i] = (x << 8) | (x >> 8);
+	}
+}
+
+static void ToStereo(const Sint16 *src, Sint16 *dst, int frames)
+{
+	int i;
+
+	for ( i=0; i<frames; ++i ) {
+		dst[i*2+0] = src[i];
+		dst[i*2+1] = src[i];
+	}
+}
+
+/* Left and right are added and clipped, like SDL_ConvertMono() */
+static void ToMono(const Sint16 *src, Sint16 *dst, int frames)
+{
+	Sint32 sample;
+	int i;
+
+	for ( i=0; i<frames; ++i ) {
+		sample = src[i*2+0] + src[i*2+1];
+		if ( sample > 32767 ) {
+			sample = 32767;
+		} else if ( sample < -32768 ) {
+			sample = -32768;
+		}
+		dst[i] = (Sint16)sample;
+	}
+}
+
+SDL_TARGETING("sse2")
+static void Unpack_U8SSE2(const Uint8 *src, Sint16 *dst, int samples)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i sign = _mm_set1_epi8((char)0x80);
+	int i;
+
+	for ( i=0; i+16<=samples; i+=16 ) {
+		__m128i x = _mm_xor_si128(
+			_mm_loadu_si128((const __m128i *)(src+i)), sign);
+		_mm_storeu_si128((__m128i *)(dst+i), _mm_unpacklo_epi8(zero, x));
+		_mm_storeu_si128((__m128i *)(dst+i+8), _mm_unpackhi_epi8(zero, x));
+	}
+	Unpack_U8(src+i, dst+i, samples-i);
+}
+
+SDL_TARGETING("sse2")
+static void Unpack_S8SSE2(const Uint8 *src, Sint16 *dst, int samples)
+{
+	const __m128i zero = _mm_setzero_si128();
+	int i;
+
+	for ( i=0; i+16<=samples; i+=16 ) {
+		__m128i x = _mm_loadu_si128((const __m128i *)(src+i));
+		_mm_storeu_si128((__m128i *)(dst+i), _mm_unpacklo_epi8(zero, x));
+		_mm_storeu_si128((__m128i *)(dst+i+8), _mm_unpackhi_epi8(zero, x));
+	}
+	Unpack_S8(src+i, dst+i, samples-i);
+}
+
+SDL_TARGETING("sse2")
+static void Unpack_S16SwappedSSE2(const Uint8 *src, Sint16 *dst, int samples)
+{
+	int i;
+
+	for ( i=0; i+8<=samples; i+=8 ) {
+		__m128i x = _mm_loadu_si128((const __m128i *)(src+i*2));
+		x = _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));
+		_mm_storeu_si128((__m128i *)(dst+i), x);
+	}
+	Unpack_S16Swapped(src+i*2, dst+i, samples-i);
+}
+
+SDL_TARGETING("sse2")
+static void Unpack_U16NativeSSE2(const Uint8 *src, Sint16 *dst, int samples)
+{
+	const __m128i sign = _mm_set1_epi16((short)0x8000);
+	int i;
+
+	for ( i=0; i+8<=samples; i+=8 ) {
+		__m128i x = _mm_loadu_si128((const __m128i *)(src+i*2));
+		_mm_storeu_si128((__m128i *)(dst+i), _mm_xor_si128(x, sign));
+	}
+	Unpack_U16Native(src+i*2, dst+i, samples-i);
+}
+
+SDL_TARGETING("sse2")
+static void Unpack_U16SwappedSSE2(const Uint8 *src, Sint16 *dst, int samples)
+{
+	const __m128i sign = _mm_set1_epi16((short)0x8000);
+	int i;
+
+	for ( i=0; i+8<=samples; i+=8 ) {
+		__m128i x = _mm_loadu_si128((const __m128i *)(src+i*2));
+		x = _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));
+		_mm_storeu_si128((__m128i *)(dst+i), _mm_xor_si128(x, sign));
+	}
+	Unpack_U16Swapped(src+i*2, dst+i, samples-i);
+}
+
+SDL_TARGETING("sse2")
+static void Pack_U8SSE2(const Sint16 *src, Uint8 *dst, int samples)
+{
+	const __m128i sign = _mm_set1_epi8((char)0x80);
+	int i;
+
+	for ( i=0; i+16<=samples; i+=16 ) {
+		__m128i a = _mm_srai_epi16(
+			_mm_loadu_si128((const __m128i *)(src+i)), 8);
+		__m128i b = _mm_srai_epi16(
+			_mm_loadu_si128((const __m128i *)(src+i+8)), 8);
+		_mm_storeu_si128((__m128i *)(dst+i),
+		                 _mm_xor_si128(_mm_packs_epi16(a, b), sign));
+	}
+	Pack_U8(src+i, dst+i, samples-i);
+}
+
+SDL_TARGETING("sse2")
+static void Pack_S8SSE2(const Sint16 *src, Uint8 *dst, int samples)
+{
+	int i;
+
+	for ( i=0; i+16<=samples; i+=16 ) {
+		__m128i a = _mm_srai_epi16(
+			_mm_loadu_si128((const __m128i *)(src+i)), 8);
+		__m128i b = _mm_srai_epi16(
+			_mm_loadu_si128((const __m128i *)(src+i+8)), 8);
+		_mm_storeu_si128((__m128i *)(dst+i), _mm_packs_epi16(a, b));
+	}
+	Pack_S8(src+i, dst+i, samples-i);
+}
+
+SDL_TARGETING("sse2")
+static void Pack_S16SwappedSSE2(const Sint16 *src, Uint8 *dst, int samples)
+{
+	int i;
+
+	for ( i=0; i+8<=samples; i+=8 ) {
+		__m128i x = _mm_loadu_si128((const __m128i *)(src+i));
+		x = _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));
+		_mm_storeu_si128((__m128i *)(dst+i*2), x);
+	}
+	Pack_S16Swapped(src+i, dst+i*2, samples-i);
+}
+
+SDL_TARGETING("sse2")
+static void Pack_U16NativeSSE2(const Sint16 *src, Uint8 *dst, int samples)
+{
+	const __m128i sign = _mm_set1_epi16((short)0x8000);
+	int i;
+
+	for ( i=0; i+8<=samples; i+=8 ) {
+		__m128i x = _mm_loadu_si128((const __m128i *)(src+i));
+		_mm_storeu_si128((__m128i *)(dst+i*2), _mm_xor_si128(x, sign));
+	}
+	Pack_U16Native(src+i, dst+i*2, samples-i);
+}
+
+SDL_TARGETING("sse2")
+static void Pack_U16SwappedSSE2(const Sint16 *src, Uint8 *dst, int samples)
+{
+	const __m128i sign = _mm_set1_epi16((short)0x8000);
+	int i;
+
+	for ( i=0; i+8<=samples; i+=8 ) {
+		__m128i x = _mm_xor_si128(
+			_mm_loadu_si128((const __m128i *)(src+i)), sign);
+		x = _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));
+		_mm_storeu_si128((__m128i *)(dst+i*2), x);
+	}
+	Pack_U16Swapped(src+i, dst+i*2, samples-i);
+}
+
+SDL_TARGETING("sse2")
+static void ToStereoSSE2(const Sint16 *src, Sint16 *dst, int frames)
+{
+	int i;
+
+	for ( i=0; i+8<=frames; i+=8 ) {
+		__m128i x = _mm_loadu_si128((const __m128i *)(src+i));
+		_mm_storeu_si128((__m128i *)(dst+i*2), _mm_unpacklo_epi16(x, x));
+		_mm_storeu_si128((__m128i *)(dst+i*2+8),
+		                 _mm_unpackhi_epi16(x, x));
+	}
+	ToStereo(src+i, dst+i*2, frames-i);
+}
+
+SDL_TARGETING("sse2")
+static void ToMonoSSE2(const Sint16 *src, Sint16 *dst, int frames)
+{
+	int i;
+
+	for ( i=0; i+8<=frames; i+=8 ) {
+		__m128i a = _mm_loadu_si128((const __m128i *)(src+i*2));
+		__m128i b = _mm_loadu_si128((const __m128i *)(src+i*2+8));
+		/* Split the frames into left and right, sign extended */
+		__m128i la = _mm_srai_epi32(_mm_slli_epi32(a, 16), 16);
+		__m128i lb = _mm_srai_epi32(_mm_slli_epi32(b, 16), 16);
+		__m128i ra = _mm_srai_epi32(a, 16);
+		__m128i rb = _mm_srai_epi32(b, 16);
+		_mm_storeu_si128((__m128i *)(dst+i),
+		                 _mm_adds_epi16(_mm_packs_epi32(la, lb),
+		                                _mm_packs_epi32(ra, rb)));
+	}
+	ToMono(src+i*2, dst+i, frames-i);
+}
+
+typedef struct {
+	Uint16 format;
+	SDL_UnpackFunc unpack;
+	SDL_PackFunc pack;
+} SDL_SampleType;
+
+static const SDL_SampleType sample_types[] = {
+	{ AUDIO_U8, Unpack_U8SSE2, Pack_U8SSE2 },
+	{ AUDIO_S8, Unpack_S8SSE2, Pack_S8SSE2 },
+	{ AUDIO_S16SYS, Unpack_S16Native, Pack_S16Native },
+	{ AUDIO_S16SYS^0x1000, Unpack_S16SwappedSSE2, Pack_S16SwappedSSE2 },
+	{ AUDIO_U16SYS, Unpack_U16NativeSSE2, Pack_U16NativeSSE2 },
+	{ AUDIO_U16SYS^0x1000, Unpack_U16SwappedSSE2, Pack_U16SwappedSSE2 },
+	{ 0, NULL, NULL }
+};
+
+/* 8-bit formats have no byte order */
+static Uint16 SampleFormat(Uint16 format)
+{
+	if ( (format & 0xFF) == 8 ) {
+		format &= ~0x1000;
+	}
+	return(format);
+}
+
+static const SDL_SampleType *FindSampleType(Uint16 format)
+{
+	const SDL_SampleType *type;
+
+	type = sample_types;
+	format = SampleFormat(format);
+	while ( type->unpack ) {
+		if ( type->format == format ) {
+			return(type);
+		}
+		++type;
+	}
+	return(NULL);
+}
+
+static void SDL_ConvertType(SDL_AudioCVT *cvt, Uint16 format,
+                            int src_channels, int dst_channels)
+{
+	Sint16 unpacked[TYPECVT_BLOCK*2];
+	Sint16 mixed[TYPECVT_BLOCK*2];
+	const SDL_SampleType *src_type, *dst_type;
+	void (*mix)(const Sint16 *src, Sint16 *dst, int frames);
+	const Sint16 *out;
+	int src_frame, dst_frame;
+	int frames, first, step, i, n;
+
+	src_type = FindSampleType(format);
+	dst_type = FindSampleType(cvt->dst_format);
+	mix = NULL;
+	if ( src_channels < dst_channels ) {
+		mix = ToStereoSSE2;
+	} else if ( src_channels > dst_channels ) {
+		mix = ToMonoSSE2;
+	}
+	src_frame = ((format & 0xFF) / 8) * src_channels;
+	dst_frame = ((cvt->dst_format & 0xFF) / 8) * dst_channels;
+	frames = cvt->len_cvt / src_frame;
+
+	/* When the data grows, work back from the end so the output never
+	   lands on input that hasn't been read yet */
+	if ( dst_frame > src_frame ) {
+		first = ((frames - 1) / TYPECVT_BLOCK) * TYPECVT_BLOCK;
+		step = -TYPECVT_BLOCK;
+	} else {
+		first = 0;
+		step = TYPECVT_BLOCK;
+	}
+	for ( i=first; (i >= 0) && (i < frames); i += step ) {
+		n = frames - i;
+		if ( n > TYPECVT_BLOCK ) {
+			n = TYPECVT_BLOCK;
+		}
+		src_type->unpack(cvt->buf + i*src_frame, unpacked,
+		                 n*src_channels);
+		out = unpacked;
+		if ( mix ) {
+			mix(unpacked, mixed, n);
+			out = mixed;
+		}
+		dst_type->pack(out, cvt->buf + i*dst_frame, n*dst_channels);
+	}
+	cvt->len_cvt = frames * dst_frame;
+
+	format = cvt->dst_format;
+	if ( cvt->filters[++cvt->filter_index] ) {
+		cvt->filters[cvt->filter_index](cvt, format);
+	}
+}
+
+/* Without a change in channels every sample is converted on its own,
+   so the samples are counted as mono frames */
+static void SDL_ConvertTypeSame(SDL_AudioCVT *cvt, Uint16 format)
+{
+	SDL_ConvertType(cvt, format, 1, 1);
+}
+
+static void SDL_ConvertTypeStereo(SDL_AudioCVT *cvt, Uint16 format)
+{
+	SDL_ConvertType(cvt, format, 1, 2);
+}
+
+static void SDL_ConvertTypeMono(SDL_AudioCVT *cvt, Uint16 format)
+{
+	SDL_ConvertType(cvt, format, 2, 1);
+}
+
+SDL_AudioFilter SDL_ChooseTypeCVT(Uint16 src_format, int src_channels,
+                                  Uint16 dst_format, int dst_channels)
+{
+	if ( ! SDL_HasSSE2() ) {
+		return(NULL);
+	}
+	if ( !FindSampleType(src_format) || !FindSampleType(dst_format) ) {
+		return(NULL);
+	}
+	if ( src_channels == dst_channels ) {
+		if ( SampleFormat(src_format) == SampleFormat(dst_format) ) {
+			return(NULL);
+		}
+		return(SDL_ConvertTypeSame);
+	}
+	if ( (src_channels == 1) && (dst_channels == 2) ) {
+		return(SDL_ConvertTypeStereo);
+	}
+	if ( (src_channels == 2) && (dst_channels == 1) ) {
+		return(SDL_ConvertTypeMono);
+	}
+	return(NULL);
+}
+
+#else
+
+SDL_AudioFilter SDL_ChooseTypeCVT(Uint16 src_format, int src_channels,
+                                  Uint16 dst_format, int dst_channels)
+{
+	return(NULL);
+}
+
+#endif /* SDL_SSE2_INTRINSICS */
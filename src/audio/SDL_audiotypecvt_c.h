@@ -0,0 +1,39 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997, 1998, 1999, 2000, 2001, 2002  Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the Free
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+
+#ifdef SAVE_RCSID
+static char rcsid =
+ "@(#) $Id$";
+#endif
+
+/* Single pass sample format and channel conversion for SDL_AudioCVT */
+
+#include "SDL_audio.h"
+
+typedef void (*SDL_AudioFilter)(SDL_AudioCVT *cvt, Uint16 format);
+
+/* Returns a filter doing the whole format and channel conversion in one
+   pass over the buffer, or NULL if there isn't one for these formats.
+   The filter converts 'len_cvt' bytes to cvt->dst_format.
+ */
+extern SDL_AudioFilter SDL_ChooseTypeCVT(Uint16 src_format, int src_channels,
+                                         Uint16 dst_format, int dst_channels);
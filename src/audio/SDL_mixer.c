@@ -38,6 +38,7 @@ static char rcsid =
 #include "SDL_mixer_MMX.h"
 #include "SDL_mixer_MMX_VC.h"
 #include "SDL_mixer_m68k.h"
+#include "SDL_mixer_SIMD.h"
 
 /* Function to check the CPU flags */
 #define MMX_CPU		0x800000
@@ -118,6 +119,7 @@ static const Uint8 mix8[] =
 void SDL_MixAudio (Uint8 *dst, const Uint8 *src, Uint32 len, int volume)
 {
 	Uint16 format;
+	Uint32 mixed;
 
 	if ( volume == 0 ) {
 		return;
@@ -133,6 +135,19 @@ void SDL_MixAudio (Uint8 *dst, const Uint8 *src, Uint32 len, int volume)
   		/* HACK HACK HACK */
 		format = AUDIO_S16;
 	}
+
+	/* The vector code mixes whole vectors and leaves the rest here,
+	   where the MMX code would drop anything short of 16 bytes */
+	mixed = SDL_MixAudio_SIMD(dst, src, len, format, volume);
+	if ( mixed ) {
+		dst += mixed;
+		src += mixed;
+		len -= mixed;
+		if ( len == 0 ) {
+			return;
+		}
+	}
+
 	switch (format) {
 
 		case AUDIO_U8: {
@@ -154,14 +169,14 @@ void SDL_MixAudio (Uint8 *dst, const Uint8 *src, Uint32 len, int volume)
 
 		case AUDIO_S8: {
 #if defined(i386) && defined(__GNUC__) && defined(USE_ASMBLIT)
-			if (CPU_Flags() & MMX_CPU)
+			if (!mixed && (CPU_Flags() & MMX_CPU))
 			{
 				SDL_MixAudio_MMX_S8((char*)dst,(char*)src,(unsigned int)len,(int)volume);
 			}
 			else
 #endif
 #if defined(USE_ASM_MIXER_VC)
-			if (SDL_IsMMX_VC())
+			if (!mixed && SDL_IsMMX_VC())
 			{
 				SDL_MixAudio_MMX_S8_VC((char*)dst,(char*)src,(unsigned int)len,(int)volume);
 			}
@@ -201,13 +216,13 @@ void SDL_MixAudio (Uint8 *dst, const Uint8 *src, Uint32 len, int volume)
 
 		case AUDIO_S16LSB: {
 #if defined(i386) && defined(__GNUC__) && defined(USE_ASMBLIT)
-			if (CPU_Flags() & MMX_CPU)
+			if (!mixed && (CPU_Flags() & MMX_CPU))
 			{
 				SDL_MixAudio_MMX_S16((char*)dst,(char*)src,(unsigned int)len,(int)volume);
 			}
 			else
 #elif defined(USE_ASM_MIXER_VC)
-			if (SDL_IsMMX_VC())
+			if (!mixed && SDL_IsMMX_VC())
 			{
 				SDL_MixAudio_MMX_S16_VC((char*)dst,(char*)src,(unsigned int)len,(int)volume);
 			}
@@ -276,6 +291,92 @@ void SDL_MixAudio (Uint8 *dst, const Uint8 *src, Uint32 len, int volume)
 		}
 		break;
 
+		case AUDIO_S32LSB:
+		case AUDIO_S32MSB: {
+			Sint32 src1, src2;
+			double dst_sample;
+			const double max_audioval = 2147483647.0;
+			const double min_audioval = -2147483648.0;
+
+			len /= 4;
+			while ( len-- ) {
+				if ( format & 0x1000 ) {
+					src1 = (Sint32)(((Uint32)src[0]<<24)|(src[1]<<16)|
+					                (src[2]<<8)|src[3]);
+					src2 = (Sint32)(((Uint32)dst[0]<<24)|(dst[1]<<16)|
+					                (dst[2]<<8)|dst[3]);
+				} else {
+					src1 = (Sint32)(((Uint32)src[3]<<24)|(src[2]<<16)|
+					                (src[1]<<8)|src[0]);
+					src2 = (Sint32)(((Uint32)dst[3]<<24)|(dst[2]<<16)|
+					                (dst[1]<<8)|dst[0]);
+				}
+				src += 4;
+				dst_sample = (double)src1*volume/SDL_MIX_MAXVOLUME;
+				dst_sample += src2;
+				if ( dst_sample > max_audioval ) {
+					dst_sample = max_audioval;
+				} else
+				if ( dst_sample < min_audioval ) {
+					dst_sample = min_audioval;
+				}
+				src2 = (Sint32)dst_sample;
+				if ( format & 0x1000 ) {
+					dst[0] = (src2>>24)&0xFF;
+					dst[1] = (src2>>16)&0xFF;
+					dst[2] = (src2>>8)&0xFF;
+					dst[3] = src2&0xFF;
+				} else {
+					dst[0] = src2&0xFF;
+					dst[1] = (src2>>8)&0xFF;
+					dst[2] = (src2>>16)&0xFF;
+					dst[3] = (src2>>24)&0xFF;
+				}
+				dst += 4;
+			}
+		}
+		break;
+
+		/* Floats have all the headroom they need, so they aren't clipped */
+		case AUDIO_F32LSB:
+		case AUDIO_F32MSB: {
+			union {
+				Uint32 u;
+				float f;
+			} src1, src2;
+			const float fvolume = (float)volume / SDL_MIX_MAXVOLUME;
+
+			len /= 4;
+			while ( len-- ) {
+				if ( format & 0x1000 ) {
+					src1.u = ((Uint32)src[0]<<24)|(src[1]<<16)|
+					         (src[2]<<8)|src[3];
+					src2.u = ((Uint32)dst[0]<<24)|(dst[1]<<16)|
+					         (dst[2]<<8)|dst[3];
+				} else {
+					src1.u = ((Uint32)src[3]<<24)|(src[2]<<16)|
+					         (src[1]<<8)|src[0];
+					src2.u = ((Uint32)dst[3]<<24)|(dst[2]<<16)|
+					         (dst[1]<<8)|dst[0];
+				}
+				src += 4;
+				src2.f += src1.f * fvolume;
+				if ( format & 0x1000 ) {
+					dst[0] = (src2.u>>24)&0xFF;
+					dst[1] = (src2.u>>16)&0xFF;
+					dst[2] = (src2.u>>8)&0xFF;
+					dst[3] = src2.u&0xFF;
+				} else {
+					dst[0] = src2.u&0xFF;
+					dst[1] = (src2.u>>8)&0xFF;
+					dst[2] = (src2.u>>16)&0xFF;
+					dst[3] = (src2.u>>24)&0xFF;
+				}
+				dst += 4;
+			}
+		}
+		break;
+
 		default: /* If this happens... FIXME! */
 			SDL_SetError("SDL_MixAudio(): unknown audio format");
 			return;
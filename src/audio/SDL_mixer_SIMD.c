@@ -0,0 +1,378 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997, 1998, 1999, 2000, 2001, 2002  Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the Free
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+
+#ifdef SAVE_RCSID
+static char rcsid =
+ "@(#) $Id$";
+#endif
+
+/* Vector versions of SDL_MixAudio()
+
+   The samples are widened to 16 or 32 bits, multiplied by the volume and
+   shifted down, rounding toward zero so the result is the same as the
+   division in SDL_mixer.c, and then added to the destination with
+   saturation.  U8 is clipped to 0xFE like the mix8 table.  Floats are
+   multiplied by the volume and added without clipping.
+*/
+
+#include <stdlib.h>
+
+#include "SDL_audio.h"
+#include "SDL_mixer_SIMD.h"
+#include "SDL_simd.h"
+
+typedef void (*SDL_MixFunc)(Uint8 *dst, const Uint8 *src, Uint32 len,
+                            int volume);
+
+typedef struct {
+	Uint16 format;
+	SDL_MixFunc mix;
+} SDL_MixKernel;
+
+#ifdef SDL_SSE2_INTRINSICS
+/* Multiply 16-bit samples by the volume and divide by 128, in 32 bits */
+SDL_TARGETING("sse2")
+static __m128i ScaleS16SSE2(__m128i x, __m128i vol)
+{
+	__m128i lo = _mm_mullo_epi16(x, vol);
+	__m128i hi = _mm_mulhi_epi16(x, vol);
+	__m128i a = _mm_unpacklo_epi16(lo, hi);
+	__m128i b = _mm_unpackhi_epi16(lo, hi);
+
+	a = _mm_add_epi32(a, _mm_srli_epi32(_mm_srai_epi32(a, 31), 25));
+	b = _mm_add_epi32(b, _mm_srli_epi32(_mm_srai_epi32(b, 31), 25));
+	return(_mm_packs_epi32(_mm_srai_epi32(a, 7), _mm_srai_epi32(b, 7)));
+}
+
+/* Multiply 8-bit samples widened to 16 bits by the volume, and divide */
+SDL_TARGETING("sse2")
+static __m128i ScaleS8SSE2(__m128i x, __m128i vol)
+{
+	__m128i p = _mm_mullo_epi16(x, vol);
+
+	p = _mm_add_epi16(p, _mm_srli_epi16(_mm_srai_epi16(p, 15), 9));
+	return(_mm_srai_epi16(p, 7));
+}
+
+SDL_TARGETING("sse2")
+static __m128i SwapS16SSE2(__m128i x)
+{
+	return(_mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8)));
+}
+
+SDL_TARGETING("sse2")
+static void MixS16SSE2(Uint8 *dst, const Uint8 *src, Uint32 len,
+                       int volume, int swap)
+{
+	const __m128i vol = _mm_set1_epi16((short)volume);
+	__m128i x, y;
+	Uint32 i;
+
+	for ( i=0; i<len; i+=16 ) {
+		x = _mm_loadu_si128((const __m128i *)(src+i));
+		y = _mm_loadu_si128((const __m128i *)(dst+i));
+		if ( swap ) {
+			x = SwapS16SSE2(x);
+			y = SwapS16SSE2(y);
+		}
+		if ( volume != SDL_MIX_MAXVOLUME ) {
+			x = ScaleS16SSE2(x, vol);
+		}
+		y = _mm_adds_epi16(x, y);
+		if ( swap ) {
+			y = SwapS16SSE2(y);
+		}
+		_mm_storeu_si128((__m128i *)(dst+i), y);
+	}
+}
+
+SDL_TARGETING("sse2")
+static void MixS16NativeSSE2(Uint8 *dst, const Uint8 *src, Uint32 len,
+                             int volume)
+{
+	MixS16SSE2(dst, src, len, volume, 0);
+}
+
+SDL_TARGETING("sse2")
+static void MixS16SwappedSSE2(Uint8 *dst, const Uint8 *src, Uint32 len,
+                              int volume)
+{
+	MixS16SSE2(dst, src, len, volume, 1);
+}
+
+SDL_TARGETING("sse2")
+static void MixS8SSE2(Uint8 *dst, const Uint8 *src, Uint32 len, int volume)
+{
+	const __m128i vol = _mm_set1_epi16((short)volume);
+	__m128i x, y, lo, hi;
+	Uint32 i;
+
+	for ( i=0; i<len; i+=16 ) {
+		x = _mm_loadu_si128((const __m128i *)(src+i));
+		y = _mm_loadu_si128((const __m128i *)(dst+i));
+		if ( volume != SDL_MIX_MAXVOLUME ) {
+			lo = _mm_srai_epi16(_mm_unpacklo_epi8(x, x), 8);
+			hi = _mm_srai_epi16(_mm_unpackhi_epi8(x, x), 8);
+			x = _mm_packs_epi16(ScaleS8SSE2(lo, vol),
+			                    ScaleS8SSE2(hi, vol));
+		}
+		_mm_storeu_si128((__m128i *)(dst+i), _mm_adds_epi8(x, y));
+	}
+}
+
+SDL_TARGETING("sse2")
+static void MixU8SSE2(Uint8 *dst, const Uint8 *src, Uint32 len, int volume)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i bias = _mm_set1_epi16(128);
+	const __m128i top = _mm_set1_epi16(0xFE);
+	const __m128i vol = _mm_set1_epi16((short)volume);
+	__m128i x, y, lo, hi;
+	Uint32 i;
+
+	for ( i=0; i<len; i+=16 ) {
+		x = _mm_loadu_si128((const __m128i *)(src+i));
+		y = _mm_loadu_si128((const __m128i *)(dst+i));
+		lo = _mm_sub_epi16(_mm_unpacklo_epi8(x, zero), bias);
+		hi = _mm_sub_epi16(_mm_unpackhi_epi8(x, zero), bias);
+		if ( volume != SDL_MIX_MAXVOLUME ) {
+			lo = ScaleS8SSE2(lo, vol);
+			hi = ScaleS8SSE2(hi, vol);
+		}
+		lo = _mm_add_epi16(lo, _mm_unpacklo_epi8(y, zero));
+		hi = _mm_add_epi16(hi, _mm_unpackhi_epi8(y, zero));
+		lo = _mm_min_epi16(_mm_max_epi16(lo, zero), top);
+		hi = _mm_min_epi16(_mm_max_epi16(hi, zero), top);
+		_mm_storeu_si128((__m128i *)(dst+i), _mm_packus_epi16(lo, hi));
+	}
+}
+
+/* Floats are added without clipping, as in SDL_mixer.c */
+SDL_TARGETING("sse2")
+static void MixF32SSE2(Uint8 *dst, const Uint8 *src, Uint32 len, int volume)
+{
+	const __m128 vol = _mm_set1_ps((float)volume / SDL_MIX_MAXVOLUME);
+	__m128 x, y;
+	Uint32 i;
+
+	for ( i=0; i<len; i+=16 ) {
+		x = _mm_loadu_ps((const float *)(src+i));
+		y = _mm_loadu_ps((const float *)(dst+i));
+		_mm_storeu_ps((float *)(dst+i), _mm_add_ps(y, _mm_mul_ps(x, vol)));
+	}
+}
+
+static const SDL_MixKernel mix_sse2[] = {
+	{ AUDIO_U8, MixU8SSE2 },
+	{ AUDIO_S8, MixS8SSE2 },
+	{ AUDIO_S16SYS, MixS16NativeSSE2 },
+	{ AUDIO_S16SYS^0x1000, MixS16SwappedSSE2 },
+	{ AUDIO_F32SYS, MixF32SSE2 },
+	{ 0, NULL }
+};
+#endif /* SDL_SSE2_INTRINSICS */
+
+#ifdef SDL_AVX2_INTRINSICS
+SDL_TARGETING("avx2")
+static __m256i ScaleS16AVX2(__m256i x, __m256i vol)
+{
+	__m256i lo = _mm256_mullo_epi16(x, vol);
+	__m256i hi = _mm256_mulhi_epi16(x, vol);
+	__m256i a = _mm256_unpacklo_epi16(lo, hi);
+	__m256i b = _mm256_unpackhi_epi16(lo, hi);
+
+	a = _mm256_add_epi32(a, _mm256_srli_epi32(_mm256_srai_epi32(a, 31), 25));
+	b = _mm256_add_epi32(b, _mm256_srli_epi32(_mm256_srai_epi32(b, 31), 25));
+	return(_mm256_packs_epi32(_mm256_srai_epi32(a, 7),
+	                          _mm256_srai_epi32(b, 7)));
+}
+
+SDL_TARGETING("avx2")
+static __m256i ScaleS8AVX2(__m256i x, __m256i vol)
+{
+	__m256i p = _mm256_mullo_epi16(x, vol);
+
+	p = _mm256_add_epi16(p, _mm256_srli_epi16(_mm256_srai_epi16(p, 15), 9));
+	return(_mm256_srai_epi16(p, 7));
+}
+
+SDL_TARGETING("avx2")
+static __m256i SwapS16AVX2(__m256i x)
+{
+	return(_mm256_or_si256(_mm256_slli_epi16(x, 8),
+	                       _mm256_srli_epi16(x, 8)));
+}
+
+SDL_TARGETING("avx2")
+static void MixS16AVX2(Uint8 *dst, const Uint8 *src, Uint32 len,
+                       int volume, int swap)
+{
+	const __m256i vol = _mm256_set1_epi16((short)volume);
+	__m256i x, y;
+	Uint32 i;
+
+	for ( i=0; i<len; i+=32 ) {
+		x = _mm256_loadu_si256((const __m256i *)(src+i));
+		y = _mm256_loadu_si256((const __m256i *)(dst+i));
+		if ( swap ) {
+			x = SwapS16AVX2(x);
+			y = SwapS16AVX2(y);
+		}
+		if ( volume != SDL_MIX_MAXVOLUME ) {
+			x = ScaleS16AVX2(x, vol);
+		}
+		y = _mm256_adds_epi16(x, y);
+		if ( swap ) {
+			y = SwapS16AVX2(y);
+		}
+		_mm256_storeu_si256((__m256i *)(dst+i), y);
+	}
+}
+
+SDL_TARGETING("avx2")
+static void MixS16NativeAVX2(Uint8 *dst, const Uint8 *src, Uint32 len,
+                             int volume)
+{
+	MixS16AVX2(dst, src, len, volume, 0);
+}
+
+SDL_TARGETING("avx2")
+static void MixS16SwappedAVX2(Uint8 *dst, const Uint8 *src, Uint32 len,
+                              int volume)
+{
+	MixS16AVX2(dst, src, len, volume, 1);
+}
+
+/* The unpacks and packs work within each 128-bit half, so the samples
+   come back out in the order they went in */
+SDL_TARGETING("avx2")
+static void MixS8AVX2(Uint8 *dst, const Uint8 *src, Uint32 len, int volume)
+{
+	const __m256i vol = _mm256_set1_epi16((short)volume);
+	__m256i x, y, lo, hi;
+	Uint32 i;
+
+	for ( i=0; i<len; i+=32 ) {
+		x = _mm256_loadu_si256((const __m256i *)(src+i));
+		y = _mm256_loadu_si256((const __m256i *)(dst+i));
+		if ( volume != SDL_MIX_MAXVOLUME ) {
+			lo = _mm256_srai_epi16(_mm256_unpacklo_epi8(x, x), 8);
+			hi = _mm256_srai_epi16(_mm256_unpackhi_epi8(x, x), 8);
+			x = _mm256_packs_epi16(ScaleS8AVX2(lo, vol),
+			                       ScaleS8AVX2(hi, vol));
+		}
+		_mm256_storeu_si256((__m256i *)(dst+i), _mm256_adds_epi8(x, y));
+	}
+}
+
+SDL_TARGETING("avx2")
+static void MixU8AVX2(Uint8 *dst, const Uint8 *src, Uint32 len, int volume)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i bias = _mm256_set1_epi16(128);
+	const __m256i top = _mm256_set1_epi16(0xFE);
+	const __m256i vol = _mm256_set1_epi16((short)volume);
+	__m256i x, y, lo, hi;
+	Uint32 i;
+
+	for ( i=0; i<len; i+=32 ) {
+		x = _mm256_loadu_si256((const __m256i *)(src+i));
+		y = _mm256_loadu_si256((const __m256i *)(dst+i));
+		lo = _mm256_sub_epi16(_mm256_unpacklo_epi8(x, zero), bias);
+		hi = _mm256_sub_epi16(_mm256_unpackhi_epi8(x, zero), bias);
+		if ( volume != SDL_MIX_MAXVOLUME ) {
+			lo = ScaleS8AVX2(lo, vol);
+			hi = ScaleS8AVX2(hi, vol);
+		}
+		lo = _mm256_add_epi16(lo, _mm256_unpacklo_epi8(y, zero));
+		hi = _mm256_add_epi16(hi, _mm256_unpackhi_epi8(y, zero));
+		lo = _mm256_min_epi16(_mm256_max_epi16(lo, zero), top);
+		hi = _mm256_min_epi16(_mm256_max_epi16(hi, zero), top);
+		_mm256_storeu_si256((__m256i *)(dst+i),
+		                    _mm256_packus_epi16(lo, hi));
+	}
+}
+
+SDL_TARGETING("avx2")
+static void MixF32AVX2(Uint8 *dst, const Uint8 *src, Uint32 len, int volume)
+{
+	const __m256 vol = _mm256_set1_ps((float)volume / SDL_MIX_MAXVOLUME);
+	__m256 x, y;
+	Uint32 i;
+
+	for ( i=0; i<len; i+=32 ) {
+		x = _mm256_loadu_ps((const float *)(src+i));
+		y = _mm256_loadu_ps((const float *)(dst+i));
+		_mm256_storeu_ps((float *)(dst+i),
+		                 _mm256_add_ps(y, _mm256_mul_ps(x, vol)));
+	}
+}
+
+static const SDL_MixKernel mix_avx2[] = {
+	{ AUDIO_U8, MixU8AVX2 },
+	{ AUDIO_S8, MixS8AVX2 },
+	{ AUDIO_S16SYS, MixS16NativeAVX2 },
+	{ AUDIO_S16SYS^0x1000, MixS16SwappedAVX2 },
+	{ AUDIO_F32SYS, MixF32AVX2 },
+	{ 0, NULL }
+};
+#endif /* SDL_AVX2_INTRINSICS */
+
+Uint32 SDL_MixAudio_SIMD(Uint8 *dst, const Uint8 *src, Uint32 len,
+                         Uint16 format, int volume)
+{
+	const SDL_MixKernel *kernel;
+	Uint32 vector;
+
+	/* Louder than SDL_MIX_MAXVOLUME wraps around in the C code */
+	if ( (volume <= 0) || (volume > SDL_MIX_MAXVOLUME) ) {
+		return(0);
+	}
+
+	/* Pick the fastest */
+	kernel = NULL;
+	vector = 0;
+#ifdef SDL_SSE2_INTRINSICS
+	if ( SDL_HasSSE2() ) {
+		kernel = mix_sse2;
+		vector = 16;
+	}
+#endif
+#ifdef SDL_AVX2_INTRINSICS
+	if ( SDL_HasAVX2() ) {
+		kernel = mix_avx2;
+		vector = 32;
+	}
+#endif
+	if ( ! kernel ) {
+		return(0);
+	}
+	while ( kernel->mix && (kernel->format != format) ) {
+		++kernel;
+	}
+	len &= ~(vector-1);
+	if ( ! kernel->mix || ! len ) {
+		return(0);
+	}
+	kernel->mix(dst, src, len, volume);
+	return(len);
+}
@@ -0,0 +1,857 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997, 1998, 1999, 2000, 2001, 2002  Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the Free
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+
+#ifdef SAVE_RCSID
+static char rcsid =
+ "@(#) $Id$";
+#endif
+
+/* Sample rate conversion
+
+   The resampler is a polyphase windowed sinc filter.  Each output frame
+   is the input around its position weighted by one row of coefficients,
+   picked by the fractional part of the position.  When the reduced
+   output rate is small, as it is for the common rates, every phase has
+   its own row.  Otherwise the position falls between two of
+   RESAMPLE_PHASES rows, and the two results are interpolated.  When
+   downsampling the cutoff is lowered to the new Nyquist frequency and
+   the filter grows to match.  The linear quality simply interpolates
+   between neighbouring frames.
+
+   Positions are kept as a whole input frame plus a fraction with the
+   reduced output rate as denominator, so the phase never drifts however
+   long the stream runs.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "SDL_error.h"
+#include "SDL_getenv.h"
+#include "SDL_audio.h"
+#include "SDL_resample_c.h"
+#include "SDL_simd.h"
+
+#ifndef M_PI
+#define M_PI	3.14159265358979323846
+#endif
+
+/* Coefficient rows when the phases aren't computed exactly */
+#define RESAMPLE_PHASES		256
+
+/* Longest filter half, reached when downsampling by a large factor */
+#define RESAMPLE_MAXHALF	512
+
+/* Output frames computed before converting them to the output format */
+#define RESAMPLE_BLOCK		128
+
+/* Largest denominator recovered from cvt->rate_incr */
+#define RESAMPLE_MAXRATE	(1<<20)
+
+static const struct {
+	int zero_crossings;	/* Filter half length at the input rate */
+	double beta;		/* Shape of the Kaiser window */
+	double rolloff;		/* Cutoff, as a fraction of the Nyquist rate */
+} tiers[] = {
+	{  0,  0.0, 1.00 },	/* SDL_RESAMPLE_LINEAR */
+	{  8,  6.0, 0.85 },	/* SDL_RESAMPLE_FAST */
+	{ 16,  8.0, 0.90 },	/* SDL_RESAMPLE_MEDIUM */
+	{ 32, 10.0, 0.94 }	/* SDL_RESAMPLE_BEST */
+};
+
+struct SDL_Resampler {
+	Uint16 format;
+	int channels;
+	int framesize;
+	int src_rate;		/* Reduced by the common divisor */
+	int dst_rate;
+	int step;		/* Whole input frames per output frame */
+	int step_num;		/* ... plus step_num/dst_rate of a frame */
+
+	/* The filter covers input frames pos-half+1 through pos+half,
+	   rounded up to 'taps' frames for the vector loops */
+	int linear;
+	int half;
+	int taps;
+	int phases;
+	int exact;
+	float phase_scale;
+	float *coeffs;
+	void *coeffs_mem;
+	float (*dot)(const float *in, const float *row, int taps);
+
+	/* Input not yet consumed, one plane of 'room' frames per channel */
+	float *hist;
+	int room;
+	int avail;
+	int pos;
+	int num;
+};
+
+static SDL_ResampleQuality SDL_resample_quality = (SDL_ResampleQuality)-1;
+
+void SDL_SetResampleQuality(SDL_ResampleQuality quality)
+{
+	if ( (int)quality < SDL_RESAMPLE_LINEAR ) {
+		quality = SDL_RESAMPLE_LINEAR;
+	}
+	if ( quality > SDL_RESAMPLE_BEST ) {
+		quality = SDL_RESAMPLE_BEST;
+	}
+	SDL_resample_quality = quality;
+}
+
+SDL_ResampleQuality SDL_GetResampleQuality(void)
+{
+	if ( (int)SDL_resample_quality < 0 ) {
+		const char *variable = getenv("SDL_AUDIO_RESAMPLER");
+
+		SDL_resample_quality = SDL_RESAMPLE_MEDIUM;
+		if ( variable ) {
+			if ( strcmp(variable, "linear") == 0 ) {
+				SDL_resample_quality = SDL_RESAMPLE_LINEAR;
+			} else if ( strcmp(variable, "fast") == 0 ) {
+				SDL_resample_quality = SDL_RESAMPLE_FAST;
+			} else if ( strcmp(variable, "best") == 0 ) {
+				SDL_resample_quality = SDL_RESAMPLE_BEST;
+			}
+		}
+	}
+	return(SDL_resample_quality);
+}
+
+/* Dot products of the input with a row of coefficients */
+static float Dot(const float *in, const float *row, int taps)
+{
+	float sum = 0.0f;
+	int i;
+
+	for ( i=0; i<taps; ++i ) {
+		sum += in[i] * row[i];
+	}
+	return(sum);
+}
+
+#ifdef SDL_SSE2_INTRINSICS
+SDL_TARGETING("sse2")
+static float DotSSE2(const float *in, const float *row, int taps)
+{
+	__m128 sum0 = _mm_setzero_ps();
+	__m128 sum1 = _mm_setzero_ps();
+	float result[4];
+	int i;
+
+	/* The rows are 32 byte aligned and a multiple of 8 long */
+	for ( i=0; i<taps; i+=8 ) {
+		sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(in+i),
+		                                   _mm_load_ps(row+i)));
+		sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(in+i+4),
+		                                   _mm_load_ps(row+i+4)));
+	}
+	_mm_storeu_ps(result, _mm_add_ps(sum0, sum1));
+	return((result[0] + result[1]) + (result[2] + result[3]));
+}
+#endif /* SDL_SSE2_INTRINSICS */
+
+#ifdef SDL_AVX2_INTRINSICS
+SDL_TARGETING("avx2")
+static float DotAVX2(const float *in, const float *row, int taps)
+{
+	__m256 sum = _mm256_setzero_ps();
+	__m128 half;
+	float result[4];
+	int i;
+
+	for ( i=0; i<taps; i+=8 ) {
+		sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_loadu_ps(in+i),
+		                                       _mm256_load_ps(row+i)));
+	}
+	half = _mm_add_ps(_mm256_castps256_ps128(sum),
+	                  _mm256_extractf128_ps(sum, 1));
+	_mm_storeu_ps(result, half);
+	return((result[0] + result[1]) + (result[2] + result[3]));
+}
+#endif /* SDL_AVX2_INTRINSICS */
+
+/* Zeroth order modified Bessel function, for the Kaiser window */
+static double BesselI0(double x)
+{
+	double sum = 1.0;
+	double term = 1.0;
+	int k;
+
+	x = (x * x) / 4.0;
+	for ( k=1; k<100; ++k ) {
+		term *= x / ((double)k * k);
+		sum += term;
+		if ( term < sum * 1e-12 ) {
+			break;
+		}
+	}
+	return(sum);
+}
+
+static int BuildCoefficients(SDL_Resampler *resampler, int quality,
+                             double cutoff)
+{
+	double *kernel;
+	double i0beta, beta;
+	int half, taps;
+	int p, k;
+
+	half = resampler->half;
+	taps = resampler->taps;
+	resampler->coeffs_mem = malloc((resampler->phases+1)*taps*sizeof(float)
+	                               + 31);
+	kernel = (double *)malloc(taps*sizeof(double));
+	if ( (resampler->coeffs_mem == NULL) || (kernel == NULL) ) {
+		if ( kernel ) {
+			free(kernel);
+		}
+		return(-1);
+	}
+	resampler->coeffs = (float *)
+		(((size_t)resampler->coeffs_mem + 31) & ~(size_t)31);
+
+	beta = tiers[quality].beta;
+	i0beta = BesselI0(beta);
+	for ( p=0; p<=resampler->phases; ++p ) {
+		double frac = (double)p / resampler->phases;
+		double sum = 0.0;
+		float *row = resampler->coeffs + p*taps;
+
+		for ( k=0; k<taps; ++k ) {
+			double d = (k - half + 1) - frac;
+			double x = d / half;
+			double w = 0.0;
+
+			if ( (k < 2*half) && (x > -1.0) && (x < 1.0) ) {
+				w = BesselI0(beta * sqrt(1.0 - x*x)) / i0beta;
+				if ( d != 0.0 ) {
+					w *= sin(M_PI*cutoff*d) / (M_PI*cutoff*d);
+				}
+			}
+			kernel[k] = w;
+			sum += w;
+		}
+		/* Every phase passes DC at exactly unity gain */
+		for ( k=0; k<taps; ++k ) {
+			row[k] = (float)(kernel[k] / sum);
+		}
+	}
+	free(kernel);
+	return(0);
+}
+
+/* Make room for 'frames' more input frames, plus the slack read past the
+   end of the data by the vector loops.  Slack is zeroed when allocated,
+   and afterwards only ever holds old samples, so it never adds NaNs.
+ */
+static int SDL_ResamplerRoom(SDL_Resampler *resampler, int frames)
+{
+	float *hist;
+	int room, c;
+
+	room = resampler->avail + frames + resampler->taps;
+	if ( room <= resampler->room ) {
+		return(0);
+	}
+	if ( room < resampler->room*2 ) {
+		room = resampler->room*2;
+	}
+	hist = (float *)calloc(room*resampler->channels, sizeof(float));
+	if ( hist == NULL ) {
+		SDL_OutOfMemory();
+		return(-1);
+	}
+	if ( resampler->hist ) {
+		for ( c=0; c<resampler->channels; ++c ) {
+			memcpy(hist+c*room, resampler->hist+c*resampler->room,
+			       resampler->avail*sizeof(float));
+		}
+		free(resampler->hist);
+	}
+	resampler->hist = hist;
+	resampler->room = room;
+	return(0);
+}
+
+SDL_Resampler *SDL_CreateResampler(Uint16 format, int channels,
+                                   int src_rate, int dst_rate)
+{
+	SDL_Resampler *resampler;
+	SDL_ResampleQuality quality;
+	int a, b;
+
+	switch (format) {
+		case AUDIO_U8:
+		case AUDIO_S8:
+		case AUDIO_U16LSB:
+		case AUDIO_S16LSB:
+		case AUDIO_U16MSB:
+		case AUDIO_S16MSB:
+		case AUDIO_S32LSB:
+		case AUDIO_S32MSB:
+		case AUDIO_F32LSB:
+		case AUDIO_F32MSB:
+			break;
+		default:
+			SDL_SetError("Unsupported audio format");
+			return(NULL);
+	}
+	if ( (channels < 1) || (channels > SDL_RESAMPLE_MAXCHANNELS) ) {
+		SDL_SetError("Can't resample %d channels", channels);
+		return(NULL);
+	}
+	if ( (src_rate <= 0) || (dst_rate <= 0) ) {
+		SDL_SetError("Invalid sample rate");
+		return(NULL);
+	}
+
+	resampler = (SDL_Resampler *)malloc(sizeof(*resampler));
+	if ( resampler == NULL ) {
+		SDL_OutOfMemory();
+		return(NULL);
+	}
+	memset(resampler, 0, sizeof(*resampler));
+	resampler->format = format;
+	resampler->channels = channels;
+	resampler->framesize = ((format & 0xFF) / 8) * channels;
+
+	/* Reduce the ratio so the phase fractions stay small */
+	a = src_rate;
+	b = dst_rate;
+	while ( b ) {
+		int t = a % b;
+		a = b;
+		b = t;
+	}
+	resampler->src_rate = src_rate / a;
+	resampler->dst_rate = dst_rate / a;
+	resampler->step = resampler->src_rate / resampler->dst_rate;
+	resampler->step_num = resampler->src_rate % resampler->dst_rate;
+
+	quality = SDL_GetResampleQuality();
+	if ( quality == SDL_RESAMPLE_LINEAR ) {
+		resampler->linear = 1;
+		resampler->half = 1;
+		resampler->taps = 2;
+	} else {
+		double ratio = (double)dst_rate / src_rate;
+		int half;
+
+		if ( ratio > 1.0 ) {
+			ratio = 1.0;
+		}
+		half = (int)ceil(tiers[quality].zero_crossings / ratio);
+		if ( half > RESAMPLE_MAXHALF ) {
+			half = RESAMPLE_MAXHALF;
+		}
+		resampler->half = half;
+		resampler->taps = (2*half + 7) & ~7;
+		if ( resampler->dst_rate <= RESAMPLE_PHASES ) {
+			resampler->phases = resampler->dst_rate;
+			resampler->exact = 1;
+		} else {
+			resampler->phases = RESAMPLE_PHASES;
+			resampler->phase_scale =
+				(float)RESAMPLE_PHASES / resampler->dst_rate;
+		}
+		if ( BuildCoefficients(resampler, quality,
+		                      tiers[quality].rolloff * ratio) < 0 ) {
+			SDL_FreeResampler(resampler);
+			SDL_OutOfMemory();
+			return(NULL);
+		}
+	}
+
+	/* Pick the fastest dot product */
+	resampler->dot = Dot;
+#ifdef SDL_SSE2_INTRINSICS
+	if ( SDL_HasSSE2() ) {
+		resampler->dot = DotSSE2;
+	}
+#endif
+#ifdef SDL_AVX2_INTRINSICS
+	if ( SDL_HasAVX2() ) {
+		resampler->dot = DotAVX2;
+	}
+#endif
+
+	if ( SDL_ResamplerRoom(resampler, resampler->half) < 0 ) {
+		SDL_FreeResampler(resampler);
+		return(NULL);
+	}
+	SDL_ResetResampler(resampler);
+	return(resampler);
+}
+
+void SDL_ResetResampler(SDL_Resampler *resampler)
+{
+	int c;
+
+	/* Start with silence before the first frame, so the first output
+	   frame falls exactly on the first input frame */
+	resampler->avail = resampler->half - 1;
+	resampler->pos = resampler->half - 1;
+	resampler->num = 0;
+	for ( c=0; c<resampler->channels; ++c ) {
+		memset(resampler->hist+c*resampler->room, 0,
+		       resampler->avail*sizeof(float));
+	}
+}
+
+/* Convert interleaved samples to the planar float history */
+static void ImportFrames(SDL_Resampler *resampler, const Uint8 *buf,
+                         int frames)
+{
+	int channels = resampler->channels;
+	int room = resampler->room;
+	float *out = resampler->hist + resampler->avail;
+	union {
+		Uint32 u;
+		float f;
+	} bits;
+	int i, c;
+
+	switch (resampler->format) {
+	    case AUDIO_U8:
+		for ( i=0; i<frames; ++i ) {
+			for ( c=0; c<channels; ++c ) {
+				out[c*room+i] = (*buf++ - 128) * (1.0f/128);
+			}
+		}
+		break;
+	    case AUDIO_S8:
+		for ( i=0; i<frames; ++i ) {
+			for ( c=0; c<channels; ++c ) {
+				out[c*room+i] = *(Sint8 *)buf++ * (1.0f/128);
+			}
+		}
+		break;
+	    case AUDIO_U16LSB:
+		for ( i=0; i<frames; ++i ) {
+			for ( c=0; c<channels; ++c, buf+=2 ) {
+				out[c*room+i] = ((buf[0]|(buf[1]<<8)) - 32768)
+				                * (1.0f/32768);
+			}
+		}
+		break;
+	    case AUDIO_S16LSB:
+		for ( i=0; i<frames; ++i ) {
+			for ( c=0; c<channels; ++c, buf+=2 ) {
+				out[c*room+i] = (Sint16)(buf[0]|(buf[1]<<8))
+				                * (1.0f/32768);
+			}
+		}
+		break;
+	    case AUDIO_U16MSB:
+		for ( i=0; i<frames; ++i ) {
+			for ( c=0; c<channels; ++c, buf+=2 ) {
+				out[c*room+i] = (((buf[0]<<8)|buf[1]) - 32768)
+				                * (1.0f/32768);
+			}
+		}
+		break;
+	    case AUDIO_S16MSB:
+		for ( i=0; i<frames; ++i ) {
+			for ( c=0; c<channels; ++c, buf+=2 ) {
+				out[c*room+i] = (Sint16)((buf[0]<<8)|buf[1])
+				                * (1.0f/32768);
+			}
+		}
+		break;
+	    case AUDIO_S32LSB:
+	    case AUDIO_S32MSB:
+	    case AUDIO_F32LSB:
+	    case AUDIO_F32MSB:
+		for ( i=0; i<frames; ++i ) {
+			for ( c=0; c<channels; ++c, buf+=4 ) {
+				if ( resampler->format & 0x1000 ) {
+					bits.u = ((Uint32)buf[0]<<24) |
+					         ((Uint32)buf[1]<<16) |
+					         ((Uint32)buf[2]<<8) | buf[3];
+				} else {
+					bits.u = ((Uint32)buf[3]<<24) |
+					         ((Uint32)buf[2]<<16) |
+					         ((Uint32)buf[1]<<8) | buf[0];
+				}
+				if ( resampler->format & 0x0100 ) {
+					out[c*room+i] = bits.f;
+				} else {
+					out[c*room+i] = (Sint32)bits.u
+					                * (1.0f/2147483648.0f);
+				}
+			}
+		}
+		break;
+	}
+}
+
+/* Convert interleaved float frames to the output format, with rounding
+   and clipping.  Biasing the value keeps it positive, so the cast
+   rounds the same way in both directions.
+ */
+static void ExportFrames(SDL_Resampler *resampler, const float *in,
+                         int frames, Uint8 *buf)
+{
+	int samples = frames * resampler->channels;
+	union {
+		Uint32 u;
+		float f;
+	} bits;
+	int i, v;
+	float s;
+
+	switch (resampler->format & 0xFF) {
+	    case 8:
+		for ( i=0; i<samples; ++i ) {
+			s = in[i] * 128.0f + 128.5f;
+			if ( s < 0.0f ) {
+				v = 0;
+			} else if ( s >= 256.0f ) {
+				v = 255;
+			} else {
+				v = (int)s;
+			}
+			if ( resampler->format & 0x8000 ) {
+				v -= 128;
+			}
+			*buf++ = (Uint8)v;
+		}
+		break;
+	    case 16:
+		for ( i=0; i<samples; ++i, buf+=2 ) {
+			s = in[i] * 32768.0f + 32768.5f;
+			if ( s < 0.0f ) {
+				v = 0;
+			} else if ( s >= 65536.0f ) {
+				v = 65535;
+			} else {
+				v = (int)s;
+			}
+			if ( resampler->format & 0x8000 ) {
+				v ^= 0x8000;
+			}
+			if ( resampler->format & 0x1000 ) {
+				buf[0] = (Uint8)(v >> 8);
+				buf[1] = (Uint8)v;
+			} else {
+				buf[0] = (Uint8)v;
+				buf[1] = (Uint8)(v >> 8);
+			}
+		}
+		break;
+	    case 32:
+		for ( i=0; i<samples; ++i, buf+=4 ) {
+			if ( resampler->format & 0x0100 ) {
+				bits.f = in[i];
+			} else if ( in[i] >= 1.0f ) {
+				bits.u = 0x7FFFFFFF;
+			} else if ( in[i] <= -1.0f ) {
+				bits.u = 0x80000000;
+			} else {
+				bits.u = (Sint32)(in[i] * 2147483648.0f);
+			}
+			if ( resampler->format & 0x1000 ) {
+				buf[0] = (Uint8)(bits.u >> 24);
+				buf[1] = (Uint8)(bits.u >> 16);
+				buf[2] = (Uint8)(bits.u >> 8);
+				buf[3] = (Uint8)bits.u;
+			} else {
+				buf[0] = (Uint8)bits.u;
+				buf[1] = (Uint8)(bits.u >> 8);
+				buf[2] = (Uint8)(bits.u >> 16);
+				buf[3] = (Uint8)(bits.u >> 24);
+			}
+		}
+		break;
+	}
+}
+
+void SDL_ResamplerPrime(SDL_Resampler *resampler, const Uint8 *buf, int frames)
+{
+	int keep;
+
+	/* Only the frames the filter reaches back to are needed */
+	SDL_ResetResampler(resampler);
+	keep = resampler->avail;
+	if ( frames > keep ) {
+		buf += (frames - keep) * resampler->framesize;
+		frames = keep;
+	}
+	if ( frames > 0 ) {
+		resampler->avail -= frames;
+		ImportFrames(resampler, buf, frames);
+		resampler->avail += frames;
+	}
+}
+
+int SDL_ResamplerPending(SDL_Resampler *resampler)
+{
+	int pending;
+
+	/* The next output frame is past 'pos' if it falls between frames */
+	pending = resampler->avail - resampler->pos;
+	if ( resampler->num ) {
+		--pending;
+	}
+	if ( pending < 0 ) {
+		pending = 0;
+	}
+	return(pending);
+}
+
+int SDL_ResamplerPut(SDL_Resampler *resampler, const Uint8 *buf, int frames)
+{
+	if ( frames <= 0 ) {
+		return(0);
+	}
+	if ( SDL_ResamplerRoom(resampler, frames) < 0 ) {
+		return(-1);
+	}
+	ImportFrames(resampler, buf, frames);
+	resampler->avail += frames;
+	return(0);
+}
+
+int SDL_ResamplerFlush(SDL_Resampler *resampler)
+{
+	int c;
+
+	if ( SDL_ResamplerRoom(resampler, resampler->half) < 0 ) {
+		return(-1);
+	}
+	for ( c=0; c<resampler->channels; ++c ) {
+		memset(resampler->hist+c*resampler->room+resampler->avail, 0,
+		       resampler->half*sizeof(float));
+	}
+	resampler->avail += resampler->half;
+	return(0);
+}
+
+int SDL_ResamplerAvailable(SDL_Resampler *resampler)
+{
+	double ahead;
+
+	/* The frames at positions below avail-half, counted in units of
+	   1/dst_rate of an input frame, where each output frame is src_rate */
+	ahead = (double)(resampler->avail - resampler->half - resampler->pos) *
+	        resampler->dst_rate - resampler->num;
+	if ( ahead <= 0.0 ) {
+		return(0);
+	}
+	return((int)ceil(ahead / resampler->src_rate));
+}
+
+int SDL_ResamplerGet(SDL_Resampler *resampler, Uint8 *buf, int frames)
+{
+	float block[RESAMPLE_BLOCK*SDL_RESAMPLE_MAXCHANNELS];
+	int channels = resampler->channels;
+	int room = resampler->room;
+	int half = resampler->half;
+	int taps = resampler->taps;
+	int done, drop, n, c;
+
+	done = 0;
+	while ( (done < frames) &&
+	        ((resampler->pos + half) < resampler->avail) ) {
+		float *out = block;
+
+		for ( n=0; (n < RESAMPLE_BLOCK) && (done+n < frames) &&
+		           ((resampler->pos + half) < resampler->avail); ++n ) {
+			const float *in = resampler->hist+resampler->pos-half+1;
+
+			if ( resampler->linear ) {
+				float frac = (float)resampler->num /
+				             resampler->dst_rate;
+
+				for ( c=0; c<channels; ++c, in+=room ) {
+					*out++ = in[0] + (in[1] - in[0]) * frac;
+				}
+			} else if ( resampler->exact ) {
+				const float *row = resampler->coeffs +
+				                   resampler->num*taps;
+
+				for ( c=0; c<channels; ++c, in+=room ) {
+					*out++ = resampler->dot(in, row, taps);
+				}
+			} else {
+				float phase = resampler->num *
+				              resampler->phase_scale;
+				int p = (int)phase;
+				const float *row = resampler->coeffs + p*taps;
+				float s0, s1;
+
+				phase -= p;
+				for ( c=0; c<channels; ++c, in+=room ) {
+					s0 = resampler->dot(in, row, taps);
+					s1 = resampler->dot(in, row+taps, taps);
+					*out++ = s0 + (s1 - s0) * phase;
+				}
+			}
+
+			/* Move on to the next output frame */
+			resampler->pos += resampler->step;
+			resampler->num += resampler->step_num;
+			if ( resampler->num >= resampler->dst_rate ) {
+				resampler->num -= resampler->dst_rate;
+				++resampler->pos;
+			}
+		}
+		ExportFrames(resampler, block, n, buf+done*resampler->framesize);
+		done += n;
+	}
+
+	/* Let go of the input that no later output frame needs */
+	drop = resampler->pos - half + 1;
+	if ( drop > resampler->avail ) {
+		drop = resampler->avail;
+	}
+	if ( drop > 0 ) {
+		for ( c=0; c<channels; ++c ) {
+			memmove(resampler->hist+c*room,
+			        resampler->hist+c*room+drop,
+			        (resampler->avail-drop)*sizeof(float));
+		}
+		resampler->avail -= drop;
+		resampler->pos -= drop;
+	}
+	return(done);
+}
+
+void SDL_FreeResampler(SDL_Resampler *resampler)
+{
+	if ( resampler ) {
+		if ( resampler->coeffs_mem ) {
+			free(resampler->coeffs_mem);
+		}
+		if ( resampler->hist ) {
+			free(resampler->hist);
+		}
+		free(resampler);
+	}
+}
+
+/* SDL_AudioCVT only records src_rate/dst_rate, as a double, so the
+   reduced fraction is recovered from its continued fraction expansion.
+   Sample rates are small integers, so this gives back the exact ratio.
+ */
+static void SDL_RateFraction(double ratio, int *src_rate, int *dst_rate)
+{
+	double h0 = 0.0, h1 = 1.0;
+	double k0 = 1.0, k1 = 0.0;
+	double x = ratio;
+	int i;
+
+	for ( i=0; i<64; ++i ) {
+		double a = floor(x);
+		double h2 = a*h1 + h0;
+		double k2 = a*k1 + k0;
+
+		if ( (h2 > RESAMPLE_MAXRATE) || (k2 > RESAMPLE_MAXRATE) ) {
+			break;
+		}
+		h0 = h1; h1 = h2;
+		k0 = k1; k1 = k2;
+		if ( (x - a) < 1e-9 || fabs(h1/k1 - ratio) <= ratio*1e-13 ) {
+			break;
+		}
+		x = 1.0 / (x - a);
+	}
+	if ( (h1 < 1.0) || (k1 < 1.0) ) {
+		/* Hopeless ratio, use a fixed denominator */
+		h1 = floor(ratio * 65536.0 + 0.5);
+		k1 = 65536.0;
+		if ( h1 < 1.0 ) {
+			h1 = 1.0;
+		}
+	}
+	*src_rate = (int)h1;
+	*dst_rate = (int)k1;
+}
+
+/* Resample a whole buffer in place.  It is taken as a complete sound,
+   with silence before and after it, and comes out with exactly as many
+   frames as its length at the new rate, rounded up.
+ */
+static void SDL_RateConvert(SDL_AudioCVT *cvt, Uint16 format, int channels)
+{
+	SDL_Resampler *resampler;
+	int src_rate, dst_rate;
+	int framesize;
+
+	SDL_RateFraction(cvt->rate_incr, &src_rate, &dst_rate);
+	resampler = SDL_CreateResampler(format, channels, src_rate, dst_rate);
+	if ( resampler ) {
+		framesize = resampler->framesize;
+		if ( (SDL_ResamplerPut(resampler, cvt->buf,
+		                       cvt->len_cvt/framesize) == 0) &&
+		     (SDL_ResamplerFlush(resampler) == 0) ) {
+			cvt->len_cvt = framesize * SDL_ResamplerGet(resampler,
+			       cvt->buf, (cvt->len*cvt->len_mult)/framesize);
+		}
+		SDL_FreeResampler(resampler);
+	}
+	if ( cvt->filters[++cvt->filter_index] ) {
+		cvt->filters[cvt->filter_index](cvt, format);
+	}
+}
+
+static void SDL_RateConvertMono(SDL_AudioCVT *cvt, Uint16 format)
+{
+	SDL_RateConvert(cvt, format, 1);
+}
+
+static void SDL_RateConvertStereo(SDL_AudioCVT *cvt, Uint16 format)
+{
+	SDL_RateConvert(cvt, format, 2);
+}
+
+static void SDL_RateConvertQuad(SDL_AudioCVT *cvt, Uint16 format)
+{
+	SDL_RateConvert(cvt, format, 4);
+}
+
+static void SDL_RateConvert51(SDL_AudioCVT *cvt, Uint16 format)
+{
+	SDL_RateConvert(cvt, format, 6);
+}
+
+static void SDL_RateConvert71(SDL_AudioCVT *cvt, Uint16 format)
+{
+	SDL_RateConvert(cvt, format, 8);
+}
+
+void (*SDL_RateConvertFilters[SDL_RESAMPLE_MAXCHANNELS+1])
+                              (SDL_AudioCVT *cvt, Uint16 format) = {
+	NULL,
+	SDL_RateConvertMono,
+	SDL_RateConvertStereo,
+	NULL,
+	SDL_RateConvertQuad,
+	NULL,
+	SDL_RateConvert51,
+	NULL,
+	SDL_RateConvert71
+};
@@ -0,0 +1,84 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997, 1998, 1999, 2000, 2001, 2002  Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the Free
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+
+#ifdef SAVE_RCSID
+static char rcsid =
+ "@(#) $Id$";
+#endif
+
+/* Sample rate conversion for SDL_BuildAudioCVT() and the audio thread */
+
+#ifndef _SDL_resample_c_h
+#define _SDL_resample_c_h
+
+#include "SDL_audio.h"
+
+/* A resampler keeps the input it has not finished with and the phase of
+   the next output frame, so a stream can be converted in pieces of any
+   size without clicks at the seams.  The data is in 'format' with
+   'channels' interleaved channels on both sides.
+*/
+typedef struct SDL_Resampler SDL_Resampler;
+
+/* Create a resampler using the quality set with SDL_SetResampleQuality(),
+   or return NULL and set the SDL error message.
+*/
+extern SDL_Resampler *SDL_CreateResampler(Uint16 format, int channels,
+                                          int src_rate, int dst_rate);
+
+/* Throw away any queued input and start a new stream */
+extern void SDL_ResetResampler(SDL_Resampler *resampler);
+
+/* Start a new stream that carries on from earlier input instead of
+   silence.  The frames just before the new input are taken from the end
+   of the 'frames' frames in 'buf'.
+ */
+extern void SDL_ResamplerPrime(SDL_Resampler *resampler,
+                               const Uint8 *buf, int frames);
+
+/* Returns the number of frames put that no output frame has reached */
+extern int SDL_ResamplerPending(SDL_Resampler *resampler);
+
+/* Add 'frames' frames of input, returns 0 or -1 if out of memory */
+extern int SDL_ResamplerPut(SDL_Resampler *resampler,
+                            const Uint8 *buf, int frames);
+
+/* Pad the input with silence so the last frames put can be read out */
+extern int SDL_ResamplerFlush(SDL_Resampler *resampler);
+
+/* Returns the number of output frames that can be read right now */
+extern int SDL_ResamplerAvailable(SDL_Resampler *resampler);
+
+/* Read up to 'frames' output frames, returns the number read */
+extern int SDL_ResamplerGet(SDL_Resampler *resampler, Uint8 *buf, int frames);
+
+extern void SDL_FreeResampler(SDL_Resampler *resampler);
+
+/* SDL_AudioCVT filters converting the rate by cvt->rate_incr, one for
+   each supported channel count.  The filter table is indexed by the
+   number of channels and has NULL entries for unsupported counts.
+*/
+#define SDL_RESAMPLE_MAXCHANNELS	8
+extern void (*SDL_RateConvertFilters[SDL_RESAMPLE_MAXCHANNELS+1])
+                                     (SDL_AudioCVT *cvt, Uint16 format);
+
+#endif /* _SDL_resample_c_h */
@@ -72,6 +72,23 @@ struct SDL_AudioDevice {
 	/* An audio conversion block for audio format emulation */
 	SDL_AudioCVT convert;
 
+	/* Converts the rate as a stream, when it differs from the hardware */
+	struct SDL_Resampler *resampler;
+
+	/* Audio from SDL_QueueAudio(), when there's no callback */
+	struct SDL_AudioQueue *queue;
+	Uint32 queue_lowwater;
+	void (*queue_callback)(void *userdata, Uint32 queued);
+	void *queue_userdata;
+
+	/* Statistics, and the trace of the buffer being worked on */
+	SDL_mutex *stats_lock;
+	SDL_AudioStats stats;
+	double stats_total[3];
+	SDL_AudioTrace trace;
+	void (*trace_hook)(void *userdata, const SDL_AudioTrace *trace);
+	void *trace_userdata;
+
 	/* Current state flags */
 	int enabled;
 	int paused;
@@ -413,7 +413,7 @@ SDL_AudioSpec * SDL_LoadWAV_RW (SDL_RWops *src, int freesrc,
 	int was_error;
 	Chunk chunk;
 	int lenread;
-	int MS_ADPCM_encoded, IMA_ADPCM_encoded;
+	int MS_ADPCM_encoded, IMA_ADPCM_encoded, IEEE_float_encoded;
 	int samplesize;
 
 	/* WAV magic header */
@@ -467,11 +467,15 @@ SDL_AudioSpec * SDL_LoadWAV_RW (SDL_RWops *src, int freesrc,
 		was_error = 1;
 		goto done;
 	}
-	MS_ADPCM_encoded = IMA_ADPCM_encoded = 0;
+	MS_ADPCM_encoded = IMA_ADPCM_encoded = IEEE_float_encoded = 0;
 	switch (SDL_SwapLE16(format->encoding)) {
 		case PCM_CODE:
 			/* We can understand this */
 			break;
+		case IEEE_FLOAT_CODE:
+			/* This too, if it's 32-bit */
+			IEEE_float_encoded = 1;
+			break;
 		case MS_ADPCM_CODE:
 			/* Try to understand this */
 			if ( InitMS_ADPCM(format) < 0 ) {
@@ -510,10 +514,20 @@ SDL_AudioSpec * SDL_LoadWAV_RW (SDL_RWops *src, int freesrc,
 		case 16:
 			spec->format = AUDIO_S16;
 			break;
+		case 32:
+			if ( IEEE_float_encoded ) {
+				spec->format = AUDIO_F32;
+			} else {
+				spec->format = AUDIO_S32;
+			}
+			break;
 		default:
 			was_error = 1;
 			break;
 	}
+	if ( IEEE_float_encoded && (spec->format != AUDIO_F32) ) {
+		was_error = 1;
+	}
 	if ( was_error ) {
 		SDL_SetError("Unknown %d-bit PCM data format",
 			SDL_SwapLE16(format->bitspersample));
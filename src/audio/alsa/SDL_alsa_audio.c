@@ -155,6 +155,9 @@ static void ALSA_PlayAudio(_THIS)
 			if ( status == -EAGAIN ) {
 				continue;
 			}
+			if ( status == -EPIPE ) {
+				SDL_AudioXrun();
+			}
 			if ( status == -ESTRPIPE ) {
 				do {
 					status = snd_pcm_resume(pcm_handle);
@@ -248,6 +251,18 @@ static int ALSA_OpenAudio(_THIS, SDL_AudioSpec *spec)
 			case AUDIO_U16MSB:
 				format = SND_PCM_FORMAT_U16_BE;
 				break;
+			case AUDIO_S32LSB:
+				format = SND_PCM_FORMAT_S32_LE;
+				break;
+			case AUDIO_S32MSB:
+				format = SND_PCM_FORMAT_S32_BE;
+				break;
+			case AUDIO_F32LSB:
+				format = SND_PCM_FORMAT_FLOAT_LE;
+				break;
+			case AUDIO_F32MSB:
+				format = SND_PCM_FORMAT_FLOAT_BE;
+				break;
 			default:
 				format = 0;
 				break;
@@ -246,6 +246,7 @@ static int AHI_OpenAudio(_THIS, SDL_AudioSpec *spec)
 		}
 		break;
 
+		case 32: /* Played as 16 bit, SDL_OpenAudio() converts */
 		case 16: { /* Signed 16 bit audio data */
 			D(bug("Samples a 16 bit...\n"));
 			spec->format = AUDIO_S16MSB;
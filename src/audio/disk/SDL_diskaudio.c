@@ -28,11 +28,21 @@ static char rcsid =
  "@(#) $Id$";
 #endif
 
-/* Output raw audio data to a file. */
+/* Output raw audio data to a file, or a WAVE file if the name ends in .wav
+
+   The audio thread is paced by SDL_DISKAUDIOMODE:
+	"realtime"	Keep to the sample rate, by a clock that
+			doesn't jump.  This is the default.
+	"delay"		Sleep SDL_DISKAUDIODELAY milliseconds per buffer,
+			the default when SDL_DISKAUDIODELAY is set.
+	"freewheel"	Don't wait, so the audio is rendered as fast as
+			the application can make it.
+*/
 
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <ctype.h>
 #include <errno.h>
 #include <unistd.h>
 #include <sys/stat.h>
@@ -57,6 +67,10 @@ static char rcsid =
 #define DISKDEFAULT_OUTFILE      "sdlaudio.raw"
 #define DISKENVR_WRITEDELAY      "SDL_DISKAUDIODELAY"
 #define DISKDEFAULT_WRITEDELAY   150
+#define DISKENVR_MODE            "SDL_DISKAUDIOMODE"
+
+/* Buffers are written in batches of about this many bytes */
+#define DISKAUD_BATCH            65536
 
 /* Audio driver functions */
 static int DISKAUD_OpenAudio(_THIS, SDL_AudioSpec *spec);
@@ -136,6 +150,17 @@ static SDL_AudioDevice *DISKAUD_CreateDevice(int devindex)
 
     envr = getenv(DISKENVR_WRITEDELAY);
     this->hidden->write_delay = (envr) ? atoi(envr) : DISKDEFAULT_WRITEDELAY;
+    this->hidden->mode = (envr) ? DISKAUD_DELAY : DISKAUD_REALTIME;
+    envr = getenv(DISKENVR_MODE);
+    if ( envr ) {
+        if ( strcmp(envr, "realtime") == 0 ) {
+            this->hidden->mode = DISKAUD_REALTIME;
+        } else if ( strcmp(envr, "delay") == 0 ) {
+            this->hidden->mode = DISKAUD_DELAY;
+        } else if ( strcmp(envr, "freewheel") == 0 ) {
+            this->hidden->mode = DISKAUD_FREEWHEEL;
+        }
+    }
 
 	/* Set the function pointers */
 	this->OpenAudio = DISKAUD_OpenAudio;
@@ -154,59 +179,250 @@ AudioBootStrap DISKAUD_bootstrap = {
 	DISKAUD_Available, DISKAUD_CreateDevice
 };
 
+/* Seconds on a clock that doesn't jump when the time of day is set */
+static double DISKAUD_Now(void)
+{
+#ifdef SDL_HAS_64BIT_TYPE
+	return((double)(Sint64)SDL_GetPerformanceCounter() /
+	       (double)(Sint64)SDL_GetPerformanceFrequency());
+#else
+	return(SDL_GetTicks() / 1000.0);
+#endif
+}
+
 /* This function waits until it is possible to write a full sound buffer */
 static void DISKAUD_WaitAudio(_THIS)
 {
-    SDL_Delay(this->hidden->write_delay);
+	struct SDL_PrivateAudioData *hidden = this->hidden;
+	double now, ahead;
+
+	switch (hidden->mode) {
+	    case DISKAUD_DELAY:
+		SDL_Delay(hidden->write_delay);
+		break;
+
+	    case DISKAUD_REALTIME:
+		now = DISKAUD_Now();
+		if ( hidden->frames == 0.0 ) {
+			hidden->start = now;
+		}
+
+		/* Wait until the audio written so far would have played,
+		   counting from the start so the rounding never adds up */
+		ahead = hidden->start + hidden->frames / hidden->freq - now;
+		if ( ahead > 0.0 ) {
+			SDL_Delay((Uint32)(ahead * 1000.0));
+		} else if ( -ahead > (double)this->spec.samples/hidden->freq ) {
+			/* More than a buffer behind, so let the time go */
+			SDL_AudioXrun();
+			hidden->start -= ahead;
+		}
+		break;
+
+	    case DISKAUD_FREEWHEEL:
+		break;
+	}
 }
 
-static void DISKAUD_PlayAudio(_THIS)
+/* Write all of 'len' bytes, checking for EAGAIN on broken audio drivers */
+static int DISKAUD_Write(int fd, const Uint8 *buf, Uint32 len)
 {
 	int written;
 
-	/* Write the audio data, checking for EAGAIN on broken audio drivers */
-	do {
-		written = write(this->hidden->audio_fd,
-                        this->hidden->mixbuf,
-                        this->hidden->mixlen);
-		if ( (written < 0) && ((errno == 0) || (errno == EAGAIN)) ) {
-			SDL_Delay(1);	/* Let a little CPU time go by */
+	while ( len > 0 ) {
+		written = write(fd, buf, len);
+		if ( written < 0 ) {
+			if ( (errno == 0) || (errno == EAGAIN) ) {
+				SDL_Delay(1);	/* Let a little CPU time go by */
+			} else if ( errno != EINTR ) {
+				return(-1);
+			}
+			continue;
 		}
-	} while ( (written < 0) && 
-	          ((errno == 0) || (errno == EAGAIN) || (errno == EINTR)) );
-
-	/* If we couldn't write, assume fatal error for now */
-	if ( written < 0 ) {
-		this->enabled = 0;
-	}
 #ifdef DEBUG_AUDIO
-	fprintf(stderr, "Wrote %d bytes of audio data\n", written);
+		fprintf(stderr, "Wrote %d bytes of audio data\n", written);
 #endif
+		buf += written;
+		len -= written;
+	}
+	return(0);
 }
 
+static int DISKAUD_Flush(_THIS)
+{
+	struct SDL_PrivateAudioData *hidden = this->hidden;
+	Uint32 len = hidden->batch_fill;
+
+	hidden->batch_fill = 0;
+	if ( DISKAUD_Write(hidden->audio_fd, hidden->mixbuf, len) < 0 ) {
+		return(-1);
+	}
+	hidden->wav_bytes += len;
+	return(0);
+}
+
+static void DISKAUD_PlayAudio(_THIS)
+{
+	struct SDL_PrivateAudioData *hidden = this->hidden;
+
+	hidden->batch_fill += hidden->mixlen;
+	hidden->frames += hidden->mixlen / hidden->framesize;
+	if ( hidden->batch_fill == hidden->batch_len ) {
+		/* If we couldn't write, assume fatal error for now */
+		if ( DISKAUD_Flush(this) < 0 ) {
+			this->enabled = 0;
+		}
+	}
+}
+
+/* The next buffer of the batch */
 static Uint8 *DISKAUD_GetAudioBuf(_THIS)
 {
-	return(this->hidden->mixbuf);
+	return(this->hidden->mixbuf + this->hidden->batch_fill);
 }
 
-static void DISKAUD_CloseAudio(_THIS)
+static void DISKAUD_Put16(Uint8 *p, Uint16 value)
 {
-	if ( this->hidden->mixbuf != NULL ) {
-		SDL_FreeAudioMem(this->hidden->mixbuf);
-		this->hidden->mixbuf = NULL;
+	p[0] = (Uint8)value;
+	p[1] = (Uint8)(value >> 8);
+}
+
+static void DISKAUD_Put32(Uint8 *p, Uint32 value)
+{
+	DISKAUD_Put16(p, (Uint16)value);
+	DISKAUD_Put16(p+2, (Uint16)(value >> 16));
+}
+
+static int DISKAUD_IsWave(const char *fname)
+{
+	size_t len = strlen(fname);
+
+	return( (len >= 4) && (fname[len-4] == '.') &&
+	        (tolower((unsigned char)fname[len-3]) == 'w') &&
+	        (tolower((unsigned char)fname[len-2]) == 'a') &&
+	        (tolower((unsigned char)fname[len-1]) == 'v') );
+}
+
+/* The nearest format a WAVE file can hold */
+static Uint16 DISKAUD_WaveFormat(Uint16 format)
+{
+	switch (format) {
+	    case AUDIO_U8:
+	    case AUDIO_S8:
+		return(AUDIO_U8);
+	    case AUDIO_S32LSB:
+	    case AUDIO_S32MSB:
+		return(AUDIO_S32LSB);
+	    case AUDIO_F32LSB:
+	    case AUDIO_F32MSB:
+		return(AUDIO_F32LSB);
+	    default:
+		return(AUDIO_S16LSB);
 	}
+}
+
+/* Write the WAVE header, with the lengths left unknown until the file
+   is closed, in case it is a pipe that can't be rewritten.  More than
+   two channels need WAVE_FORMAT_EXTENSIBLE for the speaker layout.
+ */
+static int DISKAUD_WriteWaveHeader(_THIS, SDL_AudioSpec *spec)
+{
+	static const Uint8 guid_tail[14] = {
+		0x00, 0x00, 0x00, 0x00, 0x10, 0x00,
+		0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71
+	};
+	Uint8 header[68];
+	Uint16 bits, tag;
+	Uint32 mask;
+	int framesize, fmt_len, extensible;
+
+	bits = spec->format & 0xFF;
+	tag = (spec->format & 0x0100) ? 0x0003 : 0x0001;
+	framesize = (bits / 8) * spec->channels;
+	extensible = (spec->channels > 2);
+	fmt_len = extensible ? 40 : 16;
+	switch (spec->channels) {
+	    case 1:  mask = 0x004; break;
+	    case 2:  mask = 0x003; break;
+	    case 4:  mask = 0x033; break;
+	    case 6:  mask = 0x03F; break;
+	    case 8:  mask = 0x63F; break;
+	    default: mask = 0; break;
+	}
+
+	memcpy(header, "RIFF", 4);
+	DISKAUD_Put32(header+4, 0xFFFFFFFF);
+	memcpy(header+8, "WAVEfmt ", 8);
+	DISKAUD_Put32(header+16, fmt_len);
+	DISKAUD_Put16(header+20, extensible ? 0xFFFE : tag);
+	DISKAUD_Put16(header+22, spec->channels);
+	DISKAUD_Put32(header+24, spec->freq);
+	DISKAUD_Put32(header+28, spec->freq * framesize);
+	DISKAUD_Put16(header+32, framesize);
+	DISKAUD_Put16(header+34, bits);
+	if ( extensible ) {
+		DISKAUD_Put16(header+36, 22);
+		DISKAUD_Put16(header+38, bits);
+		DISKAUD_Put32(header+40, mask);
+		DISKAUD_Put16(header+44, tag);
+		memcpy(header+46, guid_tail, sizeof(guid_tail));
+	}
+	memcpy(header+20+fmt_len, "data", 4);
+	DISKAUD_Put32(header+24+fmt_len, 0xFFFFFFFF);
+
+	this->hidden->wav_header = 28 + fmt_len;
+	return(DISKAUD_Write(this->hidden->audio_fd, header,
+	                     this->hidden->wav_header));
+}
+
+/* Fill in the lengths, if the file can be rewritten */
+static void DISKAUD_FinishWave(_THIS)
+{
+	struct SDL_PrivateAudioData *hidden = this->hidden;
+	Uint32 len = hidden->wav_bytes;
+	Uint8 value[4];
+
+	/* Chunks are padded to an even length */
+	value[0] = 0;
+	if ( (len & 1) && (DISKAUD_Write(hidden->audio_fd, value, 1) < 0) ) {
+		return;
+	}
+	if ( lseek(hidden->audio_fd, 4, SEEK_SET) == 4 ) {
+		DISKAUD_Put32(value, hidden->wav_header - 8 + len + (len & 1));
+		DISKAUD_Write(hidden->audio_fd, value, 4);
+		lseek(hidden->audio_fd, hidden->wav_header - 4, SEEK_SET);
+		DISKAUD_Put32(value, len);
+		DISKAUD_Write(hidden->audio_fd, value, 4);
+	}
+}
+
+static void DISKAUD_CloseAudio(_THIS)
+{
 	if ( this->hidden->audio_fd >= 0 ) {
+		if ( this->hidden->batch_fill ) {
+			DISKAUD_Flush(this);
+		}
+		if ( this->hidden->wav_header ) {
+			DISKAUD_FinishWave(this);
+		}
 		close(this->hidden->audio_fd);
 		this->hidden->audio_fd = -1;
 	}
+	if ( this->hidden->mixbuf != NULL ) {
+		SDL_FreeAudioMem(this->hidden->mixbuf);
+		this->hidden->mixbuf = NULL;
+	}
 }
 
 static int DISKAUD_OpenAudio(_THIS, SDL_AudioSpec *spec)
 {
     const char *fname = DISKAUD_GetOutputFilename();
 
+	Uint32 buffers;
+
 	/* Open the audio device */
-    this->hidden->audio_fd = open(fname, O_WRONLY | O_CREAT, S_IRUSR | S_IWUSR);
+    this->hidden->audio_fd = open(fname, O_WRONLY | O_CREAT | O_TRUNC,
+                                  S_IRUSR | S_IWUSR);
 	if ( this->hidden->audio_fd < 0 ) {
 		SDL_SetError("Couldn't open %s: %s", fname, strerror(errno));
 		return(-1);
@@ -215,13 +431,38 @@ static int DISKAUD_OpenAudio(_THIS, SDL_AudioSpec *spec)
     fprintf(stderr, "WARNING: You are using the SDL disk writer"
                     " audio driver!\n Writing to file [%s].\n", fname);
 
-	/* Allocate mixing buffer */
+	this->hidden->wav_header = 0;
+	this->hidden->wav_bytes = 0;
+	if ( DISKAUD_IsWave(fname) ) {
+		spec->format = DISKAUD_WaveFormat(spec->format);
+		SDL_CalculateAudioSpec(spec);
+		if ( DISKAUD_WriteWaveHeader(this, spec) < 0 ) {
+			SDL_SetError("Couldn't write %s: %s",
+			             fname, strerror(errno));
+			this->hidden->wav_header = 0;
+			DISKAUD_CloseAudio(this);
+			return(-1);
+		}
+	}
+	this->hidden->freq = spec->freq;
+	this->hidden->framesize = ((spec->format & 0xFF) / 8) * spec->channels;
+	this->hidden->frames = 0.0;
+
+	/* Allocate mixing buffer, holding a batch of buffers */
+	buffers = DISKAUD_BATCH / spec->size;
+	if ( buffers < 1 ) {
+		buffers = 1;
+	}
 	this->hidden->mixlen = spec->size;
-	this->hidden->mixbuf = (Uint8 *) SDL_AllocAudioMem(this->hidden->mixlen);
+	this->hidden->batch_len = buffers * spec->size;
+	this->hidden->batch_fill = 0;
+	this->hidden->mixbuf = (Uint8 *)
+		SDL_AllocAudioMem(this->hidden->batch_len);
 	if ( this->hidden->mixbuf == NULL ) {
+		DISKAUD_CloseAudio(this);
 		return(-1);
 	}
-	memset(this->hidden->mixbuf, spec->silence, spec->size);
+	memset(this->hidden->mixbuf, spec->silence, this->hidden->batch_len);
 
 	/* We're ready to rock and roll. :-) */
 	return(0);
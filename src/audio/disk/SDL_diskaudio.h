@@ -33,12 +33,34 @@ static char rcsid =
 /* Hidden "this" pointer for the video functions */
 #define _THIS	SDL_AudioDevice *this
 
+/* How the driver paces the audio thread */
+enum {
+	DISKAUD_DELAY,		/* Sleep a fixed delay per buffer */
+	DISKAUD_REALTIME,	/* Keep to the sample rate */
+	DISKAUD_FREEWHEEL	/* Don't wait at all */
+};
+
 struct SDL_PrivateAudioData {
 	/* The file descriptor for the audio device */
 	int audio_fd;
     Uint8 *mixbuf;
     Uint32 mixlen;
     Uint32 write_delay;
+    int mode;
+
+    /* Buffers are collected in mixbuf and written 'batch_len' at a time */
+    Uint32 batch_len;
+    Uint32 batch_fill;
+
+    /* Frames written since the real time clock started at 'start' */
+    double frames;
+    double start;
+    int freq;
+    int framesize;
+
+    /* Length of the WAV header, and the audio written after it */
+    int wav_header;
+    Uint32 wav_bytes;
 };
 
 #endif /* _SDL_diskaudio_h */
@@ -289,6 +289,9 @@ static int ESD_OpenAudio(_THIS, SDL_AudioSpec *spec)
 		case 8:
 			format |= ESD_BITS8;
 			break;
+		case 32:
+			/* Played as 16 bit, SDL_OpenAudio() converts */
+			spec->format = AUDIO_S16SYS;
 		case 16:
 			format |= ESD_BITS16;
 			break;
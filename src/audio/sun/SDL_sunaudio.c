@@ -271,6 +271,7 @@ int DSP_OpenAudio(_THIS, SDL_AudioSpec *spec)
 		}
 		break;
 
+		case 32: /* Played as 16 bit, SDL_OpenAudio() converts */
 		case 16: { /* Signed 16 bit audio data */
 		        spec->format = AUDIO_S16SYS;
 #ifdef AUDIO_SETINFO
@@ -252,6 +252,8 @@ int DIB_OpenAudio(_THIS, SDL_AudioSpec *spec)
 			spec->format = AUDIO_U8;
 			waveformat.wBitsPerSample = 8;
 			break;
+		case 32:
+			/* Played as 16 bit, SDL_OpenAudio() converts */
 		case 16:
 			/* Signed 16 bit audio data */
 			spec->format = AUDIO_S16;
@@ -635,6 +635,8 @@ static int DX5_OpenAudio(_THIS, SDL_AudioSpec *spec)
 			silence = 0x80;
 			waveformat.wBitsPerSample = 8;
 			break;
+		case 32:
+			/* Played as 16 bit, SDL_OpenAudio() converts */
 		case 16:
 			/* Signed 16 bit audio data */
 			spec->format = AUDIO_S16;
@@ -0,0 +1,289 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997, 1998, 1999, 2000, 2001, 2002  Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the Free
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+
+#ifdef SAVE_RCSID
+static char rcsid =
+ "@(#) $Id$";
+#endif
+
+/* CPU feature detection for SDL */
+
+#include "SDL_types.h"
+#include "SDL_cpuinfo.h"
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1600) && \
+    (defined(_M_IX86) || defined(_M_X64))
+#include <intrin.h>
+#endif
+#if defined(WIN32) || defined(_WIN32_WCE)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#elif defined(__BEOS__)
+#include <OS.h>
+#elif defined(unix) || defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+#define CPU_HAS_RDTSC	0x00000001
+#define CPU_HAS_MMX	0x00000002
+#define CPU_HAS_3DNOW	0x00000004
+#define CPU_HAS_SSE	0x00000008
+#define CPU_HAS_SSE2	0x00000010
+#define CPU_HAS_SSSE3	0x00000020
+#define CPU_HAS_AVX2	0x00000040
+#define CPU_HAS_NEON	0x00000080
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#define HAVE_CPUID
+static void cpuid(Uint32 leaf, Uint32 subleaf, Uint32 regs[4])
+{
+#if defined(__i386__)
+	/* %ebx may be the PIC register, so preserve it by hand */
+	__asm__ __volatile__ (
+	"	pushl %%ebx\n"
+	"	cpuid\n"
+	"	movl %%ebx, %%esi\n"
+	"	popl %%ebx\n"
+	: "=a" (regs[0]), "=S" (regs[1]), "=c" (regs[2]), "=d" (regs[3])
+	: "a" (leaf), "c" (subleaf) );
+#else
+	__asm__ __volatile__ (
+	"	cpuid\n"
+	: "=a" (regs[0]), "=b" (regs[1]), "=c" (regs[2]), "=d" (regs[3])
+	: "a" (leaf), "c" (subleaf) );
+#endif
+}
+static Uint32 xgetbv(void)
+{
+	Uint32 lo, hi;
+
+	/* xgetbv with %ecx == 0, spelled out for old assemblers */
+	__asm__ __volatile__ (
+	"	.byte 0x0f, 0x01, 0xd0\n"
+	: "=a" (lo), "=d" (hi) : "c" (0) );
+	return(lo);
+}
+#elif defined(_MSC_VER) && (_MSC_VER >= 1600) && \
+      (defined(_M_IX86) || defined(_M_X64))
+#define HAVE_CPUID
+static void cpuid(Uint32 leaf, Uint32 subleaf, Uint32 regs[4])
+{
+	__cpuidex((int *)regs, (int)leaf, (int)subleaf);
+}
+static Uint32 xgetbv(void)
+{
+	return((Uint32)_xgetbv(0));
+}
+#endif
+
+#ifdef HAVE_CPUID
+static int CPU_haveCPUID(void)
+{
+#if defined(__GNUC__) && defined(__i386__)
+	int has_CPUID = 0;
+
+	/* The ID flag in EFLAGS can only be toggled if CPUID exists */
+	__asm__ __volatile__ (
+	"	pushfl\n"
+	"	popl %%eax\n"
+	"	movl %%eax, %%ecx\n"
+	"	xorl $0x200000, %%eax\n"
+	"	pushl %%eax\n"
+	"	popfl\n"
+	"	pushfl\n"
+	"	popl %%eax\n"
+	"	xorl %%ecx, %%eax\n"
+	"	jz 1f\n"
+	"	movl $1, %0\n"
+	"1:\n"
+	: "=m" (has_CPUID) : : "%eax", "%ecx" );
+	return(has_CPUID);
+#else
+	/* Every 64-bit x86 processor has CPUID */
+	return(1);
+#endif
+}
+
+static Uint32 CPU_probeFeatures(void)
+{
+	Uint32 features = 0;
+	Uint32 regs[4];
+	Uint32 max_leaf;
+
+	if ( ! CPU_haveCPUID() ) {
+		return(0);
+	}
+	cpuid(0, 0, regs);
+	max_leaf = regs[0];
+	if ( max_leaf < 1 ) {
+		return(0);
+	}
+
+	cpuid(1, 0, regs);
+	if ( regs[3] & 0x00000010 ) {
+		features |= CPU_HAS_RDTSC;
+	}
+	if ( regs[3] & 0x00800000 ) {
+		features |= CPU_HAS_MMX;
+	}
+	if ( regs[3] & 0x02000000 ) {
+		features |= CPU_HAS_SSE;
+	}
+	if ( regs[3] & 0x04000000 ) {
+		features |= CPU_HAS_SSE2;
+	}
+	if ( regs[2] & 0x00000200 ) {
+		features |= CPU_HAS_SSSE3;
+	}
+
+	/* AVX2 needs the OS to save the YMM state (OSXSAVE + AVX + XCR0) */
+	if ( (max_leaf >= 7) &&
+	     ((regs[2] & 0x18000000) == 0x18000000) &&
+	     ((xgetbv() & 0x06) == 0x06) ) {
+		cpuid(7, 0, regs);
+		if ( regs[1] & 0x00000020 ) {
+			features |= CPU_HAS_AVX2;
+		}
+	}
+
+	cpuid(0x80000000, 0, regs);
+	if ( regs[0] >= 0x80000001 ) {
+		cpuid(0x80000001, 0, regs);
+		if ( regs[3] & 0x80000000 ) {
+			features |= CPU_HAS_3DNOW;
+		}
+	}
+	return(features);
+}
+#else
+static Uint32 CPU_probeFeatures(void)
+{
+	Uint32 features = 0;
+
+#if defined(__aarch64__) || defined(__ARM_NEON) || defined(__ARM_NEON__)
+	features |= CPU_HAS_NEON;
+#endif
+	return(features);
+}
+#endif /* HAVE_CPUID */
+
+static Uint32 SDL_CPUFeatures = 0xFFFFFFFF;
+
+static Uint32 SDL_GetCPUFeatures(void)
+{
+	if ( SDL_CPUFeatures == 0xFFFFFFFF ) {
+		SDL_CPUFeatures = CPU_probeFeatures();
+	}
+	return(SDL_CPUFeatures);
+}
+
+SDL_bool SDL_HasRDTSC(void)
+{
+	if ( SDL_GetCPUFeatures() & CPU_HAS_RDTSC ) {
+		return(SDL_TRUE);
+	}
+	return(SDL_FALSE);
+}
+
+SDL_bool SDL_HasMMX(void)
+{
+	if ( SDL_GetCPUFeatures() & CPU_HAS_MMX ) {
+		return(SDL_TRUE);
+	}
+	return(SDL_FALSE);
+}
+
+SDL_bool SDL_Has3DNow(void)
+{
+	if ( SDL_GetCPUFeatures() & CPU_HAS_3DNOW ) {
+		return(SDL_TRUE);
+	}
+	return(SDL_FALSE);
+}
+
+SDL_bool SDL_HasSSE(void)
+{
+	if ( SDL_GetCPUFeatures() & CPU_HAS_SSE ) {
+		return(SDL_TRUE);
+	}
+	return(SDL_FALSE);
+}
+
+SDL_bool SDL_HasSSE2(void)
+{
+	if ( SDL_GetCPUFeatures() & CPU_HAS_SSE2 ) {
+		return(SDL_TRUE);
+	}
+	return(SDL_FALSE);
+}
+
+SDL_bool SDL_HasSSSE3(void)
+{
+	if ( SDL_GetCPUFeatures() & CPU_HAS_SSSE3 ) {
+		return(SDL_TRUE);
+	}
+	return(SDL_FALSE);
+}
+
+SDL_bool SDL_HasAVX2(void)
+{
+	if ( SDL_GetCPUFeatures() & CPU_HAS_AVX2 ) {
+		return(SDL_TRUE);
+	}
+	return(SDL_FALSE);
+}
+
+SDL_bool SDL_HasNEON(void)
+{
+	if ( SDL_GetCPUFeatures() & CPU_HAS_NEON ) {
+		return(SDL_TRUE);
+	}
+	return(SDL_FALSE);
+}
+
+static int SDL_CPUCount = 0;
+
+int SDL_GetCPUCount(void)
+{
+	if ( SDL_CPUCount == 0 ) {
+#if defined(WIN32) || defined(_WIN32_WCE)
+		SYSTEM_INFO info;
+
+		GetSystemInfo(&info);
+		SDL_CPUCount = (int)info.dwNumberOfProcessors;
+#elif defined(__BEOS__)
+		system_info info;
+
+		if ( get_system_info(&info) == B_OK ) {
+			SDL_CPUCount = info.cpu_count;
+		}
+#elif defined(_SC_NPROCESSORS_ONLN)
+		SDL_CPUCount = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#elif defined(_SC_NPROC_ONLN)
+		SDL_CPUCount = (int)sysconf(_SC_NPROC_ONLN);
+#endif
+		if ( SDL_CPUCount <= 0 ) {
+			SDL_CPUCount = 1;
+		}
+	}
+	return(SDL_CPUCount);
+}
@@ -0,0 +1,64 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997, 1998, 1999, 2000, 2001, 2002  Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the Free
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+
+#ifdef SAVE_RCSID
+static char rcsid =
+ "@(#) $Id$";
+#endif
+
+#ifndef _SDL_simd_h
+#define _SDL_simd_h
+
+/* Which SIMD intrinsics the compiler can generate, independent of the
+   flags the library is built with.  Code using these must be wrapped in
+   SDL_TARGETING() and only called after the matching SDL_HasXXX() check.
+*/
+
+#include "SDL_cpuinfo.h"
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__)) && \
+    (defined(__clang__) || (__GNUC__ > 4) || \
+     ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 9)))
+#define SDL_SSE2_INTRINSICS
+#define SDL_SSSE3_INTRINSICS
+#define SDL_AVX2_INTRINSICS
+#define SDL_TARGETING(x)	__attribute__((target(x)))
+#include <immintrin.h>
+#endif
+
+#if defined(__GNUC__) && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+#define SDL_NEON_INTRINSICS
+#include <arm_neon.h>
+#endif
+
+#ifndef SDL_TARGETING
+#define SDL_TARGETING(x)
+#endif
+
+/* Alignment helper for SIMD scratch buffers */
+#ifdef __GNUC__
+#define SDL_SIMD_ALIGNED	__attribute__((aligned(32)))
+#else
+#define SDL_SIMD_ALIGNED
+#endif
+
+#endif /* _SDL_simd_h */
@@ -28,11 +28,19 @@ static char rcsid =
 /* General event handling code for SDL */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#if defined(unix) || defined(__unix__)
+#include <sys/types.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#endif
 
 #include "SDL.h"
 #include "SDL_thread.h"
 #include "SDL_mutex.h"
+#include "SDL_atomic_c.h"
 #include "SDL_events.h"
 #include "SDL_events_c.h"
 #include "SDL_timer_c.h"
@@ -44,24 +52,93 @@ static char rcsid =
 #endif
 #include "SDL_syswm.h"
 #include "SDL_sysevents.h"
+#include "SDL_present_c.h"
 
 /* Public data -- the event filter */
 SDL_EventFilter SDL_EventOK = NULL;
 Uint8 SDL_ProcessEvents[SDL_NUMEVENTS];
 static Uint32 SDL_eventstate = 0;
 
-/* Private data -- event queue */
-#define MAXEVENTS	128
+/* Private data -- event queue
+
+   The queue is a list of segments that grows as events arrive.  Adding
+   an event claims a slot with an atomic increment, so any thread can add
+   events without taking a lock, and a full segment is followed by a new
+   one instead of dropping the event.  Reading the queue is serialized by
+   the queue lock.  Events taken out of the middle of the queue are only
+   marked as taken, so a masked SDL_GETEVENT doesn't move the events
+   behind it.  Segments are released once every slot has been taken, but
+   not freed while an event is being added, since the thread adding it
+   may still be looking at them.
+
+   System window manager messages are copied into a separate ring, and
+   an entry stays in use until its event is taken from the queue.  The
+   entries are handed out in turn, so a message is only overwritten when
+   MAXWMMSGS more have arrived after its event was taken.  If all of
+   them are in use, the new event is dropped.
+*/
+#define SEGMENT_EVENTS	128
+#define MAXEVENTS	65536		/* Drop events beyond this */
+#define MAXWMMSGS	128		/* System messages kept at once */
+
+#define SLOT_EMPTY	0
+#define SLOT_READY	1
+#define SLOT_TAKEN	2
+
+typedef struct SDL_EventSlot {
+	volatile int state;
+	SDL_Event event;
+} SDL_EventSlot;
+
+typedef struct SDL_EventSegment {
+	struct SDL_EventSegment * volatile next;
+	volatile int reserved;		/* Slots claimed by producers */
+	volatile int written;		/* Slots with their event stored */
+	volatile Uint32 types;		/* Mask of the event types added */
+	int taken;			/* Slots taken by the reader */
+	int first;			/* First slot not yet taken */
+	struct SDL_EventSegment *retired;
+	SDL_EventSlot slot[SEGMENT_EVENTS];
+} SDL_EventSegment;
+
 static struct {
 	SDL_mutex *lock;
 	int active;
-	int head;
-	int tail;
-	SDL_Event event[MAXEVENTS];
-	int wmmsg_next;
-	struct SDL_SysWMmsg wmmsg[MAXEVENTS];
+	SDL_EventSegment *head;
+	SDL_EventSegment * volatile tail;
+	SDL_EventSegment * volatile spare;
+	SDL_EventSegment *retired;
+	volatile int producers;		/* Threads adding events right now */
+	volatile int count;
+	volatile Uint32 wmmsg_next;
+	volatile int wmmsg_used[MAXWMMSGS];
+	struct SDL_SysWMmsg wmmsg[MAXWMMSGS];
+	SDL_EventQueueStats stats;
 } SDL_EventQ;
 
+/* Private data -- waiting for events
+
+   SDL_WaitEvent() sleeps until an event is added to the queue, or until
+   a file descriptor of the video driver or an open joystick is readable.
+   Drivers that can't be waited on this way are still polled.  Adding
+   events only wakes up waiting threads when there are any.
+*/
+#if defined(unix) || defined(__unix__)
+#define WAIT_FOR_FDS
+#endif
+#define MAXWAITFDS	16
+#define POLL_INTERVAL	10	/* ms between polls of drivers without fds */
+
+static struct {
+	SDL_mutex *lock;
+	SDL_cond *cond;
+	volatile int waiting;
+#ifdef WAIT_FOR_FDS
+	int have_pipe;
+	int pipe[2];		/* Written to interrupt select() */
+#endif
+} SDL_EventWait;
+
 /* Private data -- event locking structure */
 static struct {
 	SDL_mutex *lock;
@@ -153,8 +230,26 @@ static int SDL_StartEventThread(Uint32 flags)
 #endif
 	}
 #endif /* !DISABLE_THREADS */
+	SDL_EventQ.head = (SDL_EventSegment *)malloc(sizeof(SDL_EventSegment));
+	if ( SDL_EventQ.head == NULL ) {
+		SDL_OutOfMemory();
+		return(-1);
+	}
+	memset(SDL_EventQ.head, 0, sizeof(*SDL_EventQ.head));
+	SDL_EventQ.tail = SDL_EventQ.head;
 	SDL_EventQ.active = 1;
 
+	/* Set up waiting for events, SDL_WaitEvent() polls without it */
+	SDL_EventWait.lock = SDL_CreateMutex();
+	SDL_EventWait.cond = SDL_CreateCond();
+#ifdef WAIT_FOR_FDS
+	if ( pipe(SDL_EventWait.pipe) == 0 ) {
+		fcntl(SDL_EventWait.pipe[0], F_SETFL, O_NONBLOCK);
+		fcntl(SDL_EventWait.pipe[1], F_SETFL, O_NONBLOCK);
+		SDL_EventWait.have_pipe = 1;
+	}
+#endif
+
 	if ( (flags&SDL_INIT_EVENTTHREAD) == SDL_INIT_EVENTTHREAD ) {
 		SDL_EventLock.lock = SDL_CreateMutex();
 		if ( SDL_EventLock.lock == NULL ) {
@@ -181,6 +276,22 @@ static void SDL_StopEventThread(void)
 		SDL_DestroyMutex(SDL_EventLock.lock);
 	}
 	SDL_DestroyMutex(SDL_EventQ.lock);
+
+	if ( SDL_EventWait.cond ) {
+		SDL_DestroyCond(SDL_EventWait.cond);
+		SDL_EventWait.cond = NULL;
+	}
+	if ( SDL_EventWait.lock ) {
+		SDL_DestroyMutex(SDL_EventWait.lock);
+		SDL_EventWait.lock = NULL;
+	}
+#ifdef WAIT_FOR_FDS
+	if ( SDL_EventWait.have_pipe ) {
+		close(SDL_EventWait.pipe[0]);
+		close(SDL_EventWait.pipe[1]);
+		SDL_EventWait.have_pipe = 0;
+	}
+#endif
 }
 
 Uint32 SDL_EventThreadID(void)
@@ -192,13 +303,30 @@ Uint32 SDL_EventThreadID(void)
 
 void SDL_StopEventLoop(void)
 {
+	SDL_EventSegment *segment;
+
 	/* Halt the event thread, if running */
 	SDL_StopEventThread();
 
 	/* Clean out EventQ */
-	SDL_EventQ.head = 0;
-	SDL_EventQ.tail = 0;
+	while ( SDL_EventQ.head ) {
+		segment = SDL_EventQ.head;
+		SDL_EventQ.head = segment->next;
+		free(segment);
+	}
+	while ( SDL_EventQ.retired ) {
+		segment = SDL_EventQ.retired;
+		SDL_EventQ.retired = segment->retired;
+		free(segment);
+	}
+	if ( SDL_EventQ.spare ) {
+		free(SDL_EventQ.spare);
+	}
+	SDL_EventQ.tail = NULL;
+	SDL_EventQ.spare = NULL;
+	SDL_EventQ.count = 0;
 	SDL_EventQ.wmmsg_next = 0;
+	memset((void *)SDL_EventQ.wmmsg_used, 0, sizeof(SDL_EventQ.wmmsg_used));
 }
 
 /* This function (and associated calls) may be called more than once */
@@ -210,6 +338,7 @@ int SDL_StartEventLoop(Uint32 flags)
 	SDL_EventThread = NULL;
 	SDL_EventQ.lock = NULL;
 	SDL_StopEventLoop();
+	memset(&SDL_EventQ.stats, 0, sizeof(SDL_EventQ.stats));
 
 	/* No filter to start with, process most event types */
 	SDL_EventOK = NULL;
@@ -239,61 +368,250 @@ int SDL_StartEventLoop(Uint32 flags)
 }
 
 
-/* Add an event to the event queue -- called with the queue locked */
+/* Get an empty segment for the end of the queue */
+static SDL_EventSegment *SDL_NewSegment(void)
+{
+	SDL_EventSegment *segment;
+
+	/* Use the one kept by the reader, if it's there */
+	do {
+		segment = SDL_EventQ.spare;
+	} while ( segment &&
+	          !SDL_AtomicCASPtr(&SDL_EventQ.spare, segment, NULL) );
+	if ( ! segment ) {
+		segment = (SDL_EventSegment *)malloc(sizeof(*segment));
+		if ( ! segment ) {
+			return(NULL);
+		}
+	}
+	memset(segment, 0, sizeof(*segment));
+	return(segment);
+}
+
+/* Claim the next free entry for a system message, or return -1 */
+static int SDL_ClaimWMMsg(void)
+{
+	int i, msg;
+
+	for ( i=0; i<MAXWMMSGS; ++i ) {
+		msg = SDL_AtomicAdd(&SDL_EventQ.wmmsg_next, 1) % MAXWMMSGS;
+		if ( SDL_AtomicCAS(&SDL_EventQ.wmmsg_used[msg], 0, 1) ) {
+			return(msg);
+		}
+	}
+	return(-1);
+}
+
+/* Add an event to the event queue -- called from any thread, and with the
+                          queue locked if there are no atomic operations */
 static int SDL_AddEvent(SDL_Event *event)
 {
-	int tail, added;
+	SDL_EventSegment *segment, *next;
+	SDL_EventSlot *slot;
+	int index, count, msg;
+	Uint32 peak;
+
+	msg = -1;
+	if ( event->type == SDL_SYSWMEVENT ) {
+		msg = SDL_ClaimWMMsg();
+		if ( msg < 0 ) {
+			/* Every message is still queued, drop event */
+			SDL_AtomicAdd(&SDL_EventQ.stats.dropped, 1);
+			return(0);
+		}
+	}
 
-	tail = (SDL_EventQ.tail+1)%MAXEVENTS;
-	if ( tail == SDL_EventQ.head ) {
-		/* Overflow, drop event */
-		added = 0;
-	} else {
-		SDL_EventQ.event[SDL_EventQ.tail] = *event;
-		if (event->type == SDL_SYSWMEVENT) {
-			/* Note that it's possible to lose an event */
-			int next = SDL_EventQ.wmmsg_next;
-			SDL_EventQ.wmmsg[next] = *event->syswm.msg;
-		        SDL_EventQ.event[SDL_EventQ.tail].syswm.msg =
-						&SDL_EventQ.wmmsg[next];
-			SDL_EventQ.wmmsg_next = (next+1)%MAXEVENTS;
-		}
-		SDL_EventQ.tail = tail;
-		added = 1;
-	}
-	return(added);
+	SDL_AtomicAdd(&SDL_EventQ.producers, 1);
+	for ( ; ; ) {
+		segment = SDL_EventQ.tail;
+		index = SEGMENT_EVENTS;
+		if ( segment->reserved < SEGMENT_EVENTS ) {
+			index = SDL_AtomicAdd(&segment->reserved, 1);
+		}
+		if ( index < SEGMENT_EVENTS ) {
+			break;
+		}
+
+		/* This segment is full, link in a new one unless another
+		   thread already has, and move the tail along */
+		next = segment->next;
+		if ( ! next ) {
+			if ( SDL_EventQ.count >= MAXEVENTS ) {
+				/* Overflow, drop event */
+				break;
+			}
+			next = SDL_NewSegment();
+			if ( ! next ) {
+				break;
+			}
+			if ( ! SDL_AtomicCASPtr(&segment->next, NULL, next) ) {
+				free(next);
+				next = segment->next;
+			}
+		}
+		SDL_AtomicCASPtr(&SDL_EventQ.tail, segment, next);
+	}
+	if ( index >= SEGMENT_EVENTS ) {
+		if ( msg >= 0 ) {
+			SDL_EventQ.wmmsg_used[msg] = 0;
+		}
+		SDL_AtomicAdd(&SDL_EventQ.stats.dropped, 1);
+		SDL_AtomicAdd(&SDL_EventQ.producers, -1);
+		return(0);
+	}
+
+	slot = &segment->slot[index];
+	slot->event = *event;
+	if ( msg >= 0 ) {
+		SDL_EventQ.wmmsg[msg] = *event->syswm.msg;
+		slot->event.syswm.msg = &SDL_EventQ.wmmsg[msg];
+	}
+	SDL_AtomicOr(&segment->types, SDL_EVENTMASK(event->type));
+	SDL_MemoryBarrier();
+	slot->state = SLOT_READY;
+	SDL_AtomicAdd(&segment->written, 1);
+
+	count = SDL_AtomicAdd(&SDL_EventQ.count, 1) + 1;
+	for ( ; ; ) {
+		peak = SDL_EventQ.stats.peak;
+		if ( (count <= (int)peak) ||
+		     SDL_AtomicCAS(&SDL_EventQ.stats.peak, peak, (Uint32)count) ) {
+			break;
+		}
+	}
+	SDL_AtomicAdd(&SDL_EventQ.stats.added, 1);
+	SDL_AtomicAdd(&SDL_EventQ.producers, -1);
+	return(1);
+}
+
+/* Release segments at the front of the queue that have been used up
+                                             -- called with the queue locked */
+static void SDL_TrimEvents(void)
+{
+	SDL_EventSegment *segment;
+
+	/* The tail may still point at a used up segment that has a next
+	   segment, but only while some thread is adding an event */
+	while ( (SDL_EventQ.head->taken == SEGMENT_EVENTS) &&
+	        SDL_EventQ.head->next ) {
+		segment = SDL_EventQ.head;
+		SDL_EventQ.head = segment->next;
+		segment->retired = SDL_EventQ.retired;
+		SDL_EventQ.retired = segment;
+	}
+
+	/* Retired segments can go once no thread is adding an event, since
+	   new ones only look at segments from the tail onwards */
+	SDL_MemoryBarrier();
+	if ( SDL_EventQ.retired && (SDL_EventQ.producers == 0) ) {
+		while ( SDL_EventQ.retired ) {
+			segment = SDL_EventQ.retired;
+			SDL_EventQ.retired = segment->retired;
+			if ( SDL_EventQ.spare ||
+			     !SDL_AtomicCASPtr(&SDL_EventQ.spare, NULL, segment) ) {
+				free(segment);
+			}
+		}
+	}
+}
+
+/* Copy events matching 'mask' out of the queue, marking them taken when
+   'action' is SDL_GETEVENT                 -- called with the queue locked */
+static int SDL_TakeEvents(SDL_Event *events, int numevents,
+                          SDL_eventaction action, Uint32 mask)
+{
+	SDL_EventSegment *segment;
+	SDL_EventSlot *slot;
+	int i, used, filled;
+
+	used = 0;
+	for ( segment = SDL_EventQ.head;
+	      segment && (used < numevents); segment = segment->next ) {
+		/* Skip finished segments without any interesting events */
+		if ( segment->written == SEGMENT_EVENTS ) {
+			SDL_MemoryBarrier();
+			if ( !(segment->types & mask) ||
+			     (segment->taken == SEGMENT_EVENTS) ) {
+				continue;
+			}
+		}
+		filled = segment->reserved;
+		if ( filled > SEGMENT_EVENTS ) {
+			filled = SEGMENT_EVENTS;
+		}
+		for ( i=segment->first; (i < filled) && (used < numevents); ++i ) {
+			slot = &segment->slot[i];
+			if ( slot->state == SLOT_EMPTY ) {
+				/* Still being added, and the thread adding it
+				   may have more events to follow it, so the
+				   queue ends here for now */
+				numevents = used;
+				break;
+			}
+			if ( slot->state == SLOT_TAKEN ) {
+				continue;
+			}
+			SDL_MemoryBarrier();
+			if ( mask & SDL_EVENTMASK(slot->event.type) ) {
+				events[used++] = slot->event;
+				if ( action == SDL_GETEVENT ) {
+					if ( slot->event.type == SDL_SYSWMEVENT ) {
+						SDL_EventQ.wmmsg_used[
+							slot->event.syswm.msg -
+							SDL_EventQ.wmmsg] = 0;
+					}
+					slot->state = SLOT_TAKEN;
+					++segment->taken;
+					SDL_AtomicAdd(&SDL_EventQ.count, -1);
+				}
+			}
+		}
+
+		/* Don't look at the front of the segment again */
+		while ( (segment->first < filled) &&
+		        (segment->slot[segment->first].state == SLOT_TAKEN) ) {
+			++segment->first;
+		}
+
+		/* Slots claimed in this segment since we looked come before
+		   any events in the next one, so the queue ends here for now */
+		if ( filled < SEGMENT_EVENTS ) {
+			break;
+		}
+	}
+	if ( action == SDL_GETEVENT ) {
+		SDL_TrimEvents();
+	}
+	return(used);
 }
 
-/* Cut an event, and return the next valid spot, or the tail */
-/*                           -- called with the queue locked */
-static int SDL_CutEvent(int spot)
+/* Wake up threads waiting in SDL_WaitEvent() after adding events */
+void SDL_WakeEventWaiters(void)
 {
-	if ( spot == SDL_EventQ.head ) {
-		SDL_EventQ.head = (SDL_EventQ.head+1)%MAXEVENTS;
-		return(SDL_EventQ.head);
-	} else
-	if ( (spot+1)%MAXEVENTS == SDL_EventQ.tail ) {
-		SDL_EventQ.tail = spot;
-		return(SDL_EventQ.tail);
-	} else
-	/* We cut the middle -- shift everything over */
-	{
-		int here, next;
-
-		/* This can probably be optimized with memcpy() -- careful! */
-		if ( --SDL_EventQ.tail < 0 ) {
-			SDL_EventQ.tail = MAXEVENTS-1;
-		}
-		for ( here=spot; here != SDL_EventQ.tail; here = next ) {
-			next = (here+1)%MAXEVENTS;
-			SDL_EventQ.event[here] = SDL_EventQ.event[next];
-		}
-		return(spot);
-	}
-	/* NOTREACHED */
+#ifdef SDL_HAVE_ATOMICS
+	/* Nobody is waiting, and anyone about to will see the new events */
+	if ( ! SDL_EventWait.waiting ) {
+		return;
+	}
+#endif
+#ifdef WAIT_FOR_FDS
+	if ( SDL_EventWait.have_pipe ) {
+		char c = 0;
+
+		/* If the pipe is full, the waiter will wake up anyway */
+		if ( write(SDL_EventWait.pipe[1], &c, 1) < 0 ) {
+			;
+		}
+	}
+#endif
+	if ( SDL_EventWait.lock && SDL_EventWait.cond ) {
+		SDL_mutexP(SDL_EventWait.lock);
+		SDL_CondBroadcast(SDL_EventWait.cond);
+		SDL_mutexV(SDL_EventWait.lock);
+	}
 }
 
-/* Lock the event queue, take a peep at it, and unlock it */
+/* Add events to the queue, or take a peep at it */
 int SDL_PeepEvents(SDL_Event *events, int numevents, SDL_eventaction action,
 								Uint32 mask)
 {
@@ -303,8 +621,21 @@ int SDL_PeepEvents(SDL_Event *events, int numevents, SDL_eventaction action,
 	if ( ! SDL_EventQ.active ) {
 		return(-1);
 	}
-	/* Lock the event queue */
 	used = 0;
+#ifdef SDL_HAVE_ATOMICS
+	/* Events can be added without the lock */
+	if ( action == SDL_ADDEVENT ) {
+		for ( i=0; i<numevents; ++i ) {
+			used += SDL_AddEvent(&events[i]);
+		}
+		if ( used > 0 ) {
+			SDL_WakeEventWaiters();
+		}
+		return(used);
+	}
+#endif
+
+	/* Lock the event queue */
 	if ( SDL_mutexP(SDL_EventQ.lock) == 0 ) {
 		if ( action == SDL_ADDEVENT ) {
 			for ( i=0; i<numevents; ++i ) {
@@ -312,7 +643,6 @@ int SDL_PeepEvents(SDL_Event *events, int numevents, SDL_eventaction action,
 			}
 		} else {
 			SDL_Event tmpevent;
-			int spot;
 
 			/* If 'events' is NULL, just see if they exist */
 			if ( events == NULL ) {
@@ -320,21 +650,12 @@ int SDL_PeepEvents(SDL_Event *events, int numevents, SDL_eventaction action,
 				numevents = 1;
 				events = &tmpevent;
 			}
-			spot = SDL_EventQ.head;
-			while ((used < numevents)&&(spot != SDL_EventQ.tail)) {
-				if ( mask & SDL_EVENTMASK(SDL_EventQ.event[spot].type) ) {
-					events[used++] = SDL_EventQ.event[spot];
-					if ( action == SDL_GETEVENT ) {
-						spot = SDL_CutEvent(spot);
-					} else {
-						spot = (spot+1)%MAXEVENTS;
-					}
-				} else {
-					spot = (spot+1)%MAXEVENTS;
-				}
-			}
+			used = SDL_TakeEvents(events, numevents, action, mask);
 		}
 		SDL_mutexV(SDL_EventQ.lock);
+		if ( (action == SDL_ADDEVENT) && (used > 0) ) {
+			SDL_WakeEventWaiters();
+		}
 	} else {
 		SDL_SetError("Couldn't lock event queue");
 		used = -1;
@@ -342,6 +663,19 @@ int SDL_PeepEvents(SDL_Event *events, int numevents, SDL_eventaction action,
 	return(used);
 }
 
+void SDL_GetEventQueueStats(SDL_EventQueueStats *stats, int reset)
+{
+	SDL_EventQ.stats.queued = SDL_EventQ.count;
+	if ( stats ) {
+		*stats = SDL_EventQ.stats;
+	}
+	if ( reset ) {
+		SDL_EventQ.stats.peak = SDL_EventQ.count;
+		SDL_EventQ.stats.added = 0;
+		SDL_EventQ.stats.dropped = 0;
+	}
+}
+
 /* Run the system dependent event loops */
 void SDL_PumpEvents(void)
 {
@@ -351,7 +685,9 @@ void SDL_PumpEvents(void)
 
 		/* Get events from the video subsystem */
 		if ( video ) {
+			SDL_LockPresent();
 			video->PumpEvents(this);
+			SDL_UnlockPresent();
 		}
 
 		/* Queue pending key-repeat events */
@@ -378,18 +714,154 @@ int SDL_PollEvent (SDL_Event *event)
 	return 1;
 }
 
-int SDL_WaitEvent (SDL_Event *event)
+#ifdef WAIT_FOR_FDS
+/* Sleep in select() until one of 'fds' or the wakeup pipe is readable */
+static void SDL_WaitForFDs(int *fds, int numfds, int timeout)
 {
+	fd_set fdset;
+	struct timeval tv;
+	int i, max_fd;
+	char buf[64];
+
+	FD_ZERO(&fdset);
+	max_fd = SDL_EventWait.pipe[0];
+	FD_SET(max_fd, &fdset);
+	for ( i=0; i<numfds; ++i ) {
+		FD_SET(fds[i], &fdset);
+		if ( max_fd < fds[i] ) {
+			max_fd = fds[i];
+		}
+	}
+	tv.tv_sec = timeout / 1000;
+	tv.tv_usec = (timeout % 1000) * 1000;
+
+	SDL_AtomicAdd(&SDL_EventWait.waiting, 1);
+	if ( SDL_PeepEvents(NULL, 0, SDL_PEEKEVENT, SDL_ALLEVENTS) == 0 ) {
+		select(max_fd+1, &fdset, NULL, NULL, (timeout < 0) ? NULL : &tv);
+	}
+	SDL_AtomicAdd(&SDL_EventWait.waiting, -1);
+
+	/* Empty the wakeup pipe */
+	while ( read(SDL_EventWait.pipe[0], buf, sizeof(buf)) > 0 ) {
+		;
+	}
+}
+#endif /* WAIT_FOR_FDS */
+
+/* Sleep for up to 'timeout' milliseconds, or forever if it's negative,
+   returning early when there may be new events */
+static void SDL_WaitForEvents(int timeout)
+{
+	SDL_VideoDevice *video = current_video;
+	SDL_VideoDevice *this  = current_video;
+	int fds[MAXWAITFDS];
+	int numfds, repeat;
+
+	/* Without the event thread, we do its work when we wake up */
+	numfds = 0;
+	if ( !SDL_EventThread ) {
+		repeat = SDL_KeyRepeatTimeout();
+		if ( (repeat >= 0) && ((timeout < 0) || (repeat < timeout)) ) {
+			timeout = repeat;
+		}
+		if ( video ) {
+			numfds = -1;
+			if ( video->GetEventFDs ) {
+				SDL_LockPresent();
+				numfds = video->GetEventFDs(this, fds, MAXWAITFDS);
+				SDL_UnlockPresent();
+			}
+			if ( numfds == SDL_EVENTFDS_READY ) {
+				return;
+			}
+		}
+#ifndef DISABLE_JOYSTICK
+		if ( (numfds >= 0) &&
+		     SDL_numjoysticks && (SDL_eventstate & SDL_JOYEVENTMASK) ) {
+			int n = SDL_JoystickGetFDs(&fds[numfds], MAXWAITFDS-numfds);
+			if ( n < 0 ) {
+				numfds = -1;
+			} else {
+				numfds += n;
+			}
+		}
+#endif
+	}
+#ifdef WAIT_FOR_FDS
+	if ( ! SDL_EventWait.have_pipe ) {
+		numfds = -1;
+	}
+#else
+	if ( numfds > 0 ) {
+		numfds = -1;
+	}
+#endif
+	if ( numfds < 0 ) {
+		/* Some events can only be polled for */
+		if ( (timeout < 0) || (timeout > POLL_INTERVAL) ) {
+			timeout = POLL_INTERVAL;
+		}
+	}
+	if ( timeout == 0 ) {
+		return;
+	}
+
+#ifdef WAIT_FOR_FDS
+	if ( numfds >= 0 ) {
+		SDL_WaitForFDs(fds, numfds, timeout);
+		return;
+	}
+#endif
+	if ( !SDL_EventWait.lock || !SDL_EventWait.cond ) {
+		if ( (timeout < 0) || (timeout > POLL_INTERVAL) ) {
+			timeout = POLL_INTERVAL;
+		}
+		SDL_Delay(timeout);
+		return;
+	}
+	SDL_mutexP(SDL_EventWait.lock);
+	SDL_AtomicAdd(&SDL_EventWait.waiting, 1);
+	if ( SDL_PeepEvents(NULL, 0, SDL_PEEKEVENT, SDL_ALLEVENTS) == 0 ) {
+		if ( timeout < 0 ) {
+			SDL_CondWait(SDL_EventWait.cond, SDL_EventWait.lock);
+		} else {
+			SDL_CondWaitTimeout(SDL_EventWait.cond,
+			                    SDL_EventWait.lock, timeout);
+		}
+	}
+	SDL_AtomicAdd(&SDL_EventWait.waiting, -1);
+	SDL_mutexV(SDL_EventWait.lock);
+}
+
+int SDL_WaitEventTimeout (SDL_Event *event, int timeout)
+{
+	Uint32 start, elapsed;
+	int wait;
+
+	start = SDL_GetTicks();
 	while ( 1 ) {
 		SDL_PumpEvents();
 		switch(SDL_PeepEvents(event, 1, SDL_GETEVENT, SDL_ALLEVENTS)) {
 		    case -1: return 0;
 		    case 1: return 1;
-		    case 0: SDL_Delay(10);
 		}
+		wait = -1;
+		if ( timeout >= 0 ) {
+			elapsed = SDL_GetTicks() - start;
+			if ( elapsed >= (Uint32)timeout ) {
+				return 0;
+			}
+			wait = timeout - (int)elapsed;
+		}
+		SDL_WaitForEvents(wait);
 	}
 }
 
+int SDL_WaitEvent (SDL_Event *event)
+{
+	return SDL_WaitEventTimeout(event, -1);
+}
+
 int SDL_PushEvent(SDL_Event *event)
 {
 	if ( SDL_PeepEvents(event, 1, SDL_ADDEVENT, 0) <= 0 )
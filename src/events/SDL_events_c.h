@@ -71,6 +71,14 @@ extern void SDL_ResetKeyboard(void);
 /* Used by the event loop to queue pending keyboard repeat events */
 extern void SDL_CheckKeyRepeat(void);
 
+/* Used by SDL_WaitEvent() to wake up for the next keyboard repeat event */
+extern int SDL_KeyRepeatTimeout(void);
+
+/* Used to wake up SDL_WaitEvent() when OS events may have been read into
+   a driver queue by another thread, where waiting for them can't see them
+ */
+extern void SDL_WakeEventWaiters(void);
+
 /* Used by the OS keyboard code to detect whether or not to do UNICODE */
 #ifndef DEFAULT_UNICODE_TRANSLATION
 #define DEFAULT_UNICODE_TRANSLATION 0	/* Default off because of overhead */
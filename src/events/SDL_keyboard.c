@@ -587,6 +587,27 @@ void SDL_CheckKeyRepeat(void)
 	}
 }
 
+/* Return how many milliseconds until SDL_CheckKeyRepeat() has work to do,
+   or -1 if no key is repeating */
+int SDL_KeyRepeatTimeout(void)
+{
+	Uint32 elapsed, wait;
+
+	if ( ! SDL_KeyRepeat.timestamp ) {
+		return(-1);
+	}
+	if ( SDL_KeyRepeat.firsttime ) {
+		wait = SDL_KeyRepeat.delay;
+	} else {
+		wait = SDL_KeyRepeat.interval;
+	}
+	elapsed = SDL_GetTicks() - SDL_KeyRepeat.timestamp;
+	if ( elapsed > wait ) {
+		return(0);
+	}
+	return((wait - elapsed) + 1);
+}
+
 int SDL_EnableKeyRepeat(int delay, int interval)
 {
 	if ( (delay < 0) || (interval < 0) ) {
@@ -550,6 +550,22 @@ void SDL_JoystickUpdate(void)
 	}
 }
 
+int SDL_JoystickGetFDs(int *fds, int maxfds)
+{
+	int i, n, numfds;
+
+	numfds = 0;
+	for ( i=0; SDL_joysticks[i]; ++i ) {
+		n = SDL_SYS_JoystickGetFDs(SDL_joysticks[i],
+		                           &fds[numfds], maxfds-numfds);
+		if ( n < 0 ) {
+			return(-1);
+		}
+		numfds += n;
+	}
+	return(numfds);
+}
+
 int SDL_JoystickEventState(int state)
 {
 #ifdef DISABLE_EVENTS
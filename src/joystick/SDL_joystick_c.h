@@ -40,3 +40,7 @@ extern int SDL_PrivateJoystickHat(SDL_Joystick *joystick,
                                  Uint8 hat, Uint8 value);
 extern int SDL_PrivateJoystickButton(SDL_Joystick *joystick,
                                      Uint8 button, Uint8 state);
+
+/* Get the file descriptors to wait on for events from the open joysticks,
+   returning how many were stored, or -1 if the joysticks must be polled */
+extern int SDL_JoystickGetFDs(int *fds, int maxfds);
@@ -78,6 +78,13 @@ extern int SDL_SYS_JoystickOpen(SDL_Joystick *joystick);
  */
 extern void SDL_SYS_JoystickUpdate(SDL_Joystick *joystick);
 
+/* Function to get the file descriptors that become readable when the
+ * joystick has new events, so the event loop can sleep until then.
+ * It returns how many were stored in 'fds', or -1 if the joystick has
+ * to be polled.
+ */
+extern int SDL_SYS_JoystickGetFDs(SDL_Joystick *joystick, int *fds, int maxfds);
+
 /* Function to close a joystick after use */
 extern void SDL_SYS_JoystickClose(SDL_Joystick *joystick);
 
@@ -414,6 +414,21 @@ SDL_SYS_JoystickUpdate(SDL_Joystick *joy)
 	return;
 }
 
+/* Function to get the file descriptors that become readable when the
+ * joystick has new events, returning how many were stored, or -1 if the
+ * joystick has to be polled.
+ */
+int
+SDL_SYS_JoystickGetFDs(SDL_Joystick *joy, int *fds, int maxfds)
+{
+	/* joy(4) devices always have a position to read */
+	if ((joy->hwdata->type != BSDJOY_UHID) || (maxfds < 1)) {
+		return (-1);
+	}
+	fds[0] = joy->hwdata->fd;
+	return (1);
+}
+
 /* Function to close a joystick after use */
 void
 SDL_SYS_JoystickClose(SDL_Joystick *joy)
@@ -187,6 +187,15 @@ const	int sdl_buttons[] = {
 	joystick->hwdata->prev_cond = cond;
 }
 
+/* Function to get the file descriptors that become readable when the
+ * joystick has new events, returning how many were stored, or -1 if the
+ * joystick has to be polled.
+ */
+int SDL_SYS_JoystickGetFDs(SDL_Joystick *joystick, int *fds, int maxfds)
+{
+	return(-1);
+}
+
 /* Function to close a joystick after use */
 void SDL_SYS_JoystickClose(SDL_Joystick *joystick)
 {
@@ -707,6 +707,19 @@ void SDL_SYS_JoystickUpdate(SDL_Joystick *joystick)
 	}
 }
 
+/* Function to get the file descriptors that become readable when the
+ * joystick has new events, returning how many were stored, or -1 if the
+ * joystick has to be polled.
+ */
+int SDL_SYS_JoystickGetFDs(SDL_Joystick *joystick, int *fds, int maxfds)
+{
+	if ( maxfds < 1 ) {
+		return(-1);
+	}
+	fds[0] = joystick->hwdata->fd;
+	return(1);
+}
+
 /* Function to close a joystick after use */
 void SDL_SYS_JoystickClose(SDL_Joystick *joystick)
 {
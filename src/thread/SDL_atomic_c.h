@@ -0,0 +1,73 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997, 1998, 1999, 2000, 2001, 2002  Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the Free
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+
+#ifdef SAVE_RCSID
+static char rcsid =
+ "@(#) $Id$";
+#endif
+
+#ifndef _SDL_atomic_c_h
+#define _SDL_atomic_c_h
+
+/* Atomic operations for the lock-free structures inside SDL.
+
+   SDL_HAVE_ATOMICS is defined when the compiler provides them.  The
+   read-modify-write operations act as full memory barriers.
+   SDL_AtomicAdd() returns the old value, SDL_AtomicOr() returns nothing,
+   and SDL_AtomicCAS() and SDL_AtomicCASPtr() return whether the swap was
+   made.  Without SDL_HAVE_ATOMICS the same macros are plain C, and code
+   using them must serialize with a mutex.
+*/
+
+#if defined(__GNUC__) && \
+    ((__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 1)))
+#define SDL_HAVE_ATOMICS
+#define SDL_AtomicAdd(p, v)	__sync_fetch_and_add((p), (v))
+#define SDL_AtomicOr(p, v)	((void)__sync_fetch_and_or((p), (v)))
+#define SDL_AtomicCAS(p, o, n)	__sync_bool_compare_and_swap((p), (o), (n))
+#define SDL_AtomicCASPtr(p, o, n)	\
+	__sync_bool_compare_and_swap((p), (o), (n))
+#define SDL_MemoryBarrier()	__sync_synchronize()
+#elif defined(_MSC_VER) && (_MSC_VER >= 1400) && \
+      (defined(_M_IX86) || defined(_M_X64))
+#include <intrin.h>
+#define SDL_HAVE_ATOMICS
+#define SDL_AtomicAdd(p, v)	\
+	_InterlockedExchangeAdd((long volatile *)(p), (long)(v))
+#define SDL_AtomicOr(p, v)	\
+	((void)_InterlockedOr((long volatile *)(p), (long)(v)))
+#define SDL_AtomicCAS(p, o, n)	\
+	(_InterlockedCompareExchange((long volatile *)(p), \
+	                             (long)(n), (long)(o)) == (long)(o))
+#define SDL_AtomicCASPtr(p, o, n)	\
+	(_InterlockedCompareExchangePointer((void * volatile *)(p), \
+	                             (void *)(n), (void *)(o)) == (void *)(o))
+#define SDL_MemoryBarrier()	_mm_mfence()
+#else
+#define SDL_AtomicAdd(p, v)	((*(p) += (v)) - (v))
+#define SDL_AtomicOr(p, v)	((void)(*(p) |= (v)))
+#define SDL_AtomicCAS(p, o, n)	((*(p) == (o)) ? ((*(p) = (n)), 1) : 0)
+#define SDL_AtomicCASPtr(p, o, n)	SDL_AtomicCAS(p, o, n)
+#define SDL_MemoryBarrier()
+#endif
+
+#endif /* _SDL_atomic_c_h */
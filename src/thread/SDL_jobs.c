@@ -0,0 +1,652 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997, 1998, 1999, 2000, 2001, 2002  Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the Free
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+
+#ifdef SAVE_RCSID
+static char rcsid =
+ "@(#) $Id$";
+#endif
+
+/* The SDL job system
+
+   Each worker thread has its own queue of ready jobs.  A worker pushes
+   the jobs it makes ready onto the end of its own queue and takes them
+   back from there, while idle workers and waiting threads steal the
+   oldest jobs from the front of the other queues.  The queues are locked
+   separately, so workers only meet on the same lock when stealing.
+
+   Idle threads sleep on one condition variable.  Making a job ready only
+   touches the lock of the condition when somebody is asleep: the sleeper
+   counts itself before looking at the pending jobs, and the job is
+   counted before looking at the sleepers, so one of them sees the other.
+
+   Jobs waiting for a counter are kept in a list on the counter, and the
+   count only drops to zero under the job lock, which hands the list over
+   and lets a waiting thread know the counter isn't in use any more.
+*/
+
+#include <stdlib.h>
+
+#include "SDL_error.h"
+#include "SDL_mutex.h"
+#include "SDL_thread.h"
+#include "SDL_cpuinfo.h"
+#include "SDL_atomic_c.h"
+
+#define MAX_JOB_THREADS		64
+#define JOB_QUEUE_SIZE		64	/* Must be a power of two */
+#define JOB_RANGES_PER_THREAD	4
+
+typedef struct SDL_Job {
+	SDL_JobFunction func;
+	void *data;
+	SDL_JobCounter *done;
+	struct SDL_Job *next;
+} SDL_Job;
+
+struct SDL_JobCounter {
+	volatile int value;
+	SDL_Job *waiting;
+};
+
+typedef struct {
+	SDL_mutex *lock;
+	SDL_Job **jobs;
+	int size;
+	int head;
+	int tail;
+	SDL_Thread *thread;
+} SDL_JobQueue;
+
+static struct {
+	int started;
+	int threads;
+	SDL_JobQueue *queues;
+	SDL_mutex *lock;
+	SDL_cond *wake;
+	volatile int pending;
+	volatile int sleepers;
+	volatile int watchers;	/* Sleepers that don't take jobs */
+	volatile int quit;
+	volatile int next_queue;
+	SDL_TLSID worker;
+} SDL_JobPool;
+
+static SDL_mutex *SDL_job_start_lock = NULL;
+
+static void SDL_LockJobs(void)
+{
+	if ( SDL_JobPool.lock ) {
+		SDL_mutexP(SDL_JobPool.lock);
+	}
+}
+
+static void SDL_UnlockJobs(void)
+{
+	if ( SDL_JobPool.lock ) {
+		SDL_mutexV(SDL_JobPool.lock);
+	}
+}
+
+#ifdef SDL_HAVE_ATOMICS
+#define SDL_JobAdd(p, v)	SDL_AtomicAdd(p, v)
+#else
+static int SDL_JobAdd(volatile int *p, int v)
+{
+	int old;
+
+	SDL_LockJobs();
+	old = *p;
+	*p += v;
+	SDL_UnlockJobs();
+	return(old);
+}
+#endif
+
+/* Add a job to the end of a queue, growing it if needed */
+static int SDL_PushJob(SDL_JobQueue *queue, SDL_Job *job)
+{
+	SDL_Job **jobs;
+	int i, size;
+
+	SDL_mutexP(queue->lock);
+	if ( (queue->tail - queue->head) == queue->size ) {
+		size = queue->size ? (queue->size * 2) : JOB_QUEUE_SIZE;
+		jobs = (SDL_Job **)malloc(size * sizeof(*jobs));
+		if ( jobs == NULL ) {
+			SDL_mutexV(queue->lock);
+			return(-1);
+		}
+		for ( i=queue->head; i!=queue->tail; ++i ) {
+			jobs[i & (size-1)] = queue->jobs[i & (queue->size-1)];
+		}
+		free(queue->jobs);
+		queue->jobs = jobs;
+		queue->size = size;
+	}
+	queue->jobs[queue->tail & (queue->size-1)] = job;
+	++queue->tail;
+	SDL_mutexV(queue->lock);
+	return(0);
+}
+
+/* Take the newest job of our own queue, or the oldest one of another */
+static SDL_Job *SDL_TakeJob(SDL_JobQueue *queue, int own)
+{
+	SDL_Job *job;
+
+	job = NULL;
+	SDL_mutexP(queue->lock);
+	if ( queue->tail != queue->head ) {
+		if ( own ) {
+			--queue->tail;
+			job = queue->jobs[queue->tail & (queue->size-1)];
+		} else {
+			job = queue->jobs[queue->head & (queue->size-1)];
+			++queue->head;
+		}
+	}
+	SDL_mutexV(queue->lock);
+	return(job);
+}
+
+static SDL_Job *SDL_GetJob(SDL_JobQueue *self)
+{
+	SDL_Job *job;
+	int i, first;
+
+	if ( SDL_JobPool.pending == 0 ) {
+		return(NULL);
+	}
+	job = NULL;
+	first = 0;
+	if ( self ) {
+		job = SDL_TakeJob(self, 1);
+		first = (int)(self - SDL_JobPool.queues) + 1;
+	}
+	for ( i=0; !job && (i<SDL_JobPool.threads); ++i ) {
+		SDL_JobQueue *queue;
+
+		queue = &SDL_JobPool.queues[(first+i) % SDL_JobPool.threads];
+		if ( queue != self ) {
+			job = SDL_TakeJob(queue, 0);
+		}
+	}
+	if ( job ) {
+		SDL_JobAdd(&SDL_JobPool.pending, -1);
+	}
+	return(job);
+}
+
+static void SDL_DoJob(SDL_Job *job);
+
+/* Hand a job that is ready to run to the workers */
+static void SDL_QueueJob(SDL_Job *job)
+{
+	SDL_JobQueue *queue;
+	unsigned int next;
+
+	if ( SDL_JobPool.threads == 0 ) {
+		SDL_DoJob(job);
+		return;
+	}
+	queue = (SDL_JobQueue *)SDL_TLSGet(SDL_JobPool.worker);
+	if ( queue == NULL ) {
+		next = (unsigned int)SDL_JobAdd(&SDL_JobPool.next_queue, 1);
+		queue = &SDL_JobPool.queues[next % SDL_JobPool.threads];
+	}
+	if ( SDL_PushJob(queue, job) < 0 ) {
+		SDL_DoJob(job);
+		return;
+	}
+	SDL_JobAdd(&SDL_JobPool.pending, 1);
+	if ( SDL_JobPool.sleepers > 0 ) {
+		/* A single wakeup might go to a thread that won't take it */
+		SDL_LockJobs();
+		if ( SDL_JobPool.watchers > 0 ) {
+			SDL_CondBroadcast(SDL_JobPool.wake);
+		} else {
+			SDL_CondSignal(SDL_JobPool.wake);
+		}
+		SDL_UnlockJobs();
+	}
+}
+
+/* Count a job of a counter as finished */
+static void SDL_FinishJob(SDL_JobCounter *counter)
+{
+	SDL_Job *waiting, *next;
+#ifdef SDL_HAVE_ATOMICS
+	int value;
+
+	/* Counting down to anything but zero needs no lock */
+	for ( ; ; ) {
+		value = counter->value;
+		if ( value <= 1 ) {
+			break;
+		}
+		if ( SDL_AtomicCAS(&counter->value, value, value-1) ) {
+			return;
+		}
+	}
+#endif
+	waiting = NULL;
+	SDL_LockJobs();
+	if ( SDL_JobAdd(&counter->value, -1) == 1 ) {
+		waiting = counter->waiting;
+		counter->waiting = NULL;
+		if ( SDL_JobPool.sleepers > 0 ) {
+			SDL_CondBroadcast(SDL_JobPool.wake);
+		}
+	}
+	SDL_UnlockJobs();
+
+	while ( waiting ) {
+		next = waiting->next;
+		SDL_QueueJob(waiting);
+		waiting = next;
+	}
+}
+
+static void SDL_DoJob(SDL_Job *job)
+{
+	SDL_JobCounter *done;
+
+	job->func(job->data);
+	done = job->done;
+	free(job);
+	if ( done ) {
+		SDL_FinishJob(done);
+	}
+}
+
+/* Sleep until there are jobs to take, if 'steal' is set, or until the
+   counter reaches zero.  Without a counter, this returns 0 when the pool
+   is being shut down and there is nothing left to do.
+ */
+static int SDL_SleepForJobs(SDL_JobCounter *counter, int steal)
+{
+	int awake;
+
+	SDL_LockJobs();
+	SDL_JobAdd(&SDL_JobPool.sleepers, 1);
+	if ( ! steal ) {
+		++SDL_JobPool.watchers;
+	}
+	for ( ; ; ) {
+		if ( steal && (SDL_JobPool.pending > 0) ) {
+			awake = 1;
+			break;
+		}
+		if ( counter ) {
+			if ( counter->value == 0 ) {
+				awake = 1;
+				break;
+			}
+		} else if ( SDL_JobPool.quit ) {
+			awake = 0;
+			break;
+		}
+		SDL_CondWait(SDL_JobPool.wake, SDL_JobPool.lock);
+	}
+	if ( ! steal ) {
+		--SDL_JobPool.watchers;
+	}
+	SDL_JobAdd(&SDL_JobPool.sleepers, -1);
+	SDL_UnlockJobs();
+	return(awake);
+}
+
+static int SDL_RunJobWorker(void *data)
+{
+	SDL_JobQueue *self = (SDL_JobQueue *)data;
+	SDL_Job *job;
+
+	SDL_TLSSet(SDL_JobPool.worker, self, NULL);
+	for ( ; ; ) {
+		job = SDL_GetJob(self);
+		if ( job ) {
+			SDL_DoJob(job);
+		} else if ( ! SDL_SleepForJobs(NULL, 1) ) {
+			break;
+		}
+	}
+	return(0);
+}
+
+static int SDL_JobThreadCount(void)
+{
+	int threads;
+#ifndef DISABLE_THREADS
+	const char *variable;
+
+	variable = getenv("SDL_JOB_THREADS");
+	if ( variable ) {
+		threads = atoi(variable);
+	} else {
+		threads = SDL_GetCPUCount() - 1;
+	}
+	if ( threads > MAX_JOB_THREADS ) {
+		threads = MAX_JOB_THREADS;
+	}
+	if ( threads < 0 ) {
+		threads = 0;
+	}
+#else
+	threads = 0;
+#endif
+	return(threads);
+}
+
+static void SDL_StartJobs(void)
+{
+	SDL_mutex *lock;
+	int i, threads;
+
+	if ( SDL_JobPool.started ) {
+		/* Make sure we see the pool as the starting thread left it */
+		SDL_MemoryBarrier();
+		return;
+	}
+
+	/* The lock for starting the pool is made by the first one to need it */
+	lock = SDL_job_start_lock;
+	if ( lock == NULL ) {
+		lock = SDL_CreateMutex();
+		if ( lock && !SDL_AtomicCASPtr(&SDL_job_start_lock, NULL, lock) ) {
+			SDL_DestroyMutex(lock);
+			lock = SDL_job_start_lock;
+		}
+	}
+	if ( lock ) {
+		SDL_mutexP(lock);
+	}
+	if ( ! SDL_JobPool.started ) {
+		/* Counters need the lock even when jobs run where they're made */
+		threads = SDL_JobThreadCount();
+#ifndef DISABLE_THREADS
+		SDL_JobPool.lock = SDL_CreateMutex();
+		SDL_JobPool.wake = SDL_CreateCond();
+#endif
+		if ( threads > 0 ) {
+			SDL_JobPool.queues = (SDL_JobQueue *)
+				calloc(threads, sizeof(*SDL_JobPool.queues));
+			if ( SDL_JobPool.worker == 0 ) {
+				SDL_JobPool.worker = SDL_TLSCreate();
+			}
+			if ( !SDL_JobPool.lock || !SDL_JobPool.wake ||
+			     !SDL_JobPool.queues || !SDL_JobPool.worker ) {
+				threads = 0;
+			}
+		}
+		for ( i=0; i<threads; ++i ) {
+			SDL_JobQueue *queue = &SDL_JobPool.queues[i];
+
+			queue->lock = SDL_CreateMutex();
+			if ( queue->lock == NULL ) {
+				break;
+			}
+			queue->thread = SDL_CreateThread(SDL_RunJobWorker, queue);
+			if ( queue->thread == NULL ) {
+				SDL_DestroyMutex(queue->lock);
+				queue->lock = NULL;
+				break;
+			}
+			/* No jobs are queued yet, so the workers are idle */
+			++SDL_JobPool.threads;
+		}
+		SDL_MemoryBarrier();
+		SDL_JobPool.started = 1;
+	}
+	if ( lock ) {
+		SDL_mutexV(lock);
+	}
+}
+
+void SDL_QuitJobs(void)
+{
+	int i;
+
+	if ( SDL_job_start_lock == NULL ) {
+		return;
+	}
+	SDL_mutexP(SDL_job_start_lock);
+	if ( SDL_JobPool.started ) {
+		/* The workers finish the queued jobs before they quit */
+		SDL_LockJobs();
+		SDL_JobPool.quit = 1;
+		if ( SDL_JobPool.wake ) {
+			SDL_CondBroadcast(SDL_JobPool.wake);
+		}
+		SDL_UnlockJobs();
+		for ( i=0; i<SDL_JobPool.threads; ++i ) {
+			SDL_WaitThread(SDL_JobPool.queues[i].thread, NULL);
+		}
+		for ( i=0; i<SDL_JobPool.threads; ++i ) {
+			SDL_DestroyMutex(SDL_JobPool.queues[i].lock);
+			free(SDL_JobPool.queues[i].jobs);
+		}
+		if ( SDL_JobPool.queues ) {
+			free(SDL_JobPool.queues);
+			SDL_JobPool.queues = NULL;
+		}
+		if ( SDL_JobPool.wake ) {
+			SDL_DestroyCond(SDL_JobPool.wake);
+			SDL_JobPool.wake = NULL;
+		}
+		if ( SDL_JobPool.lock ) {
+			SDL_DestroyMutex(SDL_JobPool.lock);
+			SDL_JobPool.lock = NULL;
+		}
+		SDL_JobPool.threads = 0;
+		SDL_JobPool.pending = 0;
+		SDL_JobPool.quit = 0;
+		SDL_JobPool.started = 0;
+	}
+	SDL_mutexV(SDL_job_start_lock);
+	SDL_DestroyMutex(SDL_job_start_lock);
+	SDL_job_start_lock = NULL;
+}
+
+SDL_JobCounter *SDL_CreateJobCounter(void)
+{
+	SDL_JobCounter *counter;
+
+	counter = (SDL_JobCounter *)malloc(sizeof(*counter));
+	if ( counter == NULL ) {
+		SDL_OutOfMemory();
+		return(NULL);
+	}
+	counter->value = 0;
+	counter->waiting = NULL;
+	return(counter);
+}
+
+void SDL_FreeJobCounter(SDL_JobCounter *counter)
+{
+	if ( counter ) {
+		SDL_WaitJobCounter(counter);
+		free(counter);
+	}
+}
+
+int SDL_RunJob(SDL_JobFunction func, void *data,
+               SDL_JobCounter *done, SDL_JobCounter *after)
+{
+	SDL_Job *job;
+
+	SDL_StartJobs();
+	job = (SDL_Job *)malloc(sizeof(*job));
+	if ( job == NULL ) {
+		SDL_OutOfMemory();
+		return(-1);
+	}
+	job->func = func;
+	job->data = data;
+	job->done = done;
+	job->next = NULL;
+	if ( done ) {
+		SDL_JobAdd(&done->value, 1);
+	}
+	if ( after ) {
+		SDL_LockJobs();
+		if ( after->value > 0 ) {
+			job->next = after->waiting;
+			after->waiting = job;
+			job = NULL;
+		}
+		SDL_UnlockJobs();
+	}
+	if ( job ) {
+		SDL_QueueJob(job);
+	}
+	return(0);
+}
+
+void SDL_WaitJobCounter(SDL_JobCounter *counter)
+{
+	SDL_JobQueue *self;
+	SDL_Job *job;
+
+	SDL_StartJobs();
+	self = (SDL_JobQueue *)SDL_TLSGet(SDL_JobPool.worker);
+	while ( counter->value > 0 ) {
+		job = SDL_GetJob(self);
+		if ( job ) {
+			SDL_DoJob(job);
+		} else {
+			SDL_SleepForJobs(counter, 1);
+		}
+	}
+
+	/* Wait for the thread that counted down to zero to let go of it */
+	SDL_LockJobs();
+	SDL_UnlockJobs();
+}
+
+/* The loop counts its ranges rather than its helper jobs, so the caller
+   can return as soon as the last range is done, even if some helpers
+   haven't started yet.  The last one to let go of the loop frees it.
+ */
+typedef struct {
+	SDL_ParallelFunction func;
+	void *data;
+	int count;
+	int grain;
+	volatile int next;
+	volatile int refs;
+	SDL_JobCounter done;
+} SDL_ParallelLoop;
+
+static void SDL_ReleaseParallelLoop(SDL_ParallelLoop *loop)
+{
+	if ( SDL_JobAdd(&loop->refs, -1) == 1 ) {
+		free(loop);
+	}
+}
+
+static void SDL_RunParallelRanges(SDL_ParallelLoop *loop)
+{
+	int first, last;
+
+	for ( ; ; ) {
+		first = SDL_JobAdd(&loop->next, loop->grain);
+		if ( first >= loop->count ) {
+			break;
+		}
+		last = first + loop->grain;
+		if ( last > loop->count ) {
+			last = loop->count;
+		}
+		loop->func(loop->data, first, last);
+		SDL_FinishJob(&loop->done);
+	}
+}
+
+static void SDLCALL SDL_RunParallelLoop(void *data)
+{
+	SDL_ParallelLoop *loop = (SDL_ParallelLoop *)data;
+
+	SDL_RunParallelRanges(loop);
+	SDL_ReleaseParallelLoop(loop);
+}
+
+void SDL_ParallelFor(int count, int grain, SDL_ParallelFunction func,
+                     void *data)
+{
+	SDL_ParallelLoop *loop;
+	int i, helpers, ranges;
+
+	if ( count <= 0 ) {
+		return;
+	}
+	SDL_StartJobs();
+	if ( grain <= 0 ) {
+		ranges = (SDL_JobPool.threads + 1) * JOB_RANGES_PER_THREAD;
+		grain = (count + ranges - 1) / ranges;
+	}
+	ranges = (count - 1) / grain + 1;
+	helpers = SDL_JobPool.threads;
+	if ( helpers > ranges-1 ) {
+		helpers = ranges-1;
+	}
+	loop = NULL;
+	if ( helpers > 0 ) {
+		loop = (SDL_ParallelLoop *)malloc(sizeof(*loop));
+	}
+	if ( loop == NULL ) {
+		for ( i=0; i<count; i+=grain ) {
+			func(data, i, (count-i > grain) ? i+grain : count);
+		}
+		return;
+	}
+	loop->func = func;
+	loop->data = data;
+	loop->count = count;
+	loop->grain = grain;
+	loop->next = 0;
+	loop->refs = 1 + helpers;
+	loop->done.value = ranges;
+	loop->done.waiting = NULL;
+
+	/* Ranges are handed out as the threads get to them, so one thread
+	   running late doesn't hold up the others */
+	for ( i=0; i<helpers; ++i ) {
+		if ( SDL_RunJob(SDL_RunParallelLoop, loop, NULL, NULL) < 0 ) {
+			SDL_JobAdd(&loop->refs, i-helpers);
+			break;
+		}
+	}
+	SDL_RunParallelRanges(loop);
+
+	/* Sleep until the helpers finish their last ranges, rather than
+	   running unrelated jobs while the caller may be holding locks */
+	while ( loop->done.value > 0 ) {
+		SDL_SleepForJobs(&loop->done, 0);
+	}
+	SDL_ReleaseParallelLoop(loop);
+}
+
+int SDL_GetJobThreads(void)
+{
+	SDL_StartJobs();
+	return(SDL_JobPool.threads);
+}
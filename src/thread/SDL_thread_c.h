@@ -36,10 +36,28 @@ struct SDL_Thread {
 	Uint32 threadid;
 	SYS_ThreadHandle handle;
 	int status;
-	SDL_error errbuf;
 	void *data;
 };
 
+/* This is the thread local storage of a thread, indexed by TLS ID - 1 */
+typedef struct {
+	unsigned int limit;
+	struct {
+		void *data;
+		void (SDLCALL *destructor)(void *);
+	} array[1];
+} SDL_TLSData;
+
+/* Run the destructors and free the storage of the current thread */
+extern void SDL_TLSCleanup(void);
+
+/* Run the destructors and free thread local storage */
+extern void SDL_TLSDestroy(SDL_TLSData *storage);
+
+/* Thread local storage for ports without it, searched under a lock */
+extern SDL_TLSData *SDL_Generic_GetTLSData(void);
+extern int SDL_Generic_SetTLSData(SDL_TLSData *storage);
+
 /* This is the function called to run a thread */
 extern void SDL_RunThread(void *data);
 
@@ -0,0 +1,296 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997, 1998, 1999, 2000, 2001, 2002  Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the Free
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+
+#ifdef SAVE_RCSID
+static char rcsid =
+ "@(#) $Id$";
+#endif
+
+/* Thread local storage for SDL
+
+   Each thread has an array of values indexed by TLS ID, reached through
+   SDL_SYS_GetTLSData() in constant time on platforms with native thread
+   local storage.  IDs are never reused, so creating one needs no lock.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "SDL_error.h"
+#include "SDL_mutex.h"
+#include "SDL_thread.h"
+#include "SDL_thread_c.h"
+#include "SDL_systhread.h"
+#include "SDL_atomic_c.h"
+
+#define TLS_ALLOC_CHUNKSIZE	4
+
+static SDL_TLSID SDL_tls_id = 0;
+
+SDL_TLSID SDL_TLSCreate(void)
+{
+	return(SDL_AtomicAdd(&SDL_tls_id, 1) + 1);
+}
+
+void *SDL_TLSGet(SDL_TLSID id)
+{
+	SDL_TLSData *storage;
+
+	storage = SDL_SYS_GetTLSData();
+	if ( !storage || (id == 0) || (id > storage->limit) ) {
+		return(NULL);
+	}
+	return(storage->array[id-1].data);
+}
+
+/* Set a value without touching the error buffer, which lives here too */
+static int SDL_TLSSetValue(SDL_TLSID id, const void *value,
+                           void (SDLCALL *destructor)(void *))
+{
+	SDL_TLSData *storage, *newstorage;
+	unsigned int i, oldlimit, newlimit;
+
+	storage = SDL_SYS_GetTLSData();
+	if ( !storage || (id > storage->limit) ) {
+		oldlimit = storage ? storage->limit : 0;
+		newlimit = (id + TLS_ALLOC_CHUNKSIZE);
+		newstorage = (SDL_TLSData *)malloc(
+		       sizeof(*storage)+(newlimit-1)*sizeof(storage->array[0]));
+		if ( newstorage == NULL ) {
+			return(-1);
+		}
+		if ( storage ) {
+			memcpy(newstorage->array, storage->array,
+			       oldlimit*sizeof(storage->array[0]));
+		}
+		newstorage->limit = newlimit;
+		for ( i=oldlimit; i<newlimit; ++i ) {
+			newstorage->array[i].data = NULL;
+			newstorage->array[i].destructor = NULL;
+		}
+		/* The old storage stays in place until the new one is set */
+		if ( SDL_SYS_SetTLSData(newstorage) < 0 ) {
+			free(newstorage);
+			return(-1);
+		}
+		if ( storage ) {
+			free(storage);
+		}
+		storage = newstorage;
+	}
+	storage->array[id-1].data = (void *)value;
+	storage->array[id-1].destructor = destructor;
+	return(0);
+}
+
+int SDL_TLSSet(SDL_TLSID id, const void *value,
+               void (SDLCALL *destructor)(void *))
+{
+	if ( id == 0 ) {
+		SDL_SetError("Invalid TLS ID");
+		return(-1);
+	}
+	if ( SDL_TLSSetValue(id, value, destructor) < 0 ) {
+		SDL_OutOfMemory();
+		return(-1);
+	}
+	return(0);
+}
+
+/* Run the destructors for this thread's values and free its storage */
+void SDL_TLSCleanup(void)
+{
+	SDL_TLSData *storage;
+
+	storage = SDL_SYS_GetTLSData();
+	if ( storage ) {
+		SDL_SYS_SetTLSData(NULL);
+		SDL_TLSDestroy(storage);
+	}
+}
+
+void SDL_TLSDestroy(SDL_TLSData *storage)
+{
+	unsigned int i;
+
+	for ( i=0; i<storage->limit; ++i ) {
+		if ( storage->array[i].destructor ) {
+			storage->array[i].destructor(storage->array[i].data);
+		}
+	}
+	free(storage);
+}
+
+
+/* This is the generic implementation of thread local storage, for ports
+   without it.  It is a list of the threads that have storage, searched
+   under a lock, so only the ports themselves should use it.
+ */
+typedef struct SDL_TLSEntry {
+	Uint32 thread;
+	SDL_TLSData *storage;
+	struct SDL_TLSEntry *next;
+} SDL_TLSEntry;
+
+static SDL_mutex *SDL_generic_tls_mutex = NULL;
+static SDL_TLSEntry *SDL_generic_tls = NULL;
+
+static int SDL_LockGenericTLS(void)
+{
+#ifndef DISABLE_THREADS
+	static int creating = 0;
+	SDL_mutex *mutex;
+
+	if ( ! SDL_generic_tls_mutex ) {
+		/* Failing to create the mutex sets an error, which comes back
+		   here for the error buffer, so don't try again meanwhile.
+		 */
+		if ( creating ) {
+			return(-1);
+		}
+		creating = 1;
+		mutex = SDL_CreateMutex();
+		creating = 0;
+		if ( ! mutex ) {
+			return(-1);
+		}
+		if ( ! SDL_AtomicCASPtr(&SDL_generic_tls_mutex, NULL, mutex) ) {
+			/* Another thread made one first */
+			SDL_DestroyMutex(mutex);
+		}
+	}
+	SDL_mutexP(SDL_generic_tls_mutex);
+#endif
+	return(0);
+}
+
+static void SDL_UnlockGenericTLS(void)
+{
+#ifndef DISABLE_THREADS
+	SDL_mutexV(SDL_generic_tls_mutex);
+#endif
+}
+
+SDL_TLSData *SDL_Generic_GetTLSData(void)
+{
+	Uint32 thread = SDL_ThreadID();
+	SDL_TLSEntry *entry;
+	SDL_TLSData *storage = NULL;
+
+	if ( SDL_LockGenericTLS() < 0 ) {
+		return(NULL);
+	}
+	for ( entry = SDL_generic_tls; entry; entry = entry->next ) {
+		if ( entry->thread == thread ) {
+			storage = entry->storage;
+			break;
+		}
+	}
+	SDL_UnlockGenericTLS();
+	return(storage);
+}
+
+int SDL_Generic_SetTLSData(SDL_TLSData *storage)
+{
+	Uint32 thread = SDL_ThreadID();
+	SDL_TLSEntry *prev, *entry;
+
+	if ( SDL_LockGenericTLS() < 0 ) {
+		return(-1);
+	}
+	for ( prev = NULL, entry = SDL_generic_tls; entry;
+	      prev = entry, entry = entry->next ) {
+		if ( entry->thread == thread ) {
+			break;
+		}
+	}
+	if ( entry ) {
+		if ( storage ) {
+			entry->storage = storage;
+		} else {
+			if ( prev ) {
+				prev->next = entry->next;
+			} else {
+				SDL_generic_tls = entry->next;
+			}
+			free(entry);
+		}
+	} else if ( storage ) {
+		entry = (SDL_TLSEntry *)malloc(sizeof(*entry));
+		if ( entry == NULL ) {
+			SDL_UnlockGenericTLS();
+			return(-1);
+		}
+		entry->thread = thread;
+		entry->storage = storage;
+		entry->next = SDL_generic_tls;
+		SDL_generic_tls = entry;
+	}
+	SDL_UnlockGenericTLS();
+	return(0);
+}
+
+
+/* The error buffer of each thread is kept in its local storage, so
+   setting and getting errors takes no lock.  While a thread's buffer is
+   being allocated, or if that fails, errors go to a global buffer.
+ */
+static SDL_error SDL_global_error;
+static SDL_TLSID SDL_errbuf_id = 0;
+
+#define ALLOCATION_IN_PROGRESS	((SDL_error *)-1)
+
+static void SDLCALL SDL_FreeErrBuf(void *errbuf)
+{
+	free(errbuf);
+}
+
+SDL_error *SDL_GetErrBuf(void)
+{
+	SDL_TLSID id;
+	SDL_error *errbuf;
+
+	if ( ! SDL_errbuf_id ) {
+		id = SDL_TLSCreate();
+		/* If another thread got in first, use its ID instead */
+		SDL_AtomicCAS(&SDL_errbuf_id, 0, id);
+	}
+
+	errbuf = (SDL_error *)SDL_TLSGet(SDL_errbuf_id);
+	if ( errbuf == ALLOCATION_IN_PROGRESS ) {
+		return(&SDL_global_error);
+	}
+	if ( ! errbuf ) {
+		if ( SDL_TLSSetValue(SDL_errbuf_id,
+		                     ALLOCATION_IN_PROGRESS, NULL) < 0 ) {
+			return(&SDL_global_error);
+		}
+		errbuf = (SDL_error *)malloc(sizeof(*errbuf));
+		if ( errbuf == NULL ) {
+			SDL_TLSSetValue(SDL_errbuf_id, NULL, NULL);
+			return(&SDL_global_error);
+		}
+		memset(errbuf, 0, sizeof(*errbuf));
+		SDL_TLSSetValue(SDL_errbuf_id, errbuf, SDL_FreeErrBuf);
+	}
+	return(errbuf);
+}
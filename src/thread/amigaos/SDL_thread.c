@@ -133,33 +133,6 @@ static void SDL_DelThread(SDL_Thread *thread)
 	}
 }
 
-/* The default (non-thread-safe) global error variable */
-static SDL_error SDL_global_error;
-
-/* Routine to get the thread-specific error variable */
-SDL_error *SDL_GetErrBuf(void)
-{
-	SDL_error *errbuf;
-
-	errbuf = &SDL_global_error;
-	if ( SDL_Threads ) {
-		int i;
-		Uint32 this_thread;
-
-		this_thread = SDL_ThreadID();
-		ObtainSemaphore(&thread_lock);
-		for ( i=0; i<SDL_numthreads; ++i ) {
-			if ( this_thread == SDL_Threads[i]->threadid ) {
-				errbuf = &SDL_Threads[i]->errbuf;
-				break;
-			}
-		}
-		ReleaseSemaphore(&thread_lock);
-	}
-	return(errbuf);
-}
-
-
 /* Arguments and callback to setup and run the user thread function */
 typedef struct {
 	int (*func)(void *);
@@ -194,6 +167,9 @@ void SDL_RunThread(void *data)
 
 	/* Run the function */
 	*statusloc = userfunc(userdata);
+
+	/* Clean up thread local storage while the thread can still use it */
+	SDL_TLSCleanup();
 }
 
 SDL_Thread *SDL_CreateThread(int (*fn)(void *), void *data)
@@ -125,3 +125,14 @@ void SDL_SYS_KillThread(SDL_Thread *thread)
 	rthread.Kill(0);
 	rthread.Close();
 }
+
+/* There is no native thread local storage, so use the generic list */
+SDL_TLSData *SDL_SYS_GetTLSData(void)
+{
+    return(SDL_Generic_GetTLSData());
+}
+
+int SDL_SYS_SetTLSData(SDL_TLSData *storage)
+{
+    return(SDL_Generic_SetTLSData(storage));
+}
@@ -89,3 +89,13 @@ void SDL_KillThread(SDL_Thread *thread)
 	kill(thread->handle, SIGKILL);
 }
 
+/* There is no native thread local storage, so use the generic list */
+SDL_TLSData *SDL_SYS_GetTLSData(void)
+{
+	return(SDL_Generic_GetTLSData());
+}
+
+int SDL_SYS_SetTLSData(SDL_TLSData *storage)
+{
+	return(SDL_Generic_SetTLSData(storage));
+}
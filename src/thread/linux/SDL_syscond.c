@@ -43,6 +43,7 @@ static char rcsid =
 #ifdef SDL_USE_PTHREADS
 
 #include <sys/time.h>
+#include <time.h>
 #include <unistd.h>
 #include <errno.h>
 #include <stdlib.h>
@@ -57,9 +58,20 @@ static char rcsid =
 #error You need to use the generic condition variable implementation
 #endif
 
+/* Time the waits on the monotonic clock, where the thread library can,
+   so that setting the time of day doesn't stretch or cut short a wait.
+ */
+#if defined(HAVE_CLOCK_GETTIME) && defined(_POSIX_CLOCK_SELECTION) && \
+    (_POSIX_CLOCK_SELECTION >= 0)
+#define USE_MONOTONIC_COND
+#endif
+
 struct SDL_cond
 {
 	pthread_cond_t cond;
+#ifdef USE_MONOTONIC_COND
+	clockid_t clock;
+#endif
 };
 
 /* Create a condition variable */
@@ -67,8 +79,27 @@ SDL_cond * SDL_CreateCond(void)
 {
 	SDL_cond *cond;
 
+#ifdef USE_MONOTONIC_COND
+	pthread_condattr_t attr;
+	struct timespec now;
+#endif
+
 	cond = (SDL_cond *) malloc(sizeof(SDL_cond));
 	if ( cond ) {
+#ifdef USE_MONOTONIC_COND
+		cond->clock = CLOCK_REALTIME;
+		if ( (clock_gettime(CLOCK_MONOTONIC, &now) == 0) &&
+		     (pthread_condattr_init(&attr) == 0) ) {
+			if ( (pthread_condattr_setclock(&attr, CLOCK_MONOTONIC) == 0) &&
+			     (pthread_cond_init(&cond->cond, &attr) == 0) ) {
+				cond->clock = CLOCK_MONOTONIC;
+			}
+			pthread_condattr_destroy(&attr);
+			if ( cond->clock == CLOCK_MONOTONIC ) {
+				return(cond);
+			}
+		}
+#endif
 		if ( pthread_cond_init(&cond->cond, NULL) < 0 ) {
 			SDL_SetError("pthread_cond_init() failed");
 			free(cond);
@@ -134,14 +165,22 @@ int SDL_CondWaitTimeout(SDL_cond *cond, SDL_mutex *mutex, Uint32 ms)
 		return -1;
 	}
 
-	gettimeofday(&delta, NULL);
-
-	abstime.tv_sec = delta.tv_sec + (ms/1000);
-	abstime.tv_nsec = (delta.tv_usec + (ms%1000) * 1000) * 1000;
-        if ( abstime.tv_nsec > 1000000000 ) {
-          abstime.tv_sec += 1;
-          abstime.tv_nsec -= 1000000000;
-        }
+#ifdef USE_MONOTONIC_COND
+	if ( cond->clock == CLOCK_MONOTONIC ) {
+		clock_gettime(CLOCK_MONOTONIC, &abstime);
+	} else
+#endif
+	{
+		gettimeofday(&delta, NULL);
+		abstime.tv_sec = delta.tv_sec;
+		abstime.tv_nsec = delta.tv_usec * 1000;
+	}
+	abstime.tv_sec += (ms/1000);
+	abstime.tv_nsec += (ms%1000) * 1000000;
+	if ( abstime.tv_nsec >= 1000000000 ) {
+		abstime.tv_sec += 1;
+		abstime.tv_nsec -= 1000000000;
+	}
 
   tryagain:
 	retval = pthread_cond_timedwait(&cond->cond, &mutex->id, &abstime);
@@ -54,6 +54,8 @@ static char rcsid =
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>			/* For getpid() */
+#include <errno.h>
+#include <sys/time.h>
 #include <pthread.h>
 #include <semaphore.h>
 
@@ -169,6 +171,10 @@ int SDL_SemWait(SDL_sem *sem)
 int SDL_SemWaitTimeout(SDL_sem *sem, Uint32 timeout)
 {
 	int retval;
+#ifdef HAVE_SEM_TIMEDWAIT
+	struct timeval now;
+	struct timespec abstime;
+#endif
 
 	if ( ! sem ) {
 		SDL_SetError("Passed a NULL semaphore");
@@ -183,6 +189,28 @@ int SDL_SemWaitTimeout(SDL_sem *sem, Uint32 timeout)
 		return SDL_SemWait(sem);
 	}
 
+#ifdef HAVE_SEM_TIMEDWAIT
+	/* sem_timedwait() wants an absolute time on the realtime clock */
+	gettimeofday(&now, NULL);
+	abstime.tv_sec = now.tv_sec + (timeout / 1000);
+	abstime.tv_nsec = (now.tv_usec + (timeout % 1000) * 1000) * 1000;
+	if ( abstime.tv_nsec >= 1000000000 ) {
+		abstime.tv_sec += 1;
+		abstime.tv_nsec -= 1000000000;
+	}
+	do {
+		retval = sem_timedwait(sem->sem, &abstime);
+	} while ( (retval < 0) && (errno == EINTR) );
+	if ( retval == 0 ) {
+#ifdef BROKEN_SEMGETVALUE
+		--sem->sem_value;
+#endif
+	} else if ( errno == ETIMEDOUT ) {
+		retval = SDL_MUTEX_TIMEDOUT;
+	} else {
+		SDL_SetError("sem_timedwait() failed");
+	}
+#else
 	/* Ack!  We have to busy wait... */
 	timeout += SDL_GetTicks();
 	do {
@@ -192,6 +220,7 @@ int SDL_SemWaitTimeout(SDL_sem *sem, Uint32 timeout)
 		}
 		SDL_Delay(1);
 	} while ( SDL_GetTicks() < timeout );
+#endif /* HAVE_SEM_TIMEDWAIT */
 
 	return retval;
 }
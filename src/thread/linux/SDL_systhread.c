@@ -56,6 +56,14 @@ void SDL_SYS_KillThread(SDL_Thread *thread)
 {
 	return;
 }
+SDL_TLSData *SDL_SYS_GetTLSData(void)
+{
+	return(SDL_Generic_GetTLSData());
+}
+int SDL_SYS_SetTLSData(SDL_TLSData *storage)
+{
+	return(SDL_Generic_SetTLSData(storage));
+}
 
 #else
 
@@ -145,6 +153,46 @@ void SDL_SYS_KillThread(SDL_Thread *thread)
 #endif
 }
 
+/* The key holding each thread's local storage, made on first use */
+static pthread_key_t thread_local_storage;
+static pthread_once_t thread_local_once = PTHREAD_ONCE_INIT;
+static int generic_local_storage = 0;
+
+/* Clean up after threads that weren't created by SDL */
+static void SDL_DestroyTLSData(void *storage)
+{
+	SDL_TLSDestroy((SDL_TLSData *)storage);
+}
+
+static void SDL_CreateTLSKey(void)
+{
+	if ( pthread_key_create(&thread_local_storage,
+	                        SDL_DestroyTLSData) != 0 ) {
+		generic_local_storage = 1;
+	}
+}
+
+SDL_TLSData *SDL_SYS_GetTLSData(void)
+{
+	pthread_once(&thread_local_once, SDL_CreateTLSKey);
+	if ( generic_local_storage ) {
+		return(SDL_Generic_GetTLSData());
+	}
+	return((SDL_TLSData *)pthread_getspecific(thread_local_storage));
+}
+
+int SDL_SYS_SetTLSData(SDL_TLSData *storage)
+{
+	pthread_once(&thread_local_once, SDL_CreateTLSKey);
+	if ( generic_local_storage ) {
+		return(SDL_Generic_SetTLSData(storage));
+	}
+	if ( pthread_setspecific(thread_local_storage, storage) != 0 ) {
+		return(-1);
+	}
+	return(0);
+}
+
 #else /* Linux-specific clone() based implementation */
 
 #include <stdlib.h>
@@ -250,6 +298,17 @@ void SDL_SYS_KillThread(SDL_Thread *thread)
 	kill(thread->handle, SIGKILL);
 }
 
+/* Threads made by clone() have no local storage of their own */
+SDL_TLSData *SDL_SYS_GetTLSData(void)
+{
+	return(SDL_Generic_GetTLSData());
+}
+
+int SDL_SYS_SetTLSData(SDL_TLSData *storage)
+{
+	return(SDL_Generic_SetTLSData(storage));
+}
+
 #endif /* SDL_USE_PTHREADS */
 
 #endif /* FORK_HACK */
@@ -105,3 +105,14 @@ void SDL_SYS_KillThread(SDL_Thread *thread)
 	pth_cancel(thread->handle);
 	pth_join(thread->handle, NULL);
 }
+
+/* There is no native thread local storage, so use the generic list */
+SDL_TLSData *SDL_SYS_GetTLSData(void)
+{
+	return(SDL_Generic_GetTLSData());
+}
+
+int SDL_SYS_SetTLSData(SDL_TLSData *storage)
+{
+	return(SDL_Generic_SetTLSData(storage));
+}
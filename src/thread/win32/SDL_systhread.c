@@ -34,6 +34,7 @@ static char rcsid =
 #include "SDL_error.h"
 #include "SDL_thread.h"
 #include "SDL_systhread.h"
+#include "SDL_atomic_c.h"
 
 
 static DWORD WINAPI RunThread(LPVOID data)
@@ -78,3 +79,44 @@ void SDL_SYS_KillThread(SDL_Thread *thread)
 {
 	TerminateThread(thread->handle, FALSE);
 }
+
+/* The TLS index holding each thread's local storage, made on first use */
+static DWORD thread_local_storage = TLS_OUT_OF_INDEXES;
+static int generic_local_storage = 0;
+
+static int SDL_HasTLSIndex(void)
+{
+	DWORD index;
+
+	if ( (thread_local_storage == TLS_OUT_OF_INDEXES) &&
+	     ! generic_local_storage ) {
+		index = TlsAlloc();
+		if ( index == TLS_OUT_OF_INDEXES ) {
+			generic_local_storage = 1;
+		} else if ( ! SDL_AtomicCAS(&thread_local_storage,
+		                            TLS_OUT_OF_INDEXES, index) ) {
+			/* Another thread made one first */
+			TlsFree(index);
+		}
+	}
+	return(! generic_local_storage);
+}
+
+SDL_TLSData *SDL_SYS_GetTLSData(void)
+{
+	if ( ! SDL_HasTLSIndex() ) {
+		return(SDL_Generic_GetTLSData());
+	}
+	return((SDL_TLSData *)TlsGetValue(thread_local_storage));
+}
+
+int SDL_SYS_SetTLSData(SDL_TLSData *storage)
+{
+	if ( ! SDL_HasTLSIndex() ) {
+		return(SDL_Generic_SetTLSData(storage));
+	}
+	if ( ! TlsSetValue(thread_local_storage, storage) ) {
+		return(-1);
+	}
+	return(0);
+}
@@ -44,3 +44,14 @@ extern int SDL_SYS_StartTimer(void);
 
 /* Stop a previously started timer */
 extern void SDL_SYS_StopTimer(void);
+
+/* Called when the timer thread starts and after it stops, so the system
+   can sleep with the precision the timer thread needs.
+ */
+#ifdef WIN32
+extern void SDL_SYS_TimerThreadStarted(void);
+extern void SDL_SYS_TimerThreadStopped(void);
+#else
+#define SDL_SYS_TimerThreadStarted()
+#define SDL_SYS_TimerThreadStopped()
+#endif
@@ -29,11 +29,14 @@ static char rcsid =
 
 #include <stdlib.h>
 #include <stdio.h>			/* For the definition of NULL */
+#include <time.h>
+#include <errno.h>
 
 #include "SDL_error.h"
 #include "SDL_timer.h"
 #include "SDL_timer_c.h"
 #include "SDL_mutex.h"
+#include "SDL_thread.h"
 #include "SDL_systimer.h"
 
 /* #define DEBUG_TIMERS */
@@ -45,23 +48,310 @@ int SDL_timer_running = 0;
 Uint32 SDL_alarm_interval = 0;
 SDL_TimerCallback SDL_alarm_callback;
 
-static SDL_bool list_changed = SDL_FALSE;
-
 /* Data used for a thread-based timer */
 static int SDL_timer_threaded = 0;
 
+/* Where a timer is when it isn't in the heap */
+#define TIMER_FREE	-1
+#define TIMER_RUNNING	-2
+#define TIMER_REMOVED	-3
+
 struct _SDL_TimerID {
 	Uint32 interval;
 	SDL_NewTimerCallback cb;
 	void *param;
-	Uint32 last_alarm;
-	struct _SDL_TimerID *next;
+	Uint32 deadline;
+	int index;			/* Position in the heap, or TIMER_* */
+	struct _SDL_TimerID *next;	/* Next free timer */
 };
 
-static SDL_TimerID SDL_timers = NULL;
-static Uint32 num_timers = 0;
+/* The pending timers are kept in a binary heap ordered by deadline, so
+   the next one to expire is always SDL_timers[0], and adding or removing
+   a timer costs O(log n) whatever the number of timers.
+ */
+static SDL_TimerID *SDL_timers = NULL;
+static int num_timers = 0;
+static int max_timers = 0;
+static SDL_TimerID SDL_timer_current = NULL;
 static SDL_mutex *SDL_timer_mutex;
 
+/* Timers are allocated in blocks that are kept until the timer subsystem
+   quits, so that a stale timer ID can still be checked safely.  Each block
+   is twice the size of the one before it.
+ */
+#define TIMER_BLOCK	32
+#define TIMER_BLOCKS	24
+static SDL_TimerID timer_blocks[TIMER_BLOCKS];
+static int num_blocks = 0;
+static SDL_TimerID free_timers = NULL;
+
+/* The thread that sleeps until the next deadline, if threads work */
+static SDL_Thread *SDL_timer_thread = NULL;
+static SDL_cond *SDL_timer_cond = NULL;
+static int SDL_timer_alive = 0;
+
+static SDL_TimerID SDL_AllocTimer(void)
+{
+	SDL_TimerID t;
+	int i, count;
+
+	if ( ! free_timers ) {
+		if ( num_blocks == TIMER_BLOCKS ) {
+			return(NULL);
+		}
+		count = (TIMER_BLOCK << num_blocks);
+		t = (SDL_TimerID)malloc(count*sizeof(struct _SDL_TimerID));
+		if ( t == NULL ) {
+			return(NULL);
+		}
+		timer_blocks[num_blocks++] = t;
+		for ( i=0; i<count; ++i ) {
+			t[i].index = TIMER_FREE;
+			t[i].next = &t[i+1];
+		}
+		t[count-1].next = NULL;
+		free_timers = t;
+	}
+	t = free_timers;
+	free_timers = t->next;
+	return(t);
+}
+
+static void SDL_FreeTimer(SDL_TimerID t)
+{
+	t->index = TIMER_FREE;
+	t->next = free_timers;
+	free_timers = t;
+}
+
+/* See whether a pointer is one of our timers, live or not */
+static int SDL_IsTimer(SDL_TimerID id)
+{
+	int i;
+
+	for ( i=0; i<num_blocks; ++i ) {
+		if ( (id >= timer_blocks[i]) &&
+		     (id < timer_blocks[i] + (TIMER_BLOCK << i)) ) {
+			return(((Uint8 *)id - (Uint8 *)timer_blocks[i]) %
+			       sizeof(struct _SDL_TimerID) == 0);
+		}
+	}
+	return(0);
+}
+
+static void SDL_FreeTimerBlocks(void)
+{
+	while ( num_blocks > 0 ) {
+		free(timer_blocks[--num_blocks]);
+	}
+	free_timers = NULL;
+	free(SDL_timers);
+	SDL_timers = NULL;
+	num_timers = 0;
+	max_timers = 0;
+}
+
+/* Deadlines wrap with SDL_GetTicks(), so compare them by difference */
+#define TIMER_BEFORE(A, B)	((Sint32)((A)->deadline - (B)->deadline) < 0)
+
+static void SDL_TimerSiftUp(int i)
+{
+	SDL_TimerID t = SDL_timers[i];
+	int parent;
+
+	while ( i > 0 ) {
+		parent = (i - 1) / 2;
+		if ( ! TIMER_BEFORE(t, SDL_timers[parent]) ) {
+			break;
+		}
+		SDL_timers[i] = SDL_timers[parent];
+		SDL_timers[i]->index = i;
+		i = parent;
+	}
+	SDL_timers[i] = t;
+	t->index = i;
+}
+
+static void SDL_TimerSiftDown(int i)
+{
+	SDL_TimerID t = SDL_timers[i];
+	int child;
+
+	for ( ; ; ) {
+		child = 2 * i + 1;
+		if ( child >= num_timers ) {
+			break;
+		}
+		if ( (child + 1 < num_timers) &&
+		     TIMER_BEFORE(SDL_timers[child+1], SDL_timers[child]) ) {
+			++child;
+		}
+		if ( ! TIMER_BEFORE(SDL_timers[child], t) ) {
+			break;
+		}
+		SDL_timers[i] = SDL_timers[child];
+		SDL_timers[i]->index = i;
+		i = child;
+	}
+	SDL_timers[i] = t;
+	t->index = i;
+}
+
+static int SDL_TimerInsert(SDL_TimerID t)
+{
+	SDL_TimerID *timers;
+	int count;
+
+	if ( num_timers == max_timers ) {
+		count = max_timers ? (max_timers * 2) : TIMER_BLOCK;
+		timers = (SDL_TimerID *)realloc(SDL_timers,
+		                                count*sizeof(*timers));
+		if ( timers == NULL ) {
+			return(-1);
+		}
+		SDL_timers = timers;
+		max_timers = count;
+	}
+	SDL_timers[num_timers] = t;
+	SDL_TimerSiftUp(num_timers++);
+
+	/* Wake the timer thread if it is sleeping past the new deadline */
+	if ( (t->index == 0) && SDL_timer_cond ) {
+		SDL_CondSignal(SDL_timer_cond);
+	}
+	return(0);
+}
+
+static void SDL_TimerDelete(SDL_TimerID t)
+{
+	int i = t->index;
+
+	--num_timers;
+	if ( i < num_timers ) {
+		SDL_timers[i] = SDL_timers[num_timers];
+		SDL_timers[i]->index = i;
+		if ( (i > 0) && TIMER_BEFORE(SDL_timers[i], t) ) {
+			SDL_TimerSiftUp(i);
+		} else {
+			SDL_TimerSiftDown(i);
+		}
+	}
+}
+
+/* Run the timers that expire less than 'slack' ms from now.
+   This is called with the timer mutex held.
+ */
+static void SDL_RunTimers(Sint32 slack)
+{
+	Uint32 now, ms;
+	SDL_TimerID t;
+
+	now = SDL_GetTicks();
+	while ( num_timers &&
+	        ((Sint32)(SDL_timers[0]->deadline - now) < slack) ) {
+		/* Take the timer out of the heap while its callback runs,
+		   so that it can be removed from any thread meanwhile.
+		 */
+		t = SDL_timers[0];
+		SDL_TimerDelete(t);
+		t->index = TIMER_RUNNING;
+		SDL_timer_current = t;
+#ifdef DEBUG_TIMERS
+		printf("Executing timer %p (thread = %d)\n",
+					t, SDL_ThreadID());
+#endif
+		SDL_mutexV(SDL_timer_mutex);
+		ms = t->cb(t->interval, t->param);
+		SDL_mutexP(SDL_timer_mutex);
+		SDL_timer_current = NULL;
+
+		if ( (t->index == TIMER_REMOVED) || ! ms ) {
+#ifdef DEBUG_TIMERS
+			printf("SDL: Removing timer %p\n", t);
+#endif
+			SDL_FreeTimer(t);
+			continue;
+		}
+		if ( ms != t->interval ) {
+			t->interval = SDL_timer_thread ? ms : ROUND_RESOLUTION(ms);
+		}
+
+		/* Keep in step with the original deadline, unless we have
+		   fallen a whole interval behind it.
+		 */
+		t->deadline += t->interval;
+		if ( (Sint32)(t->deadline - now) <= 0 ) {
+			t->deadline = now + t->interval;
+		}
+		if ( SDL_TimerInsert(t) < 0 ) {
+			SDL_FreeTimer(t);
+		}
+	}
+}
+
+/* The timer thread sleeps until the next deadline, or until a timer
+   that expires sooner is added.
+ */
+static int SDL_TimerThread(void *unused)
+{
+	Sint32 wait;
+
+	SDL_mutexP(SDL_timer_mutex);
+	while ( SDL_timer_alive ) {
+		if ( num_timers == 0 ) {
+			SDL_CondWait(SDL_timer_cond, SDL_timer_mutex);
+			continue;
+		}
+		wait = (Sint32)(SDL_timers[0]->deadline - SDL_GetTicks());
+		if ( wait > 0 ) {
+			SDL_CondWaitTimeout(SDL_timer_cond, SDL_timer_mutex, wait);
+		} else {
+			SDL_RunTimers(1);
+		}
+	}
+	SDL_mutexV(SDL_timer_mutex);
+	return(0);
+}
+
+static int SDL_StartTimerThread(void)
+{
+#ifndef DISABLE_THREADS
+	SDL_timer_mutex = SDL_CreateMutex();
+	SDL_timer_cond = SDL_CreateCond();
+	if ( SDL_timer_mutex && SDL_timer_cond ) {
+		SDL_timer_alive = 1;
+		SDL_timer_thread = SDL_CreateThread(SDL_TimerThread, NULL);
+		if ( SDL_timer_thread ) {
+			SDL_SYS_TimerThreadStarted();
+			return(0);
+		}
+		SDL_timer_alive = 0;
+	}
+	if ( SDL_timer_cond ) {
+		SDL_DestroyCond(SDL_timer_cond);
+		SDL_timer_cond = NULL;
+	}
+	if ( SDL_timer_mutex ) {
+		SDL_DestroyMutex(SDL_timer_mutex);
+		SDL_timer_mutex = NULL;
+	}
+#endif
+	return(-1);
+}
+
+static void SDL_StopTimerThread(void)
+{
+	SDL_mutexP(SDL_timer_mutex);
+	SDL_timer_alive = 0;
+	SDL_CondSignal(SDL_timer_cond);
+	SDL_mutexV(SDL_timer_mutex);
+	SDL_WaitThread(SDL_timer_thread, NULL);
+	SDL_timer_thread = NULL;
+	SDL_SYS_TimerThreadStopped();
+	SDL_DestroyCond(SDL_timer_cond);
+	SDL_timer_cond = NULL;
+}
+
 /* Set whether or not the timer should use a thread.
    This should not be called while the timer subsystem is running.
 */
@@ -86,11 +376,15 @@ int SDL_TimerInit(void)
 	SDL_timer_running = 0;
 	SDL_SetTimer(0, NULL);
 	retval = 0;
-	if ( ! SDL_timer_threaded ) {
-		retval = SDL_SYS_TimerInit();
-	}
-	if ( SDL_timer_threaded ) {
-		SDL_timer_mutex = SDL_CreateMutex();
+	if ( SDL_StartTimerThread() == 0 ) {
+		SDL_timer_threaded = 1;
+	} else {
+		if ( ! SDL_timer_threaded ) {
+			retval = SDL_SYS_TimerInit();
+		}
+		if ( SDL_timer_threaded ) {
+			SDL_timer_mutex = SDL_CreateMutex();
+		}
 	}
 	SDL_timer_started = 1;
 	return(retval);
@@ -99,70 +393,28 @@ int SDL_TimerInit(void)
 void SDL_TimerQuit(void)
 {
 	SDL_SetTimer(0, NULL);
-	if ( SDL_timer_threaded < 2 ) {
+	if ( SDL_timer_thread ) {
+		SDL_StopTimerThread();
+	} else if ( SDL_timer_threaded < 2 ) {
 		SDL_SYS_TimerQuit();
 	}
 	if ( SDL_timer_threaded ) {
 		SDL_DestroyMutex(SDL_timer_mutex);
+		SDL_timer_mutex = NULL;
 	}
+	SDL_FreeTimerBlocks();
 	SDL_timer_started = 0;
 	SDL_timer_threaded = 0;
 }
 
 void SDL_ThreadedTimerCheck(void)
 {
-	Uint32 now, ms;
-	SDL_TimerID t, prev, next;
-	int removed;
-
-	now = SDL_GetTicks();
-
-	SDL_mutexP(SDL_timer_mutex);
-	for ( prev = NULL, t = SDL_timers; t; t = next ) {
-		removed = 0;
-		ms = t->interval - SDL_TIMESLICE;
-		next = t->next;
-		if ( (t->last_alarm < now) && ((now - t->last_alarm) > ms) ) {
-			if ( (now - t->last_alarm) < t->interval ) {
-				t->last_alarm += t->interval;
-			} else {
-				t->last_alarm = now;
-			}
-			list_changed = SDL_FALSE;
-#ifdef DEBUG_TIMERS
-			printf("Executing timer %p (thread = %d)\n",
-						t, SDL_ThreadID());
-#endif
-			SDL_mutexV(SDL_timer_mutex);
-			ms = t->cb(t->interval, t->param);
-			SDL_mutexP(SDL_timer_mutex);
-			if ( list_changed ) {
-				/* Abort, list of timers has been modified */
-				break;
-			}
-			if ( ms != t->interval ) {
-				if ( ms ) {
-					t->interval = ROUND_RESOLUTION(ms);
-				} else { /* Remove the timer from the linked list */
-#ifdef DEBUG_TIMERS
-					printf("SDL: Removing timer %p\n", t);
-#endif
-					if ( prev ) {
-						prev->next = next;
-					} else {
-						SDL_timers = next;
-					}
-					free(t);
-					-- num_timers;
-					removed = 1;
-				}
-			}
-		}
-		/* Don't update prev if the timer has disappeared */
-		if ( ! removed ) {
-			prev = t;
-		}
+	/* The timer thread runs the timers itself when there is one */
+	if ( SDL_timer_thread ) {
+		return;
 	}
+	SDL_mutexP(SDL_timer_mutex);
+	SDL_RunTimers(SDL_TIMESLICE);
 	SDL_mutexV(SDL_timer_mutex);
 }
 
@@ -182,17 +434,24 @@ SDL_TimerID SDL_AddTimer(Uint32 interval, SDL_NewTimerCallback callback, void *p
 		return NULL;
 	}
 	SDL_mutexP(SDL_timer_mutex);
-	t = (SDL_TimerID) malloc(sizeof(struct _SDL_TimerID));
+	t = SDL_AllocTimer();
 	if ( t ) {
-		t->interval = ROUND_RESOLUTION(interval);
+		if ( ! SDL_timer_thread ) {
+			interval = ROUND_RESOLUTION(interval);
+		}
+		t->interval = interval;
 		t->cb = callback;
 		t->param = param;
-		t->last_alarm = SDL_GetTicks();
-		t->next = SDL_timers;
-		SDL_timers = t;
-		++ num_timers;
-		list_changed = SDL_TRUE;
+		t->deadline = SDL_GetTicks() + interval;
+		if ( SDL_TimerInsert(t) < 0 ) {
+			SDL_FreeTimer(t);
+			t = NULL;
+		}
+	}
+	if ( t ) {
 		SDL_timer_running = 1;
+	} else {
+		SDL_OutOfMemory();
 	}
 #ifdef DEBUG_TIMERS
 	printf("SDL_AddTimer(%d) = %08x num_timers = %d\n", interval, (Uint32)t, num_timers);
@@ -203,24 +462,19 @@ SDL_TimerID SDL_AddTimer(Uint32 interval, SDL_NewTimerCallback callback, void *p
 
 SDL_bool SDL_RemoveTimer(SDL_TimerID id)
 {
-	SDL_TimerID t, prev = NULL;
 	SDL_bool removed;
 
 	removed = SDL_FALSE;
 	SDL_mutexP(SDL_timer_mutex);
-	/* Look for id in the linked list of timers */
-	for (t = SDL_timers; t; prev=t, t = t->next ) {
-		if ( t == id ) {
-			if(prev) {
-				prev->next = t->next;
-			} else {
-				SDL_timers = t->next;
-			}
-			free(t);
-			-- num_timers;
+	if ( SDL_IsTimer(id) ) {
+		if ( id->index >= 0 ) {
+			SDL_TimerDelete(id);
+			SDL_FreeTimer(id);
+			removed = SDL_TRUE;
+		} else if ( id->index == TIMER_RUNNING ) {
+			/* Freed when its callback returns */
+			id->index = TIMER_REMOVED;
 			removed = SDL_TRUE;
-			list_changed = SDL_TRUE;
-			break;
 		}
 	}
 #ifdef DEBUG_TIMERS
@@ -230,18 +484,13 @@ SDL_bool SDL_RemoveTimer(SDL_TimerID id)
 	return removed;
 }
 
-static void SDL_RemoveAllTimers(SDL_TimerID t)
+static void SDL_RemoveAllTimers(void)
 {
-	SDL_TimerID freeme;
-
-	/* Changed to non-recursive implementation.
-	   The recursive implementation is elegant, but subject to 
-	   stack overflow if there are lots and lots of timers.
-	 */
-	while ( t ) {
-		freeme = t;
-		t = t->next;
-		free(freeme);
+	while ( num_timers ) {
+		SDL_FreeTimer(SDL_timers[--num_timers]);
+	}
+	if ( SDL_timer_current ) {
+		SDL_timer_current->index = TIMER_REMOVED;
 	}
 }
 
@@ -264,8 +513,7 @@ int SDL_SetTimer(Uint32 ms, SDL_TimerCallback callback)
 		SDL_timer_running = 0;
 		if ( SDL_timer_threaded ) {
 			SDL_mutexP(SDL_timer_mutex);
-			SDL_RemoveAllTimers(SDL_timers);
-			SDL_timers = NULL;
+			SDL_RemoveAllTimers();
 			SDL_mutexV(SDL_timer_mutex);
 		} else {
 			SDL_SYS_StopTimer();
@@ -284,3 +532,113 @@ int SDL_SetTimer(Uint32 ms, SDL_TimerCallback callback)
 	}
 	return retval;
 }
+
+#ifdef SDL_HAS_64BIT_TYPE
+
+/* With the performance counter on the monotonic clock, sleep until an
+   absolute time on that clock, which no signal or rounding can stretch.
+ */
+#if defined(HAVE_CLOCK_GETTIME) && defined(TIMER_ABSTIME)
+#define USE_CLOCK_NANOSLEEP
+#endif
+
+#define NS_PER_SECOND	1000000000
+
+/* The performance counter when SDL was initialized */
+static Uint64 SDL_start_counter = 0;
+
+/* How late the OS wakes us from a sleep, in nanoseconds, and how much
+   that varies.  The spin phase of SDL_DelayUntilNS() starts early enough
+   to cover most wakeups.
+ */
+static Sint64 SDL_wake_latency = 50000;
+static Sint64 SDL_wake_jitter = 25000;
+#define MAX_SPIN_NS	2000000
+
+void SDL_StartTicksNS(void)
+{
+	SDL_start_counter = SDL_GetPerformanceCounter();
+}
+
+Uint64 SDL_GetTicksNS(void)
+{
+	Uint64 ticks = SDL_GetPerformanceCounter() - SDL_start_counter;
+	Uint64 frequency = SDL_GetPerformanceFrequency();
+
+	if ( frequency == NS_PER_SECOND ) {
+		return(ticks);
+	}
+	/* Split the conversion so the multiplication can't overflow */
+	return((ticks / frequency) * NS_PER_SECOND +
+	       (ticks % frequency) * NS_PER_SECOND / frequency);
+}
+
+/* Sleep until SDL_GetTicksNS() reaches 'deadline', or a little after */
+static void SDL_SleepUntilNS(Uint64 deadline)
+{
+	Uint64 now;
+
+#ifdef USE_CLOCK_NANOSLEEP
+	/* A nanosecond counter is CLOCK_MONOTONIC, so sleep on it directly */
+	if ( SDL_GetPerformanceFrequency() == NS_PER_SECOND ) {
+		struct timespec abstime;
+
+		deadline += SDL_start_counter;
+		abstime.tv_sec = (time_t)(deadline / NS_PER_SECOND);
+		abstime.tv_nsec = (long)(deadline % NS_PER_SECOND);
+		while ( clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME,
+		                        &abstime, NULL) == EINTR ) {
+			/* Go back to sleep */ ;
+		}
+		return;
+	}
+#endif
+	/* Otherwise sleep in whole milliseconds, rounding up */
+	for ( now = SDL_GetTicksNS(); now < deadline; now = SDL_GetTicksNS() ) {
+		SDL_Delay((Uint32)((deadline - now + 999999) / 1000000));
+	}
+}
+
+Sint64 SDL_DelayUntilNS(Uint64 deadline, int spin)
+{
+	Uint64 now, wake;
+	Sint64 late, margin;
+
+	now = SDL_GetTicksNS();
+	if ( now >= deadline ) {
+		return((Sint64)(now - deadline));
+	}
+
+	if ( ! spin ) {
+		SDL_SleepUntilNS(deadline);
+		return((Sint64)(SDL_GetTicksNS() - deadline));
+	}
+
+	/* Sleep until shortly before the deadline, and learn from how late
+	   that turns out to be how far ahead the next sleep should stop.
+	 */
+	margin = SDL_wake_latency + 2 * SDL_wake_jitter;
+	if ( margin > MAX_SPIN_NS ) {
+		margin = MAX_SPIN_NS;
+	} else if ( margin < 0 ) {
+		margin = 0;
+	}
+	if ( deadline - now > (Uint64)margin ) {
+		wake = deadline - margin;
+		SDL_SleepUntilNS(wake);
+		late = (Sint64)(SDL_GetTicksNS() - wake);
+		SDL_wake_jitter += ((late > SDL_wake_latency ?
+		                     late - SDL_wake_latency :
+		                     SDL_wake_latency - late) -
+		                    SDL_wake_jitter) / 8;
+		SDL_wake_latency += (late - SDL_wake_latency) / 8;
+	}
+
+	/* Spin for the rest of the time */
+	do {
+		now = SDL_GetTicksNS();
+	} while ( now < deadline );
+	return((Sint64)(now - deadline));
+}
+
+#endif /* SDL_HAS_64BIT_TYPE */
@@ -209,6 +209,19 @@ void PPC_TimerInit(void)
 
 #endif
 
+#ifdef SDL_HAS_64BIT_TYPE
+/* There is no finer clock than the millisecond ticks */
+Uint64 SDL_GetPerformanceCounter(void)
+{
+	return(SDL_GetTicks());
+}
+
+Uint64 SDL_GetPerformanceFrequency(void)
+{
+	return(1000);
+}
+#endif /* SDL_HAS_64BIT_TYPE */
+
 #include "SDL_thread.h"
 
 /* Data to handle a single periodic alarm */
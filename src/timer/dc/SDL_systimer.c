@@ -55,6 +55,19 @@ Uint32 SDL_GetTicks(void)
 	return((jiffies-start)*1000/HZ);
 }
 
+#ifdef SDL_HAS_64BIT_TYPE
+/* There is no finer clock than the millisecond ticks */
+Uint64 SDL_GetPerformanceCounter(void)
+{
+	return(SDL_GetTicks());
+}
+
+Uint64 SDL_GetPerformanceFrequency(void)
+{
+	return(1000);
+}
+#endif /* SDL_HAS_64BIT_TYPE */
+
 void SDL_Delay(Uint32 ms)
 {
 	thd_sleep(ms);
@@ -29,6 +29,7 @@ static char rcsid =
 
 #include <stdio.h>
 #include <sys/time.h>
+#include <time.h>
 #include <signal.h>
 #include <unistd.h>
 #include <string.h>
@@ -59,6 +60,11 @@ static char rcsid =
 #define USE_NANOSLEEP
 #endif
 
+/* With a monotonic clock, sleep until an absolute time on that clock */
+#if defined(HAVE_CLOCK_GETTIME) && defined(TIMER_ABSTIME)
+#define USE_CLOCK_NANOSLEEP
+#endif
+
 #if defined(i386) || defined(__i386__)
 /* This only works on pentium or newer x86 processors */
 /* Actually, this isn't reliable on multi-cpu systems, so is disabled */
@@ -107,9 +113,30 @@ static float calc_cpu_mhz(void)
 
 /* The first ticks value of the application */
 static struct timeval start;
+#ifdef HAVE_CLOCK_GETTIME
+static struct timespec start_ts;
+#endif
 
 #endif  /* USE_RDTSC */
 
+#ifdef HAVE_CLOCK_GETTIME
+/* Whether CLOCK_MONOTONIC works, -1 until it has been tried.  Unlike
+   gettimeofday() it doesn't jump when the time of day is set, and with
+   a recent C library it is read without a system call.
+ */
+static int has_monotonic_time = -1;
+
+static int SDL_HasMonotonicTime(void)
+{
+	struct timespec now;
+
+	if ( has_monotonic_time < 0 ) {
+		has_monotonic_time = (clock_gettime(CLOCK_MONOTONIC, &now) == 0);
+	}
+	return(has_monotonic_time);
+}
+#endif /* HAVE_CLOCK_GETTIME */
+
 
 void SDL_StartTicks(void)
 {
@@ -120,6 +147,12 @@ void SDL_StartTicks(void)
 	}
 	rdtsc(start);
 #else
+#ifdef HAVE_CLOCK_GETTIME
+	if ( SDL_HasMonotonicTime() ) {
+		clock_gettime(CLOCK_MONOTONIC, &start_ts);
+		return;
+	}
+#endif
 	gettimeofday(&start, NULL);
 #endif /* USE_RDTSC */
 }
@@ -137,12 +170,57 @@ Uint32 SDL_GetTicks (void)
 	struct timeval now;
 	Uint32 ticks;
 
+#ifdef HAVE_CLOCK_GETTIME
+	if ( has_monotonic_time > 0 ) {
+		struct timespec now_ts;
+
+		clock_gettime(CLOCK_MONOTONIC, &now_ts);
+		ticks = (now_ts.tv_sec-start_ts.tv_sec)*1000 +
+		        (now_ts.tv_nsec-start_ts.tv_nsec)/1000000;
+		return(ticks);
+	}
+#endif
 	gettimeofday(&now, NULL);
 	ticks=(now.tv_sec-start.tv_sec)*1000+(now.tv_usec-start.tv_usec)/1000;
 	return(ticks);
 #endif /* USE_RDTSC */
 }
 
+#ifdef SDL_HAS_64BIT_TYPE
+Uint64 SDL_GetPerformanceCounter(void)
+{
+	struct timeval now;
+	Uint64 ticks;
+
+#ifdef HAVE_CLOCK_GETTIME
+	if ( SDL_HasMonotonicTime() ) {
+		struct timespec now_ts;
+
+		clock_gettime(CLOCK_MONOTONIC, &now_ts);
+		ticks = now_ts.tv_sec;
+		ticks *= 1000000000;
+		ticks += now_ts.tv_nsec;
+		return(ticks);
+	}
+#endif
+	gettimeofday(&now, NULL);
+	ticks = now.tv_sec;
+	ticks *= 1000000;
+	ticks += now.tv_usec;
+	return(ticks);
+}
+
+Uint64 SDL_GetPerformanceFrequency(void)
+{
+#ifdef HAVE_CLOCK_GETTIME
+	if ( SDL_HasMonotonicTime() ) {
+		return(1000000000);
+	}
+#endif
+	return(1000000);
+}
+#endif /* SDL_HAS_64BIT_TYPE */
+
 void SDL_Delay (Uint32 ms)
 {
 #ifdef ENABLE_PTH
@@ -153,6 +231,9 @@ void SDL_Delay (Uint32 ms)
 #else
 	int was_error;
 
+#ifdef USE_CLOCK_NANOSLEEP
+	struct timespec deadline;
+#endif
 #ifdef USE_NANOSLEEP
 	struct timespec elapsed, tv;
 #else
@@ -162,6 +243,24 @@ void SDL_Delay (Uint32 ms)
 #endif
 #endif
 
+#ifdef USE_CLOCK_NANOSLEEP
+	/* An absolute deadline stays put however often a signal wakes us */
+	if ( SDL_HasMonotonicTime() ) {
+		clock_gettime(CLOCK_MONOTONIC, &deadline);
+		deadline.tv_sec += ms/1000;
+		deadline.tv_nsec += (ms%1000)*1000000;
+		if ( deadline.tv_nsec >= 1000000000 ) {
+			deadline.tv_sec += 1;
+			deadline.tv_nsec -= 1000000000;
+		}
+		while ( clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME,
+		                        &deadline, NULL) == EINTR ) {
+			/* Go back to sleep */ ;
+		}
+		return;
+	}
+#endif /* USE_CLOCK_NANOSLEEP */
+
 	/* Set the timeout interval - Linux only needs to do this once */
 #ifdef SELECT_SETS_REMAINING
 	tv.tv_sec = ms/1000;
@@ -70,6 +70,27 @@ Uint32 SDL_GetTicks(void)
 #endif
 }
 
+Uint64 SDL_GetPerformanceCounter(void)
+{
+#ifdef USE_MICROSECONDS
+	UnsignedWide now;
+	
+	Microseconds(&now);
+	return WideTo64bit(now);
+#else
+	return(LMGetTicks());
+#endif
+}
+
+Uint64 SDL_GetPerformanceFrequency(void)
+{
+#ifdef USE_MICROSECONDS
+	return(1000000);
+#else
+	return(60);
+#endif
+}
+
 void SDL_Delay(Uint32 ms)
 {
 #ifdef USE_MICROSECONDS
@@ -63,6 +63,19 @@ Uint32 SDL_GetTicks(void)
         return FastMilliseconds();
 }
 
+Uint64 SDL_GetPerformanceCounter(void)
+{
+        if ( ! is_fast_inited )
+            SDL_SYS_TimerInit();
+
+        return (Uint64)FastMicroseconds();
+}
+
+Uint64 SDL_GetPerformanceFrequency(void)
+{
+        return 1000000;
+}
+
 void SDL_Delay(Uint32 ms)
 {
         Uint32 stop, now;
@@ -77,6 +77,19 @@ Uint32 SDL_GetTicks (void)
 
 extern void DRenderer_FillBuffers();
 
+#ifdef SDL_HAS_64BIT_TYPE
+/* There is no finer clock than the millisecond ticks */
+Uint64 SDL_GetPerformanceCounter(void)
+{
+	return(SDL_GetTicks());
+}
+
+Uint64 SDL_GetPerformanceFrequency(void)
+{
+	return(1000);
+}
+#endif /* SDL_HAS_64BIT_TYPE */
+
 void SDL_Delay (Uint32 ms)
 {
     Uint32 now,then,elapsed;
@@ -107,11 +107,50 @@ Uint32 SDL_GetTicks(void)
 	return(ticks);
 }
 
+#ifdef SDL_HAS_64BIT_TYPE
+Uint64 SDL_GetPerformanceCounter(void)
+{
+	LARGE_INTEGER counter;
+
+	if ( ! QueryPerformanceCounter(&counter) ) {
+		return(SDL_GetTicks());
+	}
+	return(counter.QuadPart);
+}
+
+Uint64 SDL_GetPerformanceFrequency(void)
+{
+	LARGE_INTEGER frequency;
+
+	if ( ! QueryPerformanceFrequency(&frequency) ) {
+		return(1000);
+	}
+	return(frequency.QuadPart);
+}
+#endif /* SDL_HAS_64BIT_TYPE */
+
 void SDL_Delay(Uint32 ms)
 {
 	Sleep(ms);
 }
 
+/* The timer thread's waits only time out at the system timer resolution,
+   about 15 ms unless we ask for more.
+ */
+void SDL_SYS_TimerThreadStarted(void)
+{
+#ifndef _WIN32_WCE
+	timeBeginPeriod(1);
+#endif
+}
+
+void SDL_SYS_TimerThreadStopped(void)
+{
+#ifndef _WIN32_WCE
+	timeEndPeriod(1);
+#endif
+}
+
 #ifdef USE_SETTIMER
 
 static UINT WIN_timer;
@@ -31,6 +31,7 @@ static char rcsid =
 
 #include "SDL_error.h"
 #include "SDL_video.h"
+#include "SDL_thread.h"
 #include "SDL_sysvideo.h"
 #include "SDL_blit.h"
 #include "SDL_RLEaccel_c.h"
@@ -50,6 +51,99 @@ static char rcsid =
 #include "HeadX86.h"
 #endif
 
+/* Parallel software blitting:
+   Large blits are split into bands of whole rows, and each band is run
+   through the normal low level blitter on the SDL job pool.
+   The calling thread converts bands too while it waits.
+*/
+#define DEFAULT_BLIT_PIXELS	(256*256)
+
+static struct {
+	int threads;
+	Uint32 min_pixels;
+} SDL_BlitPool = { 1, DEFAULT_BLIT_PIXELS };
+
+typedef struct {
+	SDL_loblit blit;
+	SDL_BlitInfo *info;
+	int srcpitch;
+	int dstpitch;
+} SDL_BlitBands;
+
+int SDL_SetBlitThreads(int threads, Uint32 min_pixels)
+{
+	int pool;
+
+	if ( min_pixels == 0 ) {
+		min_pixels = DEFAULT_BLIT_PIXELS;
+	}
+	if ( threads > 1 ) {
+		/* There's no point in more bands than threads to run them */
+		pool = SDL_GetJobThreads() + 1;
+		if ( threads > pool ) {
+			threads = pool;
+		}
+	} else {
+		threads = 1;
+	}
+	SDL_BlitPool.threads = threads;
+	SDL_BlitPool.min_pixels = min_pixels;
+	return(threads);
+}
+
+void SDL_InitBlitThreads(void)
+{
+	const char *variable;
+	int threads;
+	Uint32 min_pixels;
+
+	variable = getenv("SDL_BLIT_THREADS");
+	if ( variable && (SDL_BlitPool.threads == 1) ) {
+		threads = atoi(variable);
+		min_pixels = 0;
+		variable = getenv("SDL_BLIT_THREAD_PIXELS");
+		if ( variable ) {
+			min_pixels = (Uint32)atoi(variable);
+		}
+		SDL_SetBlitThreads(threads, min_pixels);
+	}
+}
+
+void SDL_QuitBlitThreads(void)
+{
+	SDL_BlitPool.threads = 1;
+	SDL_BlitPool.min_pixels = DEFAULT_BLIT_PIXELS;
+}
+
+static void SDLCALL SDL_RunBlitBand(void *data, int first, int last)
+{
+	SDL_BlitBands *bands = (SDL_BlitBands *)data;
+	SDL_BlitInfo info;
+
+	info = *bands->info;
+	info.s_pixels += first * bands->srcpitch;
+	info.d_pixels += first * bands->dstpitch;
+	info.s_height = last - first;
+	info.d_height = last - first;
+	bands->blit(&info);
+}
+
+/* Run a blit split into row bands, one per thread */
+static void SDL_RunBandedBlit(SDL_loblit RunBlit, SDL_BlitInfo *info,
+                              int srcpitch, int dstpitch)
+{
+	SDL_BlitBands bands;
+	int threads;
+
+	bands.blit = RunBlit;
+	bands.info = info;
+	bands.srcpitch = srcpitch;
+	bands.dstpitch = dstpitch;
+	threads = SDL_BlitPool.threads;
+	SDL_ParallelFor(info->d_height, (info->d_height+threads-1) / threads,
+	                SDL_RunBlitBand, &bands);
+}
+
 /* The general purpose software blit routine */
 static int SDL_SoftBlit(SDL_Surface *src, SDL_Rect *srcrect,
 			SDL_Surface *dst, SDL_Rect *dstrect)
@@ -105,7 +199,14 @@ static int SDL_SoftBlit(SDL_Surface *src, SDL_Rect *srcrect,
 		RunBlit = src->map->sw_data->blit;
 
 		/* Run the actual software blit */
-		RunBlit(&info);
+		if ( (SDL_BlitPool.threads > 1) && (src != dst) &&
+		     ((Uint32)info.d_width*info.d_height >=
+		      SDL_BlitPool.min_pixels) ) {
+			SDL_RunBandedBlit(RunBlit, &info,
+			                  src->pitch, dst->pitch);
+		} else {
+			RunBlit(&info);
+		}
 	}
 
 	/* We need to unlock the surfaces if they're locked */
@@ -55,6 +55,20 @@ struct private_swaccel {
 	void *aux_data;
 };
 
+/* A software blit mapping put aside for a destination that is not the
+   current one, so switching back to it doesn't rebuild anything */
+typedef struct SDL_CachedMap {
+	SDL_Surface *dst;
+	unsigned int format_version;
+	unsigned int last_used;
+	int identity;
+	Uint8 *table;
+	SDL_blit sw_blit;
+	struct private_swaccel sw_data;
+} SDL_CachedMap;
+
+#define SDL_MAP_CACHE_SIZE	4
+
 /* Blit mapping definition */
 typedef struct SDL_BlitMap {
 	SDL_Surface *dst;
@@ -68,11 +82,18 @@ typedef struct SDL_BlitMap {
 	/* the version count matches the destination; mismatch indicates
 	   an invalid mapping */
         unsigned int format_version;
+
+	/* recently used mappings to other destinations, least recently
+	   used entries are replaced first */
+	SDL_CachedMap cache[SDL_MAP_CACHE_SIZE];
+	unsigned int cache_clock;
 } SDL_BlitMap;
 
 
 /* Functions found in SDL_blit.c */
 extern int SDL_CalculateBlit(SDL_Surface *surface);
+extern void SDL_InitBlitThreads(void);
+extern void SDL_QuitBlitThreads(void);
 
 /* Functions found in SDL_blit_{0,1,N,A}.c */
 extern SDL_loblit SDL_CalculateBlit0(SDL_Surface *surface, int complex);
@@ -30,6 +30,8 @@ static char rcsid =
 #include "SDL_types.h"
 #include "SDL_video.h"
 #include "SDL_blit.h"
+#include "SDL_cpuinfo.h"
+#include "SDL_simd.h"
 
 #if defined(i386) && defined(__GNUC__) && defined(USE_ASMBLIT)
 #include "mmx.h"
@@ -1365,6 +1367,428 @@ static void BlitNtoNPixelAlpha(SDL_BlitInfo *info)
 }
 
 
+#ifdef SDL_SSE2_INTRINSICS
+/*
+ * SIMD alpha blitters.  They produce exactly the same pixels as the C
+ * versions above: every channel is blended as d + ((s - d) * alpha >> n)
+ * with the same truncation, and the same opaque/transparent special cases.
+ * Whole groups of fully transparent or fully opaque source pixels are
+ * skipped or copied without doing the multiply.
+ */
+
+/* one ARGB8888->(A)RGB8888 pixel, as in BlitRGBtoRGBPixelAlpha() */
+static __inline__ Uint32 BlendRGBPixelAlpha(Uint32 s, Uint32 d)
+{
+	Uint32 alpha = s >> 24;
+	Uint32 s1, d1;
+
+	if(alpha == SDL_ALPHA_OPAQUE)
+	    return (s & 0x00ffffff) | (d & 0xff000000);
+	s1 = s & 0xff00ff;
+	d1 = d & 0xff00ff;
+	d1 = (d1 + ((s1 - d1) * alpha >> 8)) & 0xff00ff;
+	s1 = s & 0xff00;
+	s = d & 0xff00;
+	s = (s + ((s1 - s) * alpha >> 8)) & 0xff00;
+	return d1 | s | (d & 0xff000000);
+}
+
+/* one RGB888->(A)RGB888 pixel, as in BlitRGBtoRGBSurfaceAlpha() */
+static __inline__ Uint32 BlendRGBSurfaceAlpha(Uint32 s, Uint32 d,
+					      unsigned alpha)
+{
+	Uint32 s1 = s & 0xff00ff;
+	Uint32 d1 = d & 0xff00ff;
+	d1 = (d1 + ((s1 - d1) * alpha >> 8)) & 0xff00ff;
+	s &= 0xff00;
+	d &= 0xff00;
+	d = (d + ((s - d) * alpha >> 8)) & 0xff00;
+	return d1 | d | 0xff000000;
+}
+
+/* one 16-bit pixel blended with a 5-bit alpha, gbits is 6 (565) or 5 (555) */
+static __inline__ Uint16 Blend16Alpha(Uint32 s, Uint32 d, int a, int gbits)
+{
+	int gmask = (1 << gbits) - 1;
+	int rshift = 5 + gbits;
+	int sR = s >> rshift & 0x1f, sG = s >> 5 & gmask, sB = s & 0x1f;
+	int dR = d >> rshift & 0x1f, dG = d >> 5 & gmask, dB = d & 0x1f;
+
+	dR += (sR - dR) * a >> 5;
+	dG += (sG - dG) * a >> 5;
+	dB += (sB - dB) * a >> 5;
+	return (Uint16)(dR << rshift | dG << 5 | dB);
+}
+
+/* convert an ARGB8888 pixel to 565 (gbits == 6) or 555 (gbits == 5) */
+#define ARGB_TO_16(s, gbits)						\
+	((((s) >> 19 & 0x1f) << (5 + (gbits)))				\
+	 | (((s) >> (16 - (gbits)) & ((1 << (gbits)) - 1)) << 5)		\
+	 | ((s) >> 3 & 0x1f))
+
+SDL_TARGETING("sse2")
+static void BlitRGBtoRGBPixelAlphaSSE2(SDL_BlitInfo *info)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint32 *srcp = (Uint32 *)info->s_pixels;
+	int srcskip = info->s_skip >> 2;
+	Uint32 *dstp = (Uint32 *)info->d_pixels;
+	int dstskip = info->d_skip >> 2;
+	__m128i zero = _mm_setzero_si128();
+	__m128i amask = _mm_set1_epi32(0xff000000);
+
+	while(height--) {
+	    int n;
+	    for(n = width; n >= 4; n -= 4) {
+		__m128i s = _mm_loadu_si128((__m128i *)srcp);
+		__m128i sa = _mm_and_si128(s, amask);
+		__m128i opaque = _mm_cmpeq_epi32(sa, amask);
+
+		if(_mm_movemask_epi8(_mm_cmpeq_epi32(sa, zero)) != 0xffff) {
+		    __m128i d = _mm_loadu_si128((__m128i *)dstp);
+		    __m128i r = s;
+		    if(_mm_movemask_epi8(opaque) != 0xffff) {
+			__m128i a, lo, hi;
+			a = _mm_srli_epi32(s, 24);
+			a = _mm_or_si128(a, _mm_slli_epi32(a, 16));
+			lo = _mm_sub_epi16(_mm_unpacklo_epi8(s, zero),
+					   _mm_unpacklo_epi8(d, zero));
+			hi = _mm_sub_epi16(_mm_unpackhi_epi8(s, zero),
+					   _mm_unpackhi_epi8(d, zero));
+			lo = _mm_mullo_epi16(lo, _mm_unpacklo_epi32(a, a));
+			hi = _mm_mullo_epi16(hi, _mm_unpackhi_epi32(a, a));
+			lo = _mm_srli_epi16(lo, 8);
+			hi = _mm_srli_epi16(hi, 8);
+			r = _mm_add_epi8(_mm_packus_epi16(lo, hi), d);
+			/* the >>8 blend can't reach 255, so copy opaque */
+			r = _mm_or_si128(_mm_and_si128(opaque, s),
+					 _mm_andnot_si128(opaque, r));
+		    }
+		    /* preserve the destination alpha */
+		    r = _mm_or_si128(_mm_andnot_si128(amask, r),
+				     _mm_and_si128(amask, d));
+		    _mm_storeu_si128((__m128i *)dstp, r);
+		}
+		srcp += 4;
+		dstp += 4;
+	    }
+	    while(n--) {
+		if(*srcp >> 24)
+		    *dstp = BlendRGBPixelAlpha(*srcp, *dstp);
+		++srcp;
+		++dstp;
+	    }
+	    srcp += srcskip;
+	    dstp += dstskip;
+	}
+}
+
+SDL_TARGETING("sse2")
+static void BlitRGBtoRGBSurfaceAlphaSSE2(SDL_BlitInfo *info)
+{
+	unsigned alpha = info->src->alpha;
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint32 *srcp = (Uint32 *)info->s_pixels;
+	int srcskip = info->s_skip >> 2;
+	Uint32 *dstp = (Uint32 *)info->d_pixels;
+	int dstskip = info->d_skip >> 2;
+	__m128i zero = _mm_setzero_si128();
+	__m128i amask = _mm_set1_epi32(0xff000000);
+	__m128i a = _mm_set1_epi16(alpha);
+
+	while(height--) {
+	    int n;
+	    for(n = width; n >= 4; n -= 4) {
+		__m128i s = _mm_loadu_si128((__m128i *)srcp);
+		__m128i d = _mm_loadu_si128((__m128i *)dstp);
+		__m128i lo, hi;
+		lo = _mm_sub_epi16(_mm_unpacklo_epi8(s, zero),
+				   _mm_unpacklo_epi8(d, zero));
+		hi = _mm_sub_epi16(_mm_unpackhi_epi8(s, zero),
+				   _mm_unpackhi_epi8(d, zero));
+		lo = _mm_srli_epi16(_mm_mullo_epi16(lo, a), 8);
+		hi = _mm_srli_epi16(_mm_mullo_epi16(hi, a), 8);
+		d = _mm_add_epi8(_mm_packus_epi16(lo, hi), d);
+		_mm_storeu_si128((__m128i *)dstp, _mm_or_si128(d, amask));
+		srcp += 4;
+		dstp += 4;
+	    }
+	    while(n--) {
+		*dstp = BlendRGBSurfaceAlpha(*srcp, *dstp, alpha);
+		++srcp;
+		++dstp;
+	    }
+	    srcp += srcskip;
+	    dstp += dstskip;
+	}
+}
+
+/* blend 8 pixels of 16-bit channels with 5-bit alphas */
+SDL_TARGETING("sse2")
+static __inline__ __m128i Blend16x8SSE2(__m128i s, __m128i d, __m128i a)
+{
+	__m128i t = _mm_mullo_epi16(_mm_sub_epi16(s, d), a);
+	return _mm_add_epi16(d, _mm_srai_epi16(t, 5));
+}
+
+/* blend 8 RGB565 (gbits == 6) or RGB555 (gbits == 5) pixels */
+SDL_TARGETING("sse2")
+static __inline__ __m128i Blend16to16SSE2(__m128i s, __m128i d, __m128i a,
+					  __m128i rshift, __m128i gmask)
+{
+	__m128i bmask = _mm_set1_epi16(0x1f);
+	__m128i r, g, b;
+
+	r = Blend16x8SSE2(_mm_and_si128(_mm_srl_epi16(s, rshift), bmask),
+			  _mm_and_si128(_mm_srl_epi16(d, rshift), bmask), a);
+	g = Blend16x8SSE2(_mm_and_si128(_mm_srli_epi16(s, 5), gmask),
+			  _mm_and_si128(_mm_srli_epi16(d, 5), gmask), a);
+	b = Blend16x8SSE2(_mm_and_si128(s, bmask), _mm_and_si128(d, bmask), a);
+	return _mm_or_si128(_mm_or_si128(_mm_sll_epi16(r, rshift),
+					 _mm_slli_epi16(g, 5)), b);
+}
+
+/* convert 8 ARGB8888 pixels to 565 (gbits == 6) or 555 (gbits == 5) */
+SDL_TARGETING("sse2")
+static __inline__ __m128i ARGBto16SSE2(__m128i s0, __m128i s1,
+				       __m128i rshift, __m128i gshift,
+				       __m128i gmask)
+{
+	__m128i bmask = _mm_set1_epi32(0x1f);
+	__m128i r, g, b;
+
+	r = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(s0, 19), bmask),
+			    _mm_and_si128(_mm_srli_epi32(s1, 19), bmask));
+	g = _mm_packs_epi32(_mm_and_si128(_mm_srl_epi32(s0, gshift), gmask),
+			    _mm_and_si128(_mm_srl_epi32(s1, gshift), gmask));
+	b = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(s0, 3), bmask),
+			    _mm_and_si128(_mm_srli_epi32(s1, 3), bmask));
+	return _mm_or_si128(_mm_or_si128(_mm_sll_epi16(r, rshift),
+					 _mm_slli_epi16(g, 5)), b);
+}
+
+SDL_TARGETING("sse2")
+static void BlitARGBto16PixelAlphaSSE2(SDL_BlitInfo *info, int gbits)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint32 *srcp = (Uint32 *)info->s_pixels;
+	int srcskip = info->s_skip >> 2;
+	Uint16 *dstp = (Uint16 *)info->d_pixels;
+	int dstskip = info->d_skip >> 1;
+	__m128i zero = _mm_setzero_si128();
+	__m128i full = _mm_set1_epi16(SDL_ALPHA_OPAQUE >> 3);
+	__m128i rshift = _mm_cvtsi32_si128(5 + gbits);
+	__m128i gshift = _mm_cvtsi32_si128(16 - gbits);
+	__m128i gmask = _mm_set1_epi16((1 << gbits) - 1);
+	__m128i gmask32 = _mm_set1_epi32((1 << gbits) - 1);
+
+	while(height--) {
+	    int n;
+	    for(n = width; n >= 8; n -= 8) {
+		__m128i s0 = _mm_loadu_si128((__m128i *)srcp);
+		__m128i s1 = _mm_loadu_si128((__m128i *)(srcp + 4));
+		__m128i a = _mm_packs_epi32(_mm_srli_epi32(s0, 27),
+					    _mm_srli_epi32(s1, 27));
+		__m128i clear = _mm_cmpeq_epi16(a, zero);
+		__m128i opaque = _mm_cmpeq_epi16(a, full);
+
+		if(_mm_movemask_epi8(clear) != 0xffff) {
+		    __m128i s = ARGBto16SSE2(s0, s1, rshift, gshift, gmask32);
+		    if(_mm_movemask_epi8(opaque) != 0xffff) {
+			__m128i d = _mm_loadu_si128((__m128i *)dstp);
+			__m128i r = Blend16to16SSE2(s, d, a, rshift, gmask);
+			s = _mm_or_si128(_mm_and_si128(opaque, s),
+					 _mm_andnot_si128(opaque, r));
+			s = _mm_or_si128(_mm_and_si128(clear, d),
+					 _mm_andnot_si128(clear, s));
+		    }
+		    _mm_storeu_si128((__m128i *)dstp, s);
+		}
+		srcp += 8;
+		dstp += 8;
+	    }
+	    while(n--) {
+		Uint32 s = *srcp;
+		unsigned alpha = s >> 27; /* downscale alpha to 5 bits */
+		if(alpha == (SDL_ALPHA_OPAQUE >> 3))
+		    *dstp = ARGB_TO_16(s, gbits);
+		else if(alpha)
+		    *dstp = Blend16Alpha(ARGB_TO_16(s, gbits), *dstp,
+					 alpha, gbits);
+		++srcp;
+		++dstp;
+	    }
+	    srcp += srcskip;
+	    dstp += dstskip;
+	}
+}
+
+static void BlitARGBto565PixelAlphaSSE2(SDL_BlitInfo *info)
+{
+	BlitARGBto16PixelAlphaSSE2(info, 6);
+}
+
+static void BlitARGBto555PixelAlphaSSE2(SDL_BlitInfo *info)
+{
+	BlitARGBto16PixelAlphaSSE2(info, 5);
+}
+
+SDL_TARGETING("sse2")
+static void Blit16to16SurfaceAlphaSSE2(SDL_BlitInfo *info, int gbits)
+{
+	unsigned alpha = info->src->alpha >> 3; /* downscale alpha to 5 bits */
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint16 *srcp = (Uint16 *)info->s_pixels;
+	int srcskip = info->s_skip >> 1;
+	Uint16 *dstp = (Uint16 *)info->d_pixels;
+	int dstskip = info->d_skip >> 1;
+	__m128i a = _mm_set1_epi16(alpha);
+	__m128i rshift = _mm_cvtsi32_si128(5 + gbits);
+	__m128i gmask = _mm_set1_epi16((1 << gbits) - 1);
+
+	/* The C 50% case carries the unused 555 top bit into red */
+	if(gbits == 5 && info->src->alpha == 128) {
+	    Blit16to16SurfaceAlpha128(info, 0xfbde);
+	    return;
+	}
+	while(height--) {
+	    int n;
+	    for(n = width; n >= 8; n -= 8) {
+		__m128i s = _mm_loadu_si128((__m128i *)srcp);
+		__m128i d = _mm_loadu_si128((__m128i *)dstp);
+		d = Blend16to16SSE2(s, d, a, rshift, gmask);
+		_mm_storeu_si128((__m128i *)dstp, d);
+		srcp += 8;
+		dstp += 8;
+	    }
+	    while(n--) {
+		*dstp = Blend16Alpha(*srcp, *dstp, alpha, gbits);
+		++srcp;
+		++dstp;
+	    }
+	    srcp += srcskip;
+	    dstp += dstskip;
+	}
+}
+
+static void Blit565to565SurfaceAlphaSSE2(SDL_BlitInfo *info)
+{
+	Blit16to16SurfaceAlphaSSE2(info, 6);
+}
+
+static void Blit555to555SurfaceAlphaSSE2(SDL_BlitInfo *info)
+{
+	Blit16to16SurfaceAlphaSSE2(info, 5);
+}
+#endif /* SDL_SSE2_INTRINSICS */
+
+#ifdef SDL_AVX2_INTRINSICS
+/* AVX2 versions of the 32-bit blitters, working on 8 pixels at a time */
+SDL_TARGETING("avx2")
+static void BlitRGBtoRGBPixelAlphaAVX2(SDL_BlitInfo *info)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint32 *srcp = (Uint32 *)info->s_pixels;
+	int srcskip = info->s_skip >> 2;
+	Uint32 *dstp = (Uint32 *)info->d_pixels;
+	int dstskip = info->d_skip >> 2;
+	__m256i zero = _mm256_setzero_si256();
+	__m256i amask = _mm256_set1_epi32(0xff000000);
+
+	while(height--) {
+	    int n;
+	    for(n = width; n >= 8; n -= 8) {
+		__m256i s = _mm256_loadu_si256((__m256i *)srcp);
+		__m256i sa = _mm256_and_si256(s, amask);
+		__m256i opaque = _mm256_cmpeq_epi32(sa, amask);
+
+		if(_mm256_movemask_epi8(_mm256_cmpeq_epi32(sa, zero)) != -1) {
+		    __m256i d = _mm256_loadu_si256((__m256i *)dstp);
+		    __m256i r = s;
+		    if(_mm256_movemask_epi8(opaque) != -1) {
+			__m256i a, lo, hi;
+			a = _mm256_srli_epi32(s, 24);
+			a = _mm256_or_si256(a, _mm256_slli_epi32(a, 16));
+			lo = _mm256_sub_epi16(_mm256_unpacklo_epi8(s, zero),
+					      _mm256_unpacklo_epi8(d, zero));
+			hi = _mm256_sub_epi16(_mm256_unpackhi_epi8(s, zero),
+					      _mm256_unpackhi_epi8(d, zero));
+			lo = _mm256_mullo_epi16(lo,
+					_mm256_unpacklo_epi32(a, a));
+			hi = _mm256_mullo_epi16(hi,
+					_mm256_unpackhi_epi32(a, a));
+			lo = _mm256_srli_epi16(lo, 8);
+			hi = _mm256_srli_epi16(hi, 8);
+			r = _mm256_add_epi8(_mm256_packus_epi16(lo, hi), d);
+			r = _mm256_blendv_epi8(r, s, opaque);
+		    }
+		    r = _mm256_blendv_epi8(r, d, amask);
+		    _mm256_storeu_si256((__m256i *)dstp, r);
+		}
+		srcp += 8;
+		dstp += 8;
+	    }
+	    while(n--) {
+		if(*srcp >> 24)
+		    *dstp = BlendRGBPixelAlpha(*srcp, *dstp);
+		++srcp;
+		++dstp;
+	    }
+	    srcp += srcskip;
+	    dstp += dstskip;
+	}
+	_mm256_zeroupper();
+}
+
+SDL_TARGETING("avx2")
+static void BlitRGBtoRGBSurfaceAlphaAVX2(SDL_BlitInfo *info)
+{
+	unsigned alpha = info->src->alpha;
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint32 *srcp = (Uint32 *)info->s_pixels;
+	int srcskip = info->s_skip >> 2;
+	Uint32 *dstp = (Uint32 *)info->d_pixels;
+	int dstskip = info->d_skip >> 2;
+	__m256i zero = _mm256_setzero_si256();
+	__m256i amask = _mm256_set1_epi32(0xff000000);
+	__m256i a = _mm256_set1_epi16(alpha);
+
+	while(height--) {
+	    int n;
+	    for(n = width; n >= 8; n -= 8) {
+		__m256i s = _mm256_loadu_si256((__m256i *)srcp);
+		__m256i d = _mm256_loadu_si256((__m256i *)dstp);
+		__m256i lo, hi;
+		lo = _mm256_sub_epi16(_mm256_unpacklo_epi8(s, zero),
+				      _mm256_unpacklo_epi8(d, zero));
+		hi = _mm256_sub_epi16(_mm256_unpackhi_epi8(s, zero),
+				      _mm256_unpackhi_epi8(d, zero));
+		lo = _mm256_srli_epi16(_mm256_mullo_epi16(lo, a), 8);
+		hi = _mm256_srli_epi16(_mm256_mullo_epi16(hi, a), 8);
+		d = _mm256_add_epi8(_mm256_packus_epi16(lo, hi), d);
+		_mm256_storeu_si256((__m256i *)dstp,
+				    _mm256_or_si256(d, amask));
+		srcp += 8;
+		dstp += 8;
+	    }
+	    while(n--) {
+		*dstp = BlendRGBSurfaceAlpha(*srcp, *dstp, alpha);
+		++srcp;
+		++dstp;
+	    }
+	    srcp += srcskip;
+	    dstp += dstskip;
+	}
+	_mm256_zeroupper();
+}
+#endif /* SDL_AVX2_INTRINSICS */
+
 SDL_loblit SDL_CalculateAlphaBlit(SDL_Surface *surface, int blit_index)
 {
     SDL_PixelFormat *sf = surface->format;
@@ -1386,6 +1810,10 @@ SDL_loblit SDL_CalculateAlphaBlit(SDL_Surface *surface, int blit_index)
 		if(surface->map->identity) {
 		    if(df->Gmask == 0x7e0)
 		    {
+#ifdef SDL_SSE2_INTRINSICS
+		if(SDL_HasSSE2())
+			return Blit565to565SurfaceAlphaSSE2;
+#endif
 #if defined(i386) && defined(__GNUC__) && defined(USE_ASMBLIT)
 		if((CPU_Flags()&MMX_CPU)!=0)
 			return Blit565to565SurfaceAlphaMMX;
@@ -1395,6 +1823,10 @@ SDL_loblit SDL_CalculateAlphaBlit(SDL_Surface *surface, int blit_index)
 		    }
 		    else if(df->Gmask == 0x3e0)
 		    {
+#ifdef SDL_SSE2_INTRINSICS
+		if(SDL_HasSSE2())
+			return Blit555to555SurfaceAlphaSSE2;
+#endif
 #if defined(i386) && defined(__GNUC__) && defined(USE_ASMBLIT)
 		if((CPU_Flags()&MMX_CPU)!=0)
 			return Blit555to555SurfaceAlphaMMX;
@@ -1412,6 +1844,14 @@ SDL_loblit SDL_CalculateAlphaBlit(SDL_Surface *surface, int blit_index)
 		   && (sf->Rmask | sf->Gmask | sf->Bmask) == 0xffffff
 		   && sf->BytesPerPixel == 4)
 		{
+#ifdef SDL_AVX2_INTRINSICS
+		if(SDL_HasAVX2())
+		    return BlitRGBtoRGBSurfaceAlphaAVX2;
+#endif
+#ifdef SDL_SSE2_INTRINSICS
+		if(SDL_HasSSE2())
+		    return BlitRGBtoRGBSurfaceAlphaSSE2;
+#endif
 #if defined(i386) && defined(__GNUC__) && defined(USE_ASMBLIT)
 		if((CPU_Flags()&MMX_CPU)!=0)
 		    return BlitRGBtoRGBSurfaceAlphaMMX;
@@ -1438,10 +1878,19 @@ SDL_loblit SDL_CalculateAlphaBlit(SDL_Surface *surface, int blit_index)
 	       && sf->Gmask == 0xff00
 	       && ((sf->Rmask == 0xff && df->Rmask == 0x1f)
 		   || (sf->Bmask == 0xff && df->Bmask == 0x1f))) {
-		if(df->Gmask == 0x7e0)
+		if(df->Gmask == 0x7e0) {
+#ifdef SDL_SSE2_INTRINSICS
+		    if(SDL_HasSSE2())
+			return BlitARGBto565PixelAlphaSSE2;
+#endif
 		    return BlitARGBto565PixelAlpha;
-		else if(df->Gmask == 0x3e0)
+		} else if(df->Gmask == 0x3e0) {
+#ifdef SDL_SSE2_INTRINSICS
+		    if(SDL_HasSSE2())
+			return BlitARGBto555PixelAlphaSSE2;
+#endif
 		    return BlitARGBto555PixelAlpha;
+		}
 	    }
 	    return BlitNtoNPixelAlpha;
 
@@ -1454,6 +1903,16 @@ SDL_loblit SDL_CalculateAlphaBlit(SDL_Surface *surface, int blit_index)
 	    {
 #if defined(i386) && defined(__GNUC__) && defined(USE_ASMBLIT)
 		Uint32 f;
+#endif
+#ifdef SDL_AVX2_INTRINSICS
+		if(SDL_HasAVX2())
+		    return BlitRGBtoRGBPixelAlphaAVX2;
+#endif
+#ifdef SDL_SSE2_INTRINSICS
+		if(SDL_HasSSE2())
+		    return BlitRGBtoRGBPixelAlphaSSE2;
+#endif
+#if defined(i386) && defined(__GNUC__) && defined(USE_ASMBLIT)
 		f=CPU_Flags();
 		if((f&(TDNOW_CPU|MMX_CPU))==(TDNOW_CPU|MMX_CPU))
 		    return BlitRGBtoRGBPixelAlphaMMX3DNOW;
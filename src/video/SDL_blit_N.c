@@ -26,19 +26,46 @@ static char rcsid =
 #endif
 
 #include <stdio.h>
+#include <string.h>
 
 #include "SDL_types.h"
 #include "SDL_video.h"
 #include "SDL_blit.h"
 #include "SDL_byteorder.h"
+#include "SDL_cpuinfo.h"
+#include "SDL_simd.h"
 
 /* Function to check the CPU flags */
 #define MMX_CPU		0x800000
-#ifdef USE_ASMBLIT
-#define CPU_Flags()	Hermes_X86_CPU()
-#else
-#define CPU_Flags()	0L
-#endif
+#define SSE_CPU		0x2000000
+#define SSE2_CPU	0x4000000
+#define SSSE3_CPU	0x0000200
+#define AVX2_CPU	0x0000020
+static Uint32 CPU_Flags(void)
+{
+	static Uint32 cpu_flags = 0;
+	static int checked = 0;
+
+	if ( ! checked ) {
+		if ( SDL_HasMMX() ) {
+			cpu_flags |= MMX_CPU;
+		}
+		if ( SDL_HasSSE() ) {
+			cpu_flags |= SSE_CPU;
+		}
+		if ( SDL_HasSSE2() ) {
+			cpu_flags |= SSE2_CPU;
+		}
+		if ( SDL_HasSSSE3() ) {
+			cpu_flags |= SSSE3_CPU;
+		}
+		if ( SDL_HasAVX2() ) {
+			cpu_flags |= AVX2_CPU;
+		}
+		checked = 1;
+	}
+	return(cpu_flags);
+}
 
 /* Functions to blit from N-bit surfaces to other surfaces */
 
@@ -1023,6 +1050,331 @@ static void Blit_RGB565_BGRA8888(SDL_BlitInfo *info)
     Blit_RGB565_32(info, RGB565_BGRA8888_LUT);
 }
 
+#ifdef SDL_SSE2_INTRINSICS
+/* SIMD converters between formats with byte-sized source channels.
+   Every destination channel is computed as
+	((pixel >> (srcshift+dstloss)) & (0xFF>>dstloss)) << dstshift
+   which covers the 8888 <-> 8888 swizzles and 8888 -> 565/555 packing
+   with one set of kernels, selected at runtime by CPU_Flags().
+*/
+typedef struct {
+	int channels;		/* 3, or 4 when alpha is copied */
+	int rshift[4];		/* source shift + destination loss */
+	Uint32 mask[4];		/* 0xFF >> destination loss */
+	int lshift[4];		/* destination shift */
+	Uint8 soffset[4];	/* source byte offsets, for 24-bit pixels */
+	Uint8 doffset[4];	/* destination byte offsets */
+	Uint32 alpha;		/* constant alpha bits OR'ed into each pixel */
+} SIMD_Swizzle;
+
+static void SIMD_SetupSwizzle(SDL_BlitInfo *info, SIMD_Swizzle *sw)
+{
+	SDL_PixelFormat *srcfmt = info->src;
+	SDL_PixelFormat *dstfmt = info->dst;
+	Uint8 sshift[4], dloss[4], dshift[4];
+	int c;
+
+	sshift[0] = srcfmt->Rshift; dloss[0] = dstfmt->Rloss;
+	dshift[0] = dstfmt->Rshift;
+	sshift[1] = srcfmt->Gshift; dloss[1] = dstfmt->Gloss;
+	dshift[1] = dstfmt->Gshift;
+	sshift[2] = srcfmt->Bshift; dloss[2] = dstfmt->Bloss;
+	dshift[2] = dstfmt->Bshift;
+	sshift[3] = srcfmt->Ashift; dloss[3] = dstfmt->Aloss;
+	dshift[3] = dstfmt->Ashift;
+
+	sw->channels = 3;
+	sw->alpha = 0;
+	if ( dstfmt->Amask ) {
+		if ( srcfmt->Amask ) {
+			sw->channels = 4;
+		} else {
+			sw->alpha = ((Uint32)srcfmt->alpha >> dstfmt->Aloss)
+			            << dstfmt->Ashift;
+		}
+	}
+	for ( c=0; c<4; ++c ) {
+		sw->rshift[c] = sshift[c] + dloss[c];
+		sw->mask[c] = 0xFF >> dloss[c];
+		sw->lshift[c] = dshift[c];
+		sw->soffset[c] = sshift[c] / 8;
+		sw->doffset[c] = dshift[c] / 8;
+	}
+}
+
+static __inline__ Uint32 SIMD_SwizzlePixel(const SIMD_Swizzle *sw, Uint32 pixel)
+{
+	Uint32 out = sw->alpha;
+	int c;
+
+	for ( c=0; c<sw->channels; ++c ) {
+		out |= ((pixel >> sw->rshift[c]) & sw->mask[c]) << sw->lshift[c];
+	}
+	return(out);
+}
+
+SDL_TARGETING("sse2")
+static __inline__ __m128i SIMD_Swizzle4_SSE2(const SIMD_Swizzle *sw,
+				const __m128i *rs, const __m128i *ls,
+				const __m128i *ms, __m128i alpha, __m128i p)
+{
+	__m128i out = alpha;
+	int c;
+
+	for ( c=0; c<sw->channels; ++c ) {
+		__m128i v = _mm_and_si128(_mm_srl_epi32(p, rs[c]), ms[c]);
+		out = _mm_or_si128(out, _mm_sll_epi32(v, ls[c]));
+	}
+	return(out);
+}
+
+SDL_TARGETING("sse2")
+static void Blit8888toNSSE2(SDL_BlitInfo *info)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint32 *src = (Uint32 *)info->s_pixels;
+	int srcskip = info->s_skip/4;
+	Uint8 *dst = info->d_pixels;
+	int dstskip = info->d_skip;
+	int dstbpp = info->dst->BytesPerPixel;
+	SIMD_Swizzle sw;
+	__m128i rs[4], ls[4], ms[4], alpha;
+	int c;
+
+	SIMD_SetupSwizzle(info, &sw);
+	for ( c=0; c<4; ++c ) {
+		rs[c] = _mm_cvtsi32_si128(sw.rshift[c]);
+		ls[c] = _mm_cvtsi32_si128(sw.lshift[c]);
+		ms[c] = _mm_set1_epi32(sw.mask[c]);
+	}
+	alpha = _mm_set1_epi32(sw.alpha);
+
+	while ( height-- ) {
+		int n = width;
+
+		if ( dstbpp == 4 ) {
+			Uint32 *d = (Uint32 *)dst;
+			for ( ; n >= 4; n -= 4 ) {
+				__m128i p = _mm_loadu_si128((__m128i *)src);
+				p = SIMD_Swizzle4_SSE2(&sw, rs, ls, ms, alpha, p);
+				_mm_storeu_si128((__m128i *)d, p);
+				src += 4;
+				d += 4;
+			}
+			while ( n-- ) {
+				*d++ = SIMD_SwizzlePixel(&sw, *src++);
+			}
+			dst = (Uint8 *)d;
+		} else {
+			Uint16 *d = (Uint16 *)dst;
+			for ( ; n >= 8; n -= 8 ) {
+				__m128i lo = _mm_loadu_si128((__m128i *)src);
+				__m128i hi = _mm_loadu_si128((__m128i *)(src+4));
+				lo = SIMD_Swizzle4_SSE2(&sw, rs, ls, ms, alpha, lo);
+				hi = SIMD_Swizzle4_SSE2(&sw, rs, ls, ms, alpha, hi);
+				/* Sign extend so the saturating pack is exact */
+				lo = _mm_srai_epi32(_mm_slli_epi32(lo, 16), 16);
+				hi = _mm_srai_epi32(_mm_slli_epi32(hi, 16), 16);
+				_mm_storeu_si128((__m128i *)d,
+				                 _mm_packs_epi32(lo, hi));
+				src += 8;
+				d += 8;
+			}
+			while ( n-- ) {
+				*d++ = (Uint16)SIMD_SwizzlePixel(&sw, *src++);
+			}
+			dst = (Uint8 *)d;
+		}
+		src += srcskip;
+		dst += dstskip;
+	}
+}
+#endif /* SDL_SSE2_INTRINSICS */
+
+#ifdef SDL_AVX2_INTRINSICS
+SDL_TARGETING("avx2")
+static __inline__ __m256i SIMD_Swizzle8_AVX2(const SIMD_Swizzle *sw,
+				const __m128i *rs, const __m128i *ls,
+				const __m256i *ms, __m256i alpha, __m256i p)
+{
+	__m256i out = alpha;
+	int c;
+
+	for ( c=0; c<sw->channels; ++c ) {
+		__m256i v = _mm256_and_si256(_mm256_srl_epi32(p, rs[c]), ms[c]);
+		out = _mm256_or_si256(out, _mm256_sll_epi32(v, ls[c]));
+	}
+	return(out);
+}
+
+SDL_TARGETING("avx2")
+static void Blit8888toNAVX2(SDL_BlitInfo *info)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint32 *src = (Uint32 *)info->s_pixels;
+	int srcskip = info->s_skip/4;
+	Uint8 *dst = info->d_pixels;
+	int dstskip = info->d_skip;
+	int dstbpp = info->dst->BytesPerPixel;
+	SIMD_Swizzle sw;
+	__m128i rs[4], ls[4];
+	__m256i ms[4], alpha;
+	int c;
+
+	SIMD_SetupSwizzle(info, &sw);
+	for ( c=0; c<4; ++c ) {
+		rs[c] = _mm_cvtsi32_si128(sw.rshift[c]);
+		ls[c] = _mm_cvtsi32_si128(sw.lshift[c]);
+		ms[c] = _mm256_set1_epi32(sw.mask[c]);
+	}
+	alpha = _mm256_set1_epi32(sw.alpha);
+
+	while ( height-- ) {
+		int n = width;
+
+		if ( dstbpp == 4 ) {
+			Uint32 *d = (Uint32 *)dst;
+			for ( ; n >= 8; n -= 8 ) {
+				__m256i p = _mm256_loadu_si256((__m256i *)src);
+				p = SIMD_Swizzle8_AVX2(&sw, rs, ls, ms, alpha, p);
+				_mm256_storeu_si256((__m256i *)d, p);
+				src += 8;
+				d += 8;
+			}
+			while ( n-- ) {
+				*d++ = SIMD_SwizzlePixel(&sw, *src++);
+			}
+			dst = (Uint8 *)d;
+		} else {
+			Uint16 *d = (Uint16 *)dst;
+			for ( ; n >= 16; n -= 16 ) {
+				__m256i lo = _mm256_loadu_si256((__m256i *)src);
+				__m256i hi = _mm256_loadu_si256((__m256i *)(src+8));
+				lo = SIMD_Swizzle8_AVX2(&sw, rs, ls, ms, alpha, lo);
+				hi = SIMD_Swizzle8_AVX2(&sw, rs, ls, ms, alpha, hi);
+				lo = _mm256_srai_epi32(_mm256_slli_epi32(lo, 16), 16);
+				hi = _mm256_srai_epi32(_mm256_slli_epi32(hi, 16), 16);
+				/* The pack works per 128-bit lane, so reorder */
+				lo = _mm256_permute4x64_epi64(
+				           _mm256_packs_epi32(lo, hi), 0xD8);
+				_mm256_storeu_si256((__m256i *)d, lo);
+				src += 16;
+				d += 16;
+			}
+			while ( n-- ) {
+				*d++ = (Uint16)SIMD_SwizzlePixel(&sw, *src++);
+			}
+			dst = (Uint8 *)d;
+		}
+		src += srcskip;
+		dst += dstskip;
+	}
+	_mm256_zeroupper();
+}
+#endif /* SDL_AVX2_INTRINSICS */
+
+#ifdef SDL_SSSE3_INTRINSICS
+/* Packed 24-bit pixels need a byte shuffle, so they start at SSSE3 */
+SDL_TARGETING("ssse3")
+static void Blit24to32SSSE3(SDL_BlitInfo *info)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint8 *src = info->s_pixels;
+	int srcskip = info->s_skip;
+	Uint32 *dst = (Uint32 *)info->d_pixels;
+	int dstskip = info->d_skip/4;
+	SIMD_Swizzle sw;
+	Uint8 shuffle[16];
+	__m128i shuf, alpha;
+	int i, c;
+
+	SIMD_SetupSwizzle(info, &sw);
+	memset(shuffle, 0x80, sizeof(shuffle));
+	for ( i=0; i<4; ++i ) {
+		for ( c=0; c<3; ++c ) {
+			shuffle[i*4+sw.doffset[c]] = i*3+sw.soffset[c];
+		}
+	}
+	shuf = _mm_loadu_si128((__m128i *)shuffle);
+	alpha = _mm_set1_epi32(sw.alpha);
+
+	while ( height-- ) {
+		int n = width;
+
+		/* Each load reads 4 bytes past the 4 pixels it converts */
+		for ( ; n > 5; n -= 4 ) {
+			__m128i p = _mm_loadu_si128((__m128i *)src);
+			p = _mm_or_si128(_mm_shuffle_epi8(p, shuf), alpha);
+			_mm_storeu_si128((__m128i *)dst, p);
+			src += 12;
+			dst += 4;
+		}
+		while ( n-- ) {
+			Uint32 pixel = sw.alpha;
+			for ( c=0; c<3; ++c ) {
+				pixel |= (Uint32)src[sw.soffset[c]] << sw.lshift[c];
+			}
+			*dst++ = pixel;
+			src += 3;
+		}
+		src += srcskip;
+		dst += dstskip;
+	}
+}
+
+SDL_TARGETING("ssse3")
+static void Blit32to24SSSE3(SDL_BlitInfo *info)
+{
+	int width = info->d_width;
+	int height = info->d_height;
+	Uint8 *src = info->s_pixels;
+	int srcskip = info->s_skip;
+	Uint8 *dst = info->d_pixels;
+	int dstskip = info->d_skip;
+	SIMD_Swizzle sw;
+	Uint8 shuffle[16];
+	__m128i shuf;
+	Uint32 last;
+	int i, c;
+
+	SIMD_SetupSwizzle(info, &sw);
+	memset(shuffle, 0x80, sizeof(shuffle));
+	for ( i=0; i<4; ++i ) {
+		for ( c=0; c<3; ++c ) {
+			shuffle[i*3+sw.doffset[c]] = i*4+sw.soffset[c];
+		}
+	}
+	shuf = _mm_loadu_si128((__m128i *)shuffle);
+
+	while ( height-- ) {
+		int n = width;
+
+		for ( ; n >= 4; n -= 4 ) {
+			__m128i p = _mm_loadu_si128((__m128i *)src);
+			p = _mm_shuffle_epi8(p, shuf);
+			_mm_storel_epi64((__m128i *)dst, p);
+			/* The destination isn't aligned for a 32-bit store */
+			last = _mm_cvtsi128_si32(_mm_srli_si128(p, 8));
+			memcpy(dst+8, &last, 4);
+			src += 16;
+			dst += 12;
+		}
+		while ( n-- ) {
+			for ( c=0; c<3; ++c ) {
+				dst[sw.doffset[c]] = src[sw.soffset[c]];
+			}
+			src += 4;
+			dst += 3;
+		}
+		src += srcskip;
+		dst += dstskip;
+	}
+}
+#endif /* SDL_SSSE3_INTRINSICS */
+
 /* Special optimized blit for RGB 8-8-8 --> RGB 3-3-2 */
 #ifndef RGB888_RGB332
 #define RGB888_RGB332(dst, src) { \
@@ -1432,7 +1784,7 @@ struct blit_table {
 	Uint32 cpu_flags;
 	void *aux_data;
 	SDL_loblit blitfunc;
-        enum { NO_ALPHA, SET_ALPHA, COPY_ALPHA } alpha;
+        enum { NO_ALPHA, SET_ALPHA, COPY_ALPHA, ANY_ALPHA } alpha;
 };
 static const struct blit_table normal_blit_1[] = {
 	/* Default for 8-bit RGB source, an invalid combination */
@@ -1460,10 +1812,82 @@ static const struct blit_table normal_blit_2[] = {
     { 0,0,0, 0, 0,0,0, 0, NULL, BlitNtoN, 0 }
 };
 static const struct blit_table normal_blit_3[] = {
-	/* Default for 24-bit RGB source, never optimized */
+#ifdef SDL_SSSE3_INTRINSICS
+    { 0x00FF0000,0x0000FF00,0x000000FF, 4, 0x00FF0000,0x0000FF00,0x000000FF,
+      SSSE3_CPU, NULL, Blit24to32SSSE3, ANY_ALPHA },
+    { 0x00FF0000,0x0000FF00,0x000000FF, 4, 0x000000FF,0x0000FF00,0x00FF0000,
+      SSSE3_CPU, NULL, Blit24to32SSSE3, ANY_ALPHA },
+    { 0x000000FF,0x0000FF00,0x00FF0000, 4, 0x00FF0000,0x0000FF00,0x000000FF,
+      SSSE3_CPU, NULL, Blit24to32SSSE3, ANY_ALPHA },
+    { 0x000000FF,0x0000FF00,0x00FF0000, 4, 0x000000FF,0x0000FF00,0x00FF0000,
+      SSSE3_CPU, NULL, Blit24to32SSSE3, ANY_ALPHA },
+#endif
+	/* Default for 24-bit RGB source, used if no other blitter matches */
     { 0,0,0, 0, 0,0,0, 0, NULL, BlitNtoN, 0 }
 };
 static const struct blit_table normal_blit_4[] = {
+#ifdef SDL_AVX2_INTRINSICS
+    { 0x00FF0000,0x0000FF00,0x000000FF, 2, 0x0000F800,0x000007E0,0x0000001F,
+      AVX2_CPU, NULL, Blit8888toNAVX2, ANY_ALPHA },
+    { 0x00FF0000,0x0000FF00,0x000000FF, 2, 0x0000001F,0x000007E0,0x0000F800,
+      AVX2_CPU, NULL, Blit8888toNAVX2, ANY_ALPHA },
+    { 0x00FF0000,0x0000FF00,0x000000FF, 2, 0x00007C00,0x000003E0,0x0000001F,
+      AVX2_CPU, NULL, Blit8888toNAVX2, ANY_ALPHA },
+    { 0x00FF0000,0x0000FF00,0x000000FF, 2, 0x0000001F,0x000003E0,0x00007C00,
+      AVX2_CPU, NULL, Blit8888toNAVX2, ANY_ALPHA },
+    { 0x00FF0000,0x0000FF00,0x000000FF, 4, 0x00FF0000,0x0000FF00,0x000000FF,
+      AVX2_CPU, NULL, Blit8888toNAVX2, ANY_ALPHA },
+    { 0x00FF0000,0x0000FF00,0x000000FF, 4, 0x000000FF,0x0000FF00,0x00FF0000,
+      AVX2_CPU, NULL, Blit8888toNAVX2, ANY_ALPHA },
+    { 0x000000FF,0x0000FF00,0x00FF0000, 2, 0x0000F800,0x000007E0,0x0000001F,
+      AVX2_CPU, NULL, Blit8888toNAVX2, ANY_ALPHA },
+    { 0x000000FF,0x0000FF00,0x00FF0000, 2, 0x0000001F,0x000007E0,0x0000F800,
+      AVX2_CPU, NULL, Blit8888toNAVX2, ANY_ALPHA },
+    { 0x000000FF,0x0000FF00,0x00FF0000, 2, 0x00007C00,0x000003E0,0x0000001F,
+      AVX2_CPU, NULL, Blit8888toNAVX2, ANY_ALPHA },
+    { 0x000000FF,0x0000FF00,0x00FF0000, 2, 0x0000001F,0x000003E0,0x00007C00,
+      AVX2_CPU, NULL, Blit8888toNAVX2, ANY_ALPHA },
+    { 0x000000FF,0x0000FF00,0x00FF0000, 4, 0x00FF0000,0x0000FF00,0x000000FF,
+      AVX2_CPU, NULL, Blit8888toNAVX2, ANY_ALPHA },
+    { 0x000000FF,0x0000FF00,0x00FF0000, 4, 0x000000FF,0x0000FF00,0x00FF0000,
+      AVX2_CPU, NULL, Blit8888toNAVX2, ANY_ALPHA },
+#endif
+#ifdef SDL_SSE2_INTRINSICS
+    { 0x00FF0000,0x0000FF00,0x000000FF, 2, 0x0000F800,0x000007E0,0x0000001F,
+      SSE2_CPU, NULL, Blit8888toNSSE2, ANY_ALPHA },
+    { 0x00FF0000,0x0000FF00,0x000000FF, 2, 0x0000001F,0x000007E0,0x0000F800,
+      SSE2_CPU, NULL, Blit8888toNSSE2, ANY_ALPHA },
+    { 0x00FF0000,0x0000FF00,0x000000FF, 2, 0x00007C00,0x000003E0,0x0000001F,
+      SSE2_CPU, NULL, Blit8888toNSSE2, ANY_ALPHA },
+    { 0x00FF0000,0x0000FF00,0x000000FF, 2, 0x0000001F,0x000003E0,0x00007C00,
+      SSE2_CPU, NULL, Blit8888toNSSE2, ANY_ALPHA },
+    { 0x00FF0000,0x0000FF00,0x000000FF, 4, 0x00FF0000,0x0000FF00,0x000000FF,
+      SSE2_CPU, NULL, Blit8888toNSSE2, ANY_ALPHA },
+    { 0x00FF0000,0x0000FF00,0x000000FF, 4, 0x000000FF,0x0000FF00,0x00FF0000,
+      SSE2_CPU, NULL, Blit8888toNSSE2, ANY_ALPHA },
+    { 0x000000FF,0x0000FF00,0x00FF0000, 2, 0x0000F800,0x000007E0,0x0000001F,
+      SSE2_CPU, NULL, Blit8888toNSSE2, ANY_ALPHA },
+    { 0x000000FF,0x0000FF00,0x00FF0000, 2, 0x0000001F,0x000007E0,0x0000F800,
+      SSE2_CPU, NULL, Blit8888toNSSE2, ANY_ALPHA },
+    { 0x000000FF,0x0000FF00,0x00FF0000, 2, 0x00007C00,0x000003E0,0x0000001F,
+      SSE2_CPU, NULL, Blit8888toNSSE2, ANY_ALPHA },
+    { 0x000000FF,0x0000FF00,0x00FF0000, 2, 0x0000001F,0x000003E0,0x00007C00,
+      SSE2_CPU, NULL, Blit8888toNSSE2, ANY_ALPHA },
+    { 0x000000FF,0x0000FF00,0x00FF0000, 4, 0x00FF0000,0x0000FF00,0x000000FF,
+      SSE2_CPU, NULL, Blit8888toNSSE2, ANY_ALPHA },
+    { 0x000000FF,0x0000FF00,0x00FF0000, 4, 0x000000FF,0x0000FF00,0x00FF0000,
+      SSE2_CPU, NULL, Blit8888toNSSE2, ANY_ALPHA },
+#endif
+#ifdef SDL_SSSE3_INTRINSICS
+    { 0x00FF0000,0x0000FF00,0x000000FF, 3, 0x00FF0000,0x0000FF00,0x000000FF,
+      SSSE3_CPU, NULL, Blit32to24SSSE3, NO_ALPHA },
+    { 0x00FF0000,0x0000FF00,0x000000FF, 3, 0x000000FF,0x0000FF00,0x00FF0000,
+      SSSE3_CPU, NULL, Blit32to24SSSE3, NO_ALPHA },
+    { 0x000000FF,0x0000FF00,0x00FF0000, 3, 0x00FF0000,0x0000FF00,0x000000FF,
+      SSSE3_CPU, NULL, Blit32to24SSSE3, NO_ALPHA },
+    { 0x000000FF,0x0000FF00,0x00FF0000, 3, 0x000000FF,0x0000FF00,0x00FF0000,
+      SSSE3_CPU, NULL, Blit32to24SSSE3, NO_ALPHA },
+#endif
 #ifdef USE_ASMBLIT
     { 0x00FF0000,0x0000FF00,0x000000FF, 2, 0x0000F800,0x000007E0,0x0000001F,
       MMX_CPU, ConvertMMXpII32_16RGB565, ConvertMMX, NO_ALPHA },
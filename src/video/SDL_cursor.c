@@ -41,6 +41,7 @@ static char rcsid =
 #include "SDL_sysevents.h"
 #include "SDL_cursor_c.h"
 #include "SDL_pixels_c.h"
+#include "SDL_present_c.h"
 #include "default_cursor.h"
 
 /* These are static for our cursor handling code */
@@ -160,8 +161,10 @@ SDL_Cursor * SDL_CreateCursor (Uint8 *data, Uint8 *mask,
 
 	/* If the window manager gives us a good cursor, we're done! */
 	if ( video->CreateWMCursor ) {
+		SDL_LockPresent();
 		cursor->wm_cursor = video->CreateWMCursor(video, data, mask,
 							w, h, hot_x, hot_y);
+		SDL_UnlockPresent();
 	} else {
 		cursor->wm_cursor = NULL;
 	}
@@ -182,7 +185,11 @@ void SDL_SetCursor (SDL_Cursor *cursor)
 		return;
 	}
 
-	/* Prevent the event thread from moving the mouse */
+	/* Prevent the event thread from moving the mouse, and keep the
+	   present thread out of the driver while we draw the cursor.
+	   The present lock is always taken before the cursor lock.
+	 */
+	SDL_LockPresent();
 	SDL_LockCursor();
 
 	/* Set the new cursor */
@@ -231,6 +238,7 @@ void SDL_SetCursor (SDL_Cursor *cursor)
 		}
 	}
 	SDL_UnlockCursor();
+	SDL_UnlockPresent();
 }
 
 SDL_Cursor * SDL_GetCursor (void)
@@ -255,7 +263,9 @@ void SDL_FreeCursor (SDL_Cursor *cursor)
 				free(cursor->save[0]);
 			}
 			if ( video && cursor->wm_cursor ) {
+				SDL_LockPresent();
 				video->FreeWMCursor(this, cursor->wm_cursor);
+				SDL_UnlockPresent();
 			}
 			free(cursor);
 		}
@@ -281,7 +291,9 @@ int SDL_ShowCursor (int toggle)
 
 			SDL_SetCursor(NULL);
 			if ( video && video->CheckMouseMode ) {
+				SDL_LockPresent();
 				video->CheckMouseMode(this);
+				SDL_UnlockPresent();
 			}
 		}
 	} else {
@@ -306,11 +318,13 @@ void SDL_WarpMouse (Uint16 x, Uint16 y)
 	y += (this->screen->offset / this->screen->pitch);
 
 	/* This generates a mouse motion event */
+	SDL_LockPresent();
 	if ( video->WarpWMCursor ) {
 		video->WarpWMCursor(this, x, y);
 	} else {
 		SDL_PrivateMouseMotion(0, 0, x, y);
 	}
+	SDL_UnlockPresent();
 }
 
 void SDL_MoveCursor(int x, int y)
@@ -318,6 +332,7 @@ void SDL_MoveCursor(int x, int y)
 	SDL_VideoDevice *video = current_video;
 
 	/* Erase and update the current mouse position */
+	SDL_LockPresent();
 	if ( SHOULD_DRAWCURSOR(SDL_cursorstate) ) {
 		/* Erase and redraw mouse cursor in new position */
 		SDL_LockCursor();
@@ -329,6 +344,7 @@ void SDL_MoveCursor(int x, int y)
 	} else if ( video->MoveWMCursor ) {
 		video->MoveWMCursor(video, x, y);
 	}
+	SDL_UnlockPresent();
 }
 
 /* Keep track of the current cursor colors */
@@ -660,7 +676,9 @@ void SDL_DrawCursor(SDL_Surface *screen)
 
 		/* This can be called before a video mode is set */
 		if ( video->UpdateRects ) {
+			SDL_LockPresent();
 			video->UpdateRects(this, 1, &area);
+			SDL_UnlockPresent();
 		}
 	}
 }
@@ -732,7 +750,9 @@ void SDL_EraseCursor(SDL_Surface *screen)
 
 		SDL_MouseRect(&area);
 		if ( video->UpdateRects ) {
+			SDL_LockPresent();
 			video->UpdateRects(this, 1, &area);
+			SDL_UnlockPresent();
 		}
 	}
 }
@@ -37,6 +37,7 @@ static char rcsid =
 
 #include "SDL_error.h"
 #include "SDL_sysvideo.h"
+#include "SDL_present_c.h"
 
 #ifdef USE_MATH_H
 static void CalculateGammaRamp(float gamma, Uint16 *ramp)
@@ -114,7 +115,9 @@ int SDL_SetGamma(float red, float green, float blue)
 #endif
 	if ( (succeeded < 0) && video->SetGamma ) {
 		SDL_ClearError();
+		SDL_LockPresent();
 		succeeded = video->SetGamma(this, red, green, blue);
+		SDL_UnlockPresent();
 	}
 	return succeeded;
 }
@@ -196,7 +199,9 @@ int SDL_SetGammaRamp(const Uint16 *red, const Uint16 *green, const Uint16 *blue)
 	/* Try to set the gamma ramp in the driver */
 	succeeded = -1;
 	if ( video->SetGammaRamp ) {
+		SDL_LockPresent();
 		succeeded = video->SetGammaRamp(this, video->gamma);
+		SDL_UnlockPresent();
 	} else {
 		SDL_SetError("Gamma ramp manipulation not supported");
 	}
@@ -33,11 +33,18 @@ static char rcsid =
 
 #include "SDL_error.h"
 #include "SDL_endian.h"
+#include "SDL_mutex.h"
 #include "SDL_video.h"
 #include "SDL_sysvideo.h"
 #include "SDL_blit.h"
 #include "SDL_pixels_c.h"
 #include "SDL_RLEaccel_c.h"
+#include "SDL_atomic_c.h"
+
+#ifndef SDL_HAVE_ATOMICS
+static void SDL_LockPaletteLookups(void);
+static void SDL_UnlockPaletteLookups(void);
+#endif
 
 /* Helper functions */
 /*
@@ -228,6 +235,10 @@ SDL_PixelFormat *SDL_AllocFormat(int bpp,
 		format->Gmask = ((0xFF>>format->Gloss)<<format->Gshift);
 		format->Bmask = ((0xFF>>format->Bloss)<<format->Bshift);
 	}
+	if ( format->palette ) {
+		/* Look up colors in our palettes with a table */
+		SDL_InvalidatePaletteLookup(format->palette);
+	}
 	return(format);
 }
 SDL_PixelFormat *SDL_ReallocFormat(SDL_Surface *surface, int bpp,
@@ -235,19 +246,47 @@ SDL_PixelFormat *SDL_ReallocFormat(SDL_Surface *surface, int bpp,
 {
 	if ( surface->format ) {
 		SDL_FreeFormat(surface->format);
+		surface->format = NULL;
 		SDL_FormatChanged(surface);
 	}
 	surface->format = SDL_AllocFormat(bpp, Rmask, Gmask, Bmask, Amask);
 	return surface->format;
 }
 
+/*
+ * Format versions come from a single counter, so that a blit mapping
+ * to a freed surface can't match a new surface at the same address.
+ * Surfaces are created on any thread, so the counter is atomic.
+ */
+static volatile unsigned int SDL_format_serial = 0;
+
+unsigned int SDL_NewFormatVersion(void)
+{
+	unsigned int serial;
+
+#ifndef SDL_HAVE_ATOMICS
+	SDL_LockPaletteLookups();
+#endif
+	/* (unsigned int)-1 marks an invalid mapping */
+	do {
+		serial = SDL_AtomicAdd(&SDL_format_serial, 1) + 1;
+	} while ( serial == (unsigned int)-1 );
+#ifndef SDL_HAVE_ATOMICS
+	SDL_UnlockPaletteLookups();
+#endif
+	return(serial);
+}
+
 /*
  * Change any previous mappings from/to the new surface format
  */
 void SDL_FormatChanged(SDL_Surface *surface)
 {
-	surface->format_version++;
+	surface->format_version = SDL_NewFormatVersion();
 	SDL_InvalidateMap(surface->map);
+	if ( surface->format && surface->format->palette ) {
+		SDL_InvalidatePaletteLookup(surface->format->palette);
+	}
 }
 /*
  * Free a previously allocated format structure
@@ -259,6 +298,7 @@ void SDL_FreeFormat(SDL_PixelFormat *format)
 			if ( format->palette->colors ) {
 				free(format->palette->colors);
 			}
+			SDL_FreePaletteLookup(format->palette);
 			free(format->palette);
 		}
 		free(format);
@@ -314,7 +354,9 @@ Uint16 SDL_CalculatePitch(SDL_Surface *surface)
 /*
  * Match an RGB value to a particular palette index
  */
-Uint8 SDL_FindColor(SDL_Palette *pal, Uint8 r, Uint8 g, Uint8 b)
+/* Search the whole palette for the nearest color */
+static Uint8 SDL_FindColorExact(SDL_Color *colors, int ncolors,
+                                Uint8 r, Uint8 g, Uint8 b)
 {
 	/* Do colorspace distance matching */
 	unsigned int smallest;
@@ -324,10 +366,10 @@ Uint8 SDL_FindColor(SDL_Palette *pal, Uint8 r, Uint8 g, Uint8 b)
 	Uint8 pixel=0;
 		
 	smallest = ~0;
-	for ( i=0; i<pal->ncolors; ++i ) {
-		rd = pal->colors[i].r - r;
-		gd = pal->colors[i].g - g;
-		bd = pal->colors[i].b - b;
+	for ( i=0; i<ncolors; ++i ) {
+		rd = colors[i].r - r;
+		gd = colors[i].g - g;
+		bd = colors[i].b - b;
 		distance = (rd*rd)+(gd*gd)+(bd*bd);
 		if ( distance < smallest ) {
 			pixel = i;
@@ -340,6 +382,490 @@ Uint8 SDL_FindColor(SDL_Palette *pal, Uint8 r, Uint8 g, Uint8 b)
 	return(pixel);
 }
 
+/*
+ * Nearest color lookups in a palette.
+ *
+ * Color space is divided into 8x8x8 cells, and for each cell we keep
+ * the palette entries that can possibly be nearest to some color inside
+ * it: an entry is dropped only if its closest point in the cell is
+ * further away than the furthest point of some other entry.  Searching
+ * just those entries, in palette order, gives exactly the same answer
+ * as searching the whole palette.
+ *
+ * The palettes SDL allocates are kept in a hash table keyed by their
+ * address, so SDL_Palette doesn't change, and palettes that SDL didn't
+ * allocate simply search all their colors.  Each entry has a version,
+ * which SDL_SetPalette() and SDL_FormatChanged() bump when the colors
+ * change, and the lookup is rebuilt from the current colors the first
+ * time a color is looked up in a newer version.  Colors written straight
+ * into the palette after that aren't seen until SDL_SetColors() is
+ * called.
+ *
+ * Looking up a color takes no lock, only a count of the readers.  Entries
+ * and lookups are replaced or unlinked under the lock, and the old ones
+ * are freed once no reader is left that might still be using them.
+ *
+ * If the SDL_PALETTE_LOOKUP environment variable is "fast", colors are
+ * also looked up at 5-5-5 precision in a full table, which may pick a
+ * slightly different color than the full search.
+ */
+#define LOOKUP_CELL_BITS	3
+#define LOOKUP_CELL_SHIFT	(8-LOOKUP_CELL_BITS)
+#define LOOKUP_CELLS		(1<<(3*LOOKUP_CELL_BITS))
+#define LOOKUP_BUCKETS		64	/* Must be a power of two */
+#define LOOKUP_BUCKET(pal)	(((unsigned long)(pal) >> 4) & (LOOKUP_BUCKETS-1))
+
+struct SDL_PaletteLookup {
+	int version;
+	int ncolors;
+	SDL_Color colors[256];
+	Uint32 cell_start[LOOKUP_CELLS];
+	Uint16 cell_count[LOOKUP_CELLS];
+	Uint8 *entries;
+	Uint32 used;
+	Uint32 size;
+	Uint8 *fast;
+	struct SDL_PaletteLookup *retired;
+};
+
+typedef struct SDL_PaletteEntry {
+	SDL_Palette *palette;
+	volatile int version;
+	struct SDL_PaletteLookup * volatile lookup;
+	struct SDL_PaletteEntry * volatile next;
+	struct SDL_PaletteEntry *retired;
+} SDL_PaletteEntry;
+
+static SDL_PaletteEntry * volatile SDL_palette_buckets[LOOKUP_BUCKETS];
+static volatile int SDL_palette_readers = 0;
+static struct SDL_PaletteLookup * volatile SDL_retired_lookups = NULL;
+static SDL_PaletteEntry * volatile SDL_retired_entries = NULL;
+static SDL_mutex *SDL_palette_lock = NULL;
+static int SDL_fast_palette = -1;
+
+/* Squared distances along one axis from each color component to the
+   nearest and furthest points of each cell, so that building the cells
+   is just adding up three of them.
+ */
+#define LOOKUP_AXIS_CELLS	(1<<LOOKUP_CELL_BITS)
+
+typedef struct {
+	Uint16 near[3][LOOKUP_AXIS_CELLS][256];
+	Uint16 far[3][LOOKUP_AXIS_CELLS][256];
+} SDL_LookupDistances;
+
+static void SDL_MeasureLookupAxes(struct SDL_PaletteLookup *lookup,
+                                  SDL_LookupDistances *dist)
+{
+	int axis, cell, i, v, lo, hi;
+
+	for ( i=0; i<lookup->ncolors; ++i ) {
+		for ( axis=0; axis<3; ++axis ) {
+			switch (axis) {
+			    case 0: v = lookup->colors[i].r; break;
+			    case 1: v = lookup->colors[i].g; break;
+			    default: v = lookup->colors[i].b; break;
+			}
+			for ( cell=0; cell<LOOKUP_AXIS_CELLS; ++cell ) {
+				lo = (cell << LOOKUP_CELL_SHIFT);
+				hi = lo + (1<<LOOKUP_CELL_SHIFT) - 1;
+				if ( v < lo ) {
+					dist->near[axis][cell][i] = (lo-v)*(lo-v);
+					dist->far[axis][cell][i] = (hi-v)*(hi-v);
+				} else if ( v > hi ) {
+					dist->near[axis][cell][i] = (v-hi)*(v-hi);
+					dist->far[axis][cell][i] = (v-lo)*(v-lo);
+				} else {
+					dist->near[axis][cell][i] = 0;
+					if ( v-lo > hi-v ) {
+						dist->far[axis][cell][i] = (v-lo)*(v-lo);
+					} else {
+						dist->far[axis][cell][i] = (hi-v)*(hi-v);
+					}
+				}
+			}
+		}
+	}
+}
+
+static int SDL_BuildLookupCell(struct SDL_PaletteLookup *lookup,
+                               SDL_LookupDistances *dist, int cell)
+{
+	Uint16 *rnear, *gnear, *bnear;
+	Uint16 *rfar, *gfar, *bfar;
+	unsigned int far, nearest_far;
+	int i, count;
+
+	i = (cell >> (2*LOOKUP_CELL_BITS));
+	rnear = dist->near[0][i];
+	rfar = dist->far[0][i];
+	i = ((cell >> LOOKUP_CELL_BITS) & (LOOKUP_AXIS_CELLS-1));
+	gnear = dist->near[1][i];
+	gfar = dist->far[1][i];
+	i = (cell & (LOOKUP_AXIS_CELLS-1));
+	bnear = dist->near[2][i];
+	bfar = dist->far[2][i];
+
+	nearest_far = ~0;
+	for ( i=0; i<lookup->ncolors; ++i ) {
+		far = (unsigned int)rfar[i] + gfar[i] + bfar[i];
+		if ( far < nearest_far ) {
+			nearest_far = far;
+		}
+	}
+
+	if ( lookup->used + lookup->ncolors > lookup->size ) {
+		Uint32 size = lookup->size ? lookup->size*2 : 4096;
+		Uint8 *entries;
+
+		while ( lookup->used + lookup->ncolors > size ) {
+			size *= 2;
+		}
+		entries = (Uint8 *)realloc(lookup->entries, size);
+		if ( entries == NULL ) {
+			return(-1);
+		}
+		lookup->entries = entries;
+		lookup->size = size;
+	}
+	count = 0;
+	for ( i=0; i<lookup->ncolors; ++i ) {
+		if ( (unsigned int)rnear[i]+gnear[i]+bnear[i] <= nearest_far ) {
+			lookup->entries[lookup->used+count] = i;
+			++count;
+		}
+	}
+	lookup->cell_start[cell] = lookup->used;
+	lookup->cell_count[cell] = count;
+	lookup->used += count;
+	return(0);
+}
+
+static Uint8 SDL_LookupCell(struct SDL_PaletteLookup *lookup,
+                            Uint8 r, Uint8 g, Uint8 b)
+{
+	unsigned int smallest;
+	unsigned int distance;
+	int rd, gd, bd;
+	int cell, i, count;
+	Uint8 *entries;
+	Uint8 pixel=0;
+
+	cell = ((r >> LOOKUP_CELL_SHIFT) << (2*LOOKUP_CELL_BITS)) |
+	       ((g >> LOOKUP_CELL_SHIFT) << LOOKUP_CELL_BITS) |
+	        (b >> LOOKUP_CELL_SHIFT);
+	entries = lookup->entries + lookup->cell_start[cell];
+	count = lookup->cell_count[cell];
+
+	/* Same search as SDL_FindColorExact(), over the candidates only */
+	smallest = ~0;
+	for ( i=0; i<count; ++i ) {
+		SDL_Color *color = &lookup->colors[entries[i]];
+
+		rd = color->r - r;
+		gd = color->g - g;
+		bd = color->b - b;
+		distance = (rd*rd)+(gd*gd)+(bd*bd);
+		if ( distance < smallest ) {
+			pixel = entries[i];
+			if ( distance == 0 ) { /* Perfect match! */
+				break;
+			}
+			smallest = distance;
+		}
+	}
+	return(pixel);
+}
+
+static Uint8 SDL_LookupColor(struct SDL_PaletteLookup *lookup,
+                             Uint8 r, Uint8 g, Uint8 b)
+{
+	if ( lookup->fast ) {
+		return(lookup->fast[((r>>3)<<10)|((g>>3)<<5)|(b>>3)]);
+	}
+	return(SDL_LookupCell(lookup, r, g, b));
+}
+
+static void SDL_DestroyPaletteLookup(struct SDL_PaletteLookup *lookup)
+{
+	if ( lookup ) {
+		if ( lookup->entries ) {
+			free(lookup->entries);
+		}
+		if ( lookup->fast ) {
+			free(lookup->fast);
+		}
+		free(lookup);
+	}
+}
+
+static struct SDL_PaletteLookup *SDL_CreatePaletteLookup(SDL_Palette *pal,
+                                                         int version)
+{
+	struct SDL_PaletteLookup *lookup;
+	SDL_LookupDistances *dist;
+	int i;
+
+	lookup = (struct SDL_PaletteLookup *)malloc(sizeof(*lookup));
+	if ( lookup == NULL ) {
+		return(NULL);
+	}
+	lookup->version = version;
+	lookup->ncolors = pal->ncolors;
+	memcpy(lookup->colors, pal->colors, pal->ncolors*sizeof(SDL_Color));
+	lookup->entries = NULL;
+	lookup->used = 0;
+	lookup->size = 0;
+	lookup->fast = NULL;
+	dist = (SDL_LookupDistances *)malloc(sizeof(*dist));
+	if ( dist == NULL ) {
+		SDL_DestroyPaletteLookup(lookup);
+		return(NULL);
+	}
+	SDL_MeasureLookupAxes(lookup, dist);
+	for ( i=0; i<LOOKUP_CELLS; ++i ) {
+		if ( SDL_BuildLookupCell(lookup, dist, i) < 0 ) {
+			free(dist);
+			SDL_DestroyPaletteLookup(lookup);
+			return(NULL);
+		}
+	}
+	free(dist);
+
+	if ( SDL_fast_palette < 0 ) {
+		const char *variable = getenv("SDL_PALETTE_LOOKUP");
+		SDL_fast_palette = (variable && strcmp(variable, "fast") == 0);
+	}
+	if ( SDL_fast_palette ) {
+		Uint8 *fast = (Uint8 *)malloc(32768);
+
+		/* Use the color at the center of each 5-5-5 box */
+		for ( i=0; fast && (i<32768); ++i ) {
+			fast[i] = SDL_LookupCell(lookup,
+			                         ((i >> 7) & 0xF8) | 0x04,
+			                         ((i >> 2) & 0xF8) | 0x04,
+			                         ((i << 3) & 0xF8) | 0x04);
+		}
+		lookup->fast = fast;
+	}
+	return(lookup);
+}
+
+static void SDL_LockPaletteLookups(void)
+{
+	SDL_mutex *lock;
+
+	/* The lock is made by the first one to need it, and kept */
+	lock = SDL_palette_lock;
+	if ( lock == NULL ) {
+		lock = SDL_CreateMutex();
+		if ( lock && !SDL_AtomicCASPtr(&SDL_palette_lock, NULL, lock) ) {
+			SDL_DestroyMutex(lock);
+			lock = SDL_palette_lock;
+		}
+	}
+	if ( lock ) {
+		SDL_mutexP(lock);
+	}
+}
+
+static void SDL_UnlockPaletteLookups(void)
+{
+	if ( SDL_palette_lock ) {
+		SDL_mutexV(SDL_palette_lock);
+	}
+}
+
+/* Free what has been replaced or unlinked, if nobody can be reading it.
+   This is called with the lock held.
+ */
+static void SDL_ReclaimPaletteLookups(void)
+{
+	struct SDL_PaletteLookup *lookup;
+	SDL_PaletteEntry *entry;
+
+	SDL_MemoryBarrier();
+	if ( SDL_palette_readers > 0 ) {
+		return;
+	}
+	while ( SDL_retired_lookups ) {
+		lookup = SDL_retired_lookups;
+		SDL_retired_lookups = lookup->retired;
+		SDL_DestroyPaletteLookup(lookup);
+	}
+	while ( SDL_retired_entries ) {
+		entry = SDL_retired_entries;
+		SDL_retired_entries = entry->retired;
+		SDL_DestroyPaletteLookup(entry->lookup);
+		free(entry);
+	}
+}
+
+/* Readers only count themselves, unless there are no atomic operations */
+static void SDL_EnterPaletteLookups(void)
+{
+#ifdef SDL_HAVE_ATOMICS
+	SDL_AtomicAdd(&SDL_palette_readers, 1);
+#else
+	SDL_LockPaletteLookups();
+#endif
+}
+
+static void SDL_LeavePaletteLookups(void)
+{
+#ifdef SDL_HAVE_ATOMICS
+	if ( (SDL_AtomicAdd(&SDL_palette_readers, -1) == 1) &&
+	     (SDL_retired_lookups || SDL_retired_entries) ) {
+		SDL_LockPaletteLookups();
+		SDL_ReclaimPaletteLookups();
+		SDL_UnlockPaletteLookups();
+	}
+#else
+	SDL_UnlockPaletteLookups();
+#endif
+}
+
+/* Find the entry of a palette, as a reader or with the lock held */
+static SDL_PaletteEntry *SDL_FindPaletteEntry(SDL_Palette *pal)
+{
+	SDL_PaletteEntry *entry;
+
+	entry = SDL_palette_buckets[LOOKUP_BUCKET(pal)];
+	while ( entry && (entry->palette != pal) ) {
+		entry = entry->next;
+	}
+	return(entry);
+}
+
+/* Note that the colors of a palette have changed, adding it to the table
+   if it isn't there yet.  The lookup is rebuilt when it's next used.
+ */
+void SDL_InvalidatePaletteLookup(SDL_Palette *pal)
+{
+	SDL_PaletteEntry *entry;
+	unsigned int bucket;
+
+	SDL_EnterPaletteLookups();
+	entry = SDL_FindPaletteEntry(pal);
+	if ( entry ) {
+		SDL_AtomicAdd(&entry->version, 1);
+	}
+	SDL_LeavePaletteLookups();
+	if ( entry ) {
+		return;
+	}
+
+	SDL_LockPaletteLookups();
+	entry = SDL_FindPaletteEntry(pal);
+	if ( entry ) {
+		SDL_AtomicAdd(&entry->version, 1);
+	} else {
+		entry = (SDL_PaletteEntry *)malloc(sizeof(*entry));
+		if ( entry ) {
+			bucket = LOOKUP_BUCKET(pal);
+			entry->palette = pal;
+			entry->version = 0;
+			entry->lookup = NULL;
+			entry->next = SDL_palette_buckets[bucket];
+			entry->retired = NULL;
+			SDL_MemoryBarrier();
+			SDL_palette_buckets[bucket] = entry;
+		}
+	}
+	SDL_UnlockPaletteLookups();
+}
+
+void SDL_FreePaletteLookup(SDL_Palette *pal)
+{
+	SDL_PaletteEntry *entry, *prev;
+	unsigned int bucket;
+
+	if ( SDL_palette_lock == NULL ) {
+		return;		/* No palette was ever added */
+	}
+	SDL_LockPaletteLookups();
+	bucket = LOOKUP_BUCKET(pal);
+	prev = NULL;
+	for ( entry = SDL_palette_buckets[bucket]; entry; entry = entry->next ) {
+		if ( entry->palette == pal ) {
+			/* Readers passing through keep following 'next' */
+			if ( prev ) {
+				prev->next = entry->next;
+			} else {
+				SDL_palette_buckets[bucket] = entry->next;
+			}
+			entry->retired = SDL_retired_entries;
+			SDL_retired_entries = entry;
+			break;
+		}
+		prev = entry;
+	}
+	SDL_ReclaimPaletteLookups();
+	SDL_UnlockPaletteLookups();
+}
+
+/* Get the lookup for the current colors of a palette, building it if it's
+   out of date, or return NULL if the palette has to be searched instead.
+   This must be called between SDL_EnterPaletteLookups() and
+   SDL_LeavePaletteLookups(), which keep the lookup from being freed.
+ */
+static struct SDL_PaletteLookup *SDL_GetPaletteLookup(SDL_Palette *pal)
+{
+	SDL_PaletteEntry *entry;
+	struct SDL_PaletteLookup *lookup, *old;
+	int version;
+
+	entry = SDL_FindPaletteEntry(pal);
+	if ( entry == NULL ) {
+		return(NULL);
+	}
+	version = entry->version;
+	lookup = entry->lookup;
+	if ( lookup && (lookup->version == version) &&
+	     (lookup->ncolors == pal->ncolors) ) {
+		return(lookup);
+	}
+	if ( (pal->ncolors <= 0) || (pal->ncolors > 256) ) {
+		return(NULL);
+	}
+
+	/* Only one thread builds it, the others wait for it */
+	SDL_LockPaletteLookups();
+	version = entry->version;
+	lookup = entry->lookup;
+	if ( !lookup || (lookup->version != version) ||
+	     (lookup->ncolors != pal->ncolors) ) {
+		lookup = SDL_CreatePaletteLookup(pal, version);
+		if ( lookup ) {
+			old = entry->lookup;
+			SDL_MemoryBarrier();
+			entry->lookup = lookup;
+			if ( old ) {
+				old->retired = SDL_retired_lookups;
+				SDL_retired_lookups = old;
+			}
+		}
+	}
+	SDL_UnlockPaletteLookups();
+	return(lookup);
+}
+
+Uint8 SDL_FindColor(SDL_Palette *pal, Uint8 r, Uint8 g, Uint8 b)
+{
+	struct SDL_PaletteLookup *lookup;
+	Uint8 pixel;
+
+	SDL_EnterPaletteLookups();
+	lookup = SDL_GetPaletteLookup(pal);
+	if ( lookup ) {
+		pixel = SDL_LookupColor(lookup, r, g, b);
+	} else {
+		pixel = SDL_FindColorExact(pal->colors, pal->ncolors, r, g, b);
+	}
+	SDL_LeavePaletteLookups();
+	return(pixel);
+}
+
 /* Find the opaque pixel value corresponding to an RGB triple */
 Uint32 SDL_MapRGB(SDL_PixelFormat *format, Uint8 r, Uint8 g, Uint8 b)
 {
@@ -435,6 +961,7 @@ void SDL_ApplyGamma(Uint16 *gamma, SDL_Color *colors, SDL_Color *output,
 static Uint8 *Map1to1(SDL_Palette *src, SDL_Palette *dst, int *identical)
 {
 	Uint8 *map;
+	struct SDL_PaletteLookup *lookup;
 	int i;
 
 	if ( identical ) {
@@ -453,10 +980,19 @@ static Uint8 *Map1to1(SDL_Palette *src, SDL_Palette *dst, int *identical)
 		SDL_OutOfMemory();
 		return(NULL);
 	}
+	SDL_EnterPaletteLookups();
+	lookup = SDL_GetPaletteLookup(dst);
 	for ( i=0; i<src->ncolors; ++i ) {
-		map[i] = SDL_FindColor(dst,
-			src->colors[i].r, src->colors[i].g, src->colors[i].b);
+		if ( lookup ) {
+			map[i] = SDL_LookupColor(lookup, src->colors[i].r,
+					src->colors[i].g, src->colors[i].b);
+		} else {
+			map[i] = SDL_FindColorExact(dst->colors, dst->ncolors,
+					src->colors[i].r, src->colors[i].g,
+					src->colors[i].b);
+		}
 	}
+	SDL_LeavePaletteLookups();
 	return(map);
 }
 /* Map from Palette to BitField */
@@ -520,8 +1056,18 @@ SDL_BlitMap *SDL_AllocBlitMap(void)
 	/* It's ready to go */
 	return(map);
 }
+static void SDL_FreeCachedMap(SDL_CachedMap *entry)
+{
+	entry->dst = NULL;
+	if ( entry->table ) {
+		free(entry->table);
+		entry->table = NULL;
+	}
+}
 void SDL_InvalidateMap(SDL_BlitMap *map)
 {
+	int i;
+
 	if ( ! map ) {
 		return;
 	}
@@ -531,6 +1077,91 @@ void SDL_InvalidateMap(SDL_BlitMap *map)
 		free(map->table);
 		map->table = NULL;
 	}
+
+	/* The cached mappings were made for the same source, drop them too */
+	for ( i=0; i<SDL_MAP_CACHE_SIZE; ++i ) {
+		SDL_FreeCachedMap(&map->cache[i]);
+	}
+}
+/*
+ * Put the current mapping of a surface aside for later reuse.
+ * Hardware accelerated and RLE mappings depend on per-destination state
+ * outside the map, so those are simply thrown away.
+ */
+static void SDL_SaveMap(SDL_Surface *src)
+{
+	SDL_BlitMap *map;
+	SDL_CachedMap *entry;
+	int i;
+
+	map = src->map;
+	if ( (map->dst == NULL) ||
+	     (map->format_version == (unsigned int)-1) ||
+	     (src->flags & (SDL_HWACCEL|SDL_RLEACCEL)) ) {
+		return;
+	}
+
+	/* Use a free slot, or the least recently used one */
+	entry = &map->cache[0];
+	for ( i=0; i<SDL_MAP_CACHE_SIZE; ++i ) {
+		if ( map->cache[i].dst == NULL ) {
+			entry = &map->cache[i];
+			break;
+		}
+		if ( map->cache[i].last_used < entry->last_used ) {
+			entry = &map->cache[i];
+		}
+	}
+	SDL_FreeCachedMap(entry);
+
+	entry->dst = map->dst;
+	entry->format_version = map->format_version;
+	entry->last_used = ++map->cache_clock;
+	entry->identity = map->identity;
+	entry->table = map->table;
+	entry->sw_blit = map->sw_blit;
+	entry->sw_data = *map->sw_data;
+
+	/* The table now belongs to the cache entry */
+	map->table = NULL;
+	map->dst = NULL;
+	map->format_version = (unsigned int)-1;
+}
+/*
+ * Make a cached mapping to 'dst' current again, if there is a valid one.
+ * Cached destinations may have been freed, so they are only compared
+ * against 'dst', never dereferenced.
+ */
+static int SDL_RestoreMap(SDL_Surface *src, SDL_Surface *dst)
+{
+	SDL_BlitMap *map;
+	SDL_CachedMap *entry;
+	int i;
+
+	map = src->map;
+	for ( i=0; i<SDL_MAP_CACHE_SIZE; ++i ) {
+		entry = &map->cache[i];
+		if ( entry->dst != dst ) {
+			continue;
+		}
+		if ( entry->format_version != dst->format_version ) {
+			SDL_FreeCachedMap(entry);
+			return(0);
+		}
+		map->dst = entry->dst;
+		map->format_version = entry->format_version;
+		map->identity = entry->identity;
+		map->table = entry->table;
+		map->sw_blit = entry->sw_blit;
+		*map->sw_data = entry->sw_data;
+		src->flags &= ~SDL_HWACCEL;
+
+		/* The table now belongs to the current mapping */
+		entry->table = NULL;
+		entry->dst = NULL;
+		return(1);
+	}
+	return(0);
 }
 int SDL_MapSurface (SDL_Surface *src, SDL_Surface *dst)
 {
@@ -538,12 +1169,25 @@ int SDL_MapSurface (SDL_Surface *src, SDL_Surface *dst)
 	SDL_PixelFormat *dstfmt;
 	SDL_BlitMap *map;
 
-	/* Clear out any previous mapping */
+	/* Keep the previous mapping around, if it can be reused */
 	map = src->map;
+	if ( map->dst != dst ) {
+		SDL_SaveMap(src);
+	}
 	if ( (src->flags & SDL_RLEACCEL) == SDL_RLEACCEL ) {
 		SDL_UnRLESurface(src, 1);
 	}
-	SDL_InvalidateMap(map);
+	if ( SDL_RestoreMap(src, dst) ) {
+		return(0);
+	}
+
+	/* Clear out any previous mapping */
+	map->dst = NULL;
+	map->format_version = (unsigned int)-1;
+	if ( map->table ) {
+		free(map->table);
+		map->table = NULL;
+	}
 
 	/* Figure out what kind of mapping we're doing */
 	map->identity = 0;
@@ -35,6 +35,7 @@ extern SDL_PixelFormat *SDL_AllocFormat(int bpp,
 extern SDL_PixelFormat *SDL_ReallocFormat(SDL_Surface *surface, int bpp,
 		Uint32 Rmask, Uint32 Gmask, Uint32 Bmask, Uint32 Amask);
 extern void SDL_FormatChanged(SDL_Surface *surface);
+extern unsigned int SDL_NewFormatVersion(void);
 extern void SDL_FreeFormat(SDL_PixelFormat *format);
 
 /* Blit mapping functions */
@@ -47,4 +48,6 @@ extern void SDL_FreeBlitMap(SDL_BlitMap *map);
 extern Uint16 SDL_CalculatePitch(SDL_Surface *surface);
 extern void SDL_DitherColors(SDL_Color *colors, int bpp);
 extern Uint8 SDL_FindColor(SDL_Palette *pal, Uint8 r, Uint8 g, Uint8 b);
+extern void SDL_InvalidatePaletteLookup(SDL_Palette *pal);
+extern void SDL_FreePaletteLookup(SDL_Palette *pal);
 extern void SDL_ApplyGamma(Uint16 *gamma, SDL_Color *colors, SDL_Color *output, int ncolors);
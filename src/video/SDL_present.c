@@ -0,0 +1,320 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997, 1998, 1999, 2000, 2001, 2002  Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the Free
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+
+#ifdef SAVE_RCSID
+static char rcsid =
+ "@(#) $Id$";
+#endif
+
+/* Asynchronous presentation of the shadow surface
+
+   When the display format differs from the format the application asked
+   for, SDL_Flip() has to convert the whole shadow surface before it can
+   update the screen, and the application waits for all of it.  In
+   asynchronous mode SDL_Flip() only copies the shadow surface into one
+   of a small ring of frames and returns, and a present thread converts
+   the frame and updates the screen.  The shadow surface is copied rather
+   than swapped so that its contents are unchanged after SDL_Flip(), as
+   applications expect.  If every frame is waiting to be presented,
+   SDL_Flip() blocks until the oldest one is done.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "SDL_error.h"
+#include "SDL_video.h"
+#include "SDL_thread.h"
+#include "SDL_mutex.h"
+#include "SDL_sysvideo.h"
+#include "SDL_pixels_c.h"
+#include "SDL_events_c.h"
+#include "SDL_present_c.h"
+
+#define MAX_PRESENT_FRAMES	4
+
+static struct {
+	SDL_Thread *thread;
+	SDL_mutex *lock;
+	SDL_sem *queued;	/* Frames waiting for the present thread */
+	SDL_sem *free;		/* Frames the application may fill */
+	SDL_Surface *frames[MAX_PRESENT_FRAMES];
+	int depth;
+	int head;		/* Next frame to present */
+	int tail;		/* Next frame to fill */
+	volatile int quit;
+} SDL_Presenter;
+
+static int SDL_PresentThread(void *unused)
+{
+	SDL_Surface *frame;
+	SDL_Rect rect;
+
+	for ( ; ; ) {
+		SDL_SemWait(SDL_Presenter.queued);
+		if ( SDL_Presenter.quit ) {
+			break;
+		}
+		frame = SDL_Presenter.frames[SDL_Presenter.head];
+
+		SDL_LockPresent();
+		if ( SDL_VideoSurface ) {
+			rect.x = 0;
+			rect.y = 0;
+			rect.w = frame->w;
+			rect.h = frame->h;
+			SDL_BlitShadow(frame, 1, &rect);
+			SDL_Flip(SDL_VideoSurface);
+		}
+		SDL_UnlockPresent();
+
+		/* The driver may have read OS events while updating */
+		SDL_WakeEventWaiters();
+
+		SDL_Presenter.head = (SDL_Presenter.head+1) % SDL_Presenter.depth;
+		SDL_SemPost(SDL_Presenter.free);
+	}
+	return(0);
+}
+
+static void SDL_FreeFrames(void)
+{
+	int i;
+
+	for ( i=0; i<MAX_PRESENT_FRAMES; ++i ) {
+		if ( SDL_Presenter.frames[i] ) {
+			SDL_FreeSurface(SDL_Presenter.frames[i]);
+			SDL_Presenter.frames[i] = NULL;
+		}
+	}
+}
+
+static void SDL_StopPresent(void)
+{
+	if ( SDL_Presenter.thread ) {
+		SDL_WaitPresent();
+		SDL_Presenter.quit = 1;
+		SDL_SemPost(SDL_Presenter.queued);
+		SDL_WaitThread(SDL_Presenter.thread, NULL);
+		SDL_Presenter.thread = NULL;
+		SDL_Presenter.quit = 0;
+	}
+	if ( SDL_Presenter.queued ) {
+		SDL_DestroySemaphore(SDL_Presenter.queued);
+		SDL_Presenter.queued = NULL;
+	}
+	if ( SDL_Presenter.free ) {
+		SDL_DestroySemaphore(SDL_Presenter.free);
+		SDL_Presenter.free = NULL;
+	}
+	SDL_FreeFrames();
+	SDL_Presenter.depth = 0;
+}
+
+int SDL_SetAsyncPresent(int frames)
+{
+	if ( frames > MAX_PRESENT_FRAMES ) {
+		frames = MAX_PRESENT_FRAMES;
+	}
+	if ( frames < 0 ) {
+		frames = 0;
+	}
+	if ( frames == SDL_Presenter.depth ) {
+		return(0);
+	}
+	SDL_StopPresent();
+	if ( frames == 0 ) {
+		return(0);
+	}
+
+	if ( ! SDL_Presenter.lock ) {
+		SDL_Presenter.lock = SDL_CreateMutex();
+		if ( ! SDL_Presenter.lock ) {
+			return(-1);
+		}
+	}
+	SDL_Presenter.queued = SDL_CreateSemaphore(0);
+	SDL_Presenter.free = SDL_CreateSemaphore(frames);
+	if ( !SDL_Presenter.queued || !SDL_Presenter.free ) {
+		SDL_StopPresent();
+		return(-1);
+	}
+	SDL_Presenter.depth = frames;
+	SDL_Presenter.head = 0;
+	SDL_Presenter.tail = 0;
+	SDL_Presenter.thread = SDL_CreateThread(SDL_PresentThread, NULL);
+	if ( ! SDL_Presenter.thread ) {
+		SDL_StopPresent();
+		return(-1);
+	}
+	return(0);
+}
+
+void SDL_WaitPresent(void)
+{
+	int i;
+
+	/* Once every frame is free, nothing is left to present */
+	if ( SDL_Presenter.thread ) {
+		for ( i=0; i<SDL_Presenter.depth; ++i ) {
+			SDL_SemWait(SDL_Presenter.free);
+		}
+		for ( i=0; i<SDL_Presenter.depth; ++i ) {
+			SDL_SemPost(SDL_Presenter.free);
+		}
+	}
+}
+
+int SDL_PresentActive(void)
+{
+	return(SDL_Presenter.thread != NULL);
+}
+
+/* The event thread lock is taken first, in the same order as the drivers
+   that lock the event thread from inside their update functions.
+*/
+void SDL_LockPresent(void)
+{
+	if ( SDL_Presenter.lock ) {
+		SDL_Lock_EventThread();
+		SDL_mutexP(SDL_Presenter.lock);
+	}
+}
+
+void SDL_UnlockPresent(void)
+{
+	if ( SDL_Presenter.lock ) {
+		SDL_mutexV(SDL_Presenter.lock);
+		SDL_Unlock_EventThread();
+	}
+}
+
+/* Get a frame matching the shadow surface, reusing the last one if we can */
+static SDL_Surface *SDL_GetFrame(SDL_Surface *shadow, SDL_Surface *frame)
+{
+	SDL_PixelFormat *fmt;
+
+	fmt = shadow->format;
+	if ( frame &&
+	     (frame->w == shadow->w) && (frame->h == shadow->h) &&
+	     (frame->format->BitsPerPixel == fmt->BitsPerPixel) &&
+	     (frame->format->Rmask == fmt->Rmask) &&
+	     (frame->format->Gmask == fmt->Gmask) &&
+	     (frame->format->Bmask == fmt->Bmask) ) {
+		return(frame);
+	}
+	if ( frame ) {
+		SDL_FreeSurface(frame);
+	}
+	return(SDL_CreateRGBSurface(SDL_SWSURFACE, shadow->w, shadow->h,
+			fmt->BitsPerPixel, fmt->Rmask, fmt->Gmask, fmt->Bmask, 0));
+}
+
+/* Give the frame the colors the shadow surface would be displayed with */
+static void SDL_CopyFramePalette(SDL_Surface *shadow, SDL_Surface *frame)
+{
+	SDL_VideoDevice *video = current_video;
+	SDL_Palette *pal;
+	SDL_Color *colors;
+	int ncolors;
+
+	pal = shadow->format->palette;
+	colors = pal->colors;
+	if ( !(SDL_VideoSurface->flags & SDL_HWPALETTE) ) {
+		/* simulated 8bpp, use correct physical palette */
+		if ( video->gammacols ) {
+			colors = video->gammacols;
+		} else if ( video->physpal ) {
+			colors = video->physpal->colors;
+		}
+	}
+	ncolors = pal->ncolors;
+	if ( ncolors > frame->format->palette->ncolors ) {
+		ncolors = frame->format->palette->ncolors;
+	}
+	if ( memcmp(frame->format->palette->colors, colors,
+	            ncolors*sizeof(*colors)) != 0 ) {
+		memcpy(frame->format->palette->colors, colors,
+		       ncolors*sizeof(*colors));
+		SDL_FormatChanged(frame);
+	}
+}
+
+int SDL_QueuePresent(SDL_Surface *shadow)
+{
+	SDL_Surface *frame;
+	Uint8 *src, *dst;
+	int row, len;
+
+	if ( ! SDL_Presenter.thread ) {
+		return(-1);
+	}
+
+	/* Wait for a free frame, the present thread may be behind */
+	SDL_SemWait(SDL_Presenter.free);
+	frame = SDL_GetFrame(shadow, SDL_Presenter.frames[SDL_Presenter.tail]);
+	SDL_Presenter.frames[SDL_Presenter.tail] = frame;
+	if ( ! frame ) {
+		SDL_SemPost(SDL_Presenter.free);
+		return(-1);
+	}
+	if ( shadow->format->palette ) {
+		SDL_CopyFramePalette(shadow, frame);
+	}
+
+	/* Copy the pixels, the shadow surface never needs locking */
+	src = (Uint8 *)shadow->pixels;
+	dst = (Uint8 *)frame->pixels;
+	len = shadow->w * shadow->format->BytesPerPixel;
+	if ( (len == shadow->pitch) && (len == frame->pitch) ) {
+		memcpy(dst, src, len*shadow->h);
+	} else {
+		for ( row=0; row<shadow->h; ++row ) {
+			memcpy(dst, src, len);
+			src += shadow->pitch;
+			dst += frame->pitch;
+		}
+	}
+
+	SDL_Presenter.tail = (SDL_Presenter.tail+1) % SDL_Presenter.depth;
+	SDL_SemPost(SDL_Presenter.queued);
+	return(0);
+}
+
+void SDL_InitPresent(void)
+{
+	const char *variable;
+
+	variable = getenv("SDL_ASYNC_PRESENT");
+	if ( variable ) {
+		SDL_SetAsyncPresent(atoi(variable));
+	}
+}
+
+void SDL_QuitPresent(void)
+{
+	SDL_StopPresent();
+	if ( SDL_Presenter.lock ) {
+		SDL_DestroyMutex(SDL_Presenter.lock);
+		SDL_Presenter.lock = NULL;
+	}
+}
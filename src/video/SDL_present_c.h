@@ -0,0 +1,51 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997, 1998, 1999, 2000, 2001, 2002  Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the Free
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+
+#ifdef SAVE_RCSID
+static char rcsid =
+ "@(#) $Id$";
+#endif
+
+/* Asynchronous presentation of the shadow surface (see SDL_present.c) */
+
+extern void SDL_InitPresent(void);
+extern void SDL_QuitPresent(void);
+
+/* Returns 0 if the shadow surface was queued for the present thread,
+   or -1 if it must be presented by the caller.
+*/
+extern int SDL_QueuePresent(SDL_Surface *shadow);
+
+/* Returns non-zero if SDL_Flip() of the shadow surface is asynchronous */
+extern int SDL_PresentActive(void);
+
+/* The present thread holds this lock while it talks to the video driver,
+   so anything else calling into the driver must hold it too.  It also
+   stops the event thread, if there is one.
+*/
+extern void SDL_LockPresent(void);
+extern void SDL_UnlockPresent(void);
+
+/* Copies the shadow surface (or a copy of it) to the video surface,
+   drawing the software cursor on top.  Implemented in SDL_video.c
+*/
+extern void SDL_BlitShadow(SDL_Surface *shadow, int numrects, SDL_Rect *rects);
@@ -31,105 +31,31 @@ static char rcsid =
    April 27, 2000 - Sam Lantinga
 */
 
+#include <stdlib.h>
+#include <string.h>
+
 #include "SDL_error.h"
 #include "SDL_video.h"
 #include "SDL_blit.h"
+#include "SDL_pixels_c.h"
+#include "SDL_stretch_c.h"
+#include "SDL_cpuinfo.h"
+#include "SDL_simd.h"
 
-/* This isn't ready for general consumption yet - it should be folded
-   into the general blitting mechanism.
+/* Nearest neighbour stretching between surfaces of the same depth copies
+   the pixels unchanged.  Everything else is done one row at a time: the
+   source row is unpacked to 8-bit ARGB, scaled horizontally, combined
+   with its neighbours vertically, and then packed into the destination
+   format by the normal software blitter for that conversion.
+   The working rows and the conversion to the destination format belong
+   to the call, so stretches between different surfaces may run on
+   different threads at the same time.  A source is only locked if it
+   must be, so one that needn't be can be read by several of them, but
+   each thread has to write to its own destination.
 */
 
-#if (defined(WIN32) && !defined(_M_ALPHA) && !defined(_WIN32_WCE) && \
-     !defined(__WATCOMC__) && !defined(__LCC__) && !defined(__FREEBCC__)) || \
-    (defined(i386) && defined(__GNUC__) && defined(USE_ASMBLIT))
-#define USE_ASM_STRETCH
-#endif
-
-#ifdef USE_ASM_STRETCH
-
-#if defined(WIN32) || defined(i386)
-#define PREFIX16	0x66
-#define STORE_BYTE	0xAA
-#define STORE_WORD	0xAB
-#define LOAD_BYTE	0xAC
-#define LOAD_WORD	0xAD
-#define RETURN		0xC3
-#else
-#error Need assembly opcodes for this architecture
-#endif
-
-#if defined(__ELF__) && defined(__GNUC__)
-extern unsigned char _copy_row[4096] __attribute__ ((alias ("copy_row")));
-#endif
-static unsigned char copy_row[4096];
-
-static int generate_rowbytes(int src_w, int dst_w, int bpp)
-{
-	static struct {
-		int bpp;
-		int src_w;
-		int dst_w;
-	} last;
-
-	int i;
-	int pos, inc;
-	unsigned char *eip;
-	unsigned char load, store;
-
-	/* See if we need to regenerate the copy buffer */
-	if ( (src_w == last.src_w) &&
-	     (dst_w == last.src_w) && (bpp == last.bpp) ) {
-		return(0);
-	}
-	last.bpp = bpp;
-	last.src_w = src_w;
-	last.dst_w = dst_w;
-
-	switch (bpp) {
-	    case 1:
-		load = LOAD_BYTE;
-		store = STORE_BYTE;
-		break;
-	    case 2:
-	    case 4:
-		load = LOAD_WORD;
-		store = STORE_WORD;
-		break;
-	    default:
-		SDL_SetError("ASM stretch of %d bytes isn't supported\n", bpp);
-		return(-1);
-	}
-	pos = 0x10000;
-	inc = (src_w << 16) / dst_w;
-	eip = copy_row;
-	for ( i=0; i<dst_w; ++i ) {
-		while ( pos >= 0x10000L ) {
-			if ( bpp == 2 ) {
-				*eip++ = PREFIX16;
-			}
-			*eip++ = load;
-			pos -= 0x10000L;
-		}
-		if ( bpp == 2 ) {
-			*eip++ = PREFIX16;
-		}
-		*eip++ = store;
-		pos += inc;
-	}
-	*eip++ = RETURN;
-
-	/* Verify that we didn't overflow (too late) */
-	if ( eip > (copy_row+sizeof(copy_row)) ) {
-		SDL_SetError("Copy buffer overflow");
-		return(-1);
-	}
-	return(0);
-}
-
-#else
-
 #define DEFINE_COPY_ROW(name, type)			\
-void name(type *src, int src_w, type *dst, int dst_w)	\
+static void name(type *src, int src_w, type *dst, int dst_w)	\
 {							\
 	int i;						\
 	int pos, inc;					\
@@ -150,14 +76,11 @@ DEFINE_COPY_ROW(copy_row1, Uint8)
 DEFINE_COPY_ROW(copy_row2, Uint16)
 DEFINE_COPY_ROW(copy_row4, Uint32)
 
-#endif /* USE_ASM_STRETCH */
-
-/* The ASM code doesn't handle 24-bpp stretch blits */
-void copy_row3(Uint8 *src, int src_w, Uint8 *dst, int dst_w)
+static void copy_row3(Uint8 *src, int src_w, Uint8 *dst, int dst_w)
 {
 	int i;
 	int pos, inc;
-	Uint8 pixel[3];
+	Uint8 pixel[3] = { 0, 0, 0 };
 
 	pos = 0x10000;
 	inc = (src_w << 16) / dst_w;
@@ -175,11 +98,9 @@ void copy_row3(Uint8 *src, int src_w, Uint8 *dst, int dst_w)
 	}
 }
 
-/* Perform a stretch blit between two surfaces of the same format.
-   NOTE:  This function is not safe to call from multiple threads!
-*/
-int SDL_SoftStretch(SDL_Surface *src, SDL_Rect *srcrect,
-                    SDL_Surface *dst, SDL_Rect *dstrect)
+/* Stretch pixels unchanged between surfaces of the same depth */
+static void SDL_StretchCopy(SDL_Surface *src, SDL_Rect *srcrect,
+                            SDL_Surface *dst, SDL_Rect *dstrect)
 {
 	int pos, inc;
 	int dst_width;
@@ -187,15 +108,640 @@ int SDL_SoftStretch(SDL_Surface *src, SDL_Rect *srcrect,
 	int src_row, dst_row;
 	Uint8 *srcp = NULL;
 	Uint8 *dstp;
+	Uint8 *lastp = NULL;
+	const int bpp = dst->format->BytesPerPixel;
+
+	pos = 0x10000;
+	inc = (srcrect->h << 16) / dstrect->h;
+	src_row = srcrect->y;
+	dst_row = dstrect->y;
+	dst_width = dstrect->w*bpp;
+
+	for ( dst_maxrow = dst_row+dstrect->h; dst_row<dst_maxrow; ++dst_row ) {
+		dstp = (Uint8 *)dst->pixels + (dst_row*dst->pitch)
+		                            + (dstrect->x*bpp);
+		if ( pos < 0x10000L && lastp ) {
+			/* Same source row as last time, copy what we made */
+			memcpy(dstp, lastp, dst_width);
+			pos += inc;
+			continue;
+		}
+		while ( pos >= 0x10000L ) {
+			srcp = (Uint8 *)src->pixels + (src_row*src->pitch)
+			                            + (srcrect->x*bpp);
+			++src_row;
+			pos -= 0x10000L;
+		}
+		switch (bpp) {
+		    case 1:
+			copy_row1(srcp, srcrect->w, dstp, dstrect->w);
+			break;
+		    case 2:
+			copy_row2((Uint16 *)srcp, srcrect->w,
+			          (Uint16 *)dstp, dstrect->w);
+			break;
+		    case 3:
+			copy_row3(srcp, srcrect->w, dstp, dstrect->w);
+			break;
+		    case 4:
+			copy_row4((Uint32 *)srcp, srcrect->w,
+			          (Uint32 *)dstp, dstrect->w);
+			break;
+		}
+		lastp = dstp;
+		pos += inc;
+	}
+}
+
+/* Box filter weights are fixed point, with all the weights for one
+   destination pixel adding up to BOX_ONE */
+#define BOX_SHIFT	14
+#define BOX_ONE		(1<<BOX_SHIFT)
+
+/* The source pixels that make up each destination pixel along one axis */
+typedef struct {
+	int *first;
+	int *count;		/* box filter only */
+	Uint32 *weight;		/* fraction of the next pixel, or box weights */
+} SDL_StretchAxis;
+
+typedef struct {
+	int filter;
+	SDL_Surface *src;
+	SDL_Rect *srcrect;
+	SDL_Surface *dst;
+	SDL_Rect *dstrect;
+
+	/* Unpacking the source into ARGB */
+	Uint32 palette[256];
+	Uint32 alpha;
+	int argb_src;
+
+	/* Packing ARGB into the destination */
+	SDL_Surface *row;
+	SDL_BlitInfo info;
+	SDL_loblit convert;
+
+	SDL_StretchAxis x;
+	SDL_StretchAxis y;
+
+	/* The last two source rows scaled horizontally */
+	Uint32 *fetched;
+	Uint32 *line[2];
+	int line_y[2];
+	int last_line;
+	Uint32 *out;
+	Uint32 *sum;
+
+	void (*blend)(Uint32 *out, const Uint32 *a, const Uint32 *b,
+	              int weight, int width);
+	void (*accumulate)(Uint32 *sum, const Uint32 *line,
+	                   Uint32 weight, int width);
+} SDL_StretchState;
+
+static int SDL_SetupAxis(SDL_StretchAxis *axis, int filter,
+                         int src_w, int dst_w)
+{
+	int i, j;
+
+	axis->first = (int *)malloc(dst_w*sizeof(int));
+	if ( axis->first == NULL ) {
+		return(-1);
+	}
+	switch (filter) {
+	    case SDL_STRETCH_NEAREST: {
+		/* Sample exactly as SDL_StretchCopy() does */
+		int pos = 0x10000;
+		int inc = (src_w << 16) / dst_w;
+
+		j = -1;
+		for ( i=0; i<dst_w; ++i ) {
+			while ( pos >= 0x10000L ) {
+				++j;
+				pos -= 0x10000L;
+			}
+			axis->first[i] = j;
+			pos += inc;
+		}
+	    }
+	    break;
+
+	    case SDL_STRETCH_BILINEAR: {
+		/* Sample at the pixel centers */
+		int inc = (src_w << 16) / dst_w;
+		int pos = inc/2 - 0x8000;
+
+		axis->weight = (Uint32 *)malloc(dst_w*sizeof(Uint32));
+		if ( axis->weight == NULL ) {
+			return(-1);
+		}
+		for ( i=0; i<dst_w; ++i ) {
+			if ( pos < 0 ) {
+				j = 0;
+				axis->weight[i] = 0;
+			} else {
+				j = (pos >> 16);
+				axis->weight[i] = (pos >> 8) & 0xFF;
+			}
+			if ( j >= src_w-1 ) {
+				j = src_w-1;
+				axis->weight[i] = 0;
+			}
+			axis->first[i] = j;
+			pos += inc;
+		}
+	    }
+	    break;
+
+	    case SDL_STRETCH_BOX: {
+		double scale = (double)src_w / dst_w;
+		int n = 0;
+
+		axis->count = (int *)malloc(dst_w*sizeof(int));
+		axis->weight = (Uint32 *)malloc((src_w+2*dst_w)*sizeof(Uint32));
+		if ( (axis->count == NULL) || (axis->weight == NULL) ) {
+			return(-1);
+		}
+		for ( i=0; i<dst_w; ++i ) {
+			double x0 = i*scale;
+			double x1 = (i+1)*scale;
+			Uint32 total = 0;
+			int last;
+
+			if ( x1 > src_w ) {
+				x1 = src_w;
+			}
+			axis->first[i] = (int)x0;
+			last = (int)x1;
+			if ( (last == x1) || (last >= src_w) ) {
+				--last;
+			}
+			axis->count[i] = last - axis->first[i] + 1;
+			for ( j=axis->first[i]; j<=last; ++j ) {
+				double lo = (j > x0) ? j : x0;
+				double hi = (j+1 < x1) ? j+1 : x1;
+				Uint32 weight;
+
+				weight = (Uint32)((hi-lo) / scale * BOX_ONE + 0.5);
+				if ( (j == last) || (total+weight > BOX_ONE) ) {
+					weight = BOX_ONE - total;
+				}
+				axis->weight[n++] = weight;
+				total += weight;
+			}
+		}
+	    }
+	    break;
+	}
+	return(0);
+}
+
+static void SDL_FreeAxis(SDL_StretchAxis *axis)
+{
+	if ( axis->first ) {
+		free(axis->first);
+	}
+	if ( axis->count ) {
+		free(axis->count);
+	}
+	if ( axis->weight ) {
+		free(axis->weight);
+	}
+}
+
+/* Unpack one row of the source rectangle into ARGB */
+static void SDL_FetchRow(SDL_StretchState *state, int y, Uint32 *out)
+{
+	SDL_PixelFormat *fmt = state->src->format;
+	int bpp = fmt->BytesPerPixel;
+	int width = state->srcrect->w;
+	Uint8 *srcp;
+	int i;
+
+	srcp = (Uint8 *)state->src->pixels +
+	       (state->srcrect->y+y) * state->src->pitch +
+	       state->srcrect->x * bpp;
+	if ( bpp == 1 ) {
+		for ( i=0; i<width; ++i ) {
+			out[i] = state->palette[srcp[i]];
+		}
+	} else if ( state->argb_src ) {
+		Uint32 *p = (Uint32 *)srcp;
+		for ( i=0; i<width; ++i ) {
+			out[i] = p[i] | state->alpha;
+		}
+	} else {
+		for ( i=0; i<width; ++i ) {
+			Uint32 pixel;
+			unsigned r, g, b, a;
+
+			DISEMBLE_RGBA(srcp, bpp, fmt, pixel, r, g, b, a);
+			out[i] = ((a << 24) | (r << 16) | (g << 8) | b) |
+			         state->alpha;
+			srcp += bpp;
+		}
+	}
+}
+
+/* Scale the unpacked source row horizontally */
+static void SDL_ScaleRow(SDL_StretchState *state, const Uint32 *in,
+                         Uint32 *out)
+{
+	SDL_StretchAxis *axis = &state->x;
+	int width = state->dstrect->w;
+	int last = state->srcrect->w-1;
+	int i;
+
+	switch (state->filter) {
+	    case SDL_STRETCH_NEAREST:
+		for ( i=0; i<width; ++i ) {
+			out[i] = in[axis->first[i]];
+		}
+		break;
+
+	    case SDL_STRETCH_BILINEAR:
+		for ( i=0; i<width; ++i ) {
+			int j = axis->first[i];
+			Uint32 w1 = axis->weight[i];
+			Uint32 w0 = 256 - w1;
+			Uint32 p0 = in[j];
+			Uint32 p1 = in[(j < last) ? j+1 : j];
+			Uint32 rb, ag;
+
+			rb = ((p0 & 0x00FF00FF) * w0 +
+			      (p1 & 0x00FF00FF) * w1) >> 8;
+			ag = ((p0 >> 8) & 0x00FF00FF) * w0 +
+			     ((p1 >> 8) & 0x00FF00FF) * w1;
+			out[i] = (rb & 0x00FF00FF) | (ag & 0xFF00FF00);
+		}
+		break;
+
+	    case SDL_STRETCH_BOX: {
+		const Uint32 *weight = axis->weight;
+
+		for ( i=0; i<width; ++i ) {
+			const Uint32 *p = &in[axis->first[i]];
+			Uint32 a = BOX_ONE/2, r = BOX_ONE/2;
+			Uint32 g = BOX_ONE/2, b = BOX_ONE/2;
+			int n;
+
+			for ( n=axis->count[i]; n; --n ) {
+				Uint32 w = *weight++;
+				Uint32 pixel = *p++;
+				a += (pixel >> 24) * w;
+				r += ((pixel >> 16) & 0xFF) * w;
+				g += ((pixel >> 8) & 0xFF) * w;
+				b += (pixel & 0xFF) * w;
+			}
+			out[i] = ((a >> BOX_SHIFT) << 24) |
+			         ((r >> BOX_SHIFT) << 16) |
+			         ((g >> BOX_SHIFT) << 8) |
+			          (b >> BOX_SHIFT);
+		}
+	    }
+	    break;
+	}
+}
+
+/* Get source row y scaled horizontally, keeping the row used last */
+static Uint32 *SDL_GetLine(SDL_StretchState *state, int y)
+{
+	int slot;
+
+	if ( state->line_y[0] == y ) {
+		slot = 0;
+	} else if ( state->line_y[1] == y ) {
+		slot = 1;
+	} else {
+		slot = !state->last_line;
+		SDL_FetchRow(state, y, state->fetched);
+		SDL_ScaleRow(state, state->fetched, state->line[slot]);
+		state->line_y[slot] = y;
+	}
+	state->last_line = slot;
+	return(state->line[slot]);
+}
+
+/* Vertical passes, on the bytes of whole rows */
+static void BlendRows(Uint32 *out, const Uint32 *a, const Uint32 *b,
+                      int weight, int width)
+{
+	Uint32 w1 = weight;
+	Uint32 w0 = 256 - weight;
+	int i;
+
+	for ( i=0; i<width; ++i ) {
+		Uint32 rb, ag;
+
+		rb = ((a[i] & 0x00FF00FF) * w0 + (b[i] & 0x00FF00FF) * w1) >> 8;
+		ag = ((a[i] >> 8) & 0x00FF00FF) * w0 +
+		     ((b[i] >> 8) & 0x00FF00FF) * w1;
+		out[i] = (rb & 0x00FF00FF) | (ag & 0xFF00FF00);
+	}
+}
+
+static void AccumulateRow(Uint32 *sum, const Uint32 *line,
+                          Uint32 weight, int width)
+{
+	const Uint8 *p = (const Uint8 *)line;
+	int i;
+
+	for ( i=0; i<width*4; ++i ) {
+		sum[i] += p[i] * weight;
+	}
+}
+
+#ifdef SDL_SSE2_INTRINSICS
+SDL_TARGETING("sse2")
+static void BlendRowsSSE2(Uint32 *out, const Uint32 *a, const Uint32 *b,
+                          int weight, int width)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i w0 = _mm_set1_epi16((short)(256 - weight));
+	const __m128i w1 = _mm_set1_epi16((short)weight);
+	int i;
+
+	for ( i=0; i+4<=width; i+=4 ) {
+		__m128i pa = _mm_loadu_si128((const __m128i *)(a+i));
+		__m128i pb = _mm_loadu_si128((const __m128i *)(b+i));
+		__m128i lo, hi;
+
+		lo = _mm_add_epi16(
+			_mm_mullo_epi16(_mm_unpacklo_epi8(pa, zero), w0),
+			_mm_mullo_epi16(_mm_unpacklo_epi8(pb, zero), w1));
+		hi = _mm_add_epi16(
+			_mm_mullo_epi16(_mm_unpackhi_epi8(pa, zero), w0),
+			_mm_mullo_epi16(_mm_unpackhi_epi8(pb, zero), w1));
+		lo = _mm_srli_epi16(lo, 8);
+		hi = _mm_srli_epi16(hi, 8);
+		_mm_storeu_si128((__m128i *)(out+i), _mm_packus_epi16(lo, hi));
+	}
+	BlendRows(out+i, a+i, b+i, weight, width-i);
+}
+
+SDL_TARGETING("sse2")
+static void AccumulateRowSSE2(Uint32 *sum, const Uint32 *line,
+                              Uint32 weight, int width)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i w = _mm_set1_epi16((short)weight);
+	int i;
+
+	for ( i=0; i+4<=width; i+=4 ) {
+		__m128i p = _mm_loadu_si128((const __m128i *)(line+i));
+		__m128i p16, lo, hi;
+		__m128i *s = (__m128i *)(sum+i*4);
+
+		/* weight <= BOX_ONE, so the products fit in 32 bits */
+		p16 = _mm_unpacklo_epi8(p, zero);
+		lo = _mm_mullo_epi16(p16, w);
+		hi = _mm_mulhi_epu16(p16, w);
+		_mm_storeu_si128(s+0, _mm_add_epi32(_mm_loadu_si128(s+0),
+		                                 _mm_unpacklo_epi16(lo, hi)));
+		_mm_storeu_si128(s+1, _mm_add_epi32(_mm_loadu_si128(s+1),
+		                                 _mm_unpackhi_epi16(lo, hi)));
+		p16 = _mm_unpackhi_epi8(p, zero);
+		lo = _mm_mullo_epi16(p16, w);
+		hi = _mm_mulhi_epu16(p16, w);
+		_mm_storeu_si128(s+2, _mm_add_epi32(_mm_loadu_si128(s+2),
+		                                 _mm_unpacklo_epi16(lo, hi)));
+		_mm_storeu_si128(s+3, _mm_add_epi32(_mm_loadu_si128(s+3),
+		                                 _mm_unpackhi_epi16(lo, hi)));
+	}
+	AccumulateRow(sum+i*4, line+i, weight, width-i);
+}
+#endif /* SDL_SSE2_INTRINSICS */
+
+#ifdef SDL_AVX2_INTRINSICS
+SDL_TARGETING("avx2")
+static void BlendRowsAVX2(Uint32 *out, const Uint32 *a, const Uint32 *b,
+                          int weight, int width)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i w0 = _mm256_set1_epi16((short)(256 - weight));
+	const __m256i w1 = _mm256_set1_epi16((short)weight);
+	int i;
+
+	for ( i=0; i+8<=width; i+=8 ) {
+		__m256i pa = _mm256_loadu_si256((const __m256i *)(a+i));
+		__m256i pb = _mm256_loadu_si256((const __m256i *)(b+i));
+		__m256i lo, hi;
+
+		/* Unpack and pack stay within 128-bit lanes, so the
+		   pixel order comes out unchanged */
+		lo = _mm256_add_epi16(
+			_mm256_mullo_epi16(_mm256_unpacklo_epi8(pa, zero), w0),
+			_mm256_mullo_epi16(_mm256_unpacklo_epi8(pb, zero), w1));
+		hi = _mm256_add_epi16(
+			_mm256_mullo_epi16(_mm256_unpackhi_epi8(pa, zero), w0),
+			_mm256_mullo_epi16(_mm256_unpackhi_epi8(pb, zero), w1));
+		lo = _mm256_srli_epi16(lo, 8);
+		hi = _mm256_srli_epi16(hi, 8);
+		_mm256_storeu_si256((__m256i *)(out+i),
+		                    _mm256_packus_epi16(lo, hi));
+	}
+	BlendRows(out+i, a+i, b+i, weight, width-i);
+}
+#endif /* SDL_AVX2_INTRINSICS */
+
+static int SDL_SetupStretch(SDL_StretchState *state)
+{
+	SDL_PixelFormat *srcfmt = state->src->format;
+	SDL_PixelFormat *dstfmt = state->dst->format;
+	int src_w = state->srcrect->w;
+	int dst_w = state->dstrect->w;
+	int i;
+
+	if ( (srcfmt->BitsPerPixel < 8) || (dstfmt->BitsPerPixel < 8) ) {
+		SDL_SetError("Stretching of bitmap surfaces isn't supported");
+		return(-1);
+	}
+
+	/* Work out how to unpack the source */
+	state->alpha = srcfmt->Amask ? 0 : 0xFF000000;
+	if ( srcfmt->palette ) {
+		for ( i=0; i<srcfmt->palette->ncolors && i<256; ++i ) {
+			SDL_Color *c = &srcfmt->palette->colors[i];
+			state->palette[i] = 0xFF000000 |
+				(c->r << 16) | (c->g << 8) | c->b;
+		}
+	}
+	state->argb_src = ( (srcfmt->BytesPerPixel == 4) &&
+	                    (srcfmt->Rmask == 0x00FF0000) &&
+	                    (srcfmt->Gmask == 0x0000FF00) &&
+	                    (srcfmt->Bmask == 0x000000FF) &&
+	                    ((srcfmt->Amask == 0) ||
+	                     (srcfmt->Amask == 0xFF000000)) );
+
+	/* Write straight into ARGB destinations, else convert each row */
+	if ( (dstfmt->BytesPerPixel != 4) ||
+	     (dstfmt->Rmask != 0x00FF0000) ||
+	     (dstfmt->Gmask != 0x0000FF00) ||
+	     (dstfmt->Bmask != 0x000000FF) ||
+	     ((dstfmt->Amask != 0) && (dstfmt->Amask != 0xFF000000)) ) {
+		state->out = (Uint32 *)malloc(dst_w*sizeof(Uint32));
+		if ( state->out == NULL ) {
+			SDL_OutOfMemory();
+			return(-1);
+		}
+		state->row = SDL_CreateRGBSurfaceFrom(state->out, dst_w, 1, 32,
+				dst_w*4, 0x00FF0000, 0x0000FF00,
+				0x000000FF, 0xFF000000);
+		if ( state->row == NULL ) {
+			return(-1);
+		}
+		/* Copy the alpha channel rather than blending with it */
+		SDL_SetAlpha(state->row, 0, SDL_ALPHA_OPAQUE);
+		if ( SDL_MapSurface(state->row, state->dst) < 0 ) {
+			return(-1);
+		}
+		state->convert = state->row->map->sw_data->blit;
+		state->info.s_pixels = (Uint8 *)state->out;
+		state->info.s_width = dst_w;
+		state->info.s_height = 1;
+		state->info.s_skip = 0;
+		state->info.d_width = dst_w;
+		state->info.d_height = 1;
+		state->info.d_skip = 0;
+		state->info.aux_data = state->row->map->sw_data->aux_data;
+		state->info.src = state->row->format;
+		state->info.table = state->row->map->table;
+		state->info.dst = dstfmt;
+	}
+
+	/* Allocate the row buffers and the sampling tables */
+	state->fetched = (Uint32 *)malloc(src_w*sizeof(Uint32));
+	state->line[0] = (Uint32 *)malloc(dst_w*sizeof(Uint32));
+	state->line[1] = (Uint32 *)malloc(dst_w*sizeof(Uint32));
+	if ( state->filter == SDL_STRETCH_BOX ) {
+		state->sum = (Uint32 *)malloc(dst_w*4*sizeof(Uint32));
+	}
+	if ( !state->fetched || !state->line[0] || !state->line[1] ||
+	     ((state->filter == SDL_STRETCH_BOX) && !state->sum) ||
+	     (SDL_SetupAxis(&state->x, state->filter, src_w, dst_w) < 0) ||
+	     (SDL_SetupAxis(&state->y, state->filter,
+	                    state->srcrect->h, state->dstrect->h) < 0) ) {
+		SDL_OutOfMemory();
+		return(-1);
+	}
+	state->line_y[0] = -1;
+	state->line_y[1] = -1;
+
+	/* Pick the fastest vertical pass */
+	state->blend = BlendRows;
+	state->accumulate = AccumulateRow;
+#ifdef SDL_SSE2_INTRINSICS
+	if ( SDL_HasSSE2() ) {
+		state->blend = BlendRowsSSE2;
+		state->accumulate = AccumulateRowSSE2;
+	}
+#endif
+#ifdef SDL_AVX2_INTRINSICS
+	if ( SDL_HasAVX2() ) {
+		state->blend = BlendRowsAVX2;
+	}
+#endif
+	return(0);
+}
+
+static void SDL_FreeStretch(SDL_StretchState *state)
+{
+	if ( state->row ) {
+		SDL_FreeSurface(state->row);
+	}
+	if ( state->out ) {
+		free(state->out);
+	}
+	if ( state->fetched ) {
+		free(state->fetched);
+	}
+	if ( state->line[0] ) {
+		free(state->line[0]);
+	}
+	if ( state->line[1] ) {
+		free(state->line[1]);
+	}
+	if ( state->sum ) {
+		free(state->sum);
+	}
+	SDL_FreeAxis(&state->x);
+	SDL_FreeAxis(&state->y);
+}
+
+static void SDL_StretchFiltered(SDL_StretchState *state)
+{
+	SDL_Surface *dst = state->dst;
+	SDL_StretchAxis *axis = &state->y;
+	int dst_w = state->dstrect->w;
+	int last = state->srcrect->h-1;
+	const Uint32 *weight = axis->weight;
+	int i, n;
+
+	for ( i=0; i<state->dstrect->h; ++i ) {
+		Uint8 *dstp;
+		Uint32 *out;
+
+		dstp = (Uint8 *)dst->pixels +
+		       (state->dstrect->y+i) * dst->pitch +
+		       state->dstrect->x * dst->format->BytesPerPixel;
+		out = state->out ? state->out : (Uint32 *)dstp;
+
+		switch (state->filter) {
+		    case SDL_STRETCH_NEAREST:
+			memcpy(out, SDL_GetLine(state, axis->first[i]),
+			       dst_w*sizeof(Uint32));
+			break;
+
+		    case SDL_STRETCH_BILINEAR: {
+			int y = axis->first[i];
+			Uint32 *a = SDL_GetLine(state, y);
+
+			if ( axis->weight[i] == 0 ) {
+				memcpy(out, a, dst_w*sizeof(Uint32));
+			} else {
+				Uint32 *b = SDL_GetLine(state,
+				                        (y < last) ? y+1 : y);
+				state->blend(out, a, b, axis->weight[i], dst_w);
+			}
+		    }
+		    break;
+
+		    case SDL_STRETCH_BOX: {
+			Uint8 *p = (Uint8 *)out;
+			int y = axis->first[i];
+
+			for ( n=0; n<dst_w*4; ++n ) {
+				state->sum[n] = BOX_ONE/2;
+			}
+			for ( n=axis->count[i]; n; --n ) {
+				state->accumulate(state->sum,
+				                  SDL_GetLine(state, y++),
+				                  *weight++, dst_w);
+			}
+			for ( n=0; n<dst_w*4; ++n ) {
+				p[n] = (Uint8)(state->sum[n] >> BOX_SHIFT);
+			}
+		    }
+		    break;
+		}
+
+		if ( state->convert ) {
+			state->info.d_pixels = dstp;
+			state->convert(&state->info);
+		}
+	}
+}
+
+int SDL_SoftStretchFilter(SDL_Surface *src, SDL_Rect *srcrect,
+                          SDL_Surface *dst, SDL_Rect *dstrect, int filter)
+{
 	SDL_Rect full_src;
 	SDL_Rect full_dst;
-#if defined(USE_ASM_STRETCH) && defined(__GNUC__)
-	int u1, u2;
-#endif
-	const int bpp = dst->format->BytesPerPixel;
+	SDL_StretchState state;
+	int retval;
 
-	if ( src->format->BitsPerPixel != dst->format->BitsPerPixel ) {
-		SDL_SetError("Only works with same format surfaces");
+	if ( (filter < SDL_STRETCH_NEAREST) || (filter > SDL_STRETCH_BOX) ) {
+		SDL_SetError("Unknown stretch filter");
 		return(-1);
 	}
 
@@ -228,85 +774,53 @@ int SDL_SoftStretch(SDL_Surface *src, SDL_Rect *srcrect,
 		full_dst.h = dst->h;
 		dstrect = &full_dst;
 	}
+	if ( !srcrect->w || !srcrect->h || !dstrect->w || !dstrect->h ) {
+		return(0);
+	}
 
-	/* Set up the data... */
-	pos = 0x10000;
-	inc = (srcrect->h << 16) / dstrect->h;
-	src_row = srcrect->y;
-	dst_row = dstrect->y;
-	dst_width = dstrect->w*bpp;
-
-#ifdef USE_ASM_STRETCH
-	/* Write the opcodes for this stretch */
-	if ( (bpp != 3) &&
-	     (generate_rowbytes(srcrect->w, dstrect->w, bpp) < 0) ) {
+	/* Lock the surfaces, if needed.  Locking changes the surface, so a
+	   source that doesn't need it is left alone for other threads. */
+	if ( SDL_LockSurface(dst) < 0 ) {
+		return(-1);
+	}
+	if ( SDL_MUSTLOCK(src) && (SDL_LockSurface(src) < 0) ) {
+		SDL_UnlockSurface(dst);
 		return(-1);
 	}
-#endif
 
-	/* Perform the stretch blit */
-	for ( dst_maxrow = dst_row+dstrect->h; dst_row<dst_maxrow; ++dst_row ) {
-		dstp = (Uint8 *)dst->pixels + (dst_row*dst->pitch)
-		                            + (dstrect->x*bpp);
-		while ( pos >= 0x10000L ) {
-			srcp = (Uint8 *)src->pixels + (src_row*src->pitch)
-			                            + (srcrect->x*bpp);
-			++src_row;
-			pos -= 0x10000L;
-		}
-#ifdef USE_ASM_STRETCH
-		switch (bpp) {
-		    case 3:
-			copy_row3(srcp, srcrect->w, dstp, dstrect->w);
-			break;
-		    default:
-#ifdef __GNUC__
-			__asm__ __volatile__ (
-			"call _copy_row"
-			: "=&D" (u1), "=&S" (u2)
-			: "0" (dstp), "1" (srcp)
-			: "memory" );
-#else
-#ifdef WIN32
-		{ void *code = &copy_row;
-			__asm {
-				push edi
-				push esi
-	
-				mov edi, dstp
-				mov esi, srcp
-				call dword ptr code
-
-				pop esi
-				pop edi
-			}
-		}
-#else
-#error Need inline assembly for this compiler
-#endif
-#endif /* __GNUC__ */
-			break;
-		}
-#else
-		switch (bpp) {
-		    case 1:
-			copy_row1(srcp, srcrect->w, dstp, dstrect->w);
-			break;
-		    case 2:
-			copy_row2((Uint16 *)srcp, srcrect->w,
-			          (Uint16 *)dstp, dstrect->w);
-			break;
-		    case 3:
-			copy_row3(srcp, srcrect->w, dstp, dstrect->w);
-			break;
-		    case 4:
-			copy_row4((Uint32 *)srcp, srcrect->w,
-			          (Uint32 *)dstp, dstrect->w);
-			break;
+	retval = 0;
+	if ( (filter == SDL_STRETCH_NEAREST) &&
+	     (src->format->BitsPerPixel == dst->format->BitsPerPixel) &&
+	     ((src->format->BytesPerPixel == 1) ||
+	      ((src->format->Rmask == dst->format->Rmask) &&
+	       (src->format->Gmask == dst->format->Gmask) &&
+	       (src->format->Bmask == dst->format->Bmask))) ) {
+		SDL_StretchCopy(src, srcrect, dst, dstrect);
+	} else {
+		memset(&state, 0, sizeof(state));
+		state.filter = filter;
+		state.src = src;
+		state.srcrect = srcrect;
+		state.dst = dst;
+		state.dstrect = dstrect;
+		retval = SDL_SetupStretch(&state);
+		if ( retval == 0 ) {
+			SDL_StretchFiltered(&state);
 		}
-#endif
-		pos += inc;
+		SDL_FreeStretch(&state);
 	}
-	return(0);
+
+	if ( SDL_MUSTLOCK(src) ) {
+		SDL_UnlockSurface(src);
+	}
+	SDL_UnlockSurface(dst);
+	return(retval);
 }
 
+/* Perform a nearest neighbour stretch blit between two surfaces */
+int SDL_SoftStretch(SDL_Surface *src, SDL_Rect *srcrect,
+                    SDL_Surface *dst, SDL_Rect *dstrect)
+{
+	return(SDL_SoftStretchFilter(src, srcrect, dst, dstrect,
+	                             SDL_STRETCH_NEAREST));
+}
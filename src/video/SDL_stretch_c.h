@@ -25,9 +25,11 @@ static char rcsid =
  "@(#) $Id$";
 #endif
 
-/* Perform a stretch blit between two surfaces of the same format.
-   NOTE:  This function is not safe to call from multiple threads!
-*/
+/* Perform a nearest neighbour stretch blit between two surfaces */
 extern int SDL_SoftStretch(SDL_Surface *src, SDL_Rect *srcrect,
                            SDL_Surface *dst, SDL_Rect *dstrect);
 
+/* Perform a stretch blit between two surfaces with the given filter */
+extern int SDL_SoftStretchFilter(SDL_Surface *src, SDL_Rect *srcrect,
+                       SDL_Surface *dst, SDL_Rect *dstrect, int filter);
+
@@ -137,7 +137,7 @@ SDL_Surface * SDL_CreateRGBSurface (Uint32 flags,
 	surface->hwdata = NULL;
 	surface->locked = 0;
 	surface->map = NULL;
-	surface->format_version = 0;
+	surface->format_version = SDL_NewFormatVersion();
 	surface->unused1 = 0;
 	SDL_SetClipRect(surface, NULL);
 
@@ -272,6 +272,14 @@ struct SDL_VideoDevice {
 	/* Handle any queued OS events */
 	void (*PumpEvents)(_THIS);
 
+	/* Get the file descriptors that become readable when there are OS
+	   events to handle, returning how many were stored, -1 if events
+	   must be polled for, or SDL_EVENTFDS_READY if events have already
+	   been read and are waiting to be handled.  This is optional.
+	 */
+#define SDL_EVENTFDS_READY	(-2)
+	int (*GetEventFDs)(_THIS, int *fds, int maxfds);
+
 	/* * * */
 	/* Data common to all drivers */
 	SDL_Surface *screen;
@@ -0,0 +1,247 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997, 1998, 1999, 2000, 2001, 2002  Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the Free
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+
+#ifdef SAVE_RCSID
+static char rcsid =
+ "@(#) $Id$";
+#endif
+
+/* Merging of the rectangles passed to SDL_UpdateRects()
+
+   Many programs update every sprite they draw as its own rectangle, so
+   the same pixels are often converted from the shadow surface and sent
+   to the display several times in one update.  When coalescing is
+   enabled, rectangles that overlap or share part of an edge are replaced
+   by the box around them until no two rectangles overlap.  If what is
+   left still covers most of its bounding box, the bounding box is
+   updated instead, and if the bounding box covers most of the screen,
+   the whole screen is updated.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "SDL_error.h"
+#include "SDL_video.h"
+#include "SDL_updaterects_c.h"
+
+#define DEFAULT_BOUNDING_PERCENT	75
+#define DEFAULT_FULL_PERCENT		90
+
+/* Above this many rectangles merging gets expensive, and the bounding
+   box is almost always the better update anyway */
+#define MAX_MERGE_RECTS			256
+
+static int SDL_coalesce = 0;
+static int SDL_bounding_percent = DEFAULT_BOUNDING_PERCENT;
+static int SDL_full_percent = DEFAULT_FULL_PERCENT;
+static SDL_UpdateStats SDL_update_stats;
+static SDL_Rect *SDL_merged = NULL;
+static int SDL_maxmerged = 0;
+
+void SDL_SetUpdateCoalescing(int enable, int bounding_percent,
+                             int full_percent)
+{
+	if ( bounding_percent <= 0 ) {
+		bounding_percent = DEFAULT_BOUNDING_PERCENT;
+	}
+	if ( full_percent <= 0 ) {
+		full_percent = DEFAULT_FULL_PERCENT;
+	}
+	SDL_coalesce = enable;
+	SDL_bounding_percent = bounding_percent;
+	SDL_full_percent = full_percent;
+}
+
+void SDL_GetUpdateStats(SDL_UpdateStats *stats, int reset)
+{
+	if ( stats ) {
+		*stats = SDL_update_stats;
+	}
+	if ( reset ) {
+		memset(&SDL_update_stats, 0, sizeof(SDL_update_stats));
+	}
+}
+
+void SDL_InitUpdateRects(void)
+{
+	const char *variable;
+
+	variable = getenv("SDL_UPDATE_COALESCE");
+	if ( variable ) {
+		SDL_SetUpdateCoalescing(atoi(variable), 0, 0);
+	}
+}
+
+void SDL_QuitUpdateRects(void)
+{
+	if ( SDL_merged ) {
+		free(SDL_merged);
+		SDL_merged = NULL;
+	}
+	SDL_maxmerged = 0;
+}
+
+#define AREA(rect)	((Uint32)(rect)->w * (rect)->h)
+
+static void SDL_UnionRect(const SDL_Rect *a, const SDL_Rect *b,
+                          SDL_Rect *result)
+{
+	int x1, y1, x2, y2;
+
+	x1 = (a->x < b->x) ? a->x : b->x;
+	y1 = (a->y < b->y) ? a->y : b->y;
+	x2 = ((a->x+a->w) > (b->x+b->w)) ? (a->x+a->w) : (b->x+b->w);
+	y2 = ((a->y+a->h) > (b->y+b->h)) ? (a->y+a->h) : (b->y+b->h);
+	result->x = x1;
+	result->y = y1;
+	result->w = x2 - x1;
+	result->h = y2 - y1;
+}
+
+/* See if two rectangles overlap or share part of an edge.  Rectangles
+   that only meet at a corner are left alone.
+ */
+static int SDL_RectsMeet(const SDL_Rect *a, const SDL_Rect *b)
+{
+	int xoverlap, yoverlap;
+
+	xoverlap = (a->x+a->w < b->x+b->w ? a->x+a->w : b->x+b->w) -
+	           (a->x > b->x ? a->x : b->x);
+	yoverlap = (a->y+a->h < b->y+b->h ? a->y+a->h : b->y+b->h) -
+	           (a->y > b->y ? a->y : b->y);
+	return((xoverlap >= 0) && (yoverlap >= 0) &&
+	       ((xoverlap > 0) || (yoverlap > 0)));
+}
+
+/* Merge rectangles that meet until no two of them overlap */
+static int SDL_MergeRects(SDL_Rect *rects, int numrects)
+{
+	int i, j, merged;
+
+	do {
+		merged = 0;
+		for ( i=0; i<numrects; ++i ) {
+			for ( j=i+1; j<numrects; ++j ) {
+				if ( SDL_RectsMeet(&rects[i], &rects[j]) ) {
+					SDL_UnionRect(&rects[i], &rects[j],
+					              &rects[i]);
+					rects[j] = rects[--numrects];
+					/* The bigger rectangle may now meet others */
+					j = i;
+					merged = 1;
+				}
+			}
+		}
+	/* ... including ones that were checked before it grew */
+	} while ( merged );
+	return(numrects);
+}
+
+SDL_Rect *SDL_CoalesceRects(SDL_Surface *screen,
+                            SDL_Rect *rects, int *numrects)
+{
+	SDL_Rect bounds;
+	Uint32 area;
+	int i, n;
+
+	memset(&bounds, 0, sizeof(bounds));
+	n = *numrects;
+	area = 0;
+	for ( i=0; i<n; ++i ) {
+		area += AREA(&rects[i]);
+	}
+	++SDL_update_stats.updates;
+	SDL_update_stats.rects_in += n;
+	SDL_update_stats.pixels_in += area;
+	if ( !SDL_coalesce || (n <= 1) ) {
+		SDL_update_stats.rects_out += n;
+		SDL_update_stats.pixels_out += area;
+		return(rects);
+	}
+
+	/* Copy the rectangles that aren't empty */
+	if ( n > SDL_maxmerged ) {
+		SDL_Rect *merged;
+
+		merged = (SDL_Rect *)realloc(SDL_merged, n*sizeof(*merged));
+		if ( merged == NULL ) {
+			SDL_update_stats.rects_out += n;
+			SDL_update_stats.pixels_out += area;
+			return(rects);
+		}
+		SDL_merged = merged;
+		SDL_maxmerged = n;
+	}
+	n = 0;
+	for ( i=0; i<*numrects; ++i ) {
+		if ( rects[i].w && rects[i].h ) {
+			if ( n == 0 ) {
+				bounds = rects[i];
+			} else {
+				SDL_UnionRect(&bounds, &rects[i], &bounds);
+			}
+			SDL_merged[n++] = rects[i];
+		}
+	}
+
+	if ( n > 1 ) {
+		if ( (double)AREA(&bounds)*100 >=
+		     (double)screen->w*screen->h*SDL_full_percent ) {
+			/* Nearly the whole screen, update all of it */
+			bounds.x = 0;
+			bounds.y = 0;
+			bounds.w = screen->w;
+			bounds.h = screen->h;
+			++SDL_update_stats.full_screen;
+			SDL_merged[0] = bounds;
+			n = 1;
+		} else {
+			if ( (n <= MAX_MERGE_RECTS) &&
+			     ((double)area*100 <
+			      (double)AREA(&bounds)*SDL_bounding_percent) ) {
+				n = SDL_MergeRects(SDL_merged, n);
+				area = 0;
+				for ( i=0; i<n; ++i ) {
+					area += AREA(&SDL_merged[i]);
+				}
+			}
+			if ( (n > 1) &&
+			     ((n > MAX_MERGE_RECTS) ||
+			      ((double)area*100 >=
+			       (double)AREA(&bounds)*SDL_bounding_percent)) ) {
+				++SDL_update_stats.bounding_box;
+				SDL_merged[0] = bounds;
+				n = 1;
+			}
+		}
+	}
+
+	area = 0;
+	for ( i=0; i<n; ++i ) {
+		area += AREA(&SDL_merged[i]);
+	}
+	SDL_update_stats.rects_out += n;
+	SDL_update_stats.pixels_out += area;
+	*numrects = n;
+	return(SDL_merged);
+}
@@ -42,6 +42,8 @@ static char rcsid =
 #include "SDL_pixels_c.h"
 #include "SDL_events_c.h"
 #include "SDL_cursor_c.h"
+#include "SDL_updaterects_c.h"
+#include "SDL_present_c.h"
 
 /* Available video drivers */
 static VideoBootStrap *bootstrap[] = {
@@ -271,6 +273,15 @@ int SDL_VideoInit (const char *driver_name, Uint32 flags)
 #endif
 	video->info.vfmt = SDL_VideoSurface->format;
 
+	/* Set up parallel software blitting, if requested */
+	SDL_InitBlitThreads();
+
+	/* Set up merging of screen updates, if requested */
+	SDL_InitUpdateRects();
+
+	/* Set up asynchronous flips, if requested */
+	SDL_InitPresent();
+
 	/* Start the event loop */
 	if ( SDL_StartEventLoop(flags) < 0 ) {
 		SDL_VideoQuit();
@@ -580,6 +591,9 @@ SDL_Surface * SDL_SetVideoMode (int width, int height, int bpp, Uint32 flags)
 	}
 	this = video = current_video;
 
+	/* Finish any flips of the old mode before it goes away */
+	SDL_WaitPresent();
+
 	/* Default to the current video bpp */
 	if ( bpp == 0 ) {
 		flags |= SDL_ANYFORMAT;
@@ -989,6 +1003,17 @@ void SDL_UpdateRects (SDL_Surface *screen, int numrects, SDL_Rect *rects)
 	SDL_VideoDevice *video = current_video;
 	SDL_VideoDevice *this = current_video;
 
+	/* Keep updates in order with asynchronous flips */
+	if ( (screen == SDL_ShadowSurface) && SDL_PresentActive() ) {
+		SDL_WaitPresent();
+	}
+	SDL_LockPresent();
+
+	/* Merge overlapping rectangles, if enabled */
+	if ( (screen == SDL_ShadowSurface) || (screen == SDL_VideoSurface) ) {
+		rects = SDL_CoalesceRects(screen, rects, &numrects);
+	}
+
 	if ( screen == SDL_ShadowSurface ) {
 		/* Blit the shadow surface using saved mapping */
 		SDL_Palette *pal = screen->format->palette;
@@ -1004,21 +1029,7 @@ void SDL_UpdateRects (SDL_Surface *screen, int numrects, SDL_Rect *rects)
 				pal->colors = video->physpal->colors;
 			}
 		}
-		if ( SHOULD_DRAWCURSOR(SDL_cursorstate) ) {
-			SDL_LockCursor();
-			SDL_DrawCursor(SDL_ShadowSurface);
-			for ( i=0; i<numrects; ++i ) {
-				SDL_LowerBlit(SDL_ShadowSurface, &rects[i], 
-						SDL_VideoSurface, &rects[i]);
-			}
-			SDL_EraseCursor(SDL_ShadowSurface);
-			SDL_UnlockCursor();
-		} else {
-			for ( i=0; i<numrects; ++i ) {
-				SDL_LowerBlit(SDL_ShadowSurface, &rects[i], 
-						SDL_VideoSurface, &rects[i]);
-			}
-		}
+		SDL_BlitShadow(SDL_ShadowSurface, numrects, rects);
 		if ( saved_colors ) {
 			pal->colors = saved_colors;
 		}
@@ -1042,6 +1053,33 @@ void SDL_UpdateRects (SDL_Surface *screen, int numrects, SDL_Rect *rects)
 			video->UpdateRects(this, numrects, rects);
 		}
 	}
+	SDL_UnlockPresent();
+}
+
+/*
+ * Copy rectangles of a shadow surface to the video surface, with the
+ * software cursor drawn on top.  This is also used by the present thread
+ * for its copies of the shadow surface.
+ */
+void SDL_BlitShadow(SDL_Surface *shadow, int numrects, SDL_Rect *rects)
+{
+	int i;
+
+	if ( SHOULD_DRAWCURSOR(SDL_cursorstate) ) {
+		SDL_LockCursor();
+		SDL_DrawCursor(shadow);
+		for ( i=0; i<numrects; ++i ) {
+			SDL_LowerBlit(shadow, &rects[i], 
+					SDL_VideoSurface, &rects[i]);
+		}
+		SDL_EraseCursor(shadow);
+		SDL_UnlockCursor();
+	} else {
+		for ( i=0; i<numrects; ++i ) {
+			SDL_LowerBlit(shadow, &rects[i], 
+					SDL_VideoSurface, &rects[i]);
+		}
+	}
 }
 
 /*
@@ -1050,6 +1088,15 @@ void SDL_UpdateRects (SDL_Surface *screen, int numrects, SDL_Rect *rects)
 int SDL_Flip(SDL_Surface *screen)
 {
 	SDL_VideoDevice *video = current_video;
+	int retval = 0;
+
+	/* Let the present thread do the work, if enabled */
+	if ( (screen == SDL_ShadowSurface) &&
+	     (SDL_QueuePresent(screen) == 0) ) {
+		return(0);
+	}
+
+	SDL_LockPresent();
 	/* Copy the shadow surface to the video surface */
 	if ( screen == SDL_ShadowSurface ) {
 		SDL_Rect rect;
@@ -1071,17 +1118,7 @@ int SDL_Flip(SDL_Surface *screen)
 		rect.y = 0;
 		rect.w = screen->w;
 		rect.h = screen->h;
-		if ( SHOULD_DRAWCURSOR(SDL_cursorstate) ) {
-			SDL_LockCursor();
-			SDL_DrawCursor(SDL_ShadowSurface);
-			SDL_LowerBlit(SDL_ShadowSurface, &rect,
-					SDL_VideoSurface, &rect);
-			SDL_EraseCursor(SDL_ShadowSurface);
-			SDL_UnlockCursor();
-		} else {
-			SDL_LowerBlit(SDL_ShadowSurface, &rect,
-					SDL_VideoSurface, &rect);
-		}
+		SDL_BlitShadow(SDL_ShadowSurface, 1, &rect);
 		if ( saved_colors ) {
 			pal->colors = saved_colors;
 		}
@@ -1091,11 +1128,12 @@ int SDL_Flip(SDL_Surface *screen)
 	}
 	if ( (screen->flags & SDL_DOUBLEBUF) == SDL_DOUBLEBUF ) {
 		SDL_VideoDevice *this  = current_video;
-		return(video->FlipHWSurface(this, SDL_VideoSurface));
+		retval = video->FlipHWSurface(this, SDL_VideoSurface);
 	} else {
 		SDL_UpdateRect(screen, 0, 0, 0, 0);
 	}
-	return(0);
+	SDL_UnlockPresent();
+	return(retval);
 }
 
 static void SetPalette_logical(SDL_Surface *screen, SDL_Color *colors,
@@ -1119,6 +1157,7 @@ static void SetPalette_logical(SDL_Surface *screen, SDL_Color *colors,
 		 */
 		memcpy(vidpal->colors + firstcolor, colors,
 		       ncolors * sizeof(*colors));
+		SDL_InvalidatePaletteLookup(vidpal);
 	}
 	SDL_FormatChanged(screen);
 }
@@ -1148,11 +1187,10 @@ static int SetPalette_physical(SDL_Surface *screen,
 		} else {
 			/*
 			 * The video surface is not indexed - invalidate any
-			 * active shadow-to-video blit mappings.
+			 * shadow-to-video blit mappings, including any
+			 * that are cached while blitting elsewhere.
 			 */
-			if ( screen->map->dst == SDL_VideoSurface ) {
-				SDL_InvalidateMap(screen->map);
-			}
+			SDL_InvalidateMap(screen->map);
 			if ( video->gamma ) {
 				if( ! video->gammacols ) {
 					SDL_Palette *pp = video->physpal;
@@ -1234,6 +1272,12 @@ int SDL_SetPalette(SDL_Surface *screen, int which,
 		gotall = 0;
 	}
 
+	/* The present thread may be using the screen palette */
+	if ( screen == SDL_PublicSurface ) {
+		SDL_WaitPresent();
+		SDL_LockPresent();
+	}
+
 	if ( which & SDL_LOGPAL ) {
 		/*
 		 * Logical palette change: The actual screen isn't affected,
@@ -1250,8 +1294,6 @@ int SDL_SetPalette(SDL_Surface *screen, int which,
 		 * program's idea of what the screen looks like, but changes
 		 * its actual appearance.
 		 */
-		if(!video)
-			return gotall;	/* video not yet initialized */
 		if(!video->physpal && !(which & SDL_LOGPAL) ) {
 			/* Lazy physical palette allocation */
 			int size;
@@ -1264,9 +1306,14 @@ int SDL_SetPalette(SDL_Surface *screen, int which,
 		}
 		if ( ! SetPalette_physical(screen,
 		                           colors, firstcolor, ncolors) ) {
+			/* The driver may have copied back the colors it got */
+			SDL_InvalidatePaletteLookup(pal);
 			gotall = 0;
 		}
 	}
+	if ( screen == SDL_PublicSurface ) {
+		SDL_UnlockPresent();
+	}
 	return gotall;
 }
 
@@ -1291,6 +1338,9 @@ void SDL_VideoQuit (void)
 		/* Halt event processing before doing anything else */
 		SDL_StopEventLoop();
 
+		/* Finish any pending flips and stop the present thread */
+		SDL_QuitPresent();
+
 		/* Clean up allocated window manager items */
 		if ( SDL_PublicSurface ) {
 			SDL_PublicSurface = NULL;
@@ -1303,6 +1353,10 @@ void SDL_VideoQuit (void)
 		/* Clean up the system video */
 		video->VideoQuit(this);
 
+		/* Stop the software blit threads */
+		SDL_QuitBlitThreads();
+		SDL_QuitUpdateRects();
+
 		/* Free any lingering surfaces */
 		ready_to_go = SDL_ShadowSurface;
 		SDL_ShadowSurface = NULL;
@@ -1650,7 +1704,9 @@ void SDL_WM_SetCaption (const char *title, const char *icon)
 			}
 		}
 		if ( (title || icon) && (video->SetCaption != NULL) ) {
+			SDL_LockPresent();
 			video->SetCaption(this, video->wm_title,video->wm_icon);
+			SDL_UnlockPresent();
 		}
 	}
 }
@@ -1748,10 +1804,14 @@ void SDL_WM_SetIcon (SDL_Surface *icon, Uint8 *mask)
 			if( flags ) {
 				CreateMaskFromColorKeyOrAlpha(icon, mask, flags);
 			}
+			SDL_LockPresent();
 			video->SetIcon(video, icon, mask);
+			SDL_UnlockPresent();
 			free(mask);
 		} else {
+			SDL_LockPresent();
 			video->SetIcon(this, icon, mask);
+			SDL_UnlockPresent();
 		}
 	}
 }
@@ -1775,6 +1835,7 @@ static SDL_GrabMode SDL_WM_GrabInputRaw(SDL_GrabMode mode)
 #ifdef DEBUG_GRAB
   printf("SDL_WM_GrabInputRaw(%d) ... ", mode);
 #endif
+	SDL_LockPresent();
 	if ( mode == SDL_GRAB_OFF ) {
 		if ( video->input_grab != SDL_GRAB_OFF ) {
 			mode = video->GrabInput(this, mode);
@@ -1790,6 +1851,7 @@ static SDL_GrabMode SDL_WM_GrabInputRaw(SDL_GrabMode mode)
 			video->CheckMouseMode(this);
 		}
 	}
+	SDL_UnlockPresent();
 #ifdef DEBUG_GRAB
   printf("Final mode %d\n", video->input_grab);
 #endif
@@ -1856,7 +1918,9 @@ int SDL_WM_IconifyWindow(void)
 
 	retval = 0;
 	if ( video->IconifyWindow ) {
+		SDL_LockPresent();
 		retval = video->IconifyWindow(this);
+		SDL_UnlockPresent();
 	}
 	return(retval);
 }
@@ -1873,6 +1937,7 @@ int SDL_WM_ToggleFullScreen(SDL_Surface *surface)
 	toggled = 0;
 	if ( SDL_PublicSurface && (surface == SDL_PublicSurface) &&
 	     video->ToggleFullScreen ) {
+		SDL_LockPresent();
 		if ( surface->flags & SDL_FULLSCREEN ) {
 			toggled = video->ToggleFullScreen(this, 0);
 			if ( toggled ) {
@@ -1890,6 +1955,7 @@ int SDL_WM_ToggleFullScreen(SDL_Surface *surface)
 		if ( toggled ) {
 			SDL_WM_GrabInput(video->input_grab);
 		}
+		SDL_UnlockPresent();
 	}
 	return(toggled);
 }
@@ -966,6 +966,20 @@ void FB_PumpEvents(_THIS)
 	} while ( posted );
 }
 
+int FB_GetEventFDs(_THIS, int *fds, int maxfds)
+{
+	int numfds;
+
+	numfds = 0;
+	if ( (keyboard_fd >= 0) && (numfds < maxfds) ) {
+		fds[numfds++] = keyboard_fd;
+	}
+	if ( (mouse_fd >= 0) && (numfds < maxfds) ) {
+		fds[numfds++] = mouse_fd;
+	}
+	return(numfds);
+}
+
 void FB_InitOSKeymap(_THIS)
 {
 	int i;
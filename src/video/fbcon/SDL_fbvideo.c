@@ -223,6 +223,7 @@ static SDL_VideoDevice *FB_CreateDevice(int devindex)
 	this->GetWMInfo = NULL;
 	this->InitOSKeymap = FB_InitOSKeymap;
 	this->PumpEvents = FB_PumpEvents;
+	this->GetEventFDs = FB_GetEventFDs;
 
 	this->free = FB_DeleteDevice;
 
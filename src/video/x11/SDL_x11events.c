@@ -503,6 +503,25 @@ void X11_PumpEvents(_THIS)
 	}
 }
 
+int X11_GetEventFDs(_THIS, int *fds, int maxfds)
+{
+	/* Fullscreen switches are timed, so keep polling until they're done */
+	if ( switch_waiting || (maxfds < 1) ) {
+		return(-1);
+	}
+
+	/* Make sure our requests are sent before waiting for the server.
+	   X11_PumpEvents() has handled everything queued, but another thread
+	   may have read events into the Xlib queue since, like the present
+	   thread syncing an update, and then the socket stays quiet. */
+	XFlush(SDL_Display);
+	if ( XEventsQueued(SDL_Display, QueuedAlready) > 0 ) {
+		return(SDL_EVENTFDS_READY);
+	}
+	fds[0] = ConnectionNumber(SDL_Display);
+	return(1);
+}
+
 void X11_InitKeymap(void)
 {
 	int i;
@@ -30,5 +30,6 @@ static char rcsid =
 /* Functions to be exported */
 extern void X11_InitOSKeymap(_THIS);
 extern void X11_PumpEvents(_THIS);
+extern int X11_GetEventFDs(_THIS, int *fds, int maxfds);
 extern void X11_SetKeyboardState(Display *display, const char *key_vec);
 